@@ -140,9 +140,7 @@ void MLChangeList::writeToSignal(MLSignal& y, int frames)
 			changeTime = (int)mTimeSignal[i];
 			if (changeTime >= size)
             {
-#ifdef DEBUG
-                debug() << "warning: MLChangeList time (" << changeTime <<  ") > size!\n";
-#endif
+                ML_LOG_DEBUG("warning: MLChangeList time (%d) > size!\n", changeTime);
                 
                 break;
             }
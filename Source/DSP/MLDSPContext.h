@@ -53,6 +53,10 @@ public:
 	virtual void setEnabled(bool t) = 0;
 	virtual bool isEnabled() const = 0;
 	virtual bool isProcEnabled(const MLProc* p) const = 0;
+	
+	// called when a context below this one is enabled or disabled, which can change
+	// the number of voices of published signals. 
+	virtual void enabledVoicesChanged() {}
 
 protected:
 	
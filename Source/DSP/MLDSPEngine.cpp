@@ -4,16 +4,23 @@
 // Distributed under the MIT license: http://madrona-labs.mit-license.org/
 
 #include "MLDSPEngine.h"
+#include "MLEngineCapture.h"
+
+#include <chrono>
 
 const char * kMLInputToSignalProcName("the_midi_inputs");
 const char * kMLHostPhasorProcName("the_host_phasor");
 const char * kMLPatcherProcName("voices/voice/patcher");
+const char * kMLVoicesProcName("voices/voice");
+
+const float kMLDefaultVoiceSleepTime = 1.f;
 
 MLDSPEngine::MLDSPEngine() : 
 	mpInputToSignalsProc(0),
 	mpHostPhasorProc(0),
 	mInputChans(0),
 	mOutputChans(0),
+	mVoiceEpoch(0),
 	mCollectStats(false),
 	mBufferSize(0),
 	mGraphStatus(unknownErr),
@@ -21,28 +28,44 @@ MLDSPEngine::MLDSPEngine() :
 	mSamplesToProcess(0),
 	mStatsCount(0),
 	mSampleCount(0),
-	mCPUTimeCount(0.)
+	mCPUTimeCount(0.),
+	mVoiceSleepTime(kMLDefaultVoiceSleepTime),
+	mMaxVoices(kMLEngineMaxVoices),
+	mDescHash(0),
+	mpSignalRecorder(0),
+	mpInputCapture(0),
+	mpFrameSource(0)
 {
 #if defined(DEBUG) || (BETA) || (DEMO)
 	//mCollectStats = true;
 #endif
 	setName("dspengine");
+	
+	// start writing any messages logged from the audio thread.
+	theRealtimeLog().start();
 }
 
 MLDSPEngine::~MLDSPEngine()
 {
 	removeGraphAndInputs();
+	theRealtimeLog().stop();
 }
 
 // ----------------------------------------------------------------
 #pragma mark build graph
 
-MLProc::err MLDSPEngine::buildGraphAndInputs(juce::XmlDocument* pDoc, bool makeSignalInputs, bool makeMidiInput)
+void MLDSPEngine::setMaxVoices(int v)
+{
+	mMaxVoices = clamp(v, 1, kMLEngineVoiceLimit);
+}
+
+MLProc::err MLDSPEngine::buildGraphAndInputs(const MLGraphDesc& desc, bool makeSignalInputs, bool makeMidiInput)
 {
 	MLProc::err r = unknownErr;
 	bool graphOK = false;
 	mpInputToSignalsProc = 0;
 	mpHostPhasorProc = 0;
+	mDescHash = desc.getHash();
 	clear();
 	
 	if (makeSignalInputs) // TODO for effects
@@ -53,14 +76,16 @@ MLProc::err MLDSPEngine::buildGraphAndInputs(juce::XmlDocument* pDoc, bool makeS
 	// TODO refactor - paths to proccs are plugin-specific
 	if (makeMidiInput)
  	{
-		// make XML node describing MIDI to signal processor.
-		juce::ScopedPointer<juce::XmlElement> pElem (new juce::XmlElement("proc"));
-		pElem->setAttribute("class", "midi_to_signals");
-		pElem->setAttribute("name", juce::String(kMLInputToSignalProcName));
-		pElem->setAttribute("voices", (int)kMLEngineMaxVoices);			
+		// make node describing MIDI to signal processor.
+		MLGraphDesc procDesc;
+		MLGraphDesc::Node node = procDesc.addNode(MLGraphDesc::Node(), "proc");
+		procDesc.addAttr(node, "class", "midi_to_signals");
+		procDesc.addAttr(node, "name", kMLInputToSignalProcName);
+		procDesc.addAttr(node, "voices", mMaxVoices);			
+		procDesc.addAttr(node, "max_voices", mMaxVoices);			
 		
 		// build processor object.
-		MLProc::err bpe = buildProc(pElem);
+		MLProc::err bpe = buildProc(node);
 				
 		// save a pointer to it.
 		if (bpe == OK)
@@ -76,12 +101,13 @@ MLProc::err MLDSPEngine::buildGraphAndInputs(juce::XmlDocument* pDoc, bool makeS
 
 	// make host sync phasor
 	{
-		juce::ScopedPointer<juce::XmlElement> pElem (new juce::XmlElement("proc"));
-		pElem->setAttribute("class", "host_phasor");
-		pElem->setAttribute("name", kMLHostPhasorProcName);
+		MLGraphDesc procDesc;
+		MLGraphDesc::Node node = procDesc.addNode(MLGraphDesc::Node(), "proc");
+		procDesc.addAttr(node, "class", "host_phasor");
+		procDesc.addAttr(node, "name", kMLHostPhasorProcName);
 		
 		// build processor object.
-		MLProc::err bpe = buildProc(pElem);
+		MLProc::err bpe = buildProc(node);
 				
 		// save a pointer to it.
 		if (bpe == OK)
@@ -94,17 +120,17 @@ MLProc::err MLDSPEngine::buildGraphAndInputs(juce::XmlDocument* pDoc, bool makeS
 		}
 	}
 	
-	juce::ScopedPointer<juce::XmlElement> pRootElem (pDoc->getDocumentElement());
+	MLGraphDesc::Node root = desc.getRoot();
 
-	if (pRootElem)
+	if (root)
 	{	
 		makeRoot("root");
-		buildGraph(pRootElem);
+		buildGraph(root);
         
         // make any published signal outputs at top level only
-        forEachXmlChildElement(*pRootElem, child)
+        for(MLGraphDesc::Node child = root.getFirstChild(); child; child = child.getNextSibling())
         { 
-            if (child->hasTagName("signal"))
+            if (child.hasTag("signal"))
             {
                 int mode = eMLRingBufferMostRecent;
                 MLPath procArg = RequiredPathAttribute(child, "proc");
@@ -114,7 +140,7 @@ MLProc::err MLDSPEngine::buildGraphAndInputs(juce::XmlDocument* pDoc, bool makeS
                 if (procArg && outArg && aliasArg)
                 {
                     int bufLength = kMLRingBufferDefaultSize;
-                    bufLength = child->getIntAttribute("length", bufLength);
+                    bufLength = child.getIntAttr("length", bufLength);
                     MLPath procPath (procArg);
                     MLSymbol outSym (outArg);
                     MLSymbol aliasSym (aliasArg);
@@ -127,7 +153,7 @@ MLProc::err MLDSPEngine::buildGraphAndInputs(juce::XmlDocument* pDoc, bool makeS
 	}
 	
 	// if we made one or more Patchers with the right names in the document, save a list of them for direct access. 
-	getProcList(mPatcherList, MLPath(kMLPatcherProcName), kMLEngineMaxVoices);
+	getProcList(mPatcherList, MLPath(kMLPatcherProcName), mMaxVoices);
 
 	if (graphOK)
 	{
@@ -142,6 +168,7 @@ void MLDSPEngine::removeGraphAndInputs(void)
 {
 	mGraphStatus = unknownErr;
 	mCompileStatus = unknownErr;
+	mFlatOps.clear();
 	{
 		// unimplemented
 	}
@@ -150,13 +177,39 @@ void MLDSPEngine::removeGraphAndInputs(void)
 // ----------------------------------------------------------------
 #pragma mark compile
 
-void MLDSPEngine::compileEngine()
+void MLDSPEngine::compileEngine(double sampleRate, int chunkSize)
 {
 	err e = OK;
 	
+	// look for a graph compiled from the same description and settings.
+	MLCompiledGraphPtr pCached;
+	std::shared_ptr<MLCompiledGraph> pRecord;
+	const bool useCache = (mDescHash != 0) && (sampleRate > 0.) && (chunkSize > 0);
+	if (useCache)
+	{
+		const uint64_t key = MLGraphCache::makeKey(mDescHash, sampleRate, chunkSize, mMaxVoices);
+		pCached = theGraphCache().findGraph(key);
+		if (!pCached)
+		{
+			pRecord = std::shared_ptr<MLCompiledGraph>(new MLCompiledGraph(key));
+		}
+	}
+	MLCompileCursor cursor(pCached.get(), pRecord.get());
+	
 	// order procs and make connections
 	// also makes connected signals
+	setCompileCursor(useCache ? &cursor : 0);
 	compile();
+	setCompileCursor(0);
+	
+	if (pRecord)
+	{
+		theGraphCache().addGraph(pRecord);
+	}
+	if (cursor.getMisses() > 0)
+	{
+		debug() << "MLDSPEngine: " << cursor.getMisses() << " containers did not match cached graph!\n";
+	}
 	
 	if (e != OK)
 	{
@@ -235,6 +288,15 @@ MLProc::err MLDSPEngine::prepareEngine(double sr, int bufSize, int chunkSize)
 				
 		e = prepareToProcess();		
 		clear();
+		connectVoiceGates();
+		
+		// flatten the prepared graph for processing in chunks.
+		mFlatOps.clear();
+		if (e == OK)
+		{
+			addFlatOps(mFlatOps, chunkSize);
+		}
+		enabledVoicesChanged();
 	}
 bail:
 	if (e != OK)
@@ -250,6 +312,33 @@ bail:
 	return e;
 }
 
+// give each copy of the voice container the gate signal for its voice, so that 
+// silent voices can sleep.
+void MLDSPEngine::connectVoiceGates()
+{
+	if (!mpInputToSignalsProc) return;
+	MLProcPtr pVoicesProc = getProc(MLPath(kMLVoicesProcName));
+	MLMultiContainer* pVoices = dynamic_cast<MLMultiContainer*>(pVoicesProc.get());
+	if (!pVoices) return;
+	
+	const int copies = (int)pVoices->mCopies.size();
+	const int voices = (int)mpInputToSignalsProc->getParam("voices");
+	for(int i=0; i<copies; ++i)
+	{
+		const MLSignal* pGate = 0;
+		if (i < voices)
+		{
+			int gateIdx = mpInputToSignalsProc->getOutputIndex(MLSymbol("gate").withFinalNumber(i + 1));
+			if (gateIdx && mpInputToSignalsProc->outputIsValid(gateIdx))
+			{
+				pGate = &mpInputToSignalsProc->getOutput(gateIdx);
+			}
+		}
+		pVoices->setCopyGate(i, pGate);
+	}
+	pVoices->setSleepTime(mVoiceSleepTime);
+}
+
 // ----------------------------------------------------------------
 #pragma mark I/O
 
@@ -305,13 +394,22 @@ void MLDSPEngine::readInputBuffers(const int samples)
 	}
 }
 
-// write outputs of root container to ringbuffers
+// write outputs of root container to ringbuffers. only the first sample of
+// a constant output is valid.
 void MLDSPEngine::writeOutputBuffers(const int samples)
 {
 	int outs = getNumOutputs();
 	for(int i=0; i < outs; ++i)
 	{
-		mOutputBuffers[i]->write(getOutput(i+1).getBuffer(), samples);
+		const MLSignal& y = getOutput(i+1);
+		if (y.isConstant())
+		{
+			mOutputBuffers[i]->writeConstant(y[0], samples);
+		}
+		else
+		{
+			mOutputBuffers[i]->write(y.getBuffer(), samples);
+		}
 	}
 } 
 
@@ -370,6 +468,23 @@ void MLDSPEngine::publishSignal(const MLPath & procAddress, const MLSymbol outpu
 		{
 			// TODO list copy is unnecessary here -- turn this around
 			mPublishedSignalMap[alias] = signalBuffers;
+			
+			// give each buffer the signal's change counter, keeping any existing
+			// counter so that readers don't miss changes.
+			MLSequencePtr& pSeq = mPublishedSignalSequences[alias];
+			if (!pSeq)
+			{
+				pSeq = MLSequencePtr(new std::atomic<uint32_t>(0));
+			}
+			for (MLProcList::const_iterator jt = signalBuffers.begin(); jt != signalBuffers.end(); jt++)
+			{
+				MLProcPtr proc = (*jt);
+				if (proc)
+				{
+					static_cast<MLProcRingBuffer&>(*proc).setChangeSequence(pSeq.get());
+				}
+			}
+			enabledVoicesChanged();
 		}
 	}
 }
@@ -399,6 +514,24 @@ int MLDSPEngine::getPublishedSignalVoices(const MLSymbol alias)
 	return nVoices;
 }
 
+bool MLDSPEngine::addPublishedSignalToRecorder(const MLSymbol alias, MLSignalRecorder& recorder)
+{
+	MLPublishedSignalMapT::const_iterator it = mPublishedSignalMap.find(alias);
+	if (it == mPublishedSignalMap.end()) return false;
+	recorder.addTrack(alias, it->second);
+	return true;
+}
+
+uint32_t MLDSPEngine::getPublishedSignalSequence(const MLSymbol alias) const
+{
+	std::map<MLSymbol, MLSequencePtr>::const_iterator it = mPublishedSignalSequences.find(alias);
+	if (it != mPublishedSignalSequences.end())
+	{
+		return it->second->load(std::memory_order_acquire);
+	}
+	return 0;
+}
+
 // return the number of currently enabled buffers matching alias in the signal list.
 //
 int MLDSPEngine::getPublishedSignalVoicesEnabled(const MLSymbol alias)
@@ -480,14 +613,15 @@ int MLDSPEngine::readPublishedSignal(const MLSymbol alias, MLSignal& outSig)
 		// need to iterate here again so we can pass nVoices to readToSignal().
 		if (nVoices > 0)
 		{
+			const MLSignalRef out = outSig.getView();
 			int voice = 0;  // check change
-			for (MLProcList::const_iterator jt = bufList.begin(); jt != bufList.end(); jt++)
+			for (MLProcList::const_iterator jt = bufList.begin(); (jt != bufList.end()) && (voice < out.getHeight()); jt++)
 			{
 				MLProcPtr proc = (*jt);
 				if (proc && proc->isEnabled())
 				{
 					MLProcRingBuffer& bufferProc = static_cast<MLProcRingBuffer&>(*proc);
-					r = bufferProc.readToSignal(outSig, samples, voice);
+					r = bufferProc.readToSignal(out.getRowView(voice), samples);
 					minSamplesRead = min(r, minSamplesRead);
 					voice++;
 				}
@@ -531,12 +665,31 @@ void MLDSPEngine::setInputDataRate(int p)
 	}
 }
 
+int MLDSPEngine::getEngineInputProtocol()
+{
+	return mpInputToSignalsProc ? (int)mpInputToSignalsProc->getParam("protocol") : -1;
+}
+
+int MLDSPEngine::getInputDataRate()
+{
+	return mpInputToSignalsProc ? (int)mpInputToSignalsProc->getParam("data_rate") : 0;
+}
+
 // set frame buffer for OSC inputs
 void MLDSPEngine::setInputFrameBuffer(PaUtilRingBuffer* pBuf)
 {
 	if (mpInputToSignalsProc)
 	{
-		mpInputToSignalsProc->setInputFrameBuffer(pBuf);
+		mpFrameSource = pBuf;
+		if (pBuf)
+		{
+			const int frameBytes = (int)pBuf->elementSizeBytes;
+			const int frames = MLProcInputToSignals::kFrameBufferSize;
+			mFrameData.assign(frameBytes*frames, 0);
+			mFrame.assign(frameBytes, 0);
+			PaUtil_InitializeRingBuffer(&mFrameBuf, frameBytes, frames, &mFrameData[0]);
+		}
+		mpInputToSignalsProc->setInputFrameBuffer(pBuf ? &mFrameBuf : 0);
 	}
 	else 
 	{
@@ -544,6 +697,35 @@ void MLDSPEngine::setInputFrameBuffer(PaUtilRingBuffer* pBuf)
 	}
 }
 
+// move any new OSC frames to the input proc's ring.
+void MLDSPEngine::readInputFrames(MLEngineCapture* pCapture)
+{
+	if (!mpFrameSource) return;
+	const int frameBytes = (int)mFrame.size();
+	while ((PaUtil_GetRingBufferReadAvailable(mpFrameSource) > 0) && (PaUtil_GetRingBufferWriteAvailable(&mFrameBuf) > 0))
+	{
+		PaUtil_ReadRingBuffer(mpFrameSource, &mFrame[0], 1);
+		PaUtil_WriteRingBuffer(&mFrameBuf, &mFrame[0], 1);
+		if (pCapture)
+		{
+			pCapture->captureFrame(&mFrame[0], frameBytes);
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+#pragma mark capture
+
+void MLDSPEngine::setPublishedParam(int index, const MLProperty& val)
+{
+	MLEngineCapture* pCapture = mpInputCapture.load(std::memory_order_acquire);
+	if (pCapture)
+	{
+		pCapture->captureParam(index, val);
+	}
+	MLProcContainer::setPublishedParam(index, val);
+}
+
 // ----------------------------------------------------------------
 #pragma mark Process
 
@@ -555,16 +737,24 @@ void MLDSPEngine::setCollectStats(bool k)
 // run one buffer of the compiled graph, processing signals from the global inputs (if any)
 // to the global outputs.  Processes sub-procs in chunks of our preferred vector size.
 //
-void MLDSPEngine::processSignalsAndEvents(const int frames, const MLControlEventVector& events, const int64_t , const double secs, const double ppqPos, const double bpm, bool isPlaying)
+void MLDSPEngine::processSignalsAndEvents(const int frames, const MLControlEventVector& events, const int64_t samplesPos, const double secs, const double ppqPos, const double bpm, bool isPlaying)
 {
 	int sr = getSampleRate();
 	int processed = 0;
 	bool reportStats = false;
-	osc::int64 startTime = 0, endTime = 0;
+	std::chrono::steady_clock::time_point startTime;
     MLControlEventVector::const_iterator firstEvent, lastEvent;
 		
 	//debug() << "new samples: " << frames << "\n";
 	
+	// the capture copies the inputs now, as the host may reuse them for outputs.
+	MLEngineCapture* pCapture = mpInputCapture.load(std::memory_order_acquire);
+	if (pCapture)
+	{
+		pCapture->beginBlock(frames, mIOMap.inputs, mInputChans);
+	}
+	readInputFrames(pCapture);
+	
     if (mpHostPhasorProc)
 	{	
 		mpHostPhasorProc->setTimeAndRate(secs, ppqPos, bpm, isPlaying);
@@ -613,24 +803,20 @@ void MLDSPEngine::processSignalsAndEvents(const int frames, const MLControlEvent
             
 			process(mVectorSize);  // MLProcContainer::process()
 	
-			debug() << "\n";
-			debug() << "processed " << mSampleCount << " samples in " << mCPUTimeCount << " seconds,"
-				<< "vector size " << mVectorSize << ".\n";
+			// we are on the audio thread, so no iostreams here. 
+			ML_LOG_INFO("\nprocessed %d samples in %f seconds, vector size %d.\n", mSampleCount, mCPUTimeCount, mVectorSize);
 			double uSecsPerSample = mCPUTimeCount / (double)mSampleCount * 1000000.;
 			double maxuSecsPerSample = getInvSampleRate() * 1000000.;
 			double CPUFrac = uSecsPerSample / maxuSecsPerSample;
 			double percent = CPUFrac * 100.;
-			debug() << (int)(mCPUTimeCount / (double)mVectorSize * 1000000.) << " microseconds per sample (";
-			debug() << std::fixed;
-			debug() << std::setprecision(1);
-			debug() << percent << "\%)\n";
+			ML_LOG_INFO("%d microseconds per sample (%.1f%%)\n", (int)(mCPUTimeCount / (double)mVectorSize * 1000000.), percent);
 			
 			// clear time and sample counters
 			mCPUTimeCount = 0.;
 			mSampleCount = 0;
 			
 			collectStats(0); // turn off stats collection
-			debug() << "\n";
+			ML_LOG_INFO("\n");
 			stats.dump();
 			reportStats = false;
 		}
@@ -638,24 +824,36 @@ void MLDSPEngine::processSignalsAndEvents(const int frames, const MLControlEvent
 		{
 			if (mCollectStats)
             {
-                startTime = juce::Time::getHighResolutionTicks();
+                startTime = std::chrono::steady_clock::now();
             }
 			
-			process(mVectorSize);  // MLProcContainer::process()
+			mFlatOps.process();
 			
 			if (mCollectStats) 
 			{
-				endTime = juce::Time::getHighResolutionTicks();
-				mCPUTimeCount += juce::Time::highResolutionTicksToSeconds (endTime - startTime);
+				std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+				mCPUTimeCount += elapsed.count();
 				mSampleCount += mVectorSize;
 			}
 		}		
          
+		MLSignalRecorder* pRecorder = mpSignalRecorder.load(std::memory_order_acquire);
+		if (pRecorder)
+		{
+			pRecorder->capture(mVectorSize);
+		}
+		
         writeOutputBuffers(mVectorSize);
 		processed += mVectorSize;
 		mSamplesToProcess -= mVectorSize;
 	}	
 	readOutputBuffers(frames);
+	
+	if (pCapture)
+	{
+		pCapture->endBlock(frames, events, samplesPos, secs, ppqPos, bpm, isPlaying, 
+			mIOMap.outputs, mOutputChans);
+	}
 }
 
 
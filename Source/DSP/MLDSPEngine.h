@@ -7,19 +7,25 @@
 #define ML_DSP_ENGINE_H
 
 #include "MLProcContainer.h"
+#include "MLMultProxy.h"
 #include "MLProcInputToSignals.h"
 #include "MLInputProtocols.h"
 #include "MLProcHostPhasor.h"
 #include "MLSignal.h"
 #include "MLRingBuffer.h"
+#include "MLParamQueue.h"
 #include "MLControlEvent.h"
+#include "MLSignalRecorder.h"
 #include "OscTypes.h"
 
 const int kMLEngineMaxChannels = 8;
 
+class MLEngineCapture;
+
 extern const char * kMLInputToSignalProcName;
 extern const char * kMLHostPhasorProcName;
 extern const char * kMLPatcherProcName;
+extern const char * kMLVoicesProcName;
 extern const MLPath kMLPatcherPath;
 
 // MLDSPEngine: the bridge between a top-level MLProcContainer and the outside world.
@@ -38,7 +44,12 @@ public:
 	MLDSPEngine();
 	~MLDSPEngine();	
 	
-	MLProc::err buildGraphAndInputs(juce::XmlDocument* pDoc, bool makeSignalInputs, bool makeMidiInput);
+	// set the maximum number of voices the MIDI / OSC input can play, up to kMLEngineVoiceLimit.
+	// takes effect in buildGraphAndInputs(). 
+	void setMaxVoices(int v);
+	int getMaxVoices() const { return mMaxVoices; }
+	
+	MLProc::err buildGraphAndInputs(const MLGraphDesc& desc, bool makeSignalInputs, bool makeMidiInput);
 	void removeGraphAndInputs(void);
 	err getGraphStatus(void) {return mGraphStatus;}
 	
@@ -46,7 +57,9 @@ public:
 	#pragma mark graph dynamics
 	//
 	
-	void compileEngine();
+	// compile the graph. If the sample rate and chunk size are given, buffer packing is 
+	// shared through theGraphCache() with other engines built from the same description.
+	void compileEngine(double sampleRate = 0., int chunkSize = 0);
 	bool getCompileStatus(void) {return mCompileStatus;}
 	MLProc::err prepareEngine(double sr, int bufSize, int chunkSize);
 
@@ -59,6 +72,8 @@ public:
 
 	void setInputChannels(int c); 
 	void setOutputChannels(int c); 
+	int getInputChannels() const { return mInputChans; }
+	int getOutputChannels() const { return mOutputChans; }
 	
 	// set external buffers for top level I/O with client
 	void setIOBuffers(const ClientIOMap& pMap);
@@ -77,18 +92,70 @@ public:
 	int getPublishedSignalVoicesEnabled(const MLSymbol alias);
 	int getPublishedSignalBufferSize(const MLSymbol alias);
 	int readPublishedSignal(const MLSymbol alias, MLSignal& outSig);
+	
+	// return a number that changes each time samples are written to the published signal
+	// that change its recent history. A reader that saw the same number last time can
+	// skip reading the signal.
+	uint32_t getPublishedSignalSequence(const MLSymbol alias) const;
+	
+	// return a number that changes whenever voices are enabled or disabled, or the graph
+	// is prepared. Voice counts of published signals can be cached until it changes.
+	uint32_t getVoiceEpoch() const { return mVoiceEpoch.load(std::memory_order_acquire); }
+	
+	// MLDSPContext
+	void enabledVoicesChanged() { mVoiceEpoch.fetch_add(1, std::memory_order_release); }
+	
+	// add all the voices of a published signal to a recorder. 
+	bool addPublishedSignalToRecorder(const MLSymbol alias, MLSignalRecorder& recorder);
+	
+	// set a recorder to be given each processed chunk on the audio thread, or null to 
+	// remove it. The recorder should be started first and stopped after it is removed.
+	void setSignalRecorder(MLSignalRecorder* pRecorder) { mpSignalRecorder = pRecorder; }
     
 	// ----------------------------------------------------------------
 	// control input
 
 	void setEngineInputProtocol(int p);
 	void setInputDataRate(int p);
+	int getEngineInputProtocol();
+	int getInputDataRate();
+	
+	// set the ring that OSC frames come from. Frames are moved to the input proc at the 
+	// start of each block, so that they can be captured. Set before processing.
 	void setInputFrameBuffer(PaUtilRingBuffer* pBuf);
+	int getInputFrameBytes() const { return mpFrameSource ? (int)mpFrameSource->elementSizeBytes : 0; }
+	
+	// stop reading frames from the ring, so that another engine can have them. Frames
+	// already read are still played. Audio thread.
+	void releaseInputFrameBuffer() { mpFrameSource = 0; }
+	
+	// ----------------------------------------------------------------
+	// capture
+	
+	// set a capture to be given all the engine's inputs, or null to remove it.
+	// The capture should be started first and stopped after it is removed.
+	void setInputCapture(MLEngineCapture* pCapture) { mpInputCapture = pCapture; }
+	
+	// set a published param, also passing it to any input capture. This overrides
+	// MLProcContainer::setPublishedParam(), so params set through a container
+	// pointer to the engine are captured too.
+	void setPublishedParam(int index, const MLProperty& val) override;
+	
+	// changes to published params waiting to be sent to the host. Pushed from any
+	// thread, and drained by the audio thread at the start of each block.
+	MLParamQueue& getAutomationQueue() { return mAutomationQueue; }
+	
+	// hash of the description the graph was built from.
+	uint64_t getDescHash() const { return mDescHash; }
 	
 	// ----------------------------------------------------------------
 	// Process
 
 	void setCollectStats(bool k);
+	
+	// set the time in seconds after which a silent voice with its gate off will sleep. 
+	// 0 turns voice sleep off. takes effect in prepareEngine().
+	void setVoiceSleepTime(float seconds) { mVoiceSleepTime = seconds; }
 
 	// run the compiled graph, processing signals from the global inputs (if any)
 	// to the global outputs. 
@@ -116,6 +183,14 @@ private:
     // map to published signals by name
 	typedef std::map<MLSymbol, MLProcList> MLPublishedSignalMapT;
 	MLPublishedSignalMapT mPublishedSignalMap;
+	
+	// change counters for published signals, written by their ring buffers.
+	typedef std::shared_ptr<std::atomic<uint32_t> > MLSequencePtr;
+	std::map<MLSymbol, MLSequencePtr> mPublishedSignalSequences;
+	
+	std::atomic<uint32_t> mVoiceEpoch;
+	
+	MLParamQueue mAutomationQueue;
     
 	// input signals that will be sent to the root proc.
 	std::vector<MLSignalPtr> mInputSignals;
@@ -125,6 +200,9 @@ private:
 	std::vector<MLRingBufferPtr> mInputBuffers;
 	std::vector<MLRingBufferPtr> mOutputBuffers;
 
+	// the compiled graph, flattened for processing by prepareEngine().
+	MLFlatOpList mFlatOps;
+
 	bool mCollectStats;
 	int mBufferSize;
 	err mGraphStatus;
@@ -136,11 +214,30 @@ private:
 	int mSampleCount;
 	double mCPUTimeCount;
 		
+	// time before silent voices sleep, in seconds.
+	float mVoiceSleepTime;
+	
+	int mMaxVoices;
+	
+	// hash of the description the graph was built from, for the graph cache.
+	uint64_t mDescHash;
+	
+	std::atomic<MLSignalRecorder*> mpSignalRecorder;
+	std::atomic<MLEngineCapture*> mpInputCapture;
+	
+	// OSC frames are moved from the source to mFrameBuf, which the input proc reads.
+	PaUtilRingBuffer* mpFrameSource;
+	PaUtilRingBuffer mFrameBuf;
+	std::vector<unsigned char> mFrameData;
+	std::vector<unsigned char> mFrame;
+	
+	void connectVoiceGates();
 	void writeInputBuffers(const int samples);
     void clearOutputBuffers();
 	void readInputBuffers(const int samples);
 	void writeOutputBuffers(const int samples);
 	void readOutputBuffers(const int samples);
+	void readInputFrames(MLEngineCapture* pCapture);
 };
 
 
@@ -0,0 +1,614 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLEngineCapture.h"
+#include "MLDSPEngine.h"
+#include "MLDebug.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	const int kRecordHeaderBytes = sizeof(MLEngineCaptureRecord);
+	static_assert(sizeof(MLEngineCaptureHeader) == 56, "MLEngineCapture: bad header size");
+	static_assert(sizeof(MLEngineCaptureBlock) == 56, "MLEngineCapture: bad block size");
+
+	inline int padded(int bytes)
+	{
+		return (bytes + 7) & ~7;
+	}
+}
+
+const int MLEngineCapture::kMaxEvents;
+const int MLEngineCapture::kMaxParamBytes;
+const int MLEngineCapture::kParamQueueSize;
+
+// ----------------------------------------------------------------
+#pragma mark MLEngineCapture
+
+MLEngineCapture::MLEngineCapture() :
+	mInputFrames(0),
+	mNumInputs(0),
+	mpFile(0),
+	mOverflow(false),
+	mBlocks(0)
+{
+}
+
+MLEngineCapture::~MLEngineCapture()
+{
+	stop();
+}
+
+bool MLEngineCapture::start(const std::string& path, MLDSPEngine& engine, float bufferSeconds)
+{
+	if(mWriter.isRunning()) return false;
+	const int bufSize = engine.getBufferSize();
+	if(bufSize <= 0) return false;
+
+	mpFile = fopen(path.c_str(), "wb");
+	if(!mpFile)
+	{
+		debug() << "MLEngineCapture: could not open " << path << "\n";
+		return false;
+	}
+
+	MLEngineCaptureHeader header;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = kMLEngineCaptureMagic;
+	header.mVersion = kMLEngineCaptureVersion;
+	header.mSampleRate = engine.getSampleRate();
+	header.mBufferSize = bufSize;
+	header.mVectorSize = engine.getVectorSize();
+	header.mInputs = engine.getInputChannels();
+	header.mOutputs = engine.getOutputChannels();
+	header.mMaxVoices = engine.getMaxVoices();
+	header.mInputProtocol = engine.getEngineInputProtocol();
+	header.mInputDataRate = engine.getInputDataRate();
+	header.mFrameBytes = engine.getInputFrameBytes();
+	header.mDescHash = engine.getDescHash();
+	fwrite(&header, sizeof(header), 1, mpFile);
+	fflush(mpFile);
+
+	// the largest block record, with every event and input.
+	const int maxBlockBytes = kRecordHeaderBytes + padded(sizeof(MLEngineCaptureBlock) +
+		kMaxEvents*sizeof(MLEngineCaptureEvent) + header.mInputs*bufSize*sizeof(float));
+
+	// size the ring for bufferSeconds of blocks with a few events each.
+	const int typicalBlockBytes = kRecordHeaderBytes + padded(sizeof(MLEngineCaptureBlock) +
+		16*sizeof(MLEngineCaptureEvent) + header.mInputs*bufSize*sizeof(float));
+	const int blocks = (int)(header.mSampleRate*bufferSeconds/bufSize) + 1;
+	const int ringBytes = 1 << bitsToContain(std::max(blocks*typicalBlockBytes, 4*maxBlockBytes));
+	const int maxParamBytes = kRecordHeaderBytes + padded(sizeof(MLEngineCaptureParam) + kMaxParamBytes);
+	mRingData.assign(ringBytes, 0);
+	PaUtil_InitializeRingBuffer(&mRing, 1, ringBytes, &mRingData[0]);
+	mAudioScratch.assign(std::max(maxBlockBytes, maxParamBytes), 0);
+	mWriteScratch.assign(mAudioScratch.size(), 0);
+	mInputs.assign(header.mInputs*bufSize, 0.f);
+	mInputFrames = 0;
+	mNumInputs = 0;
+
+	// discard any params left from an earlier capture.
+	while(mParamQueue.pop(mAudioParam)) {}
+	mParamQueue.getDropped();
+
+	mOverflow = false;
+	mBlocks = 0;
+	mWriter.start([this]() { write(); });
+
+	// start from the current parameter values.
+	const int params = engine.getPublishedParams();
+	for(int i=0; i<params; ++i)
+	{
+		MLPublishedParamPtr p = engine.getParamPtr(i);
+		if(p)
+		{
+			captureParam(i, p->getValueProperty());
+		}
+	}
+	return true;
+}
+
+void MLEngineCapture::stop()
+{
+	if(!mWriter.isRunning()) return;
+
+	mWriter.stop();
+	fclose(mpFile);
+	mpFile = 0;
+
+	if(mOverflow)
+	{
+		debug() << "MLEngineCapture: buffer full, capture ended after " << mBlocks << " blocks.\n";
+	}
+}
+
+// copy all complete records from the ring to the file.
+void MLEngineCapture::write()
+{
+	bool wrote = false;
+	while(PaUtil_GetRingBufferReadAvailable(&mRing) >= kRecordHeaderBytes)
+	{
+		unsigned char* p = &mWriteScratch[0];
+		PaUtil_ReadRingBuffer(&mRing, p, kRecordHeaderBytes);
+		MLEngineCaptureRecord r;
+		memcpy(&r, p, sizeof(r));
+		const int dataBytes = padded(r.mBytes);
+		PaUtil_ReadRingBuffer(&mRing, p + kRecordHeaderBytes, dataBytes);
+		fwrite(p, 1, kRecordHeaderBytes + dataBytes, mpFile);
+		wrote = true;
+	}
+	if(wrote)
+	{
+		fflush(mpFile);
+	}
+}
+
+bool MLEngineCapture::writeRecord(uint32_t type, unsigned char* pRecord, int bytes)
+{
+	const int total = kRecordHeaderBytes + padded(bytes);
+	if(PaUtil_GetRingBufferWriteAvailable(&mRing) < total)
+	{
+		endCapture();
+		return false;
+	}
+	MLEngineCaptureRecord r;
+	r.mType = type;
+	r.mBytes = bytes;
+	memcpy(pRecord, &r, sizeof(r));
+	memset(pRecord + kRecordHeaderBytes + bytes, 0, total - kRecordHeaderBytes - bytes);
+	PaUtil_WriteRingBuffer(&mRing, pRecord, total);
+	return true;
+}
+
+// a capture with a gap in it can't be replayed, so end it here.
+void MLEngineCapture::endCapture()
+{
+	mOverflow = true;
+	mWriter.close();
+}
+
+void MLEngineCapture::captureParam(int index, const MLProperty& value)
+{
+	MLBackgroundWriter::Producer producer(mWriter);
+	if(!producer.isOpen()) return;
+
+	ParamRecord rec;
+	rec.mParam.mIndex = index;
+	rec.mParam.mPropertyType = value.getType();
+	rec.mParam.mBlock = mBlocks;
+	rec.mParam.mReserved = 0;
+	int valueBytes = 0;
+	bool fits = true;
+
+	switch(value.getType())
+	{
+		case MLProperty::kFloatProperty:
+		{
+			const float f = value.getFloatValue();
+			memcpy(rec.mValue, &f, sizeof(f));
+			valueBytes = sizeof(f);
+			break;
+		}
+		case MLProperty::kStringProperty:
+		{
+			const std::string& str = value.getStringValue();
+			valueBytes = (int)str.size();
+			fits = (valueBytes <= kMaxParamBytes);
+			if(fits)
+			{
+				memcpy(rec.mValue, str.data(), valueBytes);
+			}
+			break;
+		}
+		case MLProperty::kSignalProperty:
+		{
+			const MLSignal& sig = value.getSignalValue();
+			const int32_t dims[3] = {sig.getWidth(), sig.getHeight(), sig.getDepth()};
+			valueBytes = sizeof(dims) + dims[0]*dims[1]*dims[2]*sizeof(float);
+			fits = (valueBytes <= kMaxParamBytes);
+			if(fits)
+			{
+				unsigned char* p = rec.mValue;
+				memcpy(p, dims, sizeof(dims));
+				p += sizeof(dims);
+				for(int k=0; k<dims[2]; ++k)
+				{
+					for(int j=0; j<dims[1]; ++j)
+					{
+						for(int i=0; i<dims[0]; ++i)
+						{
+							const float f = sig(i, j, k);
+							memcpy(p, &f, sizeof(f));
+							p += sizeof(f);
+						}
+					}
+				}
+			}
+			break;
+		}
+		default:
+			break;
+	}
+	rec.mBytes = sizeof(MLEngineCaptureParam) + valueBytes;
+
+	if(!fits || !mParamQueue.push(rec))
+	{
+		endCapture();
+	}
+}
+
+// pass on the params set since the last block, and copy the inputs before the
+// engine reads them.
+void MLEngineCapture::beginBlock(const int frames, const float* const* inputs, int numInputs)
+{
+	MLBackgroundWriter::Producer producer(mWriter);
+	if(!producer.isOpen()) return;
+
+	while(mParamQueue.pop(mAudioParam))
+	{
+		unsigned char* p = &mAudioScratch[0];
+		memcpy(p + kRecordHeaderBytes, &mAudioParam.mParam, sizeof(MLEngineCaptureParam));
+		memcpy(p + kRecordHeaderBytes + sizeof(MLEngineCaptureParam), mAudioParam.mValue, 
+			mAudioParam.mBytes - sizeof(MLEngineCaptureParam));
+		if(!writeRecord(MLEngineCaptureRecord::kParam, p, mAudioParam.mBytes)) return;
+	}
+
+	if(numInputs*frames > (int)mInputs.size())
+	{
+		endCapture();
+		return;
+	}
+	for(int i=0; i<numInputs; ++i)
+	{
+		memcpy(&mInputs[i*frames], inputs[i], frames*sizeof(float));
+	}
+	mInputFrames = frames;
+	mNumInputs = numInputs;
+}
+
+void MLEngineCapture::captureFrame(const void* pFrame, int bytes)
+{
+	MLBackgroundWriter::Producer producer(mWriter);
+	if(!producer.isOpen()) return;
+
+	unsigned char* p = &mAudioScratch[0];
+	memcpy(p + kRecordHeaderBytes, pFrame, bytes);
+	writeRecord(MLEngineCaptureRecord::kFrame, p, bytes);
+}
+
+void MLEngineCapture::endBlock(const int frames, const MLControlEventVector& events, const int64_t samplesPos,
+	const double secs, const double ppqPos, const double bpm, bool isPlaying,
+	const float* const* outputs, int numOutputs)
+{
+	MLBackgroundWriter::Producer producer(mWriter);
+	if(!producer.isOpen()) return;
+
+	const int numInputs = (frames == mInputFrames) ? mNumInputs : 0;
+	const int numEvents = (int)events.size();
+	const int dataBytes = sizeof(MLEngineCaptureBlock) + numEvents*sizeof(MLEngineCaptureEvent) +
+		numInputs*frames*sizeof(float);
+	if((numEvents > kMaxEvents) || (kRecordHeaderBytes + padded(dataBytes) > (int)mAudioScratch.size()))
+	{
+		endCapture();
+		return;
+	}
+
+	unsigned char* pRecord = &mAudioScratch[0];
+	unsigned char* p = pRecord + kRecordHeaderBytes;
+	MLEngineCaptureBlock block;
+	block.mFrames = frames;
+	block.mEvents = numEvents;
+	block.mInputs = numInputs;
+	block.mIsPlaying = isPlaying;
+	block.mSamplesPos = samplesPos;
+	block.mSecs = secs;
+	block.mPPQPos = ppqPos;
+	block.mBPM = bpm;
+	block.mOutputHash = hashOutputs(outputs, numOutputs, frames);
+	memcpy(p, &block, sizeof(block));
+	p += sizeof(block);
+
+	for(int i=0; i<numEvents; ++i)
+	{
+		const MLControlEvent& e = events[i];
+		MLEngineCaptureEvent ce;
+		ce.mType = e.mType;
+		ce.mChannel = e.mChannel;
+		ce.mID = e.mID;
+		ce.mTime = e.mTime;
+		ce.mValue1 = e.mValue1;
+		ce.mValue2 = e.mValue2;
+		memcpy(p, &ce, sizeof(ce));
+		p += sizeof(ce);
+	}
+	if(numInputs)
+	{
+		memcpy(p, &mInputs[0], numInputs*frames*sizeof(float));
+	}
+
+	if(writeRecord(MLEngineCaptureRecord::kBlock, pRecord, dataBytes))
+	{
+		mBlocks++;
+	}
+}
+
+// FNV-1a over 32-bit words.
+uint64_t MLEngineCapture::hashOutputs(const float* const* outputs, int numOutputs, int frames)
+{
+	uint64_t h = 14695981039346656037ULL;
+	for(int i=0; i<numOutputs; ++i)
+	{
+		const float* pOut = outputs[i];
+		if(!pOut) continue;
+		for(int n=0; n<frames; ++n)
+		{
+			uint32_t w;
+			memcpy(&w, &pOut[n], sizeof(w));
+			h ^= w;
+			h *= 1099511628211ULL;
+		}
+	}
+	return h;
+}
+
+// ----------------------------------------------------------------
+#pragma mark MLEngineReplay
+
+// set a published param from the data of a kParam record.
+static void applyParam(MLDSPEngine& engine, const unsigned char* p, int bytes)
+{
+	MLEngineCaptureParam param;
+	memcpy(&param, p, sizeof(param));
+	p += sizeof(param);
+	const int valueBytes = bytes - sizeof(param);
+	if(param.mPropertyType == MLProperty::kFloatProperty)
+	{
+		float f;
+		memcpy(&f, p, sizeof(f));
+		engine.setPublishedParam(param.mIndex, MLProperty(f));
+	}
+	else if(param.mPropertyType == MLProperty::kStringProperty)
+	{
+		engine.setPublishedParam(param.mIndex, MLProperty(std::string((const char*)p, valueBytes)));
+	}
+	else if(param.mPropertyType == MLProperty::kSignalProperty)
+	{
+		int32_t dims[3];
+		memcpy(dims, p, sizeof(dims));
+		p += sizeof(dims);
+		MLSignal sig(dims[0], dims[1], dims[2]);
+		for(int k=0; k<dims[2]; ++k)
+		{
+			for(int j=0; j<dims[1]; ++j)
+			{
+				for(int i=0; i<dims[0]; ++i)
+				{
+					float f;
+					memcpy(&f, p, sizeof(f));
+					p += sizeof(f);
+					sig(i, j, k) = f;
+				}
+			}
+		}
+		engine.setPublishedParam(param.mIndex, MLProperty(sig));
+	}
+}
+
+MLEngineReplay::MLEngineReplay()
+{
+	memset(&mHeader, 0, sizeof(mHeader));
+	mFrameRing.buffer = 0;
+}
+
+MLEngineReplay::~MLEngineReplay()
+{
+}
+
+bool MLEngineReplay::load(const std::string& path)
+{
+	mData.clear();
+	FILE* f = fopen(path.c_str(), "rb");
+	if(!f)
+	{
+		debug() << "MLEngineReplay: could not open " << path << "\n";
+		return false;
+	}
+	unsigned char buf[4096];
+	size_t n;
+	while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+	{
+		mData.insert(mData.end(), buf, buf + n);
+	}
+	fclose(f);
+
+	if(mData.size() < sizeof(MLEngineCaptureHeader)) return false;
+	memcpy(&mHeader, &mData[0], sizeof(mHeader));
+	if((mHeader.mMagic != kMLEngineCaptureMagic) || (mHeader.mVersion != kMLEngineCaptureVersion))
+	{
+		debug() << "MLEngineReplay: " << path << " is not a capture file.\n";
+		return false;
+	}
+	if((mHeader.mInputs > kMLEngineMaxChannels) || (mHeader.mOutputs > kMLEngineMaxChannels) || (mHeader.mBufferSize <= 0))
+	{
+		debug() << "MLEngineReplay: bad settings in " << path << "\n";
+		return false;
+	}
+	return true;
+}
+
+MLProc::err MLEngineReplay::setupEngine(MLDSPEngine& engine, const MLGraphDesc& desc)
+{
+	if(desc.getHash() != mHeader.mDescHash)
+	{
+		debug() << "MLEngineReplay: warning: graph description differs from the one captured.\n";
+	}
+
+	engine.setMaxVoices(mHeader.mMaxVoices);
+	engine.setInputChannels(mHeader.mInputs);
+	engine.setOutputChannels(mHeader.mOutputs);
+	MLProc::err e = engine.buildGraphAndInputs(desc, mHeader.mInputs > 0, true);
+	if(e != MLProc::OK) return e;
+	engine.compileEngine(mHeader.mSampleRate, mHeader.mVectorSize);
+	e = engine.prepareEngine(mHeader.mSampleRate, mHeader.mBufferSize, mHeader.mVectorSize);
+	if(e != MLProc::OK) return e;
+
+	if(mHeader.mInputProtocol >= 0)
+	{
+		engine.setEngineInputProtocol(mHeader.mInputProtocol);
+	}
+	if(mHeader.mInputDataRate > 0)
+	{
+		engine.setInputDataRate(mHeader.mInputDataRate);
+	}
+	if(mHeader.mFrameBytes > 0)
+	{
+		mFrameRingData.assign(mHeader.mFrameBytes*MLProcInputToSignals::kFrameBufferSize, 0);
+		PaUtil_InitializeRingBuffer(&mFrameRing, mHeader.mFrameBytes, MLProcInputToSignals::kFrameBufferSize, &mFrameRingData[0]);
+		engine.setInputFrameBuffer(&mFrameRing);
+	}
+	engine.setEnabled(true);
+	return MLProc::OK;
+}
+
+MLEngineReplay::Result MLEngineReplay::run(MLDSPEngine& engine, bool checkHashes)
+{
+	Result result;
+	result.mBlocks = 0;
+	result.mMismatches = 0;
+	result.mFirstMismatch = -1;
+	result.mLateParams = 0;
+	result.mSeconds = 0.;
+	result.mAudioSeconds = 0.;
+
+	const int bufSize = mHeader.mBufferSize;
+	std::vector<float> outputs[kMLEngineMaxChannels];
+	float* pOutputs[kMLEngineMaxChannels] = {0};
+	for(int i=0; i<mHeader.mOutputs; ++i)
+	{
+		outputs[i].resize(bufSize);
+		pOutputs[i] = &outputs[i][0];
+	}
+	MLControlEventVector events;
+	events.reserve(MLEngineCapture::kMaxEvents);
+	std::vector<const unsigned char*> pending;
+	int64_t totalFrames = 0;
+
+	size_t pos = sizeof(MLEngineCaptureHeader);
+	while(pos + kRecordHeaderBytes <= mData.size())
+	{
+		MLEngineCaptureRecord r;
+		memcpy(&r, &mData[pos], sizeof(r));
+		const unsigned char* p = &mData[pos + kRecordHeaderBytes];
+		pos += kRecordHeaderBytes + padded(r.mBytes);
+		if(pos > mData.size()) break;
+
+		switch(r.mType)
+		{
+			case MLEngineCaptureRecord::kParam:
+			{
+				// hold a param until the block it was set before.
+				MLEngineCaptureParam param;
+				memcpy(&param, p, sizeof(param));
+				if(param.mBlock > result.mBlocks)
+				{
+					pending.push_back(p - kRecordHeaderBytes);
+				}
+				else
+				{
+					if(param.mBlock < result.mBlocks)
+					{
+						result.mLateParams++;
+					}
+					applyParam(engine, p, r.mBytes);
+				}
+				break;
+			}
+			case MLEngineCaptureRecord::kFrame:
+			{
+				if(mFrameRing.buffer && ((int)r.mBytes == mHeader.mFrameBytes))
+				{
+					if(!PaUtil_WriteRingBuffer(&mFrameRing, p, 1))
+					{
+						debug() << "MLEngineReplay: frame buffer full!\n";
+					}
+				}
+				break;
+			}
+			case MLEngineCaptureRecord::kBlock:
+			{
+				MLEngineCaptureBlock block;
+				memcpy(&block, p, sizeof(block));
+				p += sizeof(block);
+				if((block.mFrames > bufSize) || (block.mInputs > kMLEngineMaxChannels)) break;
+
+				for(auto it = pending.begin(); it != pending.end(); )
+				{
+					MLEngineCaptureRecord pr;
+					MLEngineCaptureParam param;
+					const unsigned char* pData = *it + kRecordHeaderBytes;
+					memcpy(&pr, *it, sizeof(pr));
+					memcpy(&param, pData, sizeof(param));
+					if(param.mBlock <= result.mBlocks)
+					{
+						applyParam(engine, pData, pr.mBytes);
+						it = pending.erase(it);
+					}
+					else
+					{
+						++it;
+					}
+				}
+
+				events.clear();
+				for(int i=0; i<block.mEvents; ++i)
+				{
+					MLEngineCaptureEvent ce;
+					memcpy(&ce, p, sizeof(ce));
+					p += sizeof(ce);
+					events.push_back(MLControlEvent((MLControlEvent::EventType)ce.mType, ce.mChannel, ce.mID,
+						ce.mTime, ce.mValue1, ce.mValue2));
+				}
+
+				MLDSPEngine::ClientIOMap ioMap;
+				memset(&ioMap, 0, sizeof(ioMap));
+				for(int i=0; i<block.mInputs; ++i)
+				{
+					ioMap.inputs[i] = reinterpret_cast<const float*>(p);
+					p += block.mFrames*sizeof(float);
+				}
+				for(int i=0; i<mHeader.mOutputs; ++i)
+				{
+					std::fill(outputs[i].begin(), outputs[i].end(), 0.f);
+					ioMap.outputs[i] = pOutputs[i];
+				}
+				engine.setIOBuffers(ioMap);
+
+				std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+				engine.processSignalsAndEvents(block.mFrames, events, block.mSamplesPos, block.mSecs,
+					block.mPPQPos, block.mBPM, block.mIsPlaying != 0);
+				std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - t0;
+				result.mSeconds += elapsed.count();
+
+				if(checkHashes && (MLEngineCapture::hashOutputs(pOutputs, mHeader.mOutputs, block.mFrames) != block.mOutputHash))
+				{
+					if(result.mFirstMismatch < 0)
+					{
+						result.mFirstMismatch = result.mBlocks;
+					}
+					result.mMismatches++;
+				}
+				totalFrames += block.mFrames;
+				result.mBlocks++;
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	result.mAudioSeconds = totalFrames/mHeader.mSampleRate;
+	return result;
+}
@@ -0,0 +1,225 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef ML_ENGINE_CAPTURE_H
+#define ML_ENGINE_CAPTURE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "MLControlEvent.h"
+#include "MLGraphDesc.h"
+#include "MLProc.h"
+#include "MLProperty.h"
+#include "MLMPSCQueue.h"
+#include "MLBackgroundWriter.h"
+#include "pa_ringbuffer.h"
+
+class MLDSPEngine;
+
+// MLEngineCapture: records everything that goes into an MLDSPEngine so that a
+// session can be replayed exactly by MLEngineReplay, outside of a host.
+//
+// For each call to processSignalsAndEvents() the engine writes one block record
+// with the transport, control events, audio inputs and a hash of the outputs.
+// The inputs are copied when the block begins, because the host may reuse the
+// input buffers for output. Before each block come records for the published
+// parameters set and the OSC frames read since the block before.
+//
+// Parameters can be set on any thread. Each one is copied into a fixed-size
+// record, stamped with the number of blocks captured so far, and queued without
+// locking or allocating. The audio thread passes the queue on at the start of
+// the next block. On replay, a parameter is applied before the block its stamp
+// names, or as soon as it is read if that block has passed: that happens when
+// it was set while a block was running.
+//
+// As in MLSignalRecorder, the audio thread writes whole records to a lock-free
+// ring and an MLBackgroundWriter appends them to the file. A capture with a gap
+// can't be replayed, so if the ring or the parameter queue is ever full, or a
+// parameter value is too big for its record, the capture ends there.
+//
+// The file is an MLEngineCaptureHeader followed by records. Each record is an
+// MLEngineCaptureRecord followed by its data, padded to 8 bytes.
+
+const uint32_t kMLEngineCaptureMagic = 0x43494c4d; // "MLIC"
+const uint32_t kMLEngineCaptureVersion = 2;
+
+struct MLEngineCaptureHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+	double mSampleRate;
+	int32_t mBufferSize;
+	int32_t mVectorSize;
+	int32_t mInputs;
+	int32_t mOutputs;
+	int32_t mMaxVoices;
+	int32_t mInputProtocol;
+	int32_t mInputDataRate;
+	int32_t mFrameBytes;		// size of an OSC frame, or 0
+	uint64_t mDescHash;		// hash of the graph description
+};
+
+struct MLEngineCaptureRecord
+{
+	enum Type
+	{
+		kBlock = 1,
+		kParam,
+		kFrame
+	};
+
+	uint32_t mType;
+	uint32_t mBytes;		// size of the data following, not including padding
+};
+
+// data for a kBlock record, followed by [mEvents] MLEngineCaptureEvent
+// and [mInputs][mFrames] floats.
+struct MLEngineCaptureBlock
+{
+	int32_t mFrames;
+	int32_t mEvents;
+	int32_t mInputs;
+	int32_t mIsPlaying;
+	int64_t mSamplesPos;
+	double mSecs;
+	double mPPQPos;
+	double mBPM;
+	uint64_t mOutputHash;
+};
+
+struct MLEngineCaptureEvent
+{
+	int32_t mType;
+	int32_t mChannel;
+	int32_t mID;
+	int32_t mTime;
+	float mValue1;
+	float mValue2;
+};
+
+// data for a kParam record, followed by the value: a float, the characters
+// of a string, or the width, height and depth of a signal and its samples.
+struct MLEngineCaptureParam
+{
+	int32_t mIndex;
+	int32_t mPropertyType;
+	int32_t mBlock;		// blocks captured when the param was set
+	int32_t mReserved;
+};
+
+class MLEngineCapture
+{
+public:
+	static const int kMaxEvents = 1024;
+	static const int kMaxParamBytes = 1024;	// largest param value, as written
+	static const int kParamQueueSize = 256;	// must be a power of two
+
+	MLEngineCapture();
+	~MLEngineCapture();
+
+	// open the file and write a header with the engine's current settings. The
+	// engine should be prepared. Then attach with MLDSPEngine::setInputCapture().
+	bool start(const std::string& path, MLDSPEngine& engine, float bufferSeconds = 2.f);
+
+	// stop capturing and close the file. Detach from the engine first.
+	void stop();
+
+	bool isRecording() const { return mWriter.isOpen(); }
+
+	// true if the capture ended early because the writer fell behind.
+	bool didOverflow() const { return mOverflow; }
+	int getBlocks() const { return mBlocks; }
+
+	// any thread: a published parameter was set.
+	void captureParam(int index, const MLProperty& value);
+
+	// audio thread, called by the engine. beginBlock() must be called before the
+	// engine reads its inputs, and endBlock() after it writes its outputs.
+	void beginBlock(const int frames, const float* const* inputs, int numInputs);
+	void captureFrame(const void* pFrame, int bytes);
+	void endBlock(const int frames, const MLControlEventVector& events, const int64_t samplesPos,
+		const double secs, const double ppqPos, const double bpm, bool isPlaying,
+		const float* const* outputs, int numOutputs);
+
+	// hash of the bit patterns of some output channels, as stored in block records.
+	static uint64_t hashOutputs(const float* const* outputs, int numOutputs, int frames);
+
+private:
+	// a param record waiting to be passed on by the audio thread.
+	struct ParamRecord
+	{
+		int32_t mBytes;		// size of mParam and the value
+		MLEngineCaptureParam mParam;
+		unsigned char mValue[kMaxParamBytes];
+	};
+
+	// write a record whose data starts after room for its MLEngineCaptureRecord.
+	bool writeRecord(uint32_t type, unsigned char* pRecord, int bytes);
+	void write();
+	void endCapture();
+
+	// records written by the audio thread, read by the writer.
+	std::vector<unsigned char> mRingData;
+	PaUtilRingBuffer mRing;
+
+	// param records from any thread, read by the audio thread.
+	MLMPSCQueue<ParamRecord, kParamQueueSize> mParamQueue;
+	ParamRecord mAudioParam;
+
+	std::vector<unsigned char> mAudioScratch;
+	std::vector<unsigned char> mWriteScratch;
+
+	// the inputs of the current block, copied by beginBlock().
+	std::vector<float> mInputs;
+	int mInputFrames;
+	int mNumInputs;
+
+	FILE* mpFile;
+	MLBackgroundWriter mWriter;
+	std::atomic<bool> mOverflow;
+	std::atomic<int> mBlocks;
+};
+
+// MLEngineReplay: runs a capture through an engine as fast as it will go.
+
+class MLEngineReplay
+{
+public:
+	struct Result
+	{
+		int mBlocks;
+		int mMismatches;		// blocks whose output hash differs from the capture
+		int mFirstMismatch;		// index of the first, or -1
+		int mLateParams;		// params set while their block was running
+		double mSeconds;		// time spent in processSignalsAndEvents()
+		double mAudioSeconds;	// length of the audio replayed
+	};
+
+	MLEngineReplay();
+	~MLEngineReplay();
+
+	bool load(const std::string& path);
+	const MLEngineCaptureHeader& getHeader() const { return mHeader; }
+
+	// build, compile and prepare an engine from the description with the captured settings.
+	MLProc::err setupEngine(MLDSPEngine& engine, const MLGraphDesc& desc);
+
+	// run all the records through an engine made by setupEngine(). If checkHashes
+	// is true, outputs are compared with those captured.
+	Result run(MLDSPEngine& engine, bool checkHashes = true);
+
+private:
+	MLEngineCaptureHeader mHeader;
+	std::vector<unsigned char> mData;
+
+	// OSC frames are given to the engine through this.
+	std::vector<unsigned char> mFrameRingData;
+	PaUtilRingBuffer mFrameRing;
+};
+
+#endif // ML_ENGINE_CAPTURE_H
@@ -0,0 +1,209 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLEngineSwap.h"
+
+const float MLEngineSwap::kFadeTime = 0.02f;
+
+MLEngineSwap::MLEngineSwap() :
+	mBuilding(false),
+	mSwapping(false),
+	mpReady(0),
+	mpPending(0),
+	mpRetired(0),
+	mpEngine(0),
+	mpFadingEngine(0),
+	mFadeFrames(1),
+	mFadePosition(0)
+{
+}
+
+MLEngineSwap::~MLEngineSwap()
+{
+	joinBuildThread();
+	delete mpReady.exchange(0);
+}
+
+void MLEngineSwap::joinBuildThread()
+{
+	if(mBuildThread.joinable())
+	{
+		mBuildThread.join();
+	}
+}
+
+// ----------------------------------------------------------------
+#pragma mark message thread
+
+bool MLEngineSwap::startBuild(BuildFn fn)
+{
+	if(isBusy()) return false;
+	joinBuildThread();
+	mBuilding = true;
+	mBuildThread = std::thread([this, fn]()
+	{
+		MLDSPEngine* pEngine = fn();
+		mpReady.store(pEngine, std::memory_order_release);
+		mBuilding = false;
+	});
+	return true;
+}
+
+MLDSPEngine* MLEngineSwap::takeReadyEngine()
+{
+	return mpReady.exchange(0, std::memory_order_acquire);
+}
+
+bool MLEngineSwap::commit(MLDSPEngine* pEngine)
+{
+	if(!pEngine) return false;
+
+	// take back any engine still waiting. After this the audio thread can't start a 
+	// fade, so if there is none in progress the fade buffers are free to resize.
+	MLDSPEngine* pWaiting = mpPending.exchange(0, std::memory_order_acquire);
+	if(!pWaiting && mSwapping)
+	{
+		mpReady.store(pEngine, std::memory_order_release);
+		return false;
+	}
+	delete pWaiting;
+	
+	const int bufSize = pEngine->getBufferSize();
+	for(int i=0; i<kMLEngineMaxChannels; ++i)
+	{
+		mFadeBuffers[i].resize(bufSize);
+	}
+	mFadeFrames = std::max(1, (int)(pEngine->getSampleRate()*kFadeTime));
+	mSwapping = true;
+	mpPending.store(pEngine, std::memory_order_release);
+	return true;
+}
+
+void MLEngineSwap::collect()
+{
+	MLDSPEngine* pOld = mpRetired.exchange(0, std::memory_order_acquire);
+	if(pOld)
+	{
+		delete pOld;
+		mSwapping = false;
+	}
+	if(!mBuilding)
+	{
+		joinBuildThread();
+	}
+}
+
+bool MLEngineSwap::isBusy() const
+{
+	const bool fading = mSwapping && (mpPending.load() == 0);
+	return mBuilding || fading || (mpReady.load() != 0);
+}
+
+void MLEngineSwap::reset(MLDSPEngine* pEngine)
+{
+	joinBuildThread();
+	mBuilding = false;
+	delete mpReady.exchange(0);
+
+	// a committed engine is also the caller's engine, so it is not deleted here.
+	MLDSPEngine* pPending = mpPending.exchange(0);
+	MLDSPEngine* pRetired = mpRetired.exchange(0);
+	MLDSPEngine* toDelete[3] = {mpFadingEngine, pRetired, mpEngine};
+	for(int i=0; i<3; ++i)
+	{
+		if(toDelete[i] && (toDelete[i] != pEngine) && (toDelete[i] != pPending))
+		{
+			delete toDelete[i];
+		}
+	}
+	mpFadingEngine = 0;
+	mpEngine = pEngine;
+	mSwapping = false;
+}
+
+// ----------------------------------------------------------------
+#pragma mark audio thread
+
+MLDSPEngine* MLEngineSwap::getAudioEngine()
+{
+	if(!mpFadingEngine)
+	{
+		MLDSPEngine* pNew = mpPending.exchange(0, std::memory_order_acquire);
+		if(pNew)
+		{
+			mpFadingEngine = mpEngine;
+			mpEngine = pNew;
+			mFadePosition = 0;
+			
+			// otherwise the old engine, which runs first, would take the new one's frames.
+			if(mpFadingEngine)
+			{
+				mpFadingEngine->releaseInputFrameBuffer();
+			}
+		}
+	}
+	return mpEngine;
+}
+
+void MLEngineSwap::process(const int frames, const MLControlEventVector& events, const int64_t samplesPos,
+	const double secs, const double ppqPos, const double bpm, bool isPlaying,
+	const MLDSPEngine::ClientIOMap& ioMap, int outputs)
+{
+	if(!mpEngine) return;
+	outputs = std::min(outputs, kMLEngineMaxChannels);
+
+	// run the old engine first, into the fade buffers. inputs and outputs may share
+	// memory, so the new engine must not write its outputs until both have read.
+	bool fading = false;
+	if(mpFadingEngine)
+	{
+		if(frames <= (int)mFadeBuffers[0].size())
+		{
+			MLDSPEngine::ClientIOMap fadeMap = ioMap;
+			for(int i=0; i<outputs; ++i)
+			{
+				fadeMap.outputs[i] = mFadeBuffers[i].data();
+			}
+			mpFadingEngine->setIOBuffers(fadeMap);
+			mpFadingEngine->processSignalsAndEvents(frames, events, samplesPos, secs, ppqPos, bpm, isPlaying);
+			fading = true;
+		}
+		else
+		{
+			// block is too big for the fade buffers: cut over now.
+			mFadePosition = mFadeFrames;
+		}
+	}
+
+	mpEngine->setIOBuffers(ioMap);
+	mpEngine->processSignalsAndEvents(frames, events, samplesPos, secs, ppqPos, bpm, isPlaying);
+
+	if(mpFadingEngine)
+	{
+		if(fading)
+		{
+			const float dg = 1.f/(float)mFadeFrames;
+			for(int i=0; i<outputs; ++i)
+			{
+				float* pOut = ioMap.outputs[i];
+				const float* pOld = mFadeBuffers[i].data();
+				float g = (float)mFadePosition*dg;
+				for(int n=0; n<frames; ++n)
+				{
+					const float gNew = std::min(g, 1.f);
+					pOut[n] = pOut[n]*gNew + pOld[n]*(1.f - gNew);
+					g += dg;
+				}
+			}
+			mFadePosition += frames;
+		}
+
+		if(mFadePosition >= mFadeFrames)
+		{
+			// hand the old engine back to the message thread to be deleted.
+			mpRetired.store(mpFadingEngine, std::memory_order_release);
+			mpFadingEngine = 0;
+		}
+	}
+}
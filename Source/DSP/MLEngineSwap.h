@@ -0,0 +1,102 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef ML_ENGINE_SWAP_H
+#define ML_ENGINE_SWAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "MLDSPEngine.h"
+
+// MLEngineSwap: replaces a running MLDSPEngine with a new one without stopping audio.
+//
+// A new engine is built and prepared by a function run on a background thread.
+// When it is ready, the message thread takes it with takeReadyEngine(), copies any
+// state into it, and passes it to commit(). The audio thread picks it up at the
+// start of its next block in process() and crossfades from the old engine to the
+// new one. The old engine is handed back when the fade is done and deleted by
+// collect() on the message thread, so the audio thread never allocates or frees.
+//
+// If audio is not running, a committed engine waits until it is. It does not block 
+// another build: committing again replaces it, and reset() makes it the running engine.
+// During the fade only the new engine reads OSC frames, and the old one plays out the
+// frames it already has.
+
+class MLEngineSwap
+{
+public:
+	typedef std::function<MLDSPEngine*()> BuildFn;
+
+	// crossfade time in seconds.
+	static const float kFadeTime;
+
+	MLEngineSwap();
+	~MLEngineSwap();
+
+	// ----------------------------------------------------------------
+	// message thread
+
+	// run the build function on a background thread. It should return a prepared
+	// engine, or null on failure. Returns false if a swap is already in progress.
+	bool startBuild(BuildFn fn);
+
+	// if a built engine is ready, return it. The caller owns it until commit().
+	MLDSPEngine* takeReadyEngine();
+
+	// give a ready engine to the audio thread, which will fade to it. A committed engine 
+	// the audio thread has not picked up yet is deleted. Returns false if the audio 
+	// thread is still fading to the last engine, in which case pEngine is ready again
+	// for the next try.
+	bool commit(MLDSPEngine* pEngine);
+
+	// delete an old engine that has been faded out.
+	void collect();
+
+	// is a build or fade in progress? A committed engine waiting for audio to run is not.
+	bool isBusy() const;
+
+	// is a committed engine waiting to be picked up, faded to, or collected?
+	bool isSwapping() const { return mSwapping; }
+
+	// with audio stopped, drop any swap in progress and make pEngine the running engine.
+	// any other engines owned by the swap are deleted.
+	void reset(MLDSPEngine* pEngine);
+
+	// ----------------------------------------------------------------
+	// audio thread
+
+	// the engine that will run in the next call to process(). This is where a
+	// committed engine is picked up, so call this once at the start of each block.
+	MLDSPEngine* getAudioEngine();
+
+	// run the engine, and during a swap the old one too, crossfading their outputs.
+	void process(const int frames, const MLControlEventVector& events, const int64_t samplesPos,
+		const double secs, const double ppqPos, const double bpm, bool isPlaying,
+		const MLDSPEngine::ClientIOMap& ioMap, int outputs);
+
+private:
+	void joinBuildThread();
+
+	std::thread mBuildThread;
+	std::atomic<bool> mBuilding;
+	std::atomic<bool> mSwapping;
+	std::atomic<MLDSPEngine*> mpReady;
+	std::atomic<MLDSPEngine*> mpPending;
+	std::atomic<MLDSPEngine*> mpRetired;
+
+	// audio thread only, except in reset()
+	MLDSPEngine* mpEngine;
+	MLDSPEngine* mpFadingEngine;
+	int mFadeFrames;
+	int mFadePosition;
+
+	// outputs of the old engine while fading, allocated in commit().
+	std::vector<float> mFadeBuffers[kMLEngineMaxChannels];
+};
+
+#endif // ML_ENGINE_SWAP_H
@@ -0,0 +1,338 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLGraphCache.h"
+#include "MLDebug.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// ----------------------------------------------------------------
+#pragma mark MLCompiledGraph
+
+namespace
+{
+	const uint32_t kGraphFileMagic = 0x43474c4d; // "MLGC"
+	
+	// longest signal name read from a file.
+	const int32_t kMaxSignalName = 256;
+
+	template<typename T>
+	void writeValue(std::vector<unsigned char>& out, T val)
+	{
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(&val);
+		out.insert(out.end(), p, p + sizeof(T));
+	}
+
+	template<typename T>
+	bool readValue(const std::vector<unsigned char>& in, size_t& pos, T& val)
+	{
+		if(pos + sizeof(T) > in.size()) return false;
+		memcpy(&val, &in[pos], sizeof(T));
+		pos += sizeof(T);
+		return true;
+	}
+
+	void writeString(std::vector<unsigned char>& out, const std::string& str)
+	{
+		writeValue(out, (int32_t)str.size());
+		out.insert(out.end(), str.begin(), str.end());
+	}
+
+	bool readString(const std::vector<unsigned char>& in, size_t& pos, std::string& str)
+	{
+		int32_t n;
+		if(!readValue(in, pos, n) || (n < 0) || (n > kMaxSignalName) || (pos + n > in.size())) return false;
+		str.assign(reinterpret_cast<const char*>(&in[pos]), n);
+		pos += n;
+		return true;
+	}
+}
+
+const uint32_t MLCompiledGraph::kFormatVersion;
+
+void MLCompiledGraph::write(std::vector<unsigned char>& out) const
+{
+	writeValue(out, kGraphFileMagic);
+	writeValue(out, kFormatVersion);
+	writeValue(out, mKey);
+	writeValue(out, (int32_t)mContainers.size());
+	for(int i=0; i<(int)mContainers.size(); ++i)
+	{
+		const Container& c = mContainers[i];
+		writeValue(out, (int32_t)c.mProcs);
+		writeValue(out, (int32_t)c.mPipes);
+		writeValue(out, (int32_t)c.mBuffers.size());
+		for(int j=0; j<(int)c.mBuffers.size(); ++j)
+		{
+			writeString(out, c.mSignals[j]);
+			writeValue(out, (int32_t)c.mBuffers[j]);
+		}
+	}
+}
+
+bool MLCompiledGraph::read(const std::vector<unsigned char>& in)
+{
+	size_t pos = 0;
+	uint32_t magic, version;
+	uint64_t key;
+	int32_t containers;
+	mContainers.clear();
+	if(!readValue(in, pos, magic) || (magic != kGraphFileMagic)) return false;
+	if(!readValue(in, pos, version) || (version != kFormatVersion)) return false;
+	if(!readValue(in, pos, key) || (key != mKey)) return false;
+	if(!readValue(in, pos, containers) || (containers < 0)) return false;
+
+	mContainers.resize(containers);
+	for(int i=0; i<containers; ++i)
+	{
+		Container& c = mContainers[i];
+		int32_t procs, pipes, n;
+		
+		// each signal takes at least a name length and a buffer index.
+		if(!readValue(in, pos, procs) || !readValue(in, pos, pipes) || !readValue(in, pos, n) ||
+			(n < 0) || (pos + n*2*sizeof(int32_t) > in.size()))
+		{
+			mContainers.clear();
+			return false;
+		}
+		c.mProcs = procs;
+		c.mPipes = pipes;
+		c.mSignals.resize(n);
+		c.mBuffers.resize(n);
+		for(int j=0; j<n; ++j)
+		{
+			int32_t b;
+			if(!readString(in, pos, c.mSignals[j]) || !readValue(in, pos, b))
+			{
+				mContainers.clear();
+				return false;
+			}
+			c.mBuffers[j] = b;
+		}
+	}
+	return (pos == in.size());
+}
+
+// ----------------------------------------------------------------
+#pragma mark MLCompileCursor
+
+const MLCompiledGraph::Container* MLCompileCursor::next(int procs, int pipes, int signals)
+{
+	const MLCompiledGraph::Container* r = 0;
+	if(mpCached)
+	{
+		if(mIndex < mpCached->getNumContainers())
+		{
+			const MLCompiledGraph::Container& c = mpCached->getContainer(mIndex);
+			if((c.mProcs == procs) && (c.mPipes == pipes) && ((int)c.mBuffers.size() == signals))
+			{
+				r = &c;
+			}
+		}
+		if(!r)
+		{
+			mMisses++;
+		}
+	}
+	mIndex++;
+	return r;
+}
+
+void MLCompileCursor::record(int procs, int pipes, const std::vector<std::string>& signals, const std::vector<int>& buffers)
+{
+	if(!mpRecord) return;
+	MLCompiledGraph::Container c;
+	c.mProcs = procs;
+	c.mPipes = pipes;
+	c.mSignals = signals;
+	c.mBuffers = buffers;
+	mpRecord->addContainer(c);
+}
+
+// ----------------------------------------------------------------
+#pragma mark MLGraphCache
+
+const int MLGraphCache::kMaxDescriptions;
+const int MLGraphCache::kMaxGraphs;
+
+namespace
+{
+	// if the map has more than maxSize entries, remove the ones only the map uses.
+	template<typename T>
+	void trimUnused(std::map<uint64_t, std::shared_ptr<T> >& m, int maxSize)
+	{
+		if((int)m.size() <= maxSize) return;
+		for(typename std::map<uint64_t, std::shared_ptr<T> >::iterator it = m.begin(); it != m.end(); )
+		{
+			if(it->second.use_count() == 1)
+			{
+				m.erase(it++);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+}
+
+std::shared_ptr<const MLGraphDesc> MLGraphCache::getDescription(const char* text)
+{
+	const uint64_t hash = MLGraphDesc::hashText(text);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		std::map<uint64_t, std::shared_ptr<const MLGraphDesc> >::const_iterator it = mDescriptions.find(hash);
+		if(it != mDescriptions.end())
+		{
+			return it->second;
+		}
+	}
+
+	// parse outside the lock. if another instance parses the same text
+	// meanwhile, the first one stored is kept.
+	std::shared_ptr<MLGraphDesc> pDesc(new MLGraphDesc);
+	if(pDesc->parseXML(text))
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		std::pair<std::map<uint64_t, std::shared_ptr<const MLGraphDesc> >::iterator, bool> r =
+			mDescriptions.insert(std::make_pair(hash, std::shared_ptr<const MLGraphDesc>(pDesc)));
+		std::shared_ptr<const MLGraphDesc> stored = r.first->second;
+		trimUnused(mDescriptions, kMaxDescriptions);
+		return stored;
+	}
+	return pDesc;
+}
+
+uint64_t MLGraphCache::makeKey(uint64_t descHash, double sampleRate, int chunkSize, int voices)
+{
+	// FNV-1a over the settings, starting from the description hash.
+	const int64_t settings[4] = {(int64_t)llround(sampleRate*1000.), chunkSize, voices, MLCompiledGraph::kFormatVersion};
+	uint64_t h = descHash;
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(settings);
+	for(size_t i=0; i<sizeof(settings); ++i)
+	{
+		h ^= p[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+MLCompiledGraphPtr MLGraphCache::findGraph(uint64_t key)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::map<uint64_t, MLCompiledGraphPtr>::const_iterator it = mGraphs.find(key);
+	if(it != mGraphs.end())
+	{
+		return it->second;
+	}
+	if(mDirectory.empty())
+	{
+		return MLCompiledGraphPtr();
+	}
+
+	// try a graph saved in an earlier session.
+	MLCompiledGraphPtr r;
+	FILE* f = fopen(getFileName(key).c_str(), "rb");
+	if(f)
+	{
+		std::vector<unsigned char> data;
+		unsigned char buf[4096];
+		size_t n;
+		while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		{
+			data.insert(data.end(), buf, buf + n);
+		}
+		fclose(f);
+
+		std::shared_ptr<MLCompiledGraph> pGraph(new MLCompiledGraph(key));
+		if(pGraph->read(data))
+		{
+			r = pGraph;
+			mGraphs[key] = r;
+			trimUnused(mGraphs, kMaxGraphs);
+		}
+		else
+		{
+			debug() << "MLGraphCache: could not read " << getFileName(key) << "\n";
+		}
+	}
+	return r;
+}
+
+void MLGraphCache::addGraph(MLCompiledGraphPtr pGraph)
+{
+	if(!pGraph) return;
+	std::lock_guard<std::mutex> lock(mMutex);
+	const uint64_t key = pGraph->getKey();
+	if(mGraphs.find(key) != mGraphs.end()) return;
+	mGraphs[key] = pGraph;
+	trimUnused(mGraphs, kMaxGraphs);
+
+	if(!mDirectory.empty())
+	{
+		std::vector<unsigned char> data;
+		pGraph->write(data);
+		writeFile(key, data);
+	}
+}
+
+void MLGraphCache::writeFile(uint64_t key, const std::vector<unsigned char>& data) const
+{
+	// a temporary name no other writer will use.
+	const std::string name = getFileName(key);
+	char suffix[48];
+	snprintf(suffix, sizeof(suffix), ".%llx.tmp", 
+		(unsigned long long)std::chrono::steady_clock::now().time_since_epoch().count());
+	const std::string tempName = name + suffix;
+
+	FILE* f = fopen(tempName.c_str(), "wb");
+	if(!f) return;
+	const bool written = (fwrite(&data[0], 1, data.size(), f) == data.size());
+	const bool closed = (fclose(f) == 0);
+	if(!written || !closed)
+	{
+		remove(tempName.c_str());
+		return;
+	}
+	
+	// rename() replaces the file where it can. Where it can't, remove the old file first.
+	if(rename(tempName.c_str(), name.c_str()) != 0)
+	{
+		remove(name.c_str());
+		if(rename(tempName.c_str(), name.c_str()) != 0)
+		{
+			debug() << "MLGraphCache: could not write " << name << "\n";
+			remove(tempName.c_str());
+		}
+	}
+}
+
+void MLGraphCache::setDirectory(const std::string& dir)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mDirectory = dir;
+}
+
+void MLGraphCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mDescriptions.clear();
+	mGraphs.clear();
+}
+
+std::string MLGraphCache::getFileName(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.mlgraph", (unsigned long long)key);
+	return mDirectory + "/" + name;
+}
+
+MLGraphCache& theGraphCache()
+{
+	static MLGraphCache theGraphCacheObject;
+	return theGraphCacheObject;
+}
@@ -0,0 +1,140 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef ML_GRAPH_CACHE_H
+#define ML_GRAPH_CACHE_H
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "MLGraphDesc.h"
+
+// MLCompiledGraph: the parts of a compiled graph that don't depend on the
+// processor objects themselves. For each container, in the order compile()
+// finishes them, this is the index of the shared buffer that each of its
+// signals was packed into, by signal name. Signal names are made in graph
+// order, so they are the same in every session, unlike symbol IDs. A graph 
+// with the same description and engine settings compiles to the same 
+// assignments, so later instances can skip lifespan packing.
+//
+// The procs, pipes and published params and signals are all made from the
+// description, which is cached separately. Each instance still makes its
+// own procs and buffers.
+
+class MLCompiledGraph
+{
+public:
+	// the version of the binary form and of the compiler that makes the records.
+	// Change it when either changes, so that old records are not used.
+	static const uint32_t kFormatVersion = 2;
+
+	struct Container
+	{
+		int mProcs;
+		int mPipes;
+		std::vector<std::string> mSignals;
+		std::vector<int> mBuffers;	// parallel to mSignals
+	};
+
+	MLCompiledGraph(uint64_t key) : mKey(key) {}
+	~MLCompiledGraph() {}
+
+	uint64_t getKey() const { return mKey; }
+	int getNumContainers() const { return (int)mContainers.size(); }
+	const Container& getContainer(int i) const { return mContainers[i]; }
+	void addContainer(const Container& c) { mContainers.push_back(c); }
+
+	// binary form for saving between sessions. Values are stored in native
+	// byte order, so files are only for the machine that wrote them.
+	void write(std::vector<unsigned char>& out) const;
+	bool read(const std::vector<unsigned char>& in);
+
+private:
+	uint64_t mKey;
+	std::vector<Container> mContainers;
+};
+
+typedef std::shared_ptr<const MLCompiledGraph> MLCompiledGraphPtr;
+
+// MLCompileCursor: used by MLProcContainer::compile() to replay the
+// assignments of a cached graph, or to record a new one. Each container
+// asks for the next record in turn. A record that doesn't match the
+// container being compiled, or that the container finds is not a valid 
+// packing, is ignored and the container is packed as usual.
+
+class MLCompileCursor
+{
+public:
+	MLCompileCursor(const MLCompiledGraph* pCached, MLCompiledGraph* pRecord) :
+		mpCached(pCached), mpRecord(pRecord), mIndex(0), mMisses(0) {}
+
+	// the record for the next container, or null if there is none.
+	const MLCompiledGraph::Container* next(int procs, int pipes, int signals);
+	void record(int procs, int pipes, const std::vector<std::string>& signals, const std::vector<int>& buffers);
+
+	// count a record returned by next() that the container could not use.
+	void reject() { mMisses++; }
+
+	bool isReplaying() const { return mpCached != 0; }
+	int getMisses() const { return mMisses; }
+
+private:
+	const MLCompiledGraph* mpCached;
+	MLCompiledGraph* mpRecord;
+	int mIndex;
+	int mMisses;
+};
+
+// MLGraphCache: parsed descriptions and compiled graphs shared by all the
+// engines in a process, so that many plugin instances made from the same
+// graph parse and pack it once. If a directory is set, compiled graphs are
+// also saved there and read back in later sessions. Each file is written 
+// under a temporary name and renamed when complete, so a crash or another
+// process reading at the same time never sees part of one.
+//
+// Entries still in use are always kept. Past kMaxDescriptions or kMaxGraphs, 
+// entries no longer used outside the cache are dropped when new ones are added.
+
+class MLGraphCache
+{
+public:
+	static const int kMaxDescriptions = 16;
+	static const int kMaxGraphs = 64;
+
+	MLGraphCache() {}
+	~MLGraphCache() {}
+
+	// return the parsed description of the text, parsing it if needed.
+	// Descriptions with errors are returned but not kept.
+	std::shared_ptr<const MLGraphDesc> getDescription(const char* text);
+
+	// a key for a graph compiled from the description with the given hash
+	// and engine settings, by the current version of the compiler.
+	static uint64_t makeKey(uint64_t descHash, double sampleRate, int chunkSize, int voices);
+
+	MLCompiledGraphPtr findGraph(uint64_t key);
+	void addGraph(MLCompiledGraphPtr pGraph);
+
+	void setDirectory(const std::string& dir);
+	void clear();
+
+private:
+	std::string getFileName(uint64_t key) const;
+	void writeFile(uint64_t key, const std::vector<unsigned char>& data) const;
+
+	std::mutex mMutex;
+	std::map<uint64_t, std::shared_ptr<const MLGraphDesc> > mDescriptions;
+	std::map<uint64_t, MLCompiledGraphPtr> mGraphs;
+	std::string mDirectory;
+};
+
+// the cache shared by the whole application or plugin.
+//
+extern MLGraphCache& theGraphCache();
+
+#endif // ML_GRAPH_CACHE_H
@@ -0,0 +1,261 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLGraphDesc.h"
+#include "MLDebug.h"
+#include "tinyxml.h"
+
+#include <cstdlib>
+#include <sstream>
+
+// ----------------------------------------------------------------
+#pragma mark MLGraphDesc::Node
+
+MLSymbol MLGraphDesc::Node::getTag() const
+{
+	return mpDesc ? mpDesc->mNodes[mIndex].mTag : MLSymbol();
+}
+
+MLGraphDesc::Node MLGraphDesc::Node::getFirstChild() const
+{
+	if(!mpDesc) return Node();
+	const int c = mpDesc->mNodes[mIndex].mFirstChild;
+	return (c >= 0) ? Node(mpDesc, c) : Node();
+}
+
+MLGraphDesc::Node MLGraphDesc::Node::getNextSibling() const
+{
+	if(!mpDesc) return Node();
+	const int s = mpDesc->mNodes[mIndex].mNextSibling;
+	return (s >= 0) ? Node(mpDesc, s) : Node();
+}
+
+int MLGraphDesc::Node::getNumAttrs() const
+{
+	return mpDesc ? mpDesc->mNodes[mIndex].mNumAttrs : 0;
+}
+
+MLSymbol MLGraphDesc::Node::getAttrName(int i) const
+{
+	return mpDesc->mAttrs[mpDesc->mNodes[mIndex].mFirstAttr + i].mName;
+}
+
+const std::string& MLGraphDesc::Node::getAttrText(int i) const
+{
+	return mpDesc->mAttrs[mpDesc->mNodes[mIndex].mFirstAttr + i].mText;
+}
+
+double MLGraphDesc::Node::getAttrValue(int i) const
+{
+	return mpDesc->mAttrs[mpDesc->mNodes[mIndex].mFirstAttr + i].mValue;
+}
+
+int MLGraphDesc::Node::findAttr(MLSymbol name) const
+{
+	const int n = getNumAttrs();
+	for(int i=0; i<n; ++i)
+	{
+		if(getAttrName(i) == name) return i;
+	}
+	return -1;
+}
+
+bool MLGraphDesc::Node::hasAttr(MLSymbol name) const
+{
+	return findAttr(name) >= 0;
+}
+
+const std::string& MLGraphDesc::Node::getStringAttr(MLSymbol name) const
+{
+	static const std::string nullString;
+	const int i = findAttr(name);
+	return (i >= 0) ? getAttrText(i) : nullString;
+}
+
+double MLGraphDesc::Node::getDoubleAttr(MLSymbol name, double defaultValue) const
+{
+	const int i = findAttr(name);
+	return (i >= 0) ? getAttrValue(i) : defaultValue;
+}
+
+int MLGraphDesc::Node::getIntAttr(MLSymbol name, int defaultValue) const
+{
+	const int i = findAttr(name);
+	return (i >= 0) ? (int)strtol(getAttrText(i).c_str(), 0, 10) : defaultValue;
+}
+
+MLSymbol MLGraphDesc::Node::getSymbolAttr(MLSymbol name) const
+{
+	const int i = findAttr(name);
+	return (i >= 0) ? MLSymbol(getAttrText(i).c_str()) : MLSymbol();
+}
+
+MLPath MLGraphDesc::Node::getPathAttr(MLSymbol name) const
+{
+	const int i = findAttr(name);
+	return (i >= 0) ? MLPath(getAttrText(i).c_str()) : MLPath();
+}
+
+// ----------------------------------------------------------------
+#pragma mark MLGraphDesc
+
+MLGraphDesc::MLGraphDesc() :
+	mHash(0)
+{
+}
+
+MLGraphDesc::~MLGraphDesc()
+{
+}
+
+void MLGraphDesc::clear()
+{
+	mNodes.clear();
+	mAttrs.clear();
+	mError.clear();
+	mHash = 0;
+}
+
+// 64-bit FNV-1a.
+uint64_t MLGraphDesc::hashText(const char* text)
+{
+	uint64_t h = 14695981039346656037ULL;
+	if(!text) return h;
+	for(const unsigned char* p = (const unsigned char*)text; *p; ++p)
+	{
+		h ^= *p;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+MLGraphDesc::Node MLGraphDesc::getRoot() const
+{
+	return mNodes.empty() ? Node() : Node(this, 0);
+}
+
+int MLGraphDesc::addNodeData(int parent, MLSymbol tag)
+{
+	NodeData n;
+	n.mTag = tag;
+	n.mFirstAttr = (int)mAttrs.size();
+	n.mNumAttrs = 0;
+	n.mFirstChild = -1;
+	n.mLastChild = -1;
+	n.mNextSibling = -1;
+	const int index = (int)mNodes.size();
+	mNodes.push_back(n);
+
+	if(parent >= 0)
+	{
+		NodeData& p = mNodes[parent];
+		if(p.mLastChild >= 0)
+		{
+			mNodes[p.mLastChild].mNextSibling = index;
+		}
+		else
+		{
+			p.mFirstChild = index;
+		}
+		p.mLastChild = index;
+	}
+	return index;
+}
+
+MLGraphDesc::Node MLGraphDesc::addNode(const Node& parent, MLSymbol tag)
+{
+	return Node(this, addNodeData(parent ? parent.mIndex : -1, tag));
+}
+
+void MLGraphDesc::addAttr(const Node& node, MLSymbol name, const std::string& text)
+{
+	// attributes of a node are stored together, so they can only be added
+	// to the last node.
+	if(node.mIndex != (int)mNodes.size() - 1)
+	{
+		debug() << "MLGraphDesc::addAttr: " << name << " not added to last node!\n";
+		return;
+	}
+	AttrData a;
+	a.mName = name;
+	a.mText = text;
+	a.mValue = strtod(text.c_str(), 0);
+	mAttrs.push_back(a);
+	mNodes[node.mIndex].mNumAttrs++;
+}
+
+void MLGraphDesc::addAttr(const Node& node, MLSymbol name, double value)
+{
+	std::ostringstream s;
+	s.precision(17);
+	s << value;
+	addAttr(node, name, s.str());
+}
+
+namespace
+{
+	// add the elements under pElem to the description, depth first.
+	void addElement(MLGraphDesc& desc, const MLGraphDesc::Node& parent, const TiXmlElement* pElem)
+	{
+		MLGraphDesc::Node node = desc.addNode(parent, MLSymbol(pElem->Value()));
+		for(const TiXmlAttribute* pAttr = pElem->FirstAttribute(); pAttr; pAttr = pAttr->Next())
+		{
+			desc.addAttr(node, MLSymbol(pAttr->Name()), std::string(pAttr->Value()));
+		}
+		for(const TiXmlElement* pChild = pElem->FirstChildElement(); pChild; pChild = pChild->NextSiblingElement())
+		{
+			addElement(desc, node, pChild);
+		}
+	}
+
+	int countElements(const TiXmlElement* pElem, int* pAttrs)
+	{
+		int n = 1;
+		for(const TiXmlAttribute* pAttr = pElem->FirstAttribute(); pAttr; pAttr = pAttr->Next())
+		{
+			(*pAttrs)++;
+		}
+		for(const TiXmlElement* pChild = pElem->FirstChildElement(); pChild; pChild = pChild->NextSiblingElement())
+		{
+			n += countElements(pChild, pAttrs);
+		}
+		return n;
+	}
+}
+
+bool MLGraphDesc::parseXML(const char* text)
+{
+	clear();
+	if(!text)
+	{
+		mError = "no description";
+		return false;
+	}
+
+	TiXmlDocument doc;
+	doc.Parse(text, 0, TIXML_ENCODING_UTF8);
+	if(doc.Error())
+	{
+		std::ostringstream s;
+		s << doc.ErrorDesc() << " at line " << doc.ErrorRow() << ", column " << doc.ErrorCol();
+		mError = s.str();
+		return false;
+	}
+
+	const TiXmlElement* pRoot = doc.RootElement();
+	if(!pRoot)
+	{
+		mError = "no document element";
+		return false;
+	}
+
+	// size the arrays once, then copy the tree depth first.
+	int attrs = 0;
+	int nodes = countElements(pRoot, &attrs);
+	mNodes.reserve(nodes);
+	mAttrs.reserve(attrs);
+	addElement(*this, Node(), pRoot);
+	mHash = hashText(text);
+	return true;
+}
@@ -0,0 +1,112 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef ML_GRAPH_DESC_H
+#define ML_GRAPH_DESC_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "MLSymbol.h"
+#include "MLPath.h"
+
+// MLGraphDesc: a parsed description of a DSP graph, independent of JUCE.
+// The XML text is parsed once into flat arrays of nodes and attributes.
+// Tag and attribute names are stored as symbols and attribute values are
+// converted to numbers when parsed, so that building the graph doesn't go
+// back to the text.
+//
+// MLProcContainer builds graphs from these nodes, walking children with
+// getFirstChild() and getNextSibling().
+
+class MLGraphDesc
+{
+public:
+	// a lightweight handle to one node of a description. A null node is false.
+	class Node
+	{
+	friend class MLGraphDesc;
+	public:
+		Node() : mpDesc(0), mIndex(-1) {}
+		operator bool() const { return mpDesc != 0; }
+
+		MLSymbol getTag() const;
+		bool hasTag(const char* tag) const { return getTag() == MLSymbol(tag); }
+		Node getFirstChild() const;
+		Node getNextSibling() const;
+
+		// attributes by position, in document order.
+		int getNumAttrs() const;
+		MLSymbol getAttrName(int i) const;
+		const std::string& getAttrText(int i) const;
+		double getAttrValue(int i) const;
+
+		// attributes by name. Missing attributes return the default argument.
+		bool hasAttr(MLSymbol name) const;
+		const std::string& getStringAttr(MLSymbol name) const;
+		double getDoubleAttr(MLSymbol name, double defaultValue = 0.) const;
+		int getIntAttr(MLSymbol name, int defaultValue = 0) const;
+		MLSymbol getSymbolAttr(MLSymbol name) const;
+		MLPath getPathAttr(MLSymbol name) const;
+
+	private:
+		Node(const MLGraphDesc* pDesc, int index) : mpDesc(pDesc), mIndex(index) {}
+		int findAttr(MLSymbol name) const;
+
+		const MLGraphDesc* mpDesc;
+		int mIndex;
+	};
+
+	MLGraphDesc();
+	~MLGraphDesc();
+
+	// parse an XML description, replacing any current contents. On failure
+	// returns false, and getError() describes the problem.
+	bool parseXML(const char* text);
+	const std::string& getError() const { return mError; }
+
+	// a hash of the text last parsed, or 0 for descriptions built in code.
+	uint64_t getHash() const { return mHash; }
+	static uint64_t hashText(const char* text);
+
+	// the document element, or a null node if nothing has been parsed.
+	Node getRoot() const;
+
+	// build descriptions in code. Attributes are added to the node most
+	// recently added. Returns the new node.
+	Node addNode(const Node& parent, MLSymbol tag);
+	void addAttr(const Node& node, MLSymbol name, const std::string& text);
+	void addAttr(const Node& node, MLSymbol name, double value);
+
+	void clear();
+	bool isEmpty() const { return mNodes.empty(); }
+
+private:
+	struct NodeData
+	{
+		MLSymbol mTag;
+		int mFirstAttr;
+		int mNumAttrs;
+		int mFirstChild;
+		int mLastChild;
+		int mNextSibling;
+	};
+
+	struct AttrData
+	{
+		MLSymbol mName;
+		std::string mText;
+		double mValue;
+	};
+
+	int addNodeData(int parent, MLSymbol tag);
+
+	std::vector<NodeData> mNodes;
+	std::vector<AttrData> mAttrs;
+	std::string mError;
+	uint64_t mHash;
+};
+
+#endif // ML_GRAPH_DESC_H
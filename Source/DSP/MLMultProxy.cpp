@@ -35,6 +35,7 @@ void MLMultProxy::setCopies(const int newSize)
 		if (newSize != oldSize)
 		{
 			mCopies.resize(newSize);
+			mSumInputs.resize(newSize);
             // initialize new copies
             MLSymbol className = mTemplate->getClassName();
             MLSymbol procName = mTemplate->getName();
@@ -155,12 +156,11 @@ void MLMultiProc::process(const int n)
 	for (int i=1; i <= outs; ++i)
 	{
 		// sum outputs of copies to our MLProc output.
-		MLSignal& out = MLProc::getOutput(i);
-		out.clear();
 		for(int j=0; j < mEnabledCopies; ++j)
 		{
-			out.add(mCopies[j]->getOutput(i));
+			mSumInputs[j] = &mCopies[j]->getOutput(i);
 		}
+		MLProc::getOutput(i).setToSum(mSumInputs.data(), mEnabledCopies);
 	}
 }
 
@@ -309,7 +309,11 @@ namespace multiContainer
 	MLProcOutput<MLMultiContainer> outputs[] = {"*"};
 }
 
-MLMultiContainer::MLMultiContainer() //: theProcFactory(MLProcFactory::theFactory())
+const float MLMultiContainer::kSleepThreshold = 0.00001f; // -100 dB
+
+MLMultiContainer::MLMultiContainer() : //: theProcFactory(MLProcFactory::theFactory())
+	mSleepTime(0.f),
+	mSleepFrames(0)
 {
 }
 
@@ -375,46 +379,176 @@ void MLMultiContainer::collectStats(MLSignalStats* pStats)
 
 void MLMultiContainer::process(const int n)
 {
-	const int outs = getNumOutputs();
+	wakeCopies();
 	
-	// for each copy, process.  
+	// for each awake copy, process.  
 	// TODO this can be dispatched to multiple threads.
 	for (int i=0; i < mEnabledCopies; ++i)
 	{
-		getCopyAsContainer(i)->process(n);
+		if (!mCopyAsleep[i])
+		{
+			getCopyAsContainer(i)->process(n);
+		}
+	}
+	sumCopyOutputs();
+	sleepSilentCopies(n);
+}
+
+// all copies are added, because the number of enabled copies can change 
+// without the list being remade. the guard op of each copy skips it when
+// it is asleep, and the copy's own guard skips it when it is disabled.
+void MLMultiContainer::addFlatOps(MLFlatOpList& ops, const int frames)
+{
+	ops.addOp(&wakeCopiesFlat, this, frames);
+	
+	const int copies = (int)mCopies.size();
+	for (int i=0; i < copies; ++i)
+	{
+		MLProcContainer* pCopy = getCopyAsContainer(i);
+		const int guardIdx = ops.addGuard(&isCopyAwakeFlat, pCopy);
+		const int start = ops.size();
+		pCopy->addFlatOps(ops, frames);
+		ops.setGuardLength(guardIdx, ops.size() - start);
 	}
+	ops.addOp(&sumCopyOutputsFlat, this, frames);
+}
+
+int MLMultiContainer::sumCopyOutputsFlat(void* pState, const int frames)
+{
+	MLMultiContainer* pM = static_cast<MLMultiContainer*>(pState);
+	pM->sumCopyOutputs();
+	pM->sleepSilentCopies(frames);
+	return 0;
+}
+
+void MLMultiContainer::sumCopyOutputs()
+{
+	const int outs = getNumOutputs();
     
 	// for each of our outputs,
 	for (int i=1; i <= outs; ++i)
 	{
-		// sum outputs of copies to our output.
-		MLSignal& y = getOutput(i);
-		y.clear();
-                
+		// sum outputs of copies to our output in one pass. setToSum() reads all of its 
+		// inputs before writing, so a copy that shares a buffer with the parent is OK. 
+		int sumInputs = 0;
 		for(int j=0; j < mEnabledCopies; ++j)
 		{
-            // TODO rewrite to handle multiple outputs better.
-            // right now if the last copy is enabled, it shares a buffer with the
-            // parent and this add doubles the last value. the hack in place adds one more copy to prevent this. 
+			if (mCopyAsleep[j]) continue;
             MLProcContainer* pCopy = getCopyAsContainer(j);
             if(pCopy)
             {
-                y.add(pCopy->getOutput(i));
+                mSumInputs[sumInputs++] = &pCopy->getOutput(i);
             }
             else
             {
                 debug() << "MLMultiContainer: null copy in process()!\n";
             }
  		}
+		getOutput(i).setToSum(mSumInputs.data(), sumInputs);
     }
 }
 
+// ----------------------------------------------------------------
+#pragma mark voice sleep
+
+void MLMultiContainer::setCopyGate(int copy, const MLSignal* pGate)
+{
+	resizeSleepState();
+	if (within(copy, 0, (int)mCopyGates.size()))
+	{
+		mCopyGates[copy] = pGate;
+		mCopyAsleep[copy] = false;
+		mCopySilentFrames[copy] = 0;
+	}
+}
+
+void MLMultiContainer::setSleepTime(float seconds)
+{
+	resizeSleepState();
+	mSleepTime = max(seconds, 0.f);
+	mSleepFrames = (int)(mSleepTime * getContextSampleRate());
+	if (!mSleepFrames)
+	{
+		std::fill(mCopyAsleep.begin(), mCopyAsleep.end(), false);
+	}
+}
+
+void MLMultiContainer::resizeSleepState()
+{
+	const int copies = (int)mCopies.size();
+	mCopyGates.resize(copies, 0);
+	mCopySilentFrames.resize(copies, 0);
+	mCopyAsleep.resize(copies, false);
+}
+
+// wake any sleeping copies whose gates have gone on.
+void MLMultiContainer::wakeCopies()
+{
+	for (int i=0; i < mEnabledCopies; ++i)
+	{
+		if (mCopyAsleep[i] && (mCopyGates[i]->getAbsMax() > 0.f))
+		{
+			mCopyAsleep[i] = false;
+			mCopySilentFrames[i] = 0;
+		}
+	}
+}
+
+// after processing, count frames of silence for each awake copy with a gate, and
+// put the copy to sleep if it has been silent for long enough.
+void MLMultiContainer::sleepSilentCopies(const int frames)
+{
+	if (!mSleepFrames) return;
+	const int outs = getNumOutputs();
+	for (int i=0; i < mEnabledCopies; ++i)
+	{
+		if (mCopyAsleep[i] || !mCopyGates[i]) continue;
+		
+		MLProcContainer* pCopy = getCopyAsContainer(i);
+		bool active = (mCopyGates[i]->getAbsMax() > 0.f);
+		for (int j=1; (j <= outs) && !active; ++j)
+		{
+			active = (pCopy->getOutput(j).getAbsMax() >= kSleepThreshold);
+		}
+		
+		if (active)
+		{
+			mCopySilentFrames[i] = 0;
+		}
+		else
+		{
+			mCopySilentFrames[i] += frames;
+			if (mCopySilentFrames[i] >= mSleepFrames)
+			{
+				pCopy->clearProc();
+				mCopyAsleep[i] = true;
+			}
+		}
+	}
+}
+
+int MLMultiContainer::wakeCopiesFlat(void* pState, const int)
+{
+	static_cast<MLMultiContainer*>(pState)->wakeCopies();
+	return 0;
+}
+
+bool MLMultiContainer::isCopyAwakeFlat(void* pState)
+{
+	MLProcContainer* pCopy = static_cast<MLProcContainer*>(pState);
+	MLMultiContainer* pM = static_cast<MLMultiContainer*>(pCopy->getContext());
+	return pM->isCopyAwake(pCopy->getCopyIndex() - 1);
+}
+
 // Setup internal buffers and data to prepare for processing any attached input signals.
 //
 MLProc::err MLMultiContainer::prepareToProcess()
 {
 	err e = OK;
 	
+	// sample rate may have changed.
+	setSleepTime(mSleepTime);
+	
 	// prepareToProcess must set up MLProcContainer context before it is called
 	// on copies.  The copies refer to MLProcContainer context rate, etc.
 	e = MLProcContainer::prepareToProcess();
@@ -543,12 +677,12 @@ MLProcPtr MLMultiContainer::newProc(const MLSymbol className, const MLSymbol pro
 	return pNew;
 }
 
-MLProc::err MLMultiContainer::buildProc(juce::XmlElement* parent)
+MLProc::err MLMultiContainer::buildProc(const MLGraphDesc::Node& node)
 {
 	err e = OK;
 	const int copies = (int)mCopies.size();	
-	const MLSymbol className(parent->getStringAttribute("class").toUTF8());
-	const MLSymbol procName(parent->getStringAttribute("name").toUTF8());
+	const MLSymbol className(node.getSymbolAttr("class"));
+	const MLSymbol procName(node.getSymbolAttr("name"));
 	// debug() << "MLMultiContainer::buildProc (class=" << className << ", name=" << procName << ")\n";
 
 	for(int i=0; i<copies; i++)
@@ -561,7 +695,7 @@ MLProc::err MLMultiContainer::buildProc(juce::XmlElement* parent)
             if (e == MLProc::OK)
             {
                 MLPath procPath(procName);
-                pCopy->setProcParams(procPath, parent);
+                pCopy->setProcParams(procPath, node);
                 pCopy->setCopyIndex(i + 1);
                 MLProcPtr p = pCopy->getProc(procPath);	
                 if(p)
@@ -570,7 +704,7 @@ MLProc::err MLMultiContainer::buildProc(juce::XmlElement* parent)
                     if (p->isContainer())
                     {	
                         MLProcContainer* pc = static_cast<MLProcContainer*>(&(*p));
-                        pc->buildGraph(parent);
+                        pc->buildGraph(node);
                     }
                 }		
                 else
@@ -712,13 +846,13 @@ void MLMultiContainer::dumpGraph(int indent)
 	}
 }
 
-void MLMultiContainer::setProcParams(const MLPath& procName, juce::XmlElement* parent)
+void MLMultiContainer::setProcParams(const MLPath& procName, const MLGraphDesc::Node& node)
 {
 	// build in containers
 	const int copies = (int)mCopies.size();	
 	for(int i=0; i<copies; i++)
 	{
-		getCopyAsContainer(i)->setProcParams(procName, parent);
+		getCopyAsContainer(i)->setProcParams(procName, node);
 	}
 }
 
@@ -782,7 +916,10 @@ void MLMultiContainer::compile()
     
 	for(int i=0; i<copies; i++)
 	{
-		getCopyAsContainer(i)->compile();
+		MLProcContainer* pCopy = getCopyAsContainer(i);
+		pCopy->setCompileCursor(mpCompileCursor);
+		pCopy->compile();
+		pCopy->setCompileCursor(0);
 	}
     
     // MLProcContainer's outputs are allocated in compile().  We do a minimal verison here.
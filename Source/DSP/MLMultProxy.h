@@ -33,6 +33,9 @@ protected:
     MLProcPtr mTemplate;
 	std::vector<MLProcPtr> mCopies;
 	int mEnabledCopies;
+	
+	// output signals of enabled copies, gathered for summing in process().
+	std::vector<const MLSignal*> mSumInputs;
 };
 
 class MLMultiProc : public MLProc, public MLMultProxy
@@ -89,6 +92,9 @@ public:
 	void process(const int n);		
 	err prepareToProcess();	
 	void clear();
+	
+	// add each copy's ops to the flat list, followed by the output sum.
+	void addFlatOps(MLFlatOpList& ops, const int frames);
 
 	// not in ContainerBase because this is a virtual method of MLProc.
 	bool isContainer(void) { return true; }
@@ -131,9 +137,9 @@ public:
 	void gatherSignalBuffers(const MLPath & procAddress, const MLSymbol alias, MLProcList& signalBuffers);
 	
 	//
-	MLProc::err buildProc(juce::XmlElement* parent);
+	MLProc::err buildProc(const MLGraphDesc::Node& node);
 	void dumpGraph(int indent);	
-	void setProcParams(const MLPath& procName, juce::XmlElement* pelem);
+	void setProcParams(const MLPath& procName, const MLGraphDesc::Node& node);
 	MLPublishedParamPtr publishParam(const MLPath & procName, const MLSymbol paramName, const MLSymbol alias, const MLSymbol type);
 	void addSetterToParam(MLPublishedParamPtr p, const MLPath & procName, const MLSymbol param);
 	void setPublishedParam(int index, const MLProperty& val);
@@ -141,9 +147,43 @@ public:
 	//
 	void compile();
 
+	// ----------------------------------------------------------------
+	#pragma mark voice sleep
+	//
+	// a copy whose gate is off and whose outputs have stayed below kSleepThreshold 
+	// for the sleep time is put to sleep: it is cleared, then skipped by process() 
+	// until its gate goes on again. copies without a gate signal never sleep.
+	//
+	static const float kSleepThreshold;
+	
+	// set the gate signal for the copy with the given zero-based index. 
+	void setCopyGate(int copy, const MLSignal* pGate);
+	
+	// set the sleep time in seconds. 0 turns sleep off.
+	void setSleepTime(float seconds);
+	
+	bool isCopyAwake(int copy) const { return !mCopyAsleep[copy]; }
+	
 private:
+	// sum outputs of enabled copies to our outputs.
+	void sumCopyOutputs();
+	static int sumCopyOutputsFlat(void* pState, const int frames);
+
+	void resizeSleepState();
+	void wakeCopies();
+	void sleepSilentCopies(const int frames);
+	static int wakeCopiesFlat(void* pState, const int frames);
+	static bool isCopyAwakeFlat(void* pState);
+
 	MLProcInfo<MLMultiContainer> mInfo; //  unused except for errors
 
+	// voice sleep state per copy
+	std::vector<const MLSignal*> mCopyGates;
+	std::vector<int> mCopySilentFrames;
+	std::vector<bool> mCopyAsleep;
+	float mSleepTime;
+	int mSleepFrames;
+
 
 };
 
@@ -0,0 +1,74 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLParamQueue.h"
+
+const int MLParamQueue::kSize;
+const int MLParamQueue::kMaxPacedParams;
+
+MLParamQueue::MLParamQueue() :
+	mParamBlock(new unsigned[kMaxPacedParams]),
+	mBlock(1),
+	mHasHeld(false)
+{
+	for(int i=0; i<kMaxPacedParams; ++i)
+	{
+		mParamBlock[i] = 0;
+	}
+}
+
+MLParamQueue::~MLParamQueue()
+{
+}
+
+bool MLParamQueue::push(int index, float value, int offset)
+{
+	return mQueue.push(MLParamChange(index, value, offset));
+}
+
+bool MLParamQueue::pop(MLParamChange& c)
+{
+	return mQueue.pop(c);
+}
+
+void MLParamQueue::beginBlock()
+{
+	// skip 0, which marks params that have never had a change.
+	if(++mBlock == 0) 
+	{
+		for(int i=0; i<kMaxPacedParams; ++i)
+		{
+			mParamBlock[i] = 0;
+		}
+		mBlock = 1;
+	}
+}
+
+bool MLParamQueue::popForBlock(MLParamChange& c)
+{
+	if(mHasHeld)
+	{
+		c = mHeld;
+	}
+	else if(!mQueue.pop(c))
+	{
+		return false;
+	}
+	
+	const int i = c.mIndex;
+	if((i >= 0) && (i < kMaxPacedParams))
+	{
+		if(mParamBlock[i] == mBlock)
+		{
+			// this param already changed in this block. Changes after this one
+			// wait too, so that each param's changes stay in order.
+			mHeld = c;
+			mHasHeld = true;
+			return false;
+		}
+		mParamBlock[i] = mBlock;
+	}
+	mHasHeld = false;
+	return true;
+}
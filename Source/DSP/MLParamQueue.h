@@ -0,0 +1,69 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef ML_PARAM_QUEUE_H
+#define ML_PARAM_QUEUE_H
+
+#include <memory>
+
+#include "MLMPSCQueue.h"
+
+// one change to a published parameter, to be sent on to the host.
+//
+struct MLParamChange
+{
+	MLParamChange() : mIndex(0), mValue(0.f), mOffset(0) {}
+	MLParamChange(int i, float v, int offset) : mIndex(i), mValue(v), mOffset(offset) {}
+
+	int mIndex;		// published param index
+	float mValue;
+	int mOffset;	// sample offset into the block in which the change is drained
+};
+
+// MLParamQueue: a bounded queue of parameter changes, shared by all the params
+// of an engine. Any number of threads can push; one thread, usually the audio
+// thread, pops. Neither side locks or allocates, and a drain only touches the
+// params that actually have changes waiting.
+//
+// Nothing fills in the sample offsets yet, so a drain paces the changes to one
+// value per param per block, as the old per-param queues did. Otherwise a run of
+// stepped values would all reach the host at the start of one block.
+
+class MLParamQueue
+{
+public:
+	static const int kSize = 4096;	// must be a power of two
+	static const int kMaxPacedParams = 4096;	// params past this are not paced
+
+	MLParamQueue();
+	~MLParamQueue();
+
+	// add a change. If the queue is full, the change is dropped and counted.
+	bool push(int index, float value, int offset = 0);
+
+	// remove the oldest change. Single consumer only.
+	bool pop(MLParamChange& c);
+
+	// start draining the changes for a new block. Single consumer only.
+	void beginBlock();
+
+	// remove the oldest change, unless its param has already had a change this
+	// block. Then the change is held for the next block and this returns false.
+	bool popForBlock(MLParamChange& c);
+
+	// return and reset the number of changes dropped since the last call.
+	int getDropped() { return mQueue.getDropped(); }
+
+private:
+	MLMPSCQueue<MLParamChange, kSize> mQueue;
+
+	// consumer side: the block each param last had a change in, and a change
+	// popped too early, held for the next block.
+	std::unique_ptr<unsigned[]> mParamBlock;
+	unsigned mBlock;
+	MLParamChange mHeld;
+	bool mHasHeld;
+};
+
+#endif // ML_PARAM_QUEUE_H
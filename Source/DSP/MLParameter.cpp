@@ -215,11 +215,6 @@ bool MLPublishedParam::getNeedsQueue(void)
 void MLPublishedParam::setNeedsQueue(bool q)
 {
 	mNeedsQueue = q;
-	if(q)
-	{
-		mpValueQueue = MLRingBufferPtr(new MLRingBuffer());
-		mpValueQueue->resize(1024);
-	}
 }
 
 bool MLPublishedParam::getAutomatable(void)
@@ -232,24 +227,6 @@ void MLPublishedParam::setAutomatable(bool a)
 	mAutomatable = a;
 }
 
-void MLPublishedParam::pushValue(float v)
-{
-	mTempValue = v;
-	mpValueQueue->write(&mTempValue, 1);
-}
-
-float MLPublishedParam::popValue()
-{
-	mpValueQueue->read(&mTempValue, 1);
-	return mTempValue;
-}
-
-int MLPublishedParam::getQueueValuesRemaining()
-{
-	if(!mNeedsQueue) return 0;
-	return mpValueQueue->getRemaining();
-}
-
 
 // ----------------------------------------------------------------
 #pragma mark named parameter groups
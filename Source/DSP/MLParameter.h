@@ -15,7 +15,6 @@
 #include "MLPath.h"
 #include "MLSignal.h"
 #include "MLProperty.h"
-#include "MLRingBuffer.h"
 
 // MLPublishedParam: a parameter of one of the Procs in a DSP graph that is settable 
 
@@ -90,9 +89,6 @@ public:
 	void setNeedsQueue(bool q);
 	bool getAutomatable(void);
 	void setAutomatable(bool q);
-	void pushValue(float v);
-	float popValue();
-	int getQueueValuesRemaining();
 	
 	MLSymbol getAlias(void) { return mPublishedAlias; }
 				
@@ -106,8 +102,6 @@ protected:
 private:
 	std::list<ParamAddress> mAddresses;
 	MLProperty mParamValue;
-	MLRingBufferPtr mpValueQueue;
-	float mTempValue;
 	
 	MLSymbol mPublishedAlias;
 	MLSymbol mType;
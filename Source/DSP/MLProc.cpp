@@ -342,6 +342,14 @@ bool MLProc::outputIsValid(int idx)
 	}
 }
 
+int MLProc::processFlatVirtual(void* pState, const int frames)
+{
+	MLFlatProcState* pS = static_cast<MLFlatProcState*>(pState);
+	pS->resetOutputs();
+	pS->mpProc->process(frames);
+	return 0;
+}
+
 MLSymbol MLProc::getNameWithCopyIndex()
 {
     int c = mCopyIndex;
@@ -355,6 +363,26 @@ MLSymbol MLProc::getNameWithCopyIndex()
     }
 }
 
+uint32_t MLProc::getRandomSeed() const
+{
+	// FNV-1a hash of our name and the copy indices of the containers we are in.
+	const uint32_t kFNVPrime = 16777619u;
+	uint32_t h = 2166136261u;
+	const std::string& name = mName.getString();
+	for(size_t i=0; i<name.length(); ++i)
+	{
+		h = (h ^ (unsigned char)name[i])*kFNVPrime;
+	}
+	const MLProc* p = this;
+	while(p)
+	{
+		h = (h ^ (uint32_t)p->getCopyIndex())*kFNVPrime;
+		const MLProc* pParent = dynamic_cast<const MLProc*>(p->getContext());
+		p = (pParent != p) ? pParent : nullptr;
+	}
+	return h;
+}
+
 void MLProc::dumpParams()
 {
 	MLSymbolMap& map = procInfo().getParamMap();
@@ -504,9 +532,10 @@ MLProcFactory::~MLProcFactory()
 {
 }
 
-void MLProcFactory::registerFn(const MLSymbol className, MLProcCreateFnT fn)
+void MLProcFactory::registerFn(const MLSymbol className, MLProcCreateFnT fn, MLFlatOpFn flatProcessFn)
 {
     procRegistry[className] = fn;
+    flatProcessRegistry[className] = flatProcessFn;
 }
 
 MLProcPtr MLProcFactory::create(const MLSymbol className, MLDSPContext* context)
@@ -524,6 +553,7 @@ MLProcPtr MLProcFactory::create(const MLSymbol className, MLDSPContext* context)
 		// call creator fn returning new MLProc subclass instance
         resultProc = fn();
 		resultProc->setContext(context);
+		resultProc->mFlatProcessFn = flatProcessRegistry[className];
     }
 	else
 	{
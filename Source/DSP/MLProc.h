@@ -13,6 +13,7 @@
 #include <iostream>
 
 #include "MLDebug.h"
+#include "MLRealtimeLog.h"
 #include "MLDSP.h"
 #include "MLDSPContext.h"
 #include "MLSymbol.h"
@@ -40,6 +41,10 @@ const std::string kMLProcAliasUndefinedStr = "undefined";
 typedef std::vector <std::string> MLParamValueAliasVec;
 typedef std::map<MLSymbol, MLParamValueAliasVec > MLParamValueAliasMap;
 
+// a function run from a flattened op list, given its state and frame count. 
+// returns the number of following ops in the list to skip.
+typedef int (*MLFlatOpFn)(void* pState, const int frames);
+
 // ----------------------------------------------------------------
 #pragma mark templates
 
@@ -274,7 +279,7 @@ public:
 		unknownErr
 	};
 
-	MLProc() : mpContext(0), mParamsChanged(true), mCopyIndex(0) {}
+	MLProc() : mpContext(0), mParamsChanged(true), mFlatProcessFn(&processFlatVirtual), mCopyIndex(0) {}
 	
 	// ----------------------------------------------------------------
 	// wrapper for class static info
@@ -370,10 +375,17 @@ public:
 	bool inputIsValid(int idx);
 	bool outputIsValid(int idx);
 	
+	// get the function that processes this proc from a flattened op list, 
+	// with an MLFlatProcState as its state. 
+	MLFlatOpFn getFlatProcessFn() const { return mFlatProcessFn; }
+	
 	MLSymbol& getClassName() { return procInfo().getClassName(); }
 	const MLSymbol& getName() const { return mName; }
     int getCopyIndex() const { return mCopyIndex; }
     MLSymbol getNameWithCopyIndex();
+	// a seed for random generators that is the same each time the graph is built,
+	// and different for each proc and each voice copy it is in.
+	uint32_t getRandomSeed() const;
 	void dumpParams();
 	virtual void dumpProc(int indent);
 
@@ -396,6 +408,9 @@ protected:
 	
 	virtual void createInput(const int idx);
 	
+	// flat process function for procs not made by the factory. 
+	static int processFlatVirtual(void* pState, const int frames);
+	
 	// ----------------------------------------------------------------
 	// data
 	
@@ -409,6 +424,9 @@ protected:
 	std::vector<const MLSignal*> mInputs;
 	std::vector<MLSignal*> mOutputs;
 	
+	// set by the factory to a function calling our subclass's process() directly.
+	MLFlatOpFn mFlatProcessFn;
+	
 private:	
 	int mCopyIndex;		// copy index if in multicontainer, 0 otherwise
 	MLSymbol mName;
@@ -418,6 +436,24 @@ typedef std::shared_ptr<MLProc> MLProcPtr;
 typedef std::list<MLProcPtr> MLProcList;
 typedef MLProcList::iterator MLProcListIterator;
 
+// state for processing one proc from a flattened op list. the outputs are 
+// gathered at flatten time so that they can be reset to non-constant 
+// before each process() without any calls into the proc. 
+struct MLFlatProcState
+{
+	MLProc* mpProc;
+	std::vector<MLSignal*> mOutputs;
+	
+	inline void resetOutputs()
+	{
+		const int outs = (int)mOutputs.size();
+		for(int i=0; i<outs; ++i)
+		{
+			mOutputs[i]->setConstant(false);
+		}
+	}
+};
+
 // ----------------------------------------------------------------
 #pragma mark factory
 
@@ -429,10 +465,12 @@ public:
 
 	typedef MLProcPtr (*MLProcCreateFnT)(void);
     typedef std::map<MLSymbol, MLProcCreateFnT> FnRegistryT;
+    typedef std::map<MLSymbol, MLFlatOpFn> FlatFnRegistryT;
     FnRegistryT procRegistry;
+    FlatFnRegistryT flatProcessRegistry;
  
-	// register an object creation function by the name of the class.
-    void registerFn(const MLSymbol className, MLProcCreateFnT fn);
+	// register an object creation function and flat process function by the name of the class.
+    void registerFn(const MLSymbol className, MLProcCreateFnT fn, MLFlatOpFn flatProcessFn);
 	
 	// create a new object of the named class.  
     MLProcPtr create(const MLSymbol className, MLDSPContext* context);
@@ -459,7 +497,7 @@ public:
 	MLProcRegistryEntry(const char* className)
     {
 		MLSymbol classSym(className);
-        MLProcFactory::theFactory().registerFn(classSym, createInstance);	
+        MLProcFactory::theFactory().registerFn(classSym, createInstance, processFlat);	
 		MLProcInfo<MLProcSubclass>::setClassName(classSym);
     }
 
@@ -469,6 +507,16 @@ public:
 		MLProcPtr pNew(new MLProcSubclass);
 		return pNew;
     }
+	
+	// process an instance from a flattened op list. the qualified call 
+	// to process() is resolved at compile time, skipping the virtual dispatch.
+	static int processFlat(void* pState, const int frames)
+	{
+		MLFlatProcState* pS = static_cast<MLFlatProcState*>(pState);
+		pS->resetOutputs();
+		static_cast<MLProcSubclass*>(pS->mpProc)->MLProcSubclass::process(frames);
+		return 0;
+	}
 };
 
 
@@ -4,6 +4,7 @@
 // Distributed under the MIT license: http://madrona-labs.mit-license.org/
 
 #include "MLProc.h"
+#include "MLRandom.h"
 
 // ----------------------------------------------------------------
 // class definition
@@ -24,6 +25,7 @@ private:
 	void calcCoeffs(void);
 	
 	MLSignal mX;	// direct form 2, uses only one delay
+	MLRandom mRandom;
 	uintptr_t mWriteIndex;
 	uintptr_t mLengthMask;
 	uintptr_t mNoiseIndex;
@@ -85,6 +87,7 @@ MLProc::err MLProcAllpass::resize()
 	mNoiseMask = (1 << bitsToContain(noisePeriodSeconds * sr)) - 1; 
 	mOneOverNoiseDomain = 1.f / (float)(mNoiseMask + 1);
 	mNoisePeriodSeconds = (float)(mNoiseMask + 1) / (float)sr;
+	mRandom.setSeed(getRandomSeed());
 
 	return e;
 }
@@ -155,7 +158,7 @@ void MLProcAllpass::process(const int frames)
 		xc4 = xc2 * xc2;
 		w = (1.f - xc2*p25 + xc4*0.015625f) * p25;
 		
-		noise = MLRand() * w;		
+		noise = mRandom.getSample() * w;		
 		mNoiseIndex++;
 #endif		
 		
@@ -164,7 +167,7 @@ void MLProcAllpass::process(const int frames)
 		v = x[n] + mGain*fxn;
 
 		// TODO remove this, again mystery denormal workaround!
-		MLSample noiseHack = MLRand() * noiseAmp;
+		MLSample noiseHack = mRandom.getSample() * noiseAmp;
 		v += noiseHack;
 
 #if DEMO
@@ -5,12 +5,10 @@
 
 #include "MLProcContainer.h"
 
+// called from the audio thread, so write to the realtime log.
 void MLSignalStats::dump()
 {
-	debug() << "PROCS:  " << mProcs 
-	<< "  BUFS:   " << mSignalBuffers
-	<< "  CONSTS: " << mConstantSignals 
-	<< "  NAN: " << mNanSignals << "\n";
+	ML_LOG_INFO("PROCS:  %d  BUFS:   %d  CONSTS: %d  NAN: %d\n", mProcs, mSignalBuffers, mConstantSignals, mNanSignals);
 }
 
 // ----------------------------------------------------------------
@@ -31,7 +29,8 @@ namespace
 
 MLProcContainer::MLProcContainer() :
 	theProcFactory(MLProcFactory::theFactory()),
-	mStatsPtr(0)
+	mStatsPtr(0),
+	mpCompileCursor(0)
 {
 	setParam("ratio", 1.f);
 	setParam("order", 2);
@@ -62,7 +61,20 @@ void MLProcContainer::setEnabled(bool t)
 			pc.setEnabled(t);
 		}
 	}
-	mEnabled = t;
+	if (t != mEnabled)
+	{
+		mEnabled = t;
+		enabledVoicesChanged();
+	}
+}
+
+void MLProcContainer::enabledVoicesChanged()
+{
+	MLDSPContext* pContext = getContext();
+	if (pContext && (pContext != this))
+	{
+		pContext->enabledVoicesChanged();
+	}
 }
 
 
@@ -145,21 +157,19 @@ void MLProcContainer::compile()
         // multiple procs with the same name.
 		MLSymbol pName = pRef->getName();
         
-		// make a new compileOp referencing the proc.
-		compileOp c(pRef);
+		// make a new compileOp referencing the proc at the end of the compile ops list.
+		compileOps.push_back(compileOp(pRef));
+		compileOp& c = compileOps.back();
 		
 		// set number of inputs and outputs of compileOp to mirror the proc.
 		c.inputs.resize(pRef->getNumInputs());
 		c.outputs.resize(pRef->getNumOutputs());
 		
 		// mark each compileOp with its position in list
-		c.listIdx = compileOps.size();
-				
-		// push copy of new compileOp to the compile ops list
-		compileOps.push_back(c);
+		c.listIdx = compileOps.size() - 1;
 		
 		// add map entry to reference compileOp by proc name.
-		compileOpsMap[pName] = &compileOps.back();
+		compileOpsMap[pName] = &c;
 
 	}
 
@@ -229,15 +239,16 @@ void MLProcContainer::compile()
 		}
 
 		// if compileOpsMap output corresponding to pipe start has not yet been marked,
-		MLSymbol* pPipeStartSym = &(compileOpsMap[srcName]->outputs[srcIndex - 1]);
-		MLSymbol* pPipeEndSym = &(compileOpsMap[destName]->inputs[destIndex - 1]);
+		MLSymbol* pPipeStartSym = &(pSrcOp->outputs[srcIndex - 1]);
+		MLSymbol* pPipeEndSym = &(pDestOp->inputs[destIndex - 1]);
 		MLSymbol sigName;
+		compileSignal* pSig;
 
 		if (!*pPipeStartSym)
 		{		
 			// add a new compileSignal to map
 			sigName = nameMaker.nextName();
-			signals[sigName] = (compileSignal());
+			pSig = &(signals[sigName] = compileSignal());
 
 			// mark the start and end of the pipe with the new signal.
 			*pPipeStartSym = sigName;			
@@ -247,16 +258,17 @@ void MLProcContainer::compile()
 		{
 			sigName = *pPipeStartSym;
 			*pPipeEndSym = *pPipeStartSym;		
+			pSig = &signals[sigName];
 		}
 		
 		// get pipe extent
-		int pipeStartIdx = compileOpsMap[srcName]->listIdx;
-		int pipeEndIdx = compileOpsMap[destName]->listIdx;
+		int pipeStartIdx = pSrcOp->listIdx;
+		int pipeEndIdx = pDestOp->listIdx;
 
 		// debug() << "adding span for " << sigName << ": [" << pipeStartIdx << ", " <<  pipeEndIdx << "]\n";
         
 		// set signal lifetime to union of signal lifetime and pipe extent
-		signals[sigName].addLifespan(pipeStartIdx, pipeEndIdx);
+		pSig->addLifespan(pipeStartIdx, pipeEndIdx);
 		
 		// TODO change MLPipes to store proc name symbols, not procPtrs.
 	}
@@ -317,7 +329,40 @@ void MLProcContainer::compile()
 		if (p->isContainer())
 		{
 			MLProcContainer& pc = static_cast<MLProcContainer&>(*p);
+			pc.setCompileCursor(mpCompileCursor);
 			pc.compile();
+			pc.setCompileCursor(0);
+		}
+	}
+
+	// ----------------------------------------------------------------
+	// find signals that can alias container outputs.
+	// a subcontainer that is not resampling has already set its outputs to 
+	// the buffers of its internal procs in compile() above. signals from these 
+	// outputs use the same buffers, so the subcontainer need not copy to them.
+	//
+	// reads compile ops
+	// writes aliased outputs
+	//
+	std::map<MLSymbol, MLSignal*> aliasedOutputs;
+	for (std::list<compileOp>::const_iterator it = compileOps.begin(); it != compileOps.end(); ++it)
+	{
+		const compileOp& op = (*it);
+		if (!op.procRef->isContainer()) continue;
+		MLProcContainer& pc = static_cast<MLProcContainer&>(*op.procRef);
+		if (!pc.getResampleRatio().isUnity()) continue;
+		
+		for(int i=0; i<(int)op.outputs.size(); ++i)
+		{
+			MLSymbol sigName = op.outputs[i];
+			if (sigName && pc.outputIsValid(i + 1))
+			{
+				MLSignal* pSig = &pc.getOutput(i + 1);
+				if ((pSig != &pc.getNullInput()) && (pSig != &pc.getNullOutput()))
+				{
+					aliasedOutputs[sigName] = pSig;
+				}
+			}
 		}
 	}
 
@@ -325,10 +370,12 @@ void MLProcContainer::compile()
 	// allocate a buffer for each internal or output signal in signal map.
 	// if signal is an input, set to null signal awaiting input.
 	//
-	// reads signals, published outputs, procs
+	// reads signals, published outputs, procs, aliased outputs
 	// writes compile signals
 	//	
 	std::list<sharedBuffer> sharedBuffers;
+	std::vector<compileSignal*> bufferSignals;
+	std::vector<MLSymbol> bufferSignalNames;
 	
 	for (std::map<MLSymbol, compileSignal>::iterator it = signals.begin(); it != signals.end(); ++it)
 	{
@@ -369,6 +416,11 @@ void MLProcContainer::compile()
                 debug() << "    (" << i + 1 << " of " << mPublishedOutputs.size() << ")\n";
             }
 		}
+		else if (aliasedOutputs.find(sigName) != aliasedOutputs.end())
+		{
+			pCompileSig->mpSigBuffer = aliasedOutputs[sigName];
+			needsBuffer = false;
+		}
 		else 
 		{	
 			needsBuffer = true;
@@ -376,8 +428,50 @@ void MLProcContainer::compile()
 		
 		if (needsBuffer)
 		{
-			//packUsingWastefulAlgorithm(pCompileSig, sharedBuffers);
-			packUsingFirstFitAlgorithm(pCompileSig, sharedBuffers);
+			bufferSignals.push_back(pCompileSig);
+			bufferSignalNames.push_back(sigName);
+		}
+	}
+	
+	// pack signals into shared buffers, or use the packing from a cached graph.
+	const int nProcs = (int)mProcList.size();
+	const int nPipes = (int)mPipeList.size();
+	const int nBufferSignals = (int)bufferSignals.size();
+	const MLCompiledGraph::Container* pCached = mpCompileCursor ? mpCompileCursor->next(nProcs, nPipes, nBufferSignals) : 0;
+	if (pCached && !packUsingCachedAssignments(*pCached, bufferSignals, bufferSignalNames, sharedBuffers))
+	{
+		sharedBuffers.clear();
+		mpCompileCursor->reject();
+		pCached = 0;
+	}
+	if (!pCached)
+	{
+		for(int i=0; i<nBufferSignals; ++i)
+		{
+			//packUsingWastefulAlgorithm(bufferSignals[i], sharedBuffers);
+			packUsingFirstFitAlgorithm(bufferSignals[i], sharedBuffers);
+		}
+		
+		if (mpCompileCursor && !mpCompileCursor->isReplaying())
+		{
+			// record the index of the buffer each signal was packed into.
+			std::map<compileSignal*, int> bufferIndex;
+			int b = 0;
+			for (std::list<sharedBuffer>::const_iterator it = sharedBuffers.begin(); it != sharedBuffers.end(); ++it, ++b)
+			{
+				for (std::list<compileSignal*>::const_iterator jt = (*it).mSignals.begin(); jt != (*it).mSignals.end(); ++jt)
+				{
+					bufferIndex[*jt] = b;
+				}
+			}
+			std::vector<std::string> names(nBufferSignals);
+			std::vector<int> buffers(nBufferSignals);
+			for(int i=0; i<nBufferSignals; ++i)
+			{
+				names[i] = bufferSignalNames[i].getString();
+				buffers[i] = bufferIndex[bufferSignals[i]];
+			}
+			mpCompileCursor->record(nProcs, nPipes, names, buffers);
 		}
 	}
 	
@@ -630,6 +724,51 @@ void packUsingFirstFitAlgorithm(compileSignal* pSig, std::list<sharedBuffer>& bu
 	}
 }
 
+bool packUsingCachedAssignments(const MLCompiledGraph::Container& cached, const std::vector<compileSignal*>& sigs,
+	const std::vector<MLSymbol>& names, std::list<sharedBuffer>& bufs)
+{
+	const int n = (int)sigs.size();
+	if (((int)cached.mSignals.size() != n) || ((int)cached.mBuffers.size() != n)) return false;
+	
+	// each signal must be named once, with a buffer index no greater than the number of signals.
+	std::map<std::string, int> cachedBuffers;
+	for(int i=0; i<n; ++i)
+	{
+		const int b = cached.mBuffers[i];
+		if ((b < 0) || (b >= n)) return false;
+		if (!cachedBuffers.insert(std::make_pair(cached.mSignals[i], b)).second) return false;
+	}
+	
+	std::vector<sharedBuffer*> bufPtrs;
+	for(int i=0; i<n; ++i)
+	{
+		std::map<std::string, int>::const_iterator it = cachedBuffers.find(names[i].getString());
+		if (it == cachedBuffers.end()) return false;
+		const int b = it->second;
+		while((int)bufPtrs.size() <= b)
+		{
+			bufs.push_back(sharedBuffer());
+			bufPtrs.push_back(&bufs.back());
+		}
+		
+		// signals sharing a buffer must not be alive at the same time.
+		compileSignal* pSig = sigs[i];
+		const std::list<compileSignal*>& others = bufPtrs[b]->mSignals;
+		for (std::list<compileSignal*>::const_iterator jt = others.begin(); jt != others.end(); ++jt)
+		{
+			if (((*jt)->mLifeStart <= pSig->mLifeEnd) && (pSig->mLifeStart <= (*jt)->mLifeEnd)) return false;
+		}
+		bufPtrs[b]->insert(pSig);
+	}
+	
+	// every buffer must be used.
+	for(int b=0; b<(int)bufPtrs.size(); ++b)
+	{
+		if (bufPtrs[b]->mSignals.empty()) return false;
+	}
+	return true;
+}
+
 // recurse on containers, preparing each proc.
 MLProc::err MLProcContainer::prepareToProcess()
 {
@@ -755,7 +894,7 @@ void MLProcContainer::process(const int extFrames)
 	const bool resample = !myRatio.isUnity();
 	if (myRatio.isZero()) return;
 
-	jassert((MLRatio(extFrames) * myRatio).isInteger());
+	assert((MLRatio(extFrames) * myRatio).isInteger());
 	const int intFrames = (int)(extFrames * myRatio);
 	
 	if (resample)
@@ -794,14 +933,79 @@ void MLProcContainer::process(const int extFrames)
 		}
 	}
 
-	// copy to outputs
+	// copy to any outputs that are not aliased to the buffers of internal procs.
 	for(int i=0; i<(int)mPublishedOutputs.size(); ++i)
 	{
 		MLSignal& outSig = mPublishedOutputs[i]->mProc->getOutput(mPublishedOutputs[i]->mOutput);
-		mOutputs[i]->copy(outSig);
+		if (mOutputs[i] != &outSig)
+		{
+			mOutputs[i]->copy(outSig);
+		}
 	}
 }
 
+// add the ops that process() would run to a flat list. nested containers 
+// add their own ops in place of a call to their process().
+void MLProcContainer::addFlatOps(MLFlatOpList& ops, const int extFrames)
+{
+	const MLRatio myRatio = getResampleRatio();
+	const bool resample = !myRatio.isUnity();
+	if (myRatio.isZero()) return;
+	
+	const int intFrames = (int)(extFrames * myRatio);
+	const int guardIdx = ops.addGuard(&isEnabledFlat, this);
+	const int start = ops.size();
+	
+	if (resample)
+	{
+		int ins = (int)mPublishedInputs.size();
+		for(int i=0; i<ins; ++i)
+		{
+			ops.addProc(mInputResamplers[i].get(), extFrames);
+		}
+	}
+	
+	int numOps = mOpsVec.size();
+	for(int i = 0; i < numOps; ++i)
+	{
+		MLProc* p = mOpsVec[i];
+		if (p->isContainer())
+		{
+			static_cast<MLProcContainer*>(p)->addFlatOps(ops, intFrames);
+		}
+		else
+		{
+			ops.addProc(p, intFrames);
+		}
+	}
+	
+	if (resample)
+	{
+		int outs = (int)mPublishedOutputs.size();
+		for(int i=0; i<outs; ++i)
+		{
+			ops.addProc(mOutputResamplers[i].get(), intFrames);
+		}
+	}
+	
+	// copy only to outputs that are not aliased.
+	for(int i=0; i<(int)mPublishedOutputs.size(); ++i)
+	{
+		MLSignal& outSig = mPublishedOutputs[i]->mProc->getOutput(mPublishedOutputs[i]->mOutput);
+		if (mOutputs[i] != &outSig)
+		{
+			ops.addCopy(mOutputs[i], &outSig);
+		}
+	}
+	
+	ops.setGuardLength(guardIdx, ops.size() - start);
+}
+
+bool MLProcContainer::isEnabledFlat(void* pState)
+{
+	return static_cast<MLProcContainer*>(pState)->isEnabled();
+}
+
 void MLProcContainer::clearInput(const int idx)
 {	
 	MLProc::clearInput(idx);	
@@ -1461,7 +1665,7 @@ MLProc::err MLProcContainer::addSignalBuffers(const MLPath & procAddress, const
 			{		
 				// debug() << "addSignalBuffers: wild card\n";
 				// add a buffer for each possible output matching wildcard (quick and dirty)
-				for(int i = 1; i <= kMLEngineMaxVoices; ++i)
+				for(int i = 1; i <= kMLEngineVoiceLimit; ++i)
 				{				
 					if (headProc->getOutputIndex(outputName.withWildCardNumber(i)))
 					{
@@ -1524,7 +1728,7 @@ void MLProcContainer::gatherSignalBuffers(const MLPath & procAddress, const MLSy
 			{		
 				/// debug() << "gatherSignalBuffers: wild card\n";
 				// gather each buffer matching wildcard (quick and dirty)
-				for(int i = 1; i <= kMLEngineMaxVoices; ++i)
+				for(int i = 1; i <= kMLEngineVoiceLimit; ++i)
 				{
 					MLProcPtr bufferProc = context.getProc(MLPath(alias.withWildCardNumber(i)));		
 					if (bufferProc)	
@@ -1733,86 +1937,64 @@ int MLProcContainer::getPublishedParams()
 }
 
 // ----------------------------------------------------------------
-#pragma mark xml loading / saving
-// TODO go back to tinyXML to got rid of Juce dependencies
+#pragma mark graph description loading
 // TODO ditch XML altogether and make scriptable with e.g. Javascript
 
-MLSymbol stringToSymbol(const juce::String& str);
-MLPath stringToPath(const juce::String& str);
-
-MLSymbol stringToSymbol(const juce::String& str)
+void MLProcContainer::scanDoc(const MLGraphDesc& desc, int* numParameters)
 {
-	return MLSymbol(static_cast<const char *>(str.toUTF8()));
-}
-
-MLPath stringToPath(const juce::String& str)
-{
-	return MLPath(static_cast<const char *>(str.toUTF8()));
-}
-
-void MLProcContainer::scanDoc(juce::XmlDocument* pDoc, int* numParameters)
-{
-	juce::ScopedPointer<juce::XmlElement> pElem(pDoc->getDocumentElement());
-	if (pElem)
+	MLGraphDesc::Node root = desc.getRoot();
+	if (root)
 	{
-		*numParameters = countPublishedParamsInDoc(pElem);
-		
-		/*
-		/// TEST dump parsed XML
-		String test = pElem->createDocument("TEST");
-		debug() << "**************\n";
-		debug() << test;
-		*/
+		*numParameters = countPublishedParamsInDoc(root);
 	}
 	else
 	{	
-		juce::String error = pDoc->getLastParseError();
-		error << "description parse error: " << error << "\n";
+		debug() << "description parse error: " << desc.getError() << "\n";
 	}
 }
 
-MLSymbol MLProcContainer::RequiredAttribute(juce::XmlElement* parent, const char * name)
+MLSymbol MLProcContainer::RequiredAttribute(const MLGraphDesc::Node& node, const char * name)
 {
-	if (parent->hasAttribute(name))
+	if (node.hasAttr(name))
 	{
-		return stringToSymbol(parent->getStringAttribute(name));	
+		return node.getSymbolAttr(name);	
 	}
 	else
 	{
-		debug() << parent->getTagName() << ": required attribute " << name << " missing \n";
+		debug() << node.getTag() << ": required attribute " << name << " missing \n";
 		return MLSymbol();
 	}
 }
 
-MLPath MLProcContainer::RequiredPathAttribute(juce::XmlElement* parent, const char * name)
+MLPath MLProcContainer::RequiredPathAttribute(const MLGraphDesc::Node& node, const char * name)
 {
-	if (parent->hasAttribute(name))
+	if (node.hasAttr(name))
 	{
-		return stringToPath(parent->getStringAttribute(name));	
+		return node.getPathAttr(name);	
 	}
 	else
 	{
-		debug() << parent->getTagName() << ": required path attribute " << name << " missing \n";
+		debug() << node.getTag() << ": required path attribute " << name << " missing \n";
 		return MLPath();
 	}
 }
 
 // build graph of the given element.
-void MLProcContainer::buildGraph(juce::XmlElement* parent)
+void MLProcContainer::buildGraph(const MLGraphDesc::Node& parent)
 {
 	if (!parent) return;
 
-	forEachXmlChildElement(*parent, child)	
+	for(MLGraphDesc::Node child = parent.getFirstChild(); child; child = child.getNextSibling())
 	{
-		if (child->hasTagName("rootproc"))
+		if (child.hasTag("rootproc"))
 		{
 			buildGraph(child);
 		}
-		else if (child->hasTagName("proc"))
+		else if (child.hasTag("proc"))
 		{
 			buildProc(child);
 		}
-		else if (child->hasTagName("input"))
+		else if (child.hasTag("input"))
 		{
 			MLPath arg1 = RequiredPathAttribute(child, "proc");
 			MLSymbol arg2 = RequiredAttribute(child, "input");
@@ -1821,12 +2003,12 @@ void MLProcContainer::buildGraph(juce::XmlElement* parent)
 			{
 				// add optional copy attribute
 				int copy = 0;
-				copy = child->getIntAttribute("copy", copy);
+				copy = child.getIntAttr("copy", copy);
 				arg1.setCopy(copy);
 				publishInput(arg1, arg2, arg3);
 			}
 		}
-		else if (child->hasTagName("output"))
+		else if (child.hasTag("output"))
 		{
 			MLPath arg1 = RequiredPathAttribute(child, "proc");
 			MLSymbol arg2 = RequiredAttribute(child, "output");
@@ -1835,12 +2017,12 @@ void MLProcContainer::buildGraph(juce::XmlElement* parent)
 			{
 				// add optional copy attribute
 				int copy = 0;
-				copy = child->getIntAttribute("copy", copy);
+				copy = child.getIntAttr("copy", copy);
 				arg1.setCopy(copy);
 				publishOutput(arg1, arg2, arg3);
 			}
 		}
-		else if (child->hasTagName("connect"))
+		else if (child.hasTag("connect"))
 		{
 			MLPath arg1 = RequiredPathAttribute(child, "from");
 			MLSymbol arg2 = RequiredAttribute(child, "output");
@@ -1852,7 +2034,7 @@ void MLProcContainer::buildGraph(juce::XmlElement* parent)
 				addPipe(arg1, arg2, arg3, arg4);
 			}
 		}
-		else if (child->hasTagName("paramgroup"))
+		else if (child.hasTag("paramgroup"))
 		{
 			MLSymbol arg1 = RequiredAttribute(child, "name");
 			if (arg1)
@@ -1863,7 +2045,7 @@ void MLProcContainer::buildGraph(juce::XmlElement* parent)
 				buildGraph(child);
 			}
 		}				
-		else if (child->hasTagName("param"))
+		else if (child.hasTag("param"))
 		{
 			MLPath arg1 = RequiredPathAttribute(child, "proc");
 			MLSymbol arg2 = RequiredAttribute(child, "param");
@@ -1872,7 +2054,7 @@ void MLProcContainer::buildGraph(juce::XmlElement* parent)
 			if (arg1 && arg2 && arg3)
 			{
 				// optional param type attribute
-				MLSymbol type = stringToSymbol(child->getStringAttribute("type"));
+				MLSymbol type = child.getSymbolAttr("type");
 				
 				// publish param and set attributes
 				MLPublishedParamPtr p = publishParam(arg1, arg2, arg3, type);
@@ -1904,14 +2086,13 @@ void MLProcContainer::buildGraph(juce::XmlElement* parent)
 	}
 }
 
-MLProc::err MLProcContainer::buildProc(juce::XmlElement* parent)
+MLProc::err MLProcContainer::buildProc(const MLGraphDesc::Node& node)
 {
 	err e = OK;
-	const MLSymbol newProcClass ((const char *)parent->getStringAttribute("class").toUTF8());
-	const MLSymbol newProcName ((const char *)parent->getStringAttribute("name").toUTF8());
+	const MLSymbol newProcClass (node.getSymbolAttr("class"));
+	const MLSymbol newProcName (node.getSymbolAttr("name"));
 
 	// debug() << "MLProcContainer::buildProc (class=" << newProcClass << ", name=" << newProcName << ")\n";
-	// debug() << "MLProcContainer::buildProc (class=" << parent->getStringAttribute("class") << ", name=" << parent->getStringAttribute("name") << ")\n";
 
 	// add the specified proc to this container.  if this container is a multiple, 
 	// MLProcMultiple::addProc makes a MultProxy here to manage the copies. 
@@ -1921,7 +2102,7 @@ MLProc::err MLProcContainer::buildProc(juce::XmlElement* parent)
 	{
 		MLPath newProcPath(newProcName);	
 		
-		setProcParams(newProcPath, parent);
+		setProcParams(newProcPath, node);
 
 		// within multiples, this gets the appropriate multproxy class.
 		MLProcPtr p = getProc(newProcPath);	
@@ -1931,7 +2112,7 @@ MLProc::err MLProcContainer::buildProc(juce::XmlElement* parent)
 			if (p->isContainer())
 			{		
 				MLProcContainer* pc = static_cast<MLProcContainer*>(&(*p));
-				pc->buildGraph(parent);
+				pc->buildGraph(node);
 			}
 		}		
 		else
@@ -1943,36 +2124,28 @@ MLProc::err MLProcContainer::buildProc(juce::XmlElement* parent)
 	return e;
 }
 
-void MLProcContainer::setProcParams(const MLPath& procName, juce::XmlElement* parent)
+void MLProcContainer::setProcParams(const MLPath& procName, const MLGraphDesc::Node& node)
 {
 	MLProcPtr p;
-	int ac = 0;
 
-	const int numAttrs = parent->getNumAttributes();
+	const int numAttrs = node.getNumAttrs();
 	
 	// attrs to ignore
-	std::string classStr("class");
-	std::string nameStr("name");
+	static const MLSymbol classSym("class");
+	static const MLSymbol nameSym("name");
 	
 	p = getProc(procName);
 	if (p)
 	{
-		// parse new proc's parameter attributes
+		// parse new proc's parameter attributes. values were converted when the 
+		// description was parsed.
 		for(int i=0; i<numAttrs; ++i)
 		{
-			const juce::String& attrName = parent->getAttributeName(i);
-			
-			// set
-			bool isClass = (!classStr.compare(attrName.toUTF8()));
-			bool isName = (!nameStr.compare(attrName.toUTF8()));
-			MLParamValue paramVal;
-			
-			if (!isClass && !isName) // TODO a better way of ignoring certain attributes
+			const MLSymbol attrName = node.getAttrName(i);
+			if ((attrName != classSym) && (attrName != nameSym)) // TODO a better way of ignoring certain attributes
 			{
-				paramVal = (MLParamValue)parent->getDoubleAttribute(attrName);
-				p->setParam((const char *)attrName.toUTF8(), paramVal);
+				p->setParam(attrName, (MLParamValue)node.getAttrValue(i));
 			}
-			++ac;
 		}
 	}
 	else
@@ -1982,36 +2155,33 @@ void MLProcContainer::setProcParams(const MLPath& procName, juce::XmlElement* pa
 }
 
 // set up any attributes that a parameter might have. we don't recurse into param elements.
-void MLProcContainer::setPublishedParamAttrs(MLPublishedParamPtr p, juce::XmlElement* parent)
+void MLProcContainer::setPublishedParamAttrs(MLPublishedParamPtr p, const MLGraphDesc::Node& parent)
 {
-	std::string valStr;
-	
-	forEachXmlChildElement(*parent, child)	
+	for(MLGraphDesc::Node child = parent.getFirstChild(); child; child = child.getNextSibling())
 	{
-		if (child->hasTagName("range"))
+		if (child.hasTag("range"))
 		{
 			MLParamValue low = 0.f;
 			MLParamValue high = 1.f;
 			MLParamValue interval = 0.01f;
 			int logAttr = 0;
 			MLParamValue zeroThresh = -2<<16;
-			low = (MLParamValue)child->getDoubleAttribute("low", low);
-			high = (MLParamValue)child->getDoubleAttribute("high", high);
-			interval = (MLParamValue)child->getDoubleAttribute("interval", interval);
-			logAttr = child->getIntAttribute("log", logAttr);
-			zeroThresh = (MLParamValue)child->getDoubleAttribute("zt", zeroThresh);
+			low = (MLParamValue)child.getDoubleAttr("low", low);
+			high = (MLParamValue)child.getDoubleAttr("high", high);
+			interval = (MLParamValue)child.getDoubleAttr("interval", interval);
+			logAttr = child.getIntAttr("log", logAttr);
+			zeroThresh = (MLParamValue)child.getDoubleAttr("zt", zeroThresh);
 			p->setRange(low, high, max(interval, 0.001f), MLParamValue(logAttr != 0), zeroThresh);
 		}
-		else if(child->hasTagName("default"))
+		else if(child.hasTag("default"))
 		{
-			p->setDefault((MLParamValue)child->getDoubleAttribute("value", 0.f));
+			p->setDefault((MLParamValue)child.getDoubleAttr("value", 0.f));
 		}
-		else if(child->hasTagName("alsosets"))
+		else if(child.hasTag("alsosets"))
 		{
-			addSetterToParam(p, stringToPath(child->getStringAttribute("proc")),
-							 stringToSymbol(child->getStringAttribute("param")));
+			addSetterToParam(p, child.getPathAttr("proc"), child.getSymbolAttr("param"));
 		}
-		else if(child->hasTagName("size"))
+		else if(child.hasTag("size"))
 		{
 			MLSymbol type = p->getType();
 			if(type == "signal")
@@ -2020,60 +2190,60 @@ void MLProcContainer::setPublishedParamAttrs(MLPublishedParamPtr p, juce::XmlEle
 				int width = 1;
 				int height = 1;
 				int depth = 1;
-				width = child->getIntAttribute("width", width);
-				height = child->getIntAttribute("height", height);
-				depth = child->getIntAttribute("depth", depth);
+				width = child.getIntAttr("width", width);
+				height = child.getIntAttr("height", height);
+				depth = child.getIntAttr("depth", depth);
 				p->setValueProperty(MLSignal(width, height, depth));
 			}
 		}
-		else if(child->hasTagName("length"))
+		else if(child.hasTag("length"))
 		{
 			MLSymbol type = p->getType();
 			if(type == "string")
 			{
 				// create storage for the string parameter.
 				int len = 256;
-				len = child->getIntAttribute("length", len);
+				len = child.getIntAttr("length", len);
 				p->setValueProperty(std::string((size_t)len, '\0'));
 			}
 		}
-		else if(child->hasTagName("queue"))
+		else if(child.hasTag("queue"))
 		{
 			MLSymbol type = p->getType();
 			if(type == "float")
 			{
-				p->setNeedsQueue(child->getIntAttribute("value", 0));
+				p->setNeedsQueue(child.getIntAttr("value", 0));
 			}
 			else
 			{
 				debug() << "MLProcContainer::setPublishedParamAttrs: queue only supported for float parameters!\n";
 			}
 		}
-		else if(child->hasTagName("automatable"))
+		else if(child.hasTag("automatable"))
 		{
-			p->setAutomatable(child->getIntAttribute("value", 0));
+			p->setAutomatable(child.getIntAttr("value", 0));
 		}
 	}
 }
 
 // count param elements, but just at this level-- don't recurse into procs.
 // do recurse into paramgroup elements. 
-int MLProcContainer::countPublishedParamsInDoc(juce::XmlElement* parent)
+int MLProcContainer::countPublishedParamsInDoc(const MLGraphDesc::Node& parent)
 {
 	int sum = 0;
 	if (!parent) return 0;
 
-	forEachXmlChildElement(*parent, child)	
+	for(MLGraphDesc::Node child = parent.getFirstChild(); child; child = child.getNextSibling())
 	{	
-		if (child->hasTagName("rootproc"))
+		if (child.hasTag("rootproc"))
 		{
 			sum += countPublishedParamsInDoc(child);
 		}
-		else if (child->hasTagName("paramgroup"))
+		else if (child.hasTag("paramgroup"))
 		{
 			sum += countPublishedParamsInDoc(child);
 		}
-		else if (child->hasTagName("param"))
+		else if (child.hasTag("param"))
 		{
 			++sum;
 		}
@@ -2195,3 +2365,65 @@ std::ostream& operator<< (std::ostream& out, const sharedBuffer & r)
 	return out;
 }
 
+// ----------------------------------------------------------------
+#pragma mark MLFlatOpList
+
+void MLFlatOpList::clear()
+{
+	mOps.clear();
+	mProcStates.clear();
+	mGuardStates.clear();
+	mCopyStates.clear();
+}
+
+void MLFlatOpList::addProc(MLProc* p, const int frames)
+{
+	mProcStates.push_back(MLFlatProcState());
+	MLFlatProcState& state = mProcStates.back();
+	state.mpProc = p;
+	const int outs = p->getNumOutputs();
+	for(int i=0; i<outs; ++i)
+	{
+		state.mOutputs.push_back(&p->getOutput(i + 1));
+	}
+	addOp(p->getFlatProcessFn(), &state, frames);
+}
+
+int MLFlatOpList::addGuard(guardTestFn test, void* pState)
+{
+	guardState g = {test, pState, 0};
+	mGuardStates.push_back(g);
+	addOp(&guardFn, &mGuardStates.back(), 0);
+	return size() - 1;
+}
+
+void MLFlatOpList::setGuardLength(int guardIdx, int length)
+{
+	static_cast<guardState*>(mOps[guardIdx].mpState)->mLength = length;
+}
+
+void MLFlatOpList::addCopy(MLSignal* pDest, const MLSignal* pSrc)
+{
+	copyState c = {pDest, pSrc};
+	mCopyStates.push_back(c);
+	addOp(&copyFn, &mCopyStates.back(), 0);
+}
+
+void MLFlatOpList::addOp(MLFlatOpFn fn, void* pState, const int frames)
+{
+	op o = {fn, pState, frames};
+	mOps.push_back(o);
+}
+
+int MLFlatOpList::guardFn(void* pState, const int)
+{
+	guardState* pG = static_cast<guardState*>(pState);
+	return (pG->mTest)(pG->mpState) ? 0 : pG->mLength;
+}
+
+int MLFlatOpList::copyFn(void* pState, const int)
+{
+	copyState* pC = static_cast<copyState*>(pState);
+	pC->mpDest->copy(*pC->mpSrc);
+	return 0;
+}
@@ -6,6 +6,7 @@
 #ifndef ML_PROC_CONTAINER_H
 #define ML_PROC_CONTAINER_H
 
+#include <list>
 #include <map>
 #include <set>
 #include <vector>
@@ -17,8 +18,8 @@
 #include "MLProcRingBuffer.h"
 #include "MLParameter.h"
 #include "MLRatio.h"
-
-#include "JuceHeader.h" // used only for XML loading now. TODO move to creation by scripting and remove.
+#include "MLGraphDesc.h"
+#include "MLGraphCache.h"
 
 class MLProcRingBuffer;
 
@@ -112,6 +113,79 @@ public:
 	int mConstantSignals;
 };
 
+// a flat list of ops made from a compiled graph of containers, so the audio thread
+// can process the whole graph in one loop. each op is a function, its state, and a
+// frame count. frame counts, resample ratios and output resets are all worked out
+// when the list is made.
+class MLFlatOpList
+{
+public:
+	struct op
+	{
+		MLFlatOpFn mFn;
+		void* mpState;
+		int mFrames;
+	};
+
+	MLFlatOpList() {}
+	~MLFlatOpList() {}
+
+	void clear();
+	bool isEmpty() const { return mOps.empty(); }
+	int size() const { return (int)mOps.size(); }
+
+	// add a proc, to be run by its flat process function.
+	void addProc(MLProc* p, const int frames);
+
+	// add a guard that skips the following ops when its test returns false, such as 
+	// the ops of a disabled container. returns the index of the guard, for setGuardLength().
+	typedef bool (*guardTestFn)(void* pState);
+	int addGuard(guardTestFn test, void* pState);
+	void setGuardLength(int guardIdx, int length);
+
+	// add a copy from one signal to another.
+	void addCopy(MLSignal* pDest, const MLSignal* pSrc);
+
+	// add any other function.
+	void addOp(MLFlatOpFn fn, void* pState, const int frames);
+
+	// run all the ops in order.
+	inline void process() const
+	{
+		const int n = (int)mOps.size();
+		const op* pOps = mOps.data();
+		for(int i=0; i<n; ++i)
+		{
+			const op& o = pOps[i];
+			i += (o.mFn)(o.mpState, o.mFrames);
+		}
+	}
+
+private:
+	struct guardState
+	{
+		guardTestFn mTest;
+		void* mpState;
+		int mLength;
+	};
+
+	struct copyState
+	{
+		MLSignal* mpDest;
+		const MLSignal* mpSrc;
+	};
+
+	static int guardFn(void* pState, const int frames);
+	static int copyFn(void* pState, const int frames);
+
+	std::vector<op> mOps;
+
+	// states are kept in lists so that pointers to them stay valid as ops are added.
+	std::list<MLFlatProcState> mProcStates;
+	std::list<guardState> mGuardStates;
+	std::list<copyState> mCopyStates;
+};
+
 class MLContainerBase
 {
 public:
@@ -170,9 +244,9 @@ public:
 	// ----------------------------------------------------------------
 	#pragma mark -- building
 	// 
-	virtual void buildGraph(juce::XmlElement* pDoc) = 0;	
+	virtual void buildGraph(const MLGraphDesc::Node& parent) = 0;	
 	virtual void dumpGraph(int indent) = 0;	
-	virtual void setProcParams(const MLPath& procName, juce::XmlElement* pelem) = 0;
+	virtual void setProcParams(const MLPath& procName, const MLGraphDesc::Node& node) = 0;
 
 	typedef std::map<MLSymbol, MLProcPtr> MLSymbolProcMapT;	
 	typedef std::map<MLSymbol, MLPublishedParamPtr> MLPublishedParamMapT;
@@ -221,6 +295,9 @@ public:
 	virtual void setEnabled(bool t);
 	virtual bool isEnabled() const;
 	virtual bool isProcEnabled(const MLProc* p) const;
+	
+	// pass the notice up to our own context.
+	virtual void enabledVoicesChanged();
 
 	// ----------------------------------------------------------------
 	#pragma mark MLProc methods
@@ -246,6 +323,13 @@ public:
 	inline virtual bool isRoot() const { return (getContext() == this); }
 	virtual void compile();
 	
+	// while set, compile() replays or records buffer assignments with the cursor.
+	void setCompileCursor(MLCompileCursor* pCursor) { mpCompileCursor = pCursor; }
+	
+	// after compile() and prepareToProcess(), add the ops that process() would run 
+	// for the given number of frames to a flat list, recursing into containers.
+	virtual void addFlatOps(MLFlatOpList& ops, const int frames);
+	
 	// ----------------------------------------------------------------
 	#pragma mark graph creation
 	//
@@ -291,14 +375,14 @@ public:
 	int getPublishedParams();
 
 	// ----------------------------------------------------------------
-	#pragma mark xml loading / saving
+	#pragma mark graph description loading
 	//
-	void scanDoc(juce::XmlDocument* pDoc, int* numParameters);
-    MLSymbol RequiredAttribute(juce::XmlElement* parent, const char * name);
-    MLPath RequiredPathAttribute(juce::XmlElement* parent, const char * name);     
-    void buildGraph(juce::XmlElement* pDoc);
+	void scanDoc(const MLGraphDesc& desc, int* numParameters);
+    MLSymbol RequiredAttribute(const MLGraphDesc::Node& node, const char * name);
+    MLPath RequiredPathAttribute(const MLGraphDesc::Node& node, const char * name);     
+    void buildGraph(const MLGraphDesc::Node& parent);
 	virtual void dumpGraph(int indent);			
-	virtual void setProcParams(const MLPath& procName, juce::XmlElement* pelem);	
+	virtual void setProcParams(const MLPath& procName, const MLGraphDesc::Node& node);	
 
 	// ----------------------------------------------------------------
 	#pragma mark buffer pool
@@ -307,11 +391,14 @@ public:
 	void freeBuffer(MLSignal* pBuf);
 	
 protected:
-	virtual err buildProc(juce::XmlElement* parent);
+	virtual err buildProc(const MLGraphDesc::Node& node);
+	
+	// guard test for our ops in a flat list.
+	static bool isEnabledFlat(void* pState);
 	
 	// count number of param elements in document.
 	// this is used to return param info to host before graph is built. 
-	int countPublishedParamsInDoc(juce::XmlElement* pElem);	
+	int countPublishedParamsInDoc(const MLGraphDesc::Node& parent);	
 	
 	MLProcFactory& theProcFactory;
 
@@ -322,7 +409,7 @@ private:
 	void addProcToOps (MLProcPtr proc);		
 
 	// private doc building mathods
-	void setPublishedParamAttrs(MLPublishedParamPtr p, juce::XmlElement* pelem);
+	void setPublishedParamAttrs(MLPublishedParamPtr p, const MLGraphDesc::Node& node);
 	
 	// dump all MLProc subclasses registered at static init time
 	void printClassRegistry(void){ theProcFactory.printRegistry(); }
@@ -382,6 +469,8 @@ protected:
 	
 	MLSignalStats* mStatsPtr;
 	
+	MLCompileCursor* mpCompileCursor;
+	
 private: // TODO more data should be private
 
 };
@@ -477,6 +566,12 @@ public:
 void packUsingWastefulAlgorithm(compileSignal* sig, std::list<sharedBuffer>& bufs);
 void packUsingFirstFitAlgorithm(compileSignal* sig, std::list<sharedBuffer>& bufs);
 
+// pack signals into shared buffers as recorded in a cached graph, finding each
+// signal's buffer by name. Returns false if the record doesn't name every signal 
+// once, or doesn't pack them validly. The buffers must then be discarded.
+bool packUsingCachedAssignments(const MLCompiledGraph::Container& cached, const std::vector<compileSignal*>& sigs,
+	const std::vector<MLSymbol>& names, std::list<sharedBuffer>& bufs);
+
 std::ostream& operator<< (std::ostream& out, const compileOp & r);
 std::ostream& operator<< (std::ostream& out, const sharedBuffer & r);
 
@@ -4,7 +4,6 @@
 // Distributed under the MIT license: http://madrona-labs.mit-license.org/
 
 #include "MLProc.h"
-#include <iomanip>
 
 // ----------------------------------------------------------------
 // class definition
@@ -17,12 +16,14 @@ public:
 	~MLProcDebug();
 
 	void clear(){};
+	void setup();
 	void doParams();
 	void process(const int n);		
 	MLProcInfoBase& procInfo() { return mInfo; }
 
 private:
 	MLProcInfo<MLProcDebug> mInfo;
+	std::string mNameStr;	// our name as a C string, made once so logging doesn't allocate
 	bool mVerbose;
 	int mTemp;
 };
@@ -53,6 +54,11 @@ MLProcDebug::~MLProcDebug()
 {
 }
 
+void MLProcDebug::setup()
+{
+	mNameStr = getName().getString();
+}
+
 void MLProcDebug::doParams()
 {
 	mVerbose = getParam("verbose");
@@ -67,34 +73,26 @@ void MLProcDebug::process(const int frames)
 	mTemp += frames;
 	if (mTemp > intervalFrames)
 	{
+		// we are on the audio thread, so write to the realtime log.
 		const MLSignal& in = getInput(1);
-		debug() << std::setw(6);
-		debug() << std::setprecision(2);
-		debug() << "sig " << getName() << " (" << static_cast<const void *>(&in) << "), n=" << frames << " = " << std::setprecision(4) << in[0] ;
 		if(in.isConstant()) 
 		{ 
-			debug() << "(const)"; 
+			ML_LOG_INFO("sig %s, n=%d = %.4g(const)\n", mNameStr.c_str(), frames, in[0]);
 		}
 		else
 		{
-			debug() << " min:" << in.getMin() << ", max:" << in.getMax();
+			ML_LOG_INFO("sig %s, n=%d = %.4g min:%.4g, max:%.4g\n", mNameStr.c_str(), frames, in[0], in.getMin(), in.getMax());
 		}
-		
-		debug() << "\n";
 		mTemp -= intervalFrames;
 		
 		if (mVerbose)
 		{
-			debug() << frames << " frames\n";
-			debug() << "[";
-			debug() << std::setw(6);
-			debug() << std::setprecision(2);
-			for(int j=0; j<frames; ++j)
+			ML_LOG_INFO("%d frames\n[\n", frames);
+			for(int j=0; j<frames; j += 4)
 			{
-				debug() << in[j] << " " ;		
-				if ((j%8 == 7) && (j < frames-1)) debug() << "\n";	
+				ML_LOG_INFO("%6.2f %6.2f %6.2f %6.2f\n", in[j], in[j + 1], in[j + 2], in[j + 3]);
 			}
-			debug() << "]\n\n";
+			ML_LOG_INFO("]\n\n");
 		}
 	}
 }
@@ -21,6 +21,11 @@ public:
 private:
 	MLProcInfo<MLProcEnvelope> mInfo;
 	void calcCoeffs(void);
+	void calcStepSizes(float invSr, float delay, float attack, float decay, float sustain, float release, float repeat);
+	MLSample processSample(float gIn, float velIn);
+	int quietFrames(const MLSignal& gate, int start, int end);
+	void advanceCounters(int frames);
+	void renderSegment(MLSample* pY, int frames);
 		
 	MLSample mEnvThresh;	// coeffs
 	MLSample mDelayCounter, mDelayCounterStep, mDelayStep;
@@ -31,6 +36,7 @@ private:
 	MLSample mGate1, mEnv, mY1; // history
 	MLSample mMult;	// output multiply by gate amp if xvel is on, or 1 if xvel is off
 	MLSample* mpEnvCoeff; // points to current step being used
+	bool mDoMult;
 	
 	enum {stateOff, stateDelay, stateAttack, stateDecay, stateSustain, stateRelease}; // envelope states
 	int mState;
@@ -39,6 +45,12 @@ private:
 	
 static const float kMinSegTime = 0.0002f;
 
+// the filter aims this far past each threshold so it gets there in finite time.
+static const float kBias = 0.05f;
+
+// input change thresholds for state changes
+static const float kInputThresh = 0.001f;
+
 // ----------------------------------------------------------------
 // registry section
 
@@ -54,7 +66,8 @@ ML_UNUSED MLProcOutput<MLProcEnvelope> outputs[] = {"out"};
 // ----------------------------------------------------------------
 // implementation
 
-MLProcEnvelope::MLProcEnvelope()
+MLProcEnvelope::MLProcEnvelope() :
+	mDoMult(false)
 {
 }
 
@@ -64,6 +77,10 @@ MLProcEnvelope::~MLProcEnvelope()
 
 void MLProcEnvelope::calcCoeffs(void) 
 {
+	static const MLSymbol trigSelectSym("trig_select");
+	static const MLSymbol xvelSym("xvel");
+	const bool trigSelect = getParam(trigSelectSym) > 1.f; // this param is 1 or 2
+	mDoMult = (getParam(xvelSym) > 0.f) && !trigSelect;
 	mParamsChanged = false;
 }
 
@@ -81,6 +98,246 @@ void MLProcEnvelope::clear()
 	mT = 0;
 }
 
+// get step sizes and filter coefficients from the input parameter values.
+void MLProcEnvelope::calcStepSizes(float invSr, float delay, float attack, float decay, float sustain, float release, float repeat)
+{
+	// TEMP
+	float attackIn = attack - 0.0001f;
+	attackIn = clamp(attackIn, 0.f, 20.f);
+	
+	mSustain = sustain;
+	mDelayStep = invSr / max(delay, kMinSegTime); 
+	mRepeatStep = (repeat == 0.f) ? 0.f : invSr / max(repeat, kMinSegTime);
+	mCAttack =  kMLTwoPi * invSr / max(attackIn, kMinSegTime);
+	mCDecay = kMLTwoPi * invSr / max(decay, kMinSegTime);
+	mCRelease = kMLTwoPi * invSr / max(release, kMinSegTime);
+}
+
+// run the envelope state machine for one sample and return the output.
+MLSample MLProcEnvelope::processSample(float gIn, float velIn)
+{
+	bool upTrig, downTrig, crossedThresh, delayCounterDone, doRepeat;
+	
+	// process gate input
+	const bool wasOver = mGate1 > kInputThresh;
+	const bool isOver = gIn > kInputThresh;		
+	upTrig = !wasOver && isOver;
+	downTrig = wasOver && !isOver;
+	
+	// IIR filter.  
+	float dxdt = mX - mEnv;
+	mEnv += dxdt * (*mpEnvCoeff);
+	
+	// linear counters. TODO use integers
+	// TODO change repeat interval during repeat for knob or signal change
+	mDelayCounter += mDelayCounterStep;
+	mRepeatCounter += (mState == stateDelay) ? 0.f : mRepeatStep;
+	
+	// did env cross threshold in either direction?
+	crossedThresh = (sign(mEnv - mEnvThresh) != sign(mY1 - mEnvThresh));		
+	delayCounterDone = mDelayCounter > 1.0;
+	// no repeat when sustain is > thresh. (why?)
+	doRepeat = ((mSustain < 0.05f) && (mRepeatCounter > 1.0) && (mRepeatStep > 0.));
+	
+	// did something happen?  usually it doesn't, so we wrap all the branches in just one outer branch.
+	if (upTrig || downTrig || delayCounterDone || doRepeat || crossedThresh)
+	{
+		if (upTrig)  // start delay
+		{
+			mDelayCounterStep = mDelayStep;
+			mDelayCounter = 0.f;		
+			mEnvThresh = 0.f;
+			mpEnvCoeff = &mCNull;
+			mEnv = 0.f;
+			mX = 0.f;
+			mState = stateDelay;
+			mMult = mDoMult ? velIn : 1.f;	// set mMult here only.
+		}
+		else if (delayCounterDone || doRepeat) // start attack
+		{	
+			mRepeatCounter = 0.f;				
+			mDelayCounterStep = 0.f;				
+			mDelayCounter = 0.f;
+			mEnvThresh = 1.f;
+			mX = 1.f + kBias;
+			mpEnvCoeff = &mCAttack; 
+			mState = stateAttack;
+		}
+		else if (downTrig) // go to release
+		{	
+			// cancel repeat
+	//		mRepeatCounterStep = 0.;
+	//		mRepeatCounter = 0.;
+			
+			// cancel delay
+			mDelayCounter = 0.f;
+			mDelayCounterStep = 0.f;
+			
+			// release is defined as time to fall to 0 from a value of 1.0.
+			mpEnvCoeff = &mCRelease;
+			mEnvThresh = 0.f;
+			mX = 0.f - kBias;
+			mState = stateRelease;
+		}		
+		else if (crossedThresh)
+		{
+			switch(mState)
+			{
+				case stateDelay: // go to attack
+				break;
+				case stateAttack: // go to decay
+					mpEnvCoeff = &mCDecay; 
+					mEnvThresh = mSustain;
+					mX = mSustain - kBias;
+					mState = stateDecay;
+				break;
+				case stateDecay: // go to sustain
+					mpEnvCoeff = &mCNull; 
+					mState = stateSustain;
+				break;
+				case stateSustain:
+					// TODO go to new sustain value if level param changes
+					mpEnvCoeff = &mCNull; 
+				break;
+				case stateRelease: // stop at 0
+					mpEnvCoeff = &mCNull; 
+					mEnvThresh = 0.f;
+					mState = stateOff;
+				default:
+				break;
+			}
+		}
+	}
+	
+	mGate1 = gIn;
+	mY1 = mEnv; // history is of linear ramp, before clip and scale
+	mEnv = clamp(mEnv, 0.f, 1.f); // could be avoided by careful attention to overshoots > 1 and < 0		
+	return mEnv * mMult * 2.f;
+}
+
+// return a number of frames from start, no more than end - start, over which
+// processSample() would not change state. This is conservative: it can return
+// fewer frames than possible, and returns 0 when anything is unsure.
+// Step sizes must be constant over the frames.
+int MLProcEnvelope::quietFrames(const MLSignal& gate, int start, int end)
+{
+	// clipped history: let processSample() settle it.
+	if (mEnv != mY1) return 0;
+	
+	int frames = end - start;
+	
+	// gate transitions
+	const bool wasOver = mGate1 > kInputThresh;
+	if (gate.isConstant())
+	{
+		if ((gate[0] > kInputThresh) != wasOver) return 0;
+	}
+	else
+	{
+		const MLSample* pGate = gate.getBuffer();
+		for (int n = start; n < end; ++n)
+		{
+			if ((pGate[n] > kInputThresh) != wasOver)
+			{
+				frames = n - start;
+				break;
+			}
+		}
+	}
+	
+	// counters, keeping one step away from the thresholds
+	if (mDelayCounter > 1.f) return 0;
+	if (mDelayCounterStep > 0.f)
+	{
+		frames = min(frames, (int)((1.f - mDelayCounter) / mDelayCounterStep) - 1);
+	}
+	if ((mSustain < 0.05f) && (mRepeatStep > 0.f))
+	{
+		if (mRepeatCounter > 1.f) return 0;
+		if (mState != stateDelay)
+		{
+			frames = min(frames, (int)((1.f - mRepeatCounter) / mRepeatStep) - 1);
+		}
+	}
+	
+	// threshold crossing. The filter output is x + (e - x)*(1 - c)^k,
+	// which crosses the threshold when (1 - c)^k reaches r.
+	const float c = *mpEnvCoeff;
+	if ((c != 0.f) && (mEnv != mX))
+	{
+		if (c >= 1.f) return 0; // overshoots every step
+		const float r = (mEnvThresh - mX) / (mEnv - mX);
+		if (r >= 1.f) return 0;
+		if (r > 0.f)
+		{
+			const float k = logf(r) / logf(1.f - c);
+			frames = min(frames, (int)min(k, (float)frames + 1.f) - 1);
+		}
+	}
+	
+	return max(frames, 0);
+}
+
+// advance the linear counters over frames. They are summed one step at a time like 
+// processSample() does, so that they reach their thresholds on the same samples.
+void MLProcEnvelope::advanceCounters(int frames)
+{
+	const float repeatStep = (mState == stateDelay) ? 0.f : mRepeatStep;
+	for (int n=0; n<frames; ++n)
+	{
+		mDelayCounter += mDelayCounterStep;
+		mRepeatCounter += repeatStep;
+	}
+}
+
+// render frames of the current segment. Nothing changes state in the segment,
+// so the filter can be run in closed form, four samples at a time.
+void MLProcEnvelope::renderSegment(MLSample* pY, int frames)
+{
+	const float c = *mpEnvCoeff;
+	const float gain = mMult * 2.f;
+	
+	advanceCounters(frames);
+	
+	if ((c == 0.f) || (mEnv == mX))
+	{
+		const float y = mEnv * gain;
+		for (int n=0; n<frames; ++n)
+		{
+			pY[n] = y;
+		}
+		return;
+	}
+	
+	// powers of the decay factor a = (1 - c) for each lane
+	const float a = 1.f - c;
+	float p[4];
+	p[0] = a;
+	p[1] = a*a;
+	p[2] = p[1]*a;
+	p[3] = p[1]*p[1];
+	const float a4 = p[3];
+	float d = mEnv - mX;
+	
+	int n = 0;
+	for (; n <= frames - 4; n += 4)
+	{
+		for (int j=0; j<4; ++j)
+		{
+			pY[n + j] = clamp(mX + d*p[j], 0.f, 1.f) * gain;
+		}
+		d *= a4;
+	}
+	for (int j=0; n < frames; ++n, ++j)
+	{
+		pY[n] = clamp(mX + d*p[j], 0.f, 1.f) * gain;
+	}
+	
+	// history is of the last sample, before clip.
+	mEnv = mY1 = mX + (mEnv - mX)*powf(a, (float)frames);
+	mEnv = clamp(mEnv, 0.f, 1.f);
+}
+
 // generate envelope output based on gate and control signal inputs.
 void MLProcEnvelope::process(const int samples)
 {	
@@ -95,136 +352,53 @@ void MLProcEnvelope::process(const int samples)
 	const MLSignal& vel = getInput(8);
 	MLSignal& y = getOutput();
 	
-	static MLSymbol trigSelectSym("trig_select");
-	const bool trigSelect = getParam(trigSelectSym) > 1.f; // this param is 1 or 2
+	if (mParamsChanged) calcCoeffs();
 	
-	static MLSymbol xvelSym("xvel");
-	const bool doMult = (getParam(xvelSym) > 0.f) && !trigSelect;
-    
-	// input change thresholds for state changes
-	const float inputThresh = 0.001f;
-
-	for (int n=0; n<samples; ++n)
+	const bool paramsConstant = delay.isConstant() && attack.isConstant() && decay.isConstant()
+		&& sustain.isConstant() && release.isConstant() && repeat.isConstant();
+	
+	if (!paramsConstant)
 	{
-        float bias = 0.05f;
-        float dxdt, gIn, velIn;
-        bool upTrig, downTrig, crossedThresh, delayCounterDone, doRepeat;
-        
-        // TEMP
-        float attackIn = attack[n] - 0.0001f;
-        attackIn = clamp(attackIn, 0.f, 20.f);
-		
-		// TODO make constant coefficient vectors for constant input parameter signals.
-		// TODO mark/write output signal as constant when we know it is.		
-		// get step sizes(divide approx. will be just fine)
-		// SSE here works on a single instance
+		// step sizes can change every sample, so run the state machine all the way.
+		y.setConstant(false);
+		MLSample* pY = y.getBuffer();
+		for (int n=0; n<samples; ++n)
 		{
-			mSustain = sustain[n];
-			mDelayStep = invSr / max(delay[n], kMinSegTime); 
-			mRepeatStep = (repeat[n] == 0.f) ? 0.f : invSr / max(repeat[n], kMinSegTime);
-			mCAttack =  kMLTwoPi * invSr / max(attackIn, kMinSegTime);
-			mCDecay = kMLTwoPi * invSr / max(decay[n], kMinSegTime);
-//			mCSustain = kMLTwoPi * invSr / ();
-			mCRelease = kMLTwoPi * invSr / max(release[n], kMinSegTime);
+			calcStepSizes(invSr, delay[n], attack[n], decay[n], sustain[n], release[n], repeat[n]);
+			pY[n] = processSample(gate[n], vel[n]);
 		}
-		
-		// process gate input
-		gIn = gate[n];
-		velIn = vel[n];
-		const bool wasOver = mGate1 > inputThresh;
-		const bool isOver = gIn > inputThresh;		
-		upTrig = !wasOver && isOver;
-		downTrig = wasOver && !isOver;
-		
-		// IIR filter.  
-		dxdt = mX - mEnv;
-		mEnv += dxdt * (*mpEnvCoeff);
-		
-		// linear counters. TODO use integers
-		// TODO change repeat interval during repeat for knob or signal change
-		mDelayCounter += mDelayCounterStep;
-		mRepeatCounter += (mState == stateDelay) ? 0.f : mRepeatStep;
-		
-		// did env cross threshold in either direction?
-		crossedThresh = (sign(mEnv - mEnvThresh) != sign(mY1 - mEnvThresh));		
-		delayCounterDone = mDelayCounter > 1.0;
-		// no repeat when sustain is > thresh. (why?)
-		doRepeat = ((mSustain < 0.05f) && (mRepeatCounter > 1.0) && (mRepeatStep > 0.));
-		
-		// did something happen?  usually it doesn't, so we wrap all the branches in just one outer branch.
-		if (upTrig || downTrig || delayCounterDone || doRepeat || crossedThresh)
+		return;
+	}
+	
+	calcStepSizes(invSr, delay[0], attack[0], decay[0], sustain[0], release[0], repeat[0]);
+	
+	// idle, sustain, or waiting in delay for the whole block: output is constant.
+	if ((*mpEnvCoeff == 0.f) && (quietFrames(gate, 0, samples) == samples))
+	{
+		advanceCounters(samples);
+		mGate1 = gate[samples - 1];
+		y.setToConstant(mEnv * mMult * 2.f);
+		return;
+	}
+	
+	// render segments between state changes.
+	y.setConstant(false);
+	MLSample* pY = y.getBuffer();
+	int n = 0;
+	while (n < samples)
+	{
+		const int frames = quietFrames(gate, n, samples);
+		if (frames > 0)
 		{
-			if (upTrig)  // start delay
-			{
-				mDelayCounterStep = mDelayStep;
-				mDelayCounter = 0.f;		
-				mEnvThresh = 0.f;
-				mpEnvCoeff = &mCNull;
-				mEnv = 0.f;
-				mX = 0.f;
-				mState = stateDelay;
-				mMult = doMult ? velIn : 1.f;	// set mMult here only.
-			}
-			else if (delayCounterDone || doRepeat) // start attack
-			{	
-				mRepeatCounter = 0.f;				
-				mDelayCounterStep = 0.f;				
-				mDelayCounter = 0.f;
-				mEnvThresh = 1.f;
-				mX = 1.f + bias;
-				mpEnvCoeff = &mCAttack; 
-				mState = stateAttack;
-			}
-			else if (downTrig) // go to release
-			{	
-				// cancel repeat
-		//		mRepeatCounterStep = 0.;
-		//		mRepeatCounter = 0.;
-				
-				// cancel delay
-				mDelayCounter = 0.f;
-				mDelayCounterStep = 0.f;
-				
-				// release is defined as time to fall to 0 from a value of 1.0.
-				mpEnvCoeff = &mCRelease;
-				mEnvThresh = 0.f;
-				mX = 0.f - bias;
-				mState = stateRelease;
-			}		
-			else if (crossedThresh)
-			{
-				switch(mState)
-				{
-					case stateDelay: // go to attack
-					break;
-					case stateAttack: // go to decay
-						mpEnvCoeff = &mCDecay; 
-						mEnvThresh = mSustain;
-						mX = mSustain - bias;
-						mState = stateDecay;
-					break;
-					case stateDecay: // go to sustain
-						mpEnvCoeff = &mCNull; 
-						mState = stateSustain;
-					break;
-					case stateSustain:
-						// TODO go to new sustain value if level param changes
-						mpEnvCoeff = &mCNull; 
-					break;
-					case stateRelease: // stop at 0
-						mpEnvCoeff = &mCNull; 
-						mEnvThresh = 0.f;
-						mState = stateOff;
-					default:
-					break;
-				}
-			}
+			renderSegment(pY + n, frames);
+			mGate1 = gate[n + frames - 1];
+			n += frames;
+		}
+		else
+		{
+			pY[n] = processSample(gate[n], vel[n]);
+			n++;
 		}
-		
-		mGate1 = gIn;
-		mY1 = mEnv; // history is of linear ramp, before clip and scale
-		mEnv = clamp(mEnv, 0.f, 1.f); // could be avoided by careful attention to overshoots > 1 and < 0		
-		y[n] = mEnv * mMult * 2.f;
 	}
 	
 	/*
@@ -243,4 +417,3 @@ void MLProcEnvelope::process(const int samples)
 
 
 
-   
\ No newline at end of file
@@ -46,7 +46,7 @@ void MLProcHostPhasor::setTimeAndRate(const double secs, const double position,
 		|| ((MLisNaN(bpm)) || (MLisInfinite(bpm)))
 		|| ((MLisNaN(secs)) || (MLisInfinite(secs))) ) 
 	{
-		debug() << "MLProcHostPhasor::setTimeAndRate: bad input! \n";
+		ML_LOG_WARNING("MLProcHostPhasor::setTimeAndRate: bad input! \n");
 		return;
 	}
 	
@@ -49,7 +49,7 @@ MLProc::err MLVoice::resize(int bufSize)
 	MLProc::err ret = MLProc::OK;
 
 	// make delta lists
-	// allow for one change each sample, though this is unlikely to get used.
+	// allow for one change each sample of a process buffer, though this is unlikely to get used.
 	MLProc::err a = mdPitch.setDims(bufSize);
 	MLProc::err j = mdPitchBend.setDims(bufSize);
 	MLProc::err i = mdGate.setDims(bufSize);
@@ -201,6 +201,105 @@ void MLVoice::stealNoteEvent(const MLControlEvent& e, const MLScale& scale, bool
 	mState = kOn;
 }
 
+#pragma mark -
+// ----------------------------------------------------------------
+#pragma mark MLVoiceLists
+// 
+
+MLVoiceLists::MLVoiceLists()
+{
+	for(int i=0; i<MLVoice::kNumStates; ++i)
+	{
+		mHead[i] = mTail[i] = -1;
+	}
+}
+
+void MLVoiceLists::resize(int voices)
+{
+	mPrev.resize(voices);
+	mNext.resize(voices);
+	mState.resize(voices);
+	reset(voices);
+}
+
+void MLVoiceLists::reset(int activeVoices)
+{
+	const int voices = (int)mState.size();
+	for(int i=0; i<MLVoice::kNumStates; ++i)
+	{
+		mHead[i] = mTail[i] = -1;
+	}
+	for(int v=0; v<voices; ++v)
+	{
+		mPrev[v] = mNext[v] = -1;
+		mState[v] = -1;
+	}
+	for(int v=0; v<min(activeVoices, voices); ++v)
+	{
+		pushBack(v, MLVoice::kOff);
+	}
+}
+
+void MLVoiceLists::remove(int v)
+{
+	const int state = mState[v];
+	if(state < 0) return;
+	const int prev = mPrev[v];
+	const int next = mNext[v];
+	if(prev >= 0)
+	{
+		mNext[prev] = next;
+	}
+	else
+	{
+		mHead[state] = next;
+	}
+	if(next >= 0)
+	{
+		mPrev[next] = prev;
+	}
+	else
+	{
+		mTail[state] = prev;
+	}
+	mPrev[v] = mNext[v] = -1;
+	mState[v] = -1;
+}
+
+void MLVoiceLists::pushBack(int v, int state)
+{
+	remove(v);
+	const int tail = mTail[state];
+	mPrev[v] = tail;
+	if(tail >= 0)
+	{
+		mNext[tail] = v;
+	}
+	else
+	{
+		mHead[state] = v;
+	}
+	mTail[state] = v;
+	mState[v] = state;
+}
+
+void MLVoiceLists::pushFront(int v, int state)
+{
+	remove(v);
+	const int head = mHead[state];
+	mNext[v] = head;
+	if(head >= 0)
+	{
+		mPrev[head] = v;
+	}
+	else
+	{
+		mTail[state] = v;
+	}
+	mHead[state] = v;
+	mState[v] = state;
+}
+
 #pragma mark -
 // ----------------------------------------------------------------
 // registry section
@@ -208,7 +307,7 @@ void MLVoice::stealNoteEvent(const MLControlEvent& e, const MLScale& scale, bool
 namespace
 {
 	MLProcRegistryEntry<MLProcInputToSignals> classReg("midi_to_signals");
-	ML_UNUSED MLProcParam<MLProcInputToSignals> params[9] = { "bufsize", "voices", "bend", "mod", "unison", "glide", "protocol", "data_rate" , "scale"};
+	ML_UNUSED MLProcParam<MLProcInputToSignals> params[10] = { "bufsize", "voices", "max_voices", "bend", "mod", "unison", "glide", "protocol", "data_rate" , "scale"};
 	// no input signals.
 	ML_UNUSED MLProcOutput<MLProcInputToSignals> outputs[] = {"*"};	// variable outputs
 }	
@@ -222,13 +321,14 @@ MLProcInputToSignals::MLProcInputToSignals() :
 	mGlissando(false),
 	mUnisonInputTouch(-1),
 	mUnisonVel(0.),
+	mpScale(&mScaleLoader.getScale()),
 	mSustainPedal(false)
 {
 	setParam("voices", 0);	// default
+	setParam("max_voices", kMLEngineMaxVoices);	// default
 	setParam("protocol", kInputProtocolMIDI);	// default
 	setParam("data_rate", 100);	// default
 	
-	mVoiceRotateOffset = 0;
 	mNextEventIdx = 0;
     mEventTimeOffset = 0;
     
@@ -259,9 +359,9 @@ void MLProcInputToSignals::setInputFrameBuffer(PaUtilRingBuffer* pBuf)
 void MLProcInputToSignals::clearChangeLists()
 {
 	// things per voice
-	for (int v=0; v<kMLEngineMaxVoices; ++v)
+	for (auto& voice : mVoices)
 	{
-		mVoices[v].clearChanges();
+		voice.clearChanges();
 	}
 	mMPEMainVoice.clearChanges();
 }
@@ -272,21 +372,24 @@ MLProc::err MLProcInputToSignals::resize()
  	MLProc::err re = OK;
 
 	// resize voices
+	// change lists are cleared by every process() call, which is one vector of 
+	// samples, so they are sized to the vector and not to the host's "bufsize".
+	// this keeps the memory per voice small when there are many voices.
 	//
-	int bufSize = (int)getParam("bufsize");
 	int vecSize = getContextVectorSize();
+	const int voices = (int)mVoices.size();
     
 	MLProc::err r;
-	for(int i=0; i<kMLEngineMaxVoices; ++i)
+	for(int i=0; i<voices; ++i)
 	{
-		r = mVoices[i].resize(bufSize);
+		r = mVoices[i].resize(vecSize);
 		if (!(r == OK))
         {
             debug() << "MLProcInputToSignals: resize error!\n";
             break;
         }
 	}
-	mMPEMainVoice.resize(bufSize);
+	mMPEMainVoice.resize(vecSize);
 
 	// make signals that apply to all voices
 	mTempSignal.setDims(vecSize);
@@ -295,17 +398,16 @@ MLProc::err MLProcInputToSignals::resize()
 	mMainModSignal.setDims(vecSize);
 	mMainMod2Signal.setDims(vecSize);
 	mMainMod3Signal.setDims(vecSize);
+	mRandom.setSeed(getRandomSeed());
 	
-#if defined (__APPLE__)
-	if (!mLatestFrame.setDims(MLT3DHub::kFrameWidth, MLT3DHub::kFrameHeight))
+	if (!mLatestFrame.setDims(kMLTouchFrameWidth, kMLTouchFrameHeight))
 	{
 		return MLProc::memErr;
 	}
-#endif
 
 	// make outputs
 	//
-	for(int i=1; i <= kMLEngineMaxVoices * kNumVoiceSignals; ++i)
+	for(int i=1; i <= voices * kNumVoiceSignals; ++i)
 	{
 		if (!outputIsValid(i))
 		{
@@ -315,7 +417,7 @@ MLProc::err MLProcInputToSignals::resize()
 
 	// do voice params
 	//
-	for(int i=0; i<kMLEngineMaxVoices; ++i)
+	for(int i=0; i<voices; ++i)
 	{
         if((i*kNumVoiceSignals + 1) < getNumOutputs())
         {
@@ -373,60 +475,78 @@ int MLProcInputToSignals::getOutputIndex(const MLSymbol name)
  	return idx;
 }
 
+// make voices for the "max_voices" param. The number of voices playing can then 
+// be changed up to this maximum with the "voices" param without allocating memory.
 void MLProcInputToSignals::setup()
 {
+	int maxVoices = (int)getParam("max_voices");
+	maxVoices = clamp(maxVoices, 1, kMLEngineVoiceLimit);
+	if(maxVoices != (int)mVoices.size())
+	{
+		mVoices.resize(maxVoices);
+		mVoiceLists.resize(maxVoices);
+		mCurrentVoices = min(mCurrentVoices, maxVoices);
+	}
 	doParams();
 }
 
+// start loading a new scale as soon as it is set, so that the audio thread
+// never waits for a scale file to be read and parsed.
+void MLProcInputToSignals::setParam(const MLSymbol p, const MLProperty& val)
+{
+	MLProc::setParam(p, val);
+	if(p == "scale")
+	{
+		mScaleLoader.requestScale(val.getStringValue());
+	}
+}
+
 void MLProcInputToSignals::doParams()
 {
 	int newVoices = (int)getParam("voices");
-	newVoices = clamp(newVoices, 0, 15);
+	newVoices = clamp(newVoices, 0, (int)mVoices.size());
     
     // TODO enable / disable voice containers here
 	mOSCDataRate = (int)getParam("data_rate");
 	
-	const std::string& scaleName = getStringParam("scale");
-	mScale.loadFromRelativePath(scaleName);
-	
 	const int newProtocol = (int)getParam("protocol");	
 	mProtocol = newProtocol;
 	
 	mGlide = getParam("glide");
-	for (int v=0; v<kMLEngineMaxVoices; ++v)
+	for (auto& voice : mVoices)
 	{
-		mVoices[v].mdPitch.setGlideTime(mGlide);
-		mVoices[v].mdPitchBend.setGlideTime(mGlide);
+		voice.mdPitch.setGlideTime(mGlide);
+		voice.mdPitchBend.setGlideTime(mGlide);
 	}
 	mMPEMainVoice.mdPitchBend.setGlideTime(mGlide);
 	
 	switch(mProtocol)
 	{
 		case kInputProtocolOSC:	
-			for(int i=0; i<kMLEngineMaxVoices; ++i)
+			for(auto& voice : mVoices)
 			{
-				mVoices[i].mdGate.setGlideTime(0.0f);
-				mVoices[i].mdAmp.setGlideTime(1.f / (float)mOSCDataRate);
-				mVoices[i].mdVel.setGlideTime(0.0f);
-				mVoices[i].mdNotePressure.setGlideTime(1.f / (float)mOSCDataRate);
-				mVoices[i].mdChannelPressure.setGlideTime(1.f / (float)mOSCDataRate);
-				mVoices[i].mdMod.setGlideTime(1.f / (float)mOSCDataRate);
-				mVoices[i].mdMod2.setGlideTime(1.f / (float)mOSCDataRate);
-				mVoices[i].mdMod3.setGlideTime(1.f / (float)mOSCDataRate);
+				voice.mdGate.setGlideTime(0.0f);
+				voice.mdAmp.setGlideTime(1.f / (float)mOSCDataRate);
+				voice.mdVel.setGlideTime(0.0f);
+				voice.mdNotePressure.setGlideTime(1.f / (float)mOSCDataRate);
+				voice.mdChannelPressure.setGlideTime(1.f / (float)mOSCDataRate);
+				voice.mdMod.setGlideTime(1.f / (float)mOSCDataRate);
+				voice.mdMod2.setGlideTime(1.f / (float)mOSCDataRate);
+				voice.mdMod3.setGlideTime(1.f / (float)mOSCDataRate);
 			}
 			break;
 		case kInputProtocolMIDI:	
 		case kInputProtocolMIDI_MPE:	
-			for(int i=0; i<kMLEngineMaxVoices; ++i)
+			for(auto& voice : mVoices)
 			{
-				mVoices[i].mdGate.setGlideTime(0.f);
-				mVoices[i].mdAmp.setGlideTime(0.001f);
-				mVoices[i].mdVel.setGlideTime(0.f);
-				mVoices[i].mdNotePressure.setGlideTime(0.001f);
-				mVoices[i].mdChannelPressure.setGlideTime(0.001f);
-				mVoices[i].mdMod.setGlideTime(0.001f);
-				mVoices[i].mdMod2.setGlideTime(0.001f);
-				mVoices[i].mdMod3.setGlideTime(0.001f);
+				voice.mdGate.setGlideTime(0.f);
+				voice.mdAmp.setGlideTime(0.001f);
+				voice.mdVel.setGlideTime(0.f);
+				voice.mdNotePressure.setGlideTime(0.001f);
+				voice.mdChannelPressure.setGlideTime(0.001f);
+				voice.mdMod.setGlideTime(0.001f);
+				voice.mdMod2.setGlideTime(0.001f);
+				voice.mdMod3.setGlideTime(0.001f);
 			}
 			break;
 	}
@@ -478,7 +598,8 @@ void MLProcInputToSignals::clear()
 	int outs = getNumOutputs();
 	if (outs)
 	{
-		for (int v=0; v<kMLEngineMaxVoices; ++v)
+		const int voices = (int)mVoices.size();
+		for (int v=0; v<voices; ++v)
 		{
 			mVoices[v].clearState();
 			mVoices[v].clearChanges();
@@ -502,6 +623,7 @@ void MLProcInputToSignals::clear()
 		mMPEMainVoice.clearChanges();
 		mMPEMainVoice.zero();
 	}
+	mVoiceLists.reset(mCurrentVoices);
 	mEventCounter = 0;
 }
 
@@ -521,6 +643,7 @@ void MLProcInputToSignals::clear()
 void MLProcInputToSignals::process(const int frames)
 {	
 	if (mParamsChanged) doParams();
+	mpScale = &mScaleLoader.getScale();
     int sr = getContextSampleRate();
     clearChangeLists();
     
@@ -530,7 +653,7 @@ void MLProcInputToSignals::process(const int frames)
 	{
 		for (int v=0; v<mCurrentVoices; ++v)
 		{
-			float drift = (kDriftConstants[v] * kDriftConstantsAmount) + (MLRand()*kDriftRandomAmount);
+			float drift = (kDriftConstants[v & 15] * kDriftConstantsAmount) + (mRandom.getSample()*kDriftRandomAmount);
 			mVoices[v].mdDrift.addChange(drift, 1);
 		}		
 		mDriftCounter = 0;
@@ -591,6 +714,9 @@ void MLProcInputToSignals::processOSC(const int frames)
 	// reading from OSC.
 
 	if(!mpFrameBuf) return;
+	
+	// a touch frame has one row per touch, which may be fewer than the voices.
+	const int touchVoices = min(mCurrentVoices, kMLTouchFrameHeight);
 
 	// read from mpFrameBuf, which is being filled up by OSC listener thread
 	// we can't simply throw away any frames because they may contain note-ons or note-offs
@@ -613,7 +739,7 @@ void MLProcInputToSignals::processOSC(const int frames)
 			float udx = 0.;
 			float udy = 0.;
 			
-			for (int v=0; v<mCurrentVoices; ++v)
+			for (int v=0; v<touchVoices; ++v)
 			{			
 				x = mLatestFrame(0, v);
 				y = mLatestFrame(1, v);
@@ -628,7 +754,7 @@ void MLProcInputToSignals::processOSC(const int frames)
 						mUnisonInputTouch = v;
 						ux = mVoices[v].mStartX = x;
 						uy = mVoices[v].mStartY = y;
-						upitch = mVoices[v].mPitch = mScale.noteToLogPitch(note);
+						upitch = mVoices[v].mPitch = mpScale->noteToLogPitch(note);
 						udx = 0.f;
 						udy = 0.f;
 						
@@ -653,7 +779,7 @@ void MLProcInputToSignals::processOSC(const int frames)
 					mUnisonInputTouch = -1;
 
 					float maxZ = 0;
-					for (int v=0; v<mCurrentVoices; ++v)
+					for (int v=0; v<touchVoices; ++v)
 					{
 						float zz = mLatestFrame(2, v);
 						if(zz > maxZ)
@@ -671,7 +797,7 @@ void MLProcInputToSignals::processOSC(const int frames)
 					ux = mLatestFrame(0, mUnisonInputTouch);
 					uy = mLatestFrame(1, mUnisonInputTouch);
 					note = mLatestFrame(3, mUnisonInputTouch);
-					upitch = mScale.noteToLogPitch(note);
+					upitch = mpScale->noteToLogPitch(note);
 					udx = ux - mVoices[mUnisonInputTouch].mStartX;
 					udy = uy - mVoices[mUnisonInputTouch].mStartY;
 				}
@@ -694,7 +820,7 @@ void MLProcInputToSignals::processOSC(const int frames)
 		}
 		else 
 		{
-			for (int v=0; v<mCurrentVoices; ++v)
+			for (int v=0; v<touchVoices; ++v)
 			{
 				x = mLatestFrame(0, v);
 				y = mLatestFrame(1, v);
@@ -710,7 +836,7 @@ void MLProcInputToSignals::processOSC(const int frames)
 						// process note on
 						mVoices[v].mStartX = x;
 						mVoices[v].mStartY = y;
-						mVoices[v].mPitch = mScale.noteToLogPitch(note);
+						mVoices[v].mPitch = mpScale->noteToLogPitch(note);
 						
 						// start velocity is sent as first z value over t3d
 						mVoices[v].mStartVel = VelocityFromInitialZ(z);
@@ -720,7 +846,7 @@ void MLProcInputToSignals::processOSC(const int frames)
 					else
 					{
 						// note continues
-						mVoices[v].mPitch = mScale.noteToLogPitch(note);
+						mVoices[v].mPitch = mpScale->noteToLogPitch(note);
 						dx = x - mVoices[v].mStartX;
 						dy = y - mVoices[v].mStartY;
 					}
@@ -815,7 +941,8 @@ void MLProcInputToSignals::doNoteOn(const MLControlEvent& event)
 		}
 		for (int v = 0; v < mCurrentVoices; ++v)
 		{
-			mVoices[v].addNoteEvent(event, mScale);
+			mVoices[v].addNoteEvent(event, *mpScale);
+			voiceStateChanged(v);
 		}
 	}
 	else
@@ -826,24 +953,25 @@ void MLProcInputToSignals::doNoteOn(const MLControlEvent& event)
 				v = findFreeVoice();
 				if(v >= 0)
 				{
-					mVoices[v].addNoteEvent(event, mScale);
+					mVoices[v].addNoteEvent(event, *mpScale);
 				}
 				else
 				{
 					// find a sustained voice to steal
 					v = findOldestSustainedVoice();
 					
-					// or failing that, the voice with the nearest note
+					// or failing that, the oldest playing voice
 					if(v < 0)
 					{
-						int note = event.mValue1;
-						v = findNearestVoice(note);
+						v = findOldestVoice();
 					}
+					if(v < 0) break;
 					
 					// push note we are stealing to pending list and steal it
 					mNoteEventsPending.push(mVoices[v].mCurrentNoteEvent);
-					mVoices[v].stealNoteEvent(event, mScale, true);			
+					mVoices[v].stealNoteEvent(event, *mpScale, true);			
 				}
+				voiceStateChanged(v);
 				break;
 			case kInputProtocolMIDI_MPE:
 				chan = event.mChannel;
@@ -852,12 +980,13 @@ void MLProcInputToSignals::doNoteOn(const MLControlEvent& event)
 					int v = MPEChannelToVoiceIDX(chan);
 					if (mVoices[v].mState == MLVoice::kOff)
 					{
-						mVoices[v].addNoteEvent(event, mScale);
+						mVoices[v].addNoteEvent(event, *mpScale);
 					}
 					else
 					{
-						mVoices[v].stealNoteEvent(event, mScale, true);
+						mVoices[v].stealNoteEvent(event, *mpScale, true);
 					}
+					voiceStateChanged(v);
 				}
 				break;
 		}
@@ -889,7 +1018,8 @@ void MLProcInputToSignals::doNoteOff(const MLControlEvent& event)
 				MLControlEvent pendingEvent = mNoteEventsPending.pop();
 				for (int v = 0; v < mCurrentVoices; ++v)
 				{
-					mVoices[v].stealNoteEvent(pendingEvent, mScale, mGlissando);
+					mVoices[v].stealNoteEvent(pendingEvent, *mpScale, mGlissando);
+					voiceStateChanged(v);
 				}
 			}
 			else
@@ -901,7 +1031,8 @@ void MLProcInputToSignals::doNoteOff(const MLControlEvent& event)
 					MLVoice& voice = mVoices[v];
 					MLControlEvent eventToSend = event;
 					eventToSend.mType = newEventType;
-					voice.addNoteEvent(eventToSend, mScale);
+					voice.addNoteEvent(eventToSend, *mpScale);
+					voiceStateChanged(v);
 				}
 			}
 		}
@@ -916,19 +1047,24 @@ void MLProcInputToSignals::doNoteOff(const MLControlEvent& event)
 		{
 			case kInputProtocolMIDI:
 			{
-				// send either off or sustain event to voices matching instigator
+				// send either off or sustain event to playing voices matching instigator
 				MLControlEvent::EventType newEventType = mSustainPedal ? MLControlEvent::kNoteSustain : MLControlEvent::kNoteOff;
 				int voiceReleased = -1;
-				for(int v=0; v<mCurrentVoices; ++v)
+				int v = mVoiceLists.front(MLVoice::kOn);
+				while(v >= 0)
 				{
+					// get next first, because changing state moves the voice to another list
+					const int next = mVoiceLists.next(v);
 					MLVoice& voice = mVoices[v];
 					if(voice.mInstigatorID == instigator)
 					{
 						voiceReleased = v;
 						MLControlEvent eventToSend = event;
 						eventToSend.mType = newEventType;
-						voice.addNoteEvent(eventToSend, mScale);
+						voice.addNoteEvent(eventToSend, *mpScale);
+						voiceStateChanged(v);
 					}
+					v = next;
 				}
 				
 				// activate pending notes		
@@ -941,7 +1077,8 @@ void MLProcInputToSignals::doNoteOff(const MLControlEvent& event)
 							MLControlEvent pendingEvent = mNoteEventsPending.pop();
 							if(pendingEvent.mValue1 > 0)
 							{
-								mVoices[voiceReleased].stealNoteEvent(pendingEvent, mScale, mGlissando);
+								mVoices[voiceReleased].stealNoteEvent(pendingEvent, *mpScale, mGlissando);
+								voiceStateChanged(voiceReleased);
 							}
 						}
 					}
@@ -959,7 +1096,8 @@ void MLProcInputToSignals::doNoteOff(const MLControlEvent& event)
 					MLVoice& voice = mVoices[voiceReleased];
 					MLControlEvent eventToSend = event;
 					eventToSend.mType = newEventType;
-					voice.addNoteEvent(eventToSend, mScale);
+					voice.addNoteEvent(eventToSend, *mpScale);
+					voiceStateChanged(voiceReleased);
 					
 					if(newEventType == MLControlEvent::kNoteOff)
 					{
@@ -968,7 +1106,8 @@ void MLProcInputToSignals::doNoteOff(const MLControlEvent& event)
 							MLControlEvent pendingEvent = mNoteEventsPending.pop();
 							if(pendingEvent.mValue1 > 0)
 							{
-								mVoices[voiceReleased].stealNoteEvent(pendingEvent, mScale, mGlissando);
+								mVoices[voiceReleased].stealNoteEvent(pendingEvent, *mpScale, mGlissando);
+								voiceStateChanged(voiceReleased);
 							}
 						}
 					}
@@ -984,16 +1123,14 @@ void MLProcInputToSignals::doSustain(const MLControlEvent& event)
     mSustainPedal = (int)event.mValue1;
     if(!mSustainPedal)
     {
-        // clear any sustaining voices
-		for(int i=0; i<mCurrentVoices; ++i)
+        // clear any sustaining voices, oldest first
+		int v;
+		while((v = mVoiceLists.front(MLVoice::kSustain)) >= 0)
 		{
-			MLVoice& v = mVoices[i];
-			if(v.mState == MLVoice::kSustain)
-			{
-				MLControlEvent newEvent;
-				newEvent.mType = MLControlEvent::kNoteOff;
-				v.addNoteEvent(newEvent, mScale);
-			}
+			MLControlEvent newEvent;
+			newEvent.mType = MLControlEvent::kNoteOff;
+			mVoices[v].addNoteEvent(newEvent, *mpScale);
+			voiceStateChanged(v);
 		}
     }
 }
@@ -1150,7 +1287,9 @@ void MLProcInputToSignals::writeOutputSignals(const int frames)
 		mMPEMainVoice.mdMod3.writeToSignal(mMainMod3Signal, frames);
 	}
 	
-	for (int v=0; v<kMLEngineMaxVoices; ++v)
+	// write only the voices we have outputs for
+	const int voices = min((int)mVoices.size(), getNumOutputs() / kNumVoiceSignals);
+	for (int v=0; v<voices; ++v)
 	{
 		// changes per voice
 		MLSignal& pitch = getOutput(v*kNumVoiceSignals + 1);
@@ -1262,91 +1401,40 @@ void MLProcInputToSignals::writeOutputSignals(const int frames)
 
 #pragma mark -
 
-// return index of free voice or -1 for none.
-// increments mVoiceRotateOffset.
-//
-int MLProcInputToSignals::findFreeVoice()
+// after the state of voice v changes, move it to the back of the list for its new state,
+// so that each list stays ordered by age. In rotate mode, freed voices wait behind 
+// all other free voices so their release tails can finish. Otherwise the most 
+// recently freed voice is reused first.
+void MLProcInputToSignals::voiceStateChanged(int v)
 {
-	int r = -1;
-	for (int v = 0; v < mCurrentVoices; ++v)
+	const int state = mVoices[v].mState;
+	if((state == MLVoice::kOff) && !mRotateMode)
 	{
-		int vr = v;
-        if(mRotateMode)
-        {
-            vr = (vr + mVoiceRotateOffset) % mCurrentVoices;
-        }
-        if (mVoices[vr].mState == MLVoice::kOff)
-		{
-			r = vr;
-            mVoiceRotateOffset++;
-			break;
-		}
+		mVoiceLists.pushFront(v, state);
+	}
+	else
+	{
+		mVoiceLists.pushBack(v, state);
 	}
-	return r;
 }
 
-int MLProcInputToSignals::findOldestSustainedVoice()
+// return index of free voice or -1 for none.
+//
+int MLProcInputToSignals::findFreeVoice()
 {
-	int r = -1;
-	std::list<int> sustainedVoices;
-	for (int i=0; i<mCurrentVoices; ++i)
-	{
-		MLVoice& v = mVoices[i];
-		if(v.mState == MLVoice::kSustain)
-		{
-			sustainedVoices.push_back(i);
-		}
-	}
-	
-	int maxAge = -1;
-	for(std::list<int>::const_iterator it = sustainedVoices.begin();
-		it != sustainedVoices.end(); it++)
-	{
-		int voiceIdx = *it;
-		int age = mVoices[voiceIdx].mAge;
-		if (age > maxAge)
-		{
-			maxAge = age;
-			r = voiceIdx;
-		}
-	}
-	return r;
+	return mVoiceLists.front(MLVoice::kOff);
 }
 
-// return the index of the voice with the note nearest to the note n. 
-// Must always return a valid voice index.
-int MLProcInputToSignals::findNearestVoice(int note)
+// return index of the sustained voice that was released first, or -1 for none.
+int MLProcInputToSignals::findOldestSustainedVoice()
 {
-	int r = 0;
-	int minDist = 128;
-	for (int v=0; v<mCurrentVoices; ++v)
-	{
-		int vNote = mVoices[v].mNote;
-		int noteDist = abs(note - vNote);
-		if (noteDist < minDist)
-		{
-			minDist = noteDist;
-			r = v;
-		}
-	}
-	return r;
+	return mVoiceLists.front(MLVoice::kSustain);
 }
 
-// unused
+// return index of the playing voice that started first, or -1 for none.
 int MLProcInputToSignals::findOldestVoice()
 {
-	int r = 0;
-    int maxAge = -1;
-    for (int v=0; v<mCurrentVoices; ++v)
-    {
-        int age = mVoices[v].mAge;
-        if (age > maxAge)
-        {
-            maxAge = age;
-            r = v;
-        }
-    }
-	return r;
+	return mVoiceLists.front(MLVoice::kOn);
 }
 
 int MLProcInputToSignals::MPEChannelToVoiceIDX(int i)
@@ -6,16 +6,20 @@
 #ifndef ML_PROC_MIDI_TO_SIGNALS_H
 #define ML_PROC_MIDI_TO_SIGNALS_H
 
+// project options such as INPUT_DRIFT come from the application's AppConfig.h,
+// which headless builds of the DSP code don't have.
+#if !ML_DSP_ONLY
 #include "AppConfig.h"
+#endif
 
 #include "MLDSP.h"
 #include "MLProc.h"
+#include "MLRandom.h"
 #include "MLScale.h"
+#include "MLScaleLoader.h"
 #include "MLChangeList.h"
 #include "MLInputProtocols.h"
 #include "MLControlEvent.h"
-#include "MLT3DHub.h"
-#include "MLDefaultFileLocations.h"
 
 #include "pa_ringbuffer.h"
 
@@ -29,7 +33,8 @@ public:
 	{
 		kOff,
 		kOn,
-		kSustain
+		kSustain,
+		kNumStates
 	};
 	
 	MLVoice();
@@ -72,6 +77,43 @@ public:
 	MLControlEvent mCurrentNoteEvent;
 };
 
+// lists of voice indices, one for each voice state, each ordered by the time
+// the voices entered that state. Every voice is in at most one list, so all the
+// lists can share one set of links. Finding, adding and removing voices are O(1).
+//
+class MLVoiceLists
+{
+public:
+	MLVoiceLists();
+	~MLVoiceLists() {}
+	
+	// allocate links for the given number of voices. not for the audio thread.
+	void resize(int voices);
+	
+	// put the first activeVoices voices in the kOff list in index order,
+	// and take any others out of all lists. 
+	void reset(int activeVoices);
+	
+	// move voice v to the back or front of the list for the given state.
+	void pushBack(int v, int state);
+	void pushFront(int v, int state);
+	
+	// return the first (oldest) voice in the list for the state, or -1 if empty.
+	int front(int state) const { return mHead[state]; }
+	
+	// return the voice after v in its list, or -1 at the end.
+	int next(int v) const { return mNext[v]; }
+
+private:
+	void remove(int v);
+
+	std::vector<int> mPrev;
+	std::vector<int> mNext;
+	std::vector<int> mState;
+	int mHead[MLVoice::kNumStates];
+	int mTail[MLVoice::kNumStates];
+};
+
 extern const int kNumVoiceSignals;
 extern const MLSymbol voiceSignalNames[];
 
@@ -89,6 +131,7 @@ public:
 	~MLProcInputToSignals();
 	MLProcInfoBase& procInfo() { return mInfo; }
 	int getOutputIndex(const MLSymbol name);
+	void setParam(const MLSymbol p, const MLProperty& val);
 
 	void setInputFrameBuffer(PaUtilRingBuffer* pBuf);
 	void clear();
@@ -123,9 +166,9 @@ private:
 	void dumpVoices();
 	void dumpSignals();
     
+	void voiceStateChanged(int v);
     int findFreeVoice();
     int findOldestSustainedVoice();
-	int findNearestVoice(int note);
     int findOldestVoice();
 	
 	int MPEChannelToVoiceIDX(int i);
@@ -142,15 +185,17 @@ private:
     MLControlEventVector mNoteEventsPlaying;    // notes with keys held down and sounding
     MLControlEventStack mNoteEventsPending;    // notes stolen that may play again when voices are freed
     
-	// the usual voices for each channel
-	MLVoice mVoices[kMLEngineMaxVoices];
+	// the usual voices for each channel, made in setup() for the "max_voices" param.
+	std::vector<MLVoice> mVoices;
+	
+	// voices ordered by state and age, for finding voices to play or steal.
+	MLVoiceLists mVoiceLists;
 	
 	// a special voice for the MPE "Main Channel"
 	// stores main pitch bend and controller inputs, which are added to other voices. 
 	MLVoice mMPEMainVoice;						
 
 	int mNextEventIdx;
-	int mVoiceRotateOffset;
 	
     int mEventTimeOffset;
 	
@@ -160,6 +205,7 @@ private:
 	int mControllerNumber;
 	int mCurrentVoices;
 	int mDriftCounter;
+	MLRandom mRandom;
 	int mEventCounter;
     int mFrameCounter;
 		
@@ -183,7 +229,11 @@ private:
 	MLSignal mMainMod3Signal;
 
 	float mPitchWheelSemitones;
-	MLScale mScale;
+	
+	// scales are loaded off the audio thread. mpScale is updated from the loader
+	// at the start of each process() call.
+	MLScaleLoader mScaleLoader;
+	const MLScale* mpScale;
 	
 	int temp;
 	bool mSustainPedal;
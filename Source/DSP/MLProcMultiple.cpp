@@ -227,3 +227,19 @@ void MLProcMultiple::process(const int samples)
 	
 	MLProcContainer::process(samples);
 }
+
+void MLProcMultiple::addFlatOps(MLFlatOpList& ops, const int frames)
+{
+	ops.addOp(&doParamsFlat, this, frames);
+	MLProcContainer::addFlatOps(ops, frames);
+}
+
+int MLProcMultiple::doParamsFlat(void* pState, const int)
+{
+	MLProcMultiple* pM = static_cast<MLProcMultiple*>(pState);
+	if (pM->mParamsChanged) 
+	{
+		pM->doParams();
+	}
+	return 0;
+}
@@ -25,12 +25,17 @@ public:
 	
 	void doParams();		
 	void process(const int samples);
+	
+	// add an op for our param changes, then our contents.
+	void addFlatOps(MLFlatOpList& ops, const int frames);
 
 	MLProc::err addProc(const MLSymbol className, const MLSymbol procName);
 	MLProcPtr getProc(const MLPath & pathName);
 	
 	MLProcInfoBase& procInfo() { return mInfo; }
 protected:	
+	static int doParamsFlat(void* pState, const int frames);
+
  	MLProcInfo<MLProcMultiple> mInfo;	
 };
 
@@ -7,6 +7,7 @@
 #include <string>
 #include <math.h>
 #include "MLProc.h"
+#include "MLRandom.h"
 
 // ----------------------------------------------------------------
 // class definition
@@ -14,11 +15,17 @@
 class MLProcNoise : public MLProc
 {
 public:
+	MLProcNoise();
+	err resize();
 	void process(const int n);		
 	MLProcInfoBase& procInfo() { return mInfo; }
 
 private:
 	MLProcInfo<MLProcNoise> mInfo;
+	void doParams();
+	
+	MLRandom mRandom;
+	MLSample mGain;
 };
 
 
@@ -36,17 +43,30 @@ namespace
 // ----------------------------------------------------------------
 // implementation
 
+MLProcNoise::MLProcNoise() :
+	mGain(1.f)
+{
+}
+
+// seed from our place in the graph, so each voice makes different noise and
+// the same graph makes the same noise each time it is prepared.
+MLProc::err MLProcNoise::resize()
+{
+	mRandom.setSeed(getRandomSeed());
+	return OK;
+}
+
+void MLProcNoise::doParams()
+{
+	static const MLSymbol gainSym("gain");
+	mGain = getParam(gainSym);
+	mParamsChanged = false;
+}
+
 void MLProcNoise::process(const int samples)
 {	
-	static MLSymbol gainSym("gain");
+	if (mParamsChanged) doParams();
 	MLSignal& y = getOutput();
-	y.setConstant(false); // ?
-	MLSample gain = getParam(gainSym);
-	
-	for (int n=0; n<samples; ++n)
-	{
-		y[n] = MLRand() * gain;
-	}
+	y.setConstant(false);
+	mRandom.fillUniform(y.getBuffer(), samples, mGain);
 }
-
-
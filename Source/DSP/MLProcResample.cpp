@@ -16,6 +16,7 @@
 // that uses the z^-1 for its states, and then rearranging some of the operations.
 
 #include "MLProc.h"
+#include "MLRandom.h"
 
 // ----------------------------------------------------------------
 // allpass
@@ -400,6 +401,7 @@ private:
 	float mx1; // prev input value
 	HalfBandFilter* mFilters[4]; // for second order downsampling
 	MLSignal mUp; // temp buffer for resampling up then down.
+	MLRandom mRandom;
 	
 	void upsample0(MLSample* pSrc, MLSample* pDest, int inFrames, int ratio);
 	void upsample1(MLSample* pSrc, MLSample* pDest, int inFrames, int ratio);
@@ -473,6 +475,7 @@ MLProc::err MLProcResample::resize()
 	{
 		e = MLProc::memErr;
 	}
+	mRandom.setSeed(getRandomSeed());
 	return e;
 }
 
@@ -668,7 +671,7 @@ void MLProcResample::downsample2(MLSample* pSrc, MLSample* pDest, int inFrames,
 		case 2:
 			for (int n = 0; n < inFrames; n += 2)
 			{
-				MLSample sss = MLRand() * noiseAmp;
+				MLSample sss = mRandom.getSample() * noiseAmp;
 				mFilters[0]->process(pSrc[n] + sss);
 				pDest[m++] = mFilters[0]->process(pSrc[n + 1] + sss);	
 			}
@@ -31,6 +31,10 @@ MLProcRingBuffer::MLProcRingBuffer()
 	setParam("length", kMLRingBufferDefaultSize);	
 	setParam("mode", eMLRingBufferNoTrash);
 	mTrig1 = -1.f;
+	mpChangeSequence = 0;
+	mLastWritten = 0.f;
+	mSamplesSinceChange = 0;
+	mLength = 0;
 }
 
 
@@ -64,6 +68,10 @@ MLProc::err MLProcRingBuffer::resize()
 			mTrashSignal.setDims(size);	
 		}
 	}
+	
+	mLength = (int)getParam("length");
+	mLastWritten = 0.f;
+	mSamplesSinceChange = 0;
 
 	return e;
 }
@@ -94,16 +102,47 @@ void MLProcRingBuffer::process(const int frames)
 				
 //	debug() << "wrote " << written << " from " << (void *)x.getConstBuffer() << "\n"; 
 	}
+	
+	if (mpChangeSequence)
+	{
+		// did the input differ from the last sample written?
+		bool changed = false;
+		if (x.isConstant())
+		{
+			changed = (x[0] != mLastWritten);
+			mLastWritten = x[0];
+		}
+		else
+		{
+			const MLSample* px = x.getConstBuffer();
+			for (int n=0; n<frames; ++n)
+			{
+				if (px[n] != mLastWritten)
+				{
+					changed = true;
+					break;
+				}
+			}
+			mLastWritten = px[frames - 1];
+		}
+		
+		// keep counting changes until the last change has scrolled out of a reader's view.
+		mSamplesSinceChange = changed ? 0 : min(mSamplesSinceChange + frames, mLength);
+		if (mSamplesSinceChange < mLength)
+		{
+			mpChangeSequence->fetch_add(1, std::memory_order_release);
+		}
+	}
 }
 
-// read a ring buffer into the given row of the destination signal.
+// read a ring buffer into the first row of the destination view.
 //
-int MLProcRingBuffer::readToSignal(MLSignal& outSig, int samples, int row)
+int MLProcRingBuffer::readToSignal(const MLSignalRef& out, int samples)
 {
 	int lastRead = 0;
 	int skipped = 0;
 	int available = 0;
-	MLSample * outBuffer = outSig.getBuffer() + outSig.row(row);
+	MLSample * outBuffer = out.getRow(0);
 	void * trashBuffer = (void *)mTrashSignal.getBuffer();
 	MLSample * trashbufferAsSamples = reinterpret_cast<MLSample*>(trashBuffer);
 	static MLSymbol modeSym("mode");
@@ -111,7 +150,7 @@ int MLProcRingBuffer::readToSignal(MLSignal& outSig, int samples, int row)
 	bool underTrigger = false;
 	MLSample triggerVal = 0.f;
 		
-	samples = min(samples, (int)outSig.getWidth());
+	samples = min(samples, out.getWidth());
 	available = (int)PaUtil_GetRingBufferReadAvailable( &mBuf );
     
     // return if we have not accumulated enough signal.
@@ -9,6 +9,8 @@
 #include "MLProc.h"
 #include "pa_ringbuffer.h"
 
+#include <atomic>
+
 extern const uint32_t RingBufferConstants[16];
 
 // default size in samples.  should equal kMLSignalViewBufferSize. (MLUI.h)
@@ -35,10 +37,16 @@ public:
 	void clear(){};
 	void process(const int n);		
 
-	// read the buffer contents out to the specified row of the given signal.
-	int readToSignal(MLSignal& outSig, int samples, int row=0);
+	// read the buffer contents out to the first row of the view, which can be
+	// a row of a larger signal. 
+	int readToSignal(const MLSignalRef& out, int samples);
 	const MLSignal& getOutputSignal();
 	MLProcInfoBase& procInfo() { return mInfo; }
+	
+	// set a counter to increment each time process() writes samples that change
+	// what a reader of the last "length" samples would see. The counter can be
+	// shared between the voices of a published signal.
+	void setChangeSequence(std::atomic<uint32_t>* pSeq) { mpChangeSequence = pSeq; }
 
 private:
 	err resize(); // rebuilds buffer 
@@ -51,6 +59,11 @@ private:
 	
 	MLSignal test;
 	MLSample mTrig1;
+	
+	std::atomic<uint32_t>* mpChangeSequence;
+	MLSample mLastWritten;
+	int mSamplesSinceChange;
+	int mLength;
 };
 
 
@@ -5,20 +5,25 @@
 
 #include "MLProperty.h"
 
+#include <algorithm>
+
 #pragma mark MLProperty
 
 const std::string MLProperty::nullString;
 const MLSignal MLProperty::nullSignal;
 
+// properties that aren't signals keep a signal of size 1, which doesn't allocate.
 MLProperty::MLProperty() :
 	mType(kUndefinedProperty),
-	mFloatVal(0)
+	mFloatVal(0),
+	mSignalVal(1)
 {
 }
 
 MLProperty::MLProperty(const MLProperty& other) :
 	mType(other.getType()),
-	mFloatVal(0)
+	mFloatVal(0),
+	mSignalVal(1)
 {
 	switch(mType)
 	{
@@ -60,21 +65,24 @@ MLProperty& MLProperty::operator= (const MLProperty& other)
 }
 
 MLProperty::MLProperty(float v) :
-	mType(kFloatProperty)
+	mType(kFloatProperty),
+	mSignalVal(1)
 {
 	mFloatVal = v;
 }
 
 MLProperty::MLProperty(const std::string& s) :
-	mType(kStringProperty)
+	mType(kStringProperty),
+	mSignalVal(1)
 {
 	mStringVal = s.c_str();
 }
 
 MLProperty::MLProperty(const MLSignal& s) :
-	mType(kSignalProperty)
+	mType(kSignalProperty),
+	mFloatVal(0),
+	mSignalVal(s)
 {
-	mSignalVal = s;
 }
 
 MLProperty::~MLProperty()
@@ -194,10 +202,10 @@ const MLProperty& MLPropertySet::getProperty(MLSymbol p) const
 {
 	static const MLProperty nullProperty;
 	
-	std::map<MLSymbol, MLProperty>::const_iterator it = mProperties.find(p);
-	if(it != mProperties.end())
+	int i = findPropertyIndex(p);
+	if(i >= 0)
 	{
-		return it->second;
+		return mProperties[i];
 	}
 	else
 	{
@@ -209,10 +217,10 @@ const float& MLPropertySet::getFloatProperty(MLSymbol p) const
 {
 	static const float nullFloat = 0.f;
 
-	std::map<MLSymbol, MLProperty>::const_iterator it = mProperties.find(p);
-	if(it != mProperties.end())
+	int i = findPropertyIndex(p);
+	if(i >= 0)
 	{
-		return it->second.getFloatValue();
+		return mProperties[i].getFloatValue();
 	}
 	else
 	{
@@ -222,10 +230,10 @@ const float& MLPropertySet::getFloatProperty(MLSymbol p) const
 
 const std::string& MLPropertySet::getStringProperty(MLSymbol p) const
 {
-	std::map<MLSymbol, MLProperty>::const_iterator it = mProperties.find(p);
-	if(it != mProperties.end())
+	int i = findPropertyIndex(p);
+	if(i >= 0)
 	{
-		return it->second.getStringValue();
+		return mProperties[i].getStringValue();
 	}
 	else
 	{
@@ -235,10 +243,10 @@ const std::string& MLPropertySet::getStringProperty(MLSymbol p) const
 
 const MLSignal& MLPropertySet::getSignalProperty(MLSymbol p) const
 {
-	std::map<MLSymbol, MLProperty>::const_iterator it = mProperties.find(p);
-	if(it != mProperties.end())
+	int i = findPropertyIndex(p);
+	if(i >= 0)
 	{
-		return it->second.getSignalValue();
+		return mProperties[i].getSignalValue();
 	}
 	else
 	{
@@ -246,6 +254,29 @@ const MLSignal& MLPropertySet::getSignalProperty(MLSymbol p) const
 	}
 }
 
+int MLPropertySet::findPropertyIndex(MLSymbol p) const
+{
+	std::map<MLSymbol, int>::const_iterator it = mPropertyIndices.find(p);
+	if(it != mPropertyIndices.end())
+	{
+		return it->second;
+	}
+	return -1;
+}
+
+int MLPropertySet::getPropertyIndex(MLSymbol p)
+{
+	int i = findPropertyIndex(p);
+	if(i < 0)
+	{
+		i = mProperties.size();
+		mProperties.push_back(MLProperty());
+		mPropertyNames.push_back(p);
+		mPropertyIndices[p] = i;
+	}
+	return i;
+}
+
 // TODO check for duplicates! That could lead to a crash.
 void MLPropertySet::addPropertyListener(MLPropertyListener* pL)
 {
@@ -266,17 +297,17 @@ void MLPropertySet::removePropertyListener(MLPropertyListener* pToRemove)
 	}
 }
 
-void MLPropertySet::broadcastProperty(MLSymbol p, bool immediate)
+void MLPropertySet::broadcastProperty(int i, bool immediate)
 {
 	std::list<MLPropertyListener*>::iterator it;
 	for(it = mpListeners.begin(); it != mpListeners.end(); it++)
 	{
 		MLPropertyListener* pL = *it;
-		pL->propertyChanged(p, immediate);
+		pL->propertyChanged(i, immediate);
 	}
 }
 
-void MLPropertySet::broadcastPropertyExcludingListener(MLSymbol p, bool immediate, MLPropertyListener* pListenerToExclude)
+void MLPropertySet::broadcastPropertyExcludingListener(int i, bool immediate, MLPropertyListener* pListenerToExclude)
 {
 	std::list<MLPropertyListener*>::iterator it;
 	for(it = mpListeners.begin(); it != mpListeners.end(); it++)
@@ -284,39 +315,55 @@ void MLPropertySet::broadcastPropertyExcludingListener(MLSymbol p, bool immediat
 		MLPropertyListener* pL = *it;
 		if(pL != pListenerToExclude)
 		{
-			pL->propertyChanged(p, immediate);
+			pL->propertyChanged(i, immediate);
 		}
 	}
 }
 
 void MLPropertySet::broadcastAllProperties()
 {
-	std::map<MLSymbol, MLProperty>::const_iterator it;
-	for(it = mProperties.begin(); it != mProperties.end(); it++)
+	const int n = mProperties.size();
+	for(int i = 0; i < n; ++i)
 	{
-		MLSymbol p = it->first;
-		broadcastProperty(p, false);
+		broadcastProperty(i, false);
 	}
 }
 
 #pragma mark MLPropertyListener
 
+const int MLPropertyListener::kMaxProperties;
+const int MLPropertyListener::kDirtyWords;
+
+void MLPropertyListener::setChanged(int i)
+{
+	mDirtyBits[i >> 6].fetch_or(1ULL << (i & 63));
+}
+
 void MLPropertyListener::updateChangedProperties()
 {
     if(!mpPropertyOwner) return;
-	// for all model parameters we know about
-	std::map<MLSymbol, PropertyState>::iterator it;
-	for(it = mPropertyStates.begin(); it != mPropertyStates.end(); it++)
+	
+	// visit only the properties with bits set. The lock is not held during the
+	// action, which may set properties and so come back to propertyChanged().
+	for(int w = 0; w < kDirtyWords; ++w)
 	{
-		MLSymbol key = it->first;
-		PropertyState& state = it->second;
-		
-		if(state.mChangedSinceUpdate)
+		uint64_t bits = mDirtyBits[w].exchange(0);
+		for(int i = w << 6; bits; bits >>= 1, ++i)
 		{
-			const MLProperty& newValue = mpPropertyOwner->getProperty(key);
-			doPropertyChangeAction(key, newValue);
-			state.mChangedSinceUpdate = false;			
-			state.mValue = newValue;
+			if(bits & 1)
+			{
+				const MLProperty& newValue = mpPropertyOwner->getPropertyAtIndex(i);
+				MLSymbol name;
+				{
+					std::lock_guard<std::mutex> lock(mStatesLock);
+					name = mPropertyStates[i].mName;
+				}
+				doPropertyChangeAction(name, newValue);
+				{
+					std::lock_guard<std::mutex> lock(mStatesLock);
+					mPropertyStates[i].mValue = newValue;
+				}
+			}
 		}
 	}
 }
@@ -327,35 +374,63 @@ void MLPropertyListener::updateAllProperties()
 	mpPropertyOwner->broadcastAllProperties();
 
 	// mark all states as changed
-	std::map<MLSymbol, PropertyState>::iterator it;
-	for(it = mPropertyStates.begin(); it != mPropertyStates.end(); it++)
 	{
-		PropertyState& state = it->second;
-		state.mChangedSinceUpdate = true;
+		std::lock_guard<std::mutex> lock(mStatesLock);
+		const int n = mPropertyStates.size();
+		for(int i = 0; i < n; ++i)
+		{
+			if(mPropertyStates[i].mKnown)
+			{
+				setChanged(i);
+			}
+		}
 	}
 	
 	updateChangedProperties();
 }
 
-void MLPropertyListener::propertyChanged(MLSymbol propName, bool immediate)
+void MLPropertyListener::propertyChanged(int i, bool immediate)
 {
     if(!mpPropertyOwner) return;
+	if((i < 0) || (i >= kMaxProperties)) return;
     
-	// if the property does not exist in the map yet, this lookup will add it.
-	PropertyState& state = mPropertyStates[propName];
+	const MLProperty& ownerValue = mpPropertyOwner->getPropertyAtIndex(i);
+	MLSymbol name;
+	bool changed;
+	{
+		std::lock_guard<std::mutex> lock(mStatesLock);
+		if(i >= (int)mPropertyStates.size())
+		{
+			mPropertyStates.resize(i + 1);
+		}
+		PropertyState& state = mPropertyStates[i];
+		
+		// a property we have not seen before is always reported at the next update.
+		if(!state.mKnown)
+		{
+			state.mKnown = true;
+			state.mName = mpPropertyOwner->getPropertyName(i);
+			setChanged(i);
+		}
+		
+		// check for change in property. Note that this also compares signals and strings, which may possibly be slow.
+		changed = (ownerValue != state.mValue);
+		if(changed && immediate)
+		{
+			state.mValue = ownerValue;
+		}
+		name = state.mName;
+	}
 	
-	// check for change in property. Note that this also compares signals and strings, which may possibly be slow.
-    const MLProperty& ownerValue = mpPropertyOwner->getProperty(propName);	
-	if(ownerValue != state.mValue)
+	if(changed)
     {
 		if(immediate)
 		{
-			doPropertyChangeAction(propName, ownerValue);
-			state.mValue = ownerValue;
+			doPropertyChangeAction(name, ownerValue);
 		}
 		else
 		{
-			state.mChangedSinceUpdate = true;
+			setChanged(i);
 		}
     }
 }
@@ -365,4 +440,3 @@ void MLPropertyListener::propertyOwnerClosing()
     if(!mpPropertyOwner) return;
     mpPropertyOwner = nullptr;
 }
-
@@ -9,6 +9,12 @@
 #include <string>
 #include <list>
 #include <map>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
 #include "MLSignal.h"
 #include "MLSymbol.h"
 #include "MLDebug.h"
@@ -71,7 +77,10 @@ private:
 
 std::ostream& operator<< (std::ostream& out, const MLProperty & r);
 
-// MLPropertySet: a Set of Properties. Property names are stored as keys to the property map.
+// MLPropertySet: a Set of Properties. Each property is stored in a slot with a dense integer
+// index, which stays the same for the life of the set. A map from property names to indices is
+// used to resolve names, so code that sets the same property often can look up its index once
+// with getPropertyIndex() and then use the index versions of the get and set methods.
 
 class MLPropertyListener;
 
@@ -87,22 +96,39 @@ public:
 	const float& getFloatProperty(MLSymbol p) const;
 	const std::string& getStringProperty(MLSymbol p) const;
 	const MLSignal& getSignalProperty(MLSymbol p) const;
+	
+	// return the index of the named property, adding an undefined property if it does not exist.
+	int getPropertyIndex(MLSymbol p);
+	
+	// return the index of the named property, or -1 if it does not exist.
+	int findPropertyIndex(MLSymbol p) const;
+	
+	int getNumProperties() const { return mProperties.size(); }
+	const MLProperty& getPropertyAtIndex(int i) const { return mProperties[i]; }
+	MLSymbol getPropertyName(int i) const { return mPropertyNames[i]; }
     
 	// set the property and allow it to propagate to Listeners the next time
 	// each Listener calls updateChangedProperties().
 	template <typename T>
 	void setProperty(MLSymbol p, T v)
 	{
-		mProperties[p].setValue(v);
-		broadcastProperty(p, false);
+		setPropertyAtIndex(getPropertyIndex(p), v);
+	}
+
+	template <typename T>
+	void setPropertyAtIndex(int i, T v)
+	{
+		mProperties[i].setValue(v);
+		broadcastProperty(i, false);
 	}
 
 	// set the property and propagate to Listeners immediately.
 	template <typename T>
 	void setPropertyImmediate(MLSymbol p, T v)
 	{
-		mProperties[p].setValue(v);
-		broadcastProperty(p, true);
+		int i = getPropertyIndex(p);
+		mProperties[i].setValue(v);
+		broadcastProperty(i, true);
 	}
 	
 	// set the property and propagate to Listeners immediately,
@@ -110,8 +136,9 @@ public:
 	template <typename T>
 	void setPropertyImmediateExcludingListener(MLSymbol p, T v, MLPropertyListener* pL)
 	{
-		mProperties[p].setValue(v);
-		broadcastPropertyExcludingListener(p, true, pL);
+		int i = getPropertyIndex(p);
+		mProperties[i].setValue(v);
+		broadcastPropertyExcludingListener(i, true, pL);
 	}
 	
     void broadcastAllProperties();
@@ -123,22 +150,40 @@ protected:
 	void removePropertyListener(MLPropertyListener* pToRemove);
 	
 private:
-	std::map<MLSymbol, MLProperty> mProperties;
+	// property slots. a deque keeps references to existing properties valid as slots are added.
+	std::deque<MLProperty> mProperties;
+	std::vector<MLSymbol> mPropertyNames;
+	std::map<MLSymbol, int> mPropertyIndices;
 	std::list<MLPropertyListener*> mpListeners;
 	
-	void broadcastProperty(MLSymbol p, bool immediate);
-	void broadcastPropertyExcludingListener(MLSymbol p, bool immediate, MLPropertyListener* pListenerToExclude);
+	void broadcastProperty(int i, bool immediate);
+	void broadcastPropertyExcludingListener(int i, bool immediate, MLPropertyListener* pListenerToExclude);
 };
 
 // MLPropertyListeners are notified when a Property of an MLPropertySet changes. They do something in
 // response by overriding doPropertyChangeAction().
+//
+// Each listener keeps the last value it saw of each property in a vector indexed like the owner's
+// slots, and marks changed properties in a bitset. updateChangedProperties() visits only the
+// properties whose bits are set, so it costs almost nothing when nothing has changed.
+//
+// Properties may be set on other threads than the one calling updateChangedProperties(), as
+// when OSC input sets properties of a plugin. So the bitset has a fixed size of kMaxProperties
+// bits and is never moved, and the states are only used with mStatesLock held. Properties past
+// kMaxProperties are not reported.
 
 class MLPropertyListener
 {
     friend class MLPropertySet;
 public:
-	MLPropertyListener(MLPropertySet* m) : mpPropertyOwner(m)
+	static const int kMaxProperties = 1 << 12;
+	
+	MLPropertyListener(MLPropertySet* m) : mpPropertyOwner(m), mDirtyBits(new std::atomic<uint64_t>[kDirtyWords])
     {
+		for(int w = 0; w < kDirtyWords; ++w)
+		{
+			mDirtyBits[w] = 0;
+		}
         mpPropertyOwner->addPropertyListener(this);
     }
     
@@ -161,10 +206,10 @@ public:
     
 protected:
 
-    // called by a PropertySet to notify us that one property has changed.
+    // called by a PropertySet to notify us that the property in slot i has changed.
 	// if the property is new, or the value has changed, we mark the state as changed.
 	// If immediate is true and the state has changed, doPropertyChangeAction() will be called.
-	void propertyChanged(MLSymbol p, bool immediate);
+	void propertyChanged(int i, bool immediate);
     
 	// Must be called by the Property owner to notify us in the event it is going away.
     void propertyOwnerClosing();
@@ -173,17 +218,28 @@ protected:
 	class PropertyState
 	{
 	public:
-		PropertyState() : mChangedSinceUpdate(true) {}
+		PropertyState() : mKnown(false) {}
 		~PropertyState() {}
 		
-		bool mChangedSinceUpdate;
+		// true once the owner has told us about this property.
+		bool mKnown;
+		MLSymbol mName;
 		MLProperty mValue;
 	};
     
-	std::map<MLSymbol, PropertyState> mPropertyStates;
+	// indexed by the owner's property slots. Hold mStatesLock to use these.
+	std::vector<PropertyState> mPropertyStates;
+	std::mutex mStatesLock;
 	MLPropertySet* mpPropertyOwner;
-};
 
+private:
+	static const int kDirtyWords = kMaxProperties/64;
+	
+	void setChanged(int i);
+	
+	// one bit per property slot, set when the property has changed since the last update.
+	std::unique_ptr<std::atomic<uint64_t>[]> mDirtyBits;
+};
 typedef std::shared_ptr<MLPropertyListener> MLPropertyListenerPtr;
 
 #endif // __ML_PROPERTY__
@@ -50,6 +50,16 @@ int MLRingBuffer::write(const MLSample* pSrc, int samples)
 	}
 	return r;
 }
+
+int MLRingBuffer::writeConstant(MLSample val, int samples)
+{
+	int r = 0;
+	if (pData)
+	{
+		r = PaUtil_WriteRingBufferConstant( &mBuf, val, samples );
+	}
+	return r;
+}
 		
 int MLRingBuffer::read(MLSample* pDest, int samples)
 {
@@ -25,6 +25,7 @@ public:
 	int getRemaining();
 		
 	int write(const MLSample* pSrc, int samples);
+	int writeConstant(MLSample val, int samples);
 	int read(MLSample* pDest, int samples);
 
 	PaUtilRingBuffer mBuf;
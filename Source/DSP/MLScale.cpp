@@ -5,6 +5,21 @@
 
 #include "MLScale.h"
 
+#include <fstream>
+
+namespace
+{
+	bool readFileToString(const std::string& path, std::string& str)
+	{
+		std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+		if(!in) return false;
+		std::ostringstream contents;
+		contents << in.rdbuf();
+		str = contents.str();
+		return true;
+	}
+}
+
 MLScale::MLScale()
 {
 	setDefaultScale();
@@ -21,12 +36,12 @@ void MLScale::operator= (const MLScale& b)
 {
 	mName = b.mName;
 	mDescription = b.mDescription;
+	mKeyMap = b.mKeyMap;
 	mRatioList = b.mRatioList;
-	for(int p=0; p<kMLNumRatios; ++p)
-	{
-		mRatios[p] = b.mRatios[p];
-		mPitches[p] = b.mPitches[p];
-	}
+	std::copy(b.mRatios, b.mRatios + kMLNumRatios, mRatios);
+	std::copy(b.mPitches, b.mPitches + kMLNumRatios, mPitches);
+	std::copy(b.mLogPitches, b.mLogPitches + kMLNumLogPitches, mLogPitches);
+	mScalePath = b.mScalePath;
 }
 
 void MLScale::setDefaults()
@@ -113,6 +128,14 @@ void MLScale::recalcRatios()
 		mRatios[i] = (float)octaveStartRatio*mRatioList[mKeyMap.mNotes[degree]]*mKeyMap.mTonicFreq/440.0f;
 		mPitches[i] = log2f(mRatios[i]);
 	}
+	
+	// tabulate log pitch between notes. The last entry repeats the highest note, so
+	// noteToLogPitch() can always read one entry past the note.
+	const float stepSize = 1.f / kMLLogPitchStepsPerNote;
+	for (int i=0; i < kMLNumLogPitches; ++i)
+	{
+		mLogPitches[i] = log2f(noteToPitch(i*stepSize));
+	}
 }
 
 void MLScale::loadFromString(const std::string& scaleStr, const std::string& mapStr)
@@ -246,42 +269,24 @@ int MLScale::loadMappingFromString(const std::string& mapStr)
 	return mKeyMap.mNotes.size();
 }
 
-// TODO: look at moving this code and similar kinds to a loader utilities / file helpers object or something.
-// the impetus is that an object like MLScale really shouldn't know about Files.
-// scales are used by procs, which also shouldn't really have to know about Files. so maybe the MLProc
-// gets the i/o utility through the help of its Context.
-void MLScale::loadFromRelativePath(const std::string& scaleName)
+void MLScale::loadFromFile(const std::string& sclPath)
 {
-	if(scaleName != mScalePath)
+	std::string scaleStr;
+	if(readFileToString(sclPath, scaleStr))
 	{
-		File scaleRoot = getDefaultFileLocation(kScaleFiles);
-		if (scaleRoot.exists() && scaleRoot.isDirectory())
-		{
-			// TODO add MLFile methods so this can all be done with MLFiles and std::string
-			File scaleFile = scaleRoot.getChildFile(String(scaleName.c_str())).withFileExtension(".scl");
-			if(scaleFile.exists())
-			{
-				String scaleStr = scaleFile.loadFileAsString();
-				
-				// look for .kbm mapping file
-				String mapStr;
-				File mappingFile = scaleFile.withFileExtension(".kbm");
-				if(mappingFile.exists())
-				{
-					mapStr = mappingFile.loadFileAsString();
-				}
-				
-				loadFromString(std::string(scaleStr.toUTF8()), std::string(mapStr.toUTF8()));
-			}
-			else
-			{
-				// default is 12-equal
-				setDefaults();
-			}
-		}
-		// use of c_str preventing possible move assignment if (= std::string) were used. TODO revisit!
-		mScalePath = scaleName.c_str();
+		// look for .kbm mapping file
+		std::string mapStr;
+		const std::string::size_type dot = sclPath.find_last_of('.');
+		const std::string basePath = (dot == std::string::npos) ? sclPath : sclPath.substr(0, dot);
+		readFileToString(basePath + ".kbm", mapStr);
+		loadFromString(scaleStr, mapStr);
 	}
+	else
+	{
+		// default is 12-equal
+		setDefaults();
+	}
+	mScalePath = sclPath;
 }
 
 float MLScale::noteToPitch(float note) const
@@ -303,7 +308,10 @@ float MLScale::noteToPitch(int note) const
 
 float MLScale::noteToLogPitch(float note) const
 {
-	return log2f(noteToPitch(clamp(note, 0.f, 127.f)));
+	float fn = clamp(note, 0.f, (float)(kMLNumScaleNotes - 1))*kMLLogPitchStepsPerNote;
+	int i = fn;
+	float fracPart = fn - i;
+	return lerp(mLogPitches[i], mLogPitches[i + 1], fracPart);
 }
 
 float MLScale::quantizePitch(float a) const
@@ -12,11 +12,13 @@
 #include "MLDSP.h"
 #include "MLDebug.h"
 
-#include "MLDefaultFileLocations.h" // to remove
-
 const int kMLNumRatios = 256;
 const int kMLNumScaleNotes = 128;
 
+// resolution of the table used to convert fractional notes to log pitch.
+const int kMLLogPitchStepsPerNote = 16;
+const int kMLNumLogPitches = (kMLNumScaleNotes - 1)*kMLLogPitchStepsPerNote + 2;
+
 class MLScale
 {
 
@@ -30,13 +32,16 @@ public:
 	// load a scale from an input string along with an optional mapping.
 	void loadFromString(const std::string& scaleStr, const std::string& mapStr = "");
 	
-	void loadFromRelativePath(const std::string& path);
+	// load a scale from a .scl file, along with a .kbm mapping file of the same name if
+	// one exists. If the scale file can't be read, the default scale is loaded.
+	void loadFromFile(const std::string& sclPath);
 	
 	// convert a note number into a pitch ratio from 440.0 Hz, using the currently loaded scale.
 	float noteToPitch(float note) const;
 	float noteToPitch(int note) const;
 
 	// return pitch of the given note in log pitch (1.0 per octave) space with 440.0Hz = 0.
+	// Fractional notes are interpolated from a table, so no logs are taken.
 	float noteToLogPitch(float note) const;
 
 	// return log pitch of the note of the current scale closest to the input.
@@ -55,7 +60,7 @@ private:
 	// add a ratio expressed in cents.
 	void addRatio(double c);
 	
-	// recalculate of all ratios in mRatios.
+	// recalculate all ratios in mRatios, and the pitch tables made from them.
 	void recalcRatios();
 
 	// load a map from an input string.
@@ -101,6 +106,9 @@ private:
 	// pitches stored in linear octave space. pitch = log2(ratio).
 	float mPitches[kMLNumRatios];
 	
+	// log2(noteToPitch(n)) at kMLLogPitchStepsPerNote steps per note, for interpolation.
+	float mLogPitches[kMLNumLogPitches];
+	
 	std::string mScalePath; 
 };
 
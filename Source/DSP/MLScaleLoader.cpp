@@ -0,0 +1,151 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLScaleLoader.h"
+
+#include <map>
+#include <memory>
+
+namespace
+{
+	typedef std::map<std::string, std::unique_ptr<MLScale> > ScaleCache;
+
+	std::mutex& getCacheLock()
+	{
+		static std::mutex lock;
+		return lock;
+	}
+
+	ScaleCache& getCache()
+	{
+		static ScaleCache cache;
+		return cache;
+	}
+
+	// guarded by the cache lock.
+	std::string& getScaleRoot()
+	{
+		static std::string root;
+		return root;
+	}
+}
+
+MLScaleLoader::MLScaleLoader() :
+	mHasRequest(false),
+	mLoading(false),
+	mpPending(0),
+	mpScale(getCachedScale(""))
+{
+}
+
+MLScaleLoader::~MLScaleLoader()
+{
+	joinLoadThread();
+}
+
+void MLScaleLoader::joinLoadThread()
+{
+	if(mLoadThread.joinable())
+	{
+		mLoadThread.join();
+	}
+}
+
+// ----------------------------------------------------------------
+#pragma mark any thread but the audio thread
+
+void MLScaleLoader::setScaleRoot(const std::string& dir)
+{
+	std::lock_guard<std::mutex> lock(getCacheLock());
+	getScaleRoot() = dir;
+}
+
+const MLScale* MLScaleLoader::getCachedScale(const std::string& path)
+{
+	// scales are cached by full path, or "" for the default scale.
+	std::string fullPath;
+	{
+		std::lock_guard<std::mutex> lock(getCacheLock());
+		if(!path.empty() && !getScaleRoot().empty())
+		{
+			fullPath = getScaleRoot() + "/" + path + ".scl";
+		}
+		ScaleCache::const_iterator it = getCache().find(fullPath);
+		if(it != getCache().end())
+		{
+			return it->second.get();
+		}
+	}
+	
+	// load outside the lock, so that reading one file does not hold up lookups
+	// of scales already cached. 
+	std::unique_ptr<MLScale> pScale(new MLScale);
+	if(!fullPath.empty())
+	{
+		pScale->loadFromFile(fullPath);
+	}
+	
+	// if another thread loaded the same scale meanwhile, keep the first one.
+	std::lock_guard<std::mutex> lock(getCacheLock());
+	std::unique_ptr<MLScale>& entry = getCache()[fullPath];
+	if(!entry)
+	{
+		entry = std::move(pScale);
+	}
+	return entry.get();
+}
+
+void MLScaleLoader::requestScale(const std::string& path)
+{
+	bool startThread = false;
+	{
+		std::lock_guard<std::mutex> lock(mRequestLock);
+		mRequestPath = path;
+		mHasRequest = true;
+		if(!mLoading)
+		{
+			mLoading = true;
+			startThread = true;
+		}
+	}
+	
+	// a thread that has cleared mLoading has no more work, so this join is brief.
+	if(startThread)
+	{
+		joinLoadThread();
+		mLoadThread = std::thread([this]() { loadRequests(); });
+	}
+}
+
+void MLScaleLoader::loadRequests()
+{
+	std::string path;
+	for(;;)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mRequestLock);
+			if(!mHasRequest)
+			{
+				mLoading = false;
+				return;
+			}
+			path = mRequestPath;
+			mHasRequest = false;
+		}
+		mpPending.store(getCachedScale(path), std::memory_order_release);
+	}
+}
+
+// ----------------------------------------------------------------
+#pragma mark audio thread
+
+const MLScale& MLScaleLoader::getScale()
+{
+	const MLScale* pNew = mpPending.exchange(0, std::memory_order_acquire);
+	if(pNew)
+	{
+		mpScale = pNew;
+	}
+	return *mpScale;
+}
@@ -0,0 +1,69 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef ML_SCALE_LOADER_H
+#define ML_SCALE_LOADER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "MLScale.h"
+
+// MLScaleLoader: changes the scale used by the audio thread without blocking it.
+//
+// Scales are read and parsed on a background thread into a cache shared by all
+// loaders and keyed by path, so each scale file is parsed once no matter how often
+// it is selected. Cached scales are never changed or deleted, so the audio thread
+// can use them through plain pointers. When a requested scale is ready its pointer
+// is published atomically, and the audio thread picks it up in getScale().
+
+class MLScaleLoader
+{
+public:
+	MLScaleLoader();
+	~MLScaleLoader();
+
+	// ----------------------------------------------------------------
+	// any thread but the audio thread
+
+	// start loading the scale at the path relative to the scales directory, and
+	// return immediately. If requests come faster than scales load, only the last
+	// one is loaded.
+	void requestScale(const std::string& path);
+
+	// return the scale at the path, loading it into the cache if needed.
+	static const MLScale* getCachedScale(const std::string& path);
+
+	// set the directory that scale paths are relative to. The application sets
+	// this once at startup. Until it is set, every path gives the default scale.
+	static void setScaleRoot(const std::string& dir);
+
+	// ----------------------------------------------------------------
+	// audio thread
+
+	// the current scale. A newly loaded scale is picked up here, so call this
+	// once at the start of each block.
+	const MLScale& getScale();
+
+private:
+	void joinLoadThread();
+	void loadRequests();
+
+	std::thread mLoadThread;
+
+	// the latest request and whether the load thread is running, guarded by mRequestLock.
+	std::mutex mRequestLock;
+	std::string mRequestPath;
+	bool mHasRequest;
+	bool mLoading;
+
+	std::atomic<const MLScale*> mpPending;
+
+	// audio thread only
+	const MLScale* mpScale;
+};
+
+#endif // ML_SCALE_LOADER_H
@@ -0,0 +1,270 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLSignalRecorder.h"
+#include "MLDebug.h"
+
+#include <cstring>
+
+namespace
+{
+	// block headers are copied into the ring as whole floats.
+	const int kBlockHeaderWords = sizeof(MLSignalRecordingBlock)/sizeof(float);
+	static_assert(sizeof(MLSignalRecordingBlock) % sizeof(float) == 0, "MLSignalRecorder: bad block header size");
+	static_assert(sizeof(MLSignalRecordingHeader) == 32, "MLSignalRecorder: bad file header size");
+	static_assert(sizeof(MLSignalRecordingTrack) == 48, "MLSignalRecorder: bad track header size");
+}
+
+// ----------------------------------------------------------------
+#pragma mark MLSignalRecorder
+
+MLSignalRecorder::MLSignalRecorder() :
+	mBlockFrames(0),
+	mFrame(0),
+	mpFile(0),
+	mDropped(0)
+{
+}
+
+MLSignalRecorder::~MLSignalRecorder()
+{
+	stop();
+}
+
+void MLSignalRecorder::addTrack(const MLSymbol name, const MLProcList& voices)
+{
+	if(mWriter.isRunning()) return;
+	Track t;
+	t.mName = name;
+	for(MLProcList::const_iterator it = voices.begin(); it != voices.end(); ++it)
+	{
+		if(*it)
+		{
+			t.mVoices.push_back(*it);
+		}
+	}
+	if(t.mVoices.size() > 64)
+	{
+		debug() << "MLSignalRecorder: only the first 64 voices of " << name << " are recorded.\n";
+		t.mVoices.resize(64);
+	}
+	if(!t.mVoices.empty())
+	{
+		mTracks.push_back(t);
+	}
+}
+
+void MLSignalRecorder::clearTracks()
+{
+	if(mWriter.isRunning()) return;
+	mTracks.clear();
+}
+
+bool MLSignalRecorder::start(const std::string& path, double sampleRate, int blockFrames, float bufferSeconds)
+{
+	if(mWriter.isRunning() || mTracks.empty() || (blockFrames <= 0)) return false;
+
+	mpFile = fopen(path.c_str(), "wb");
+	if(!mpFile)
+	{
+		debug() << "MLSignalRecorder: could not open " << path << "\n";
+		return false;
+	}
+
+	// write the header and track table.
+	const int tracks = (int)mTracks.size();
+	MLSignalRecordingHeader header;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = kMLSignalRecordingMagic;
+	header.mVersion = kMLSignalRecordingVersion;
+	header.mHeaderBytes = sizeof(MLSignalRecordingHeader) + tracks*sizeof(MLSignalRecordingTrack);
+	header.mTracks = tracks;
+	header.mSampleRate = sampleRate;
+	header.mBlockFrames = blockFrames;
+	fwrite(&header, sizeof(header), 1, mpFile);
+
+	int maxBlockWords = 0;
+	int chunkWords = 0;
+	for(int i=0; i<tracks; ++i)
+	{
+		const int voices = (int)mTracks[i].mVoices.size();
+		const int blockWords = kBlockHeaderWords + voices*blockFrames;
+		MLSignalRecordingTrack t;
+		memset(&t, 0, sizeof(t));
+		strncpy(t.mName, mTracks[i].mName.getString().c_str(), kMLSignalRecordingNameLength - 1);
+		t.mVoices = voices;
+		t.mBlockBytes = blockWords*sizeof(float);
+		fwrite(&t, sizeof(t), 1, mpFile);
+		maxBlockWords = std::max(maxBlockWords, blockWords);
+		chunkWords += blockWords;
+	}
+	fflush(mpFile);
+
+	// the ring holds bufferSeconds worth of chunks, rounded up to a power of two.
+	const int chunks = std::max(4, (int)(sampleRate*bufferSeconds/blockFrames));
+	const int ringWords = 1 << bitsToContain(chunks*chunkWords);
+	mRingData.assign(ringWords, 0.f);
+	PaUtil_InitializeRingBuffer(&mRing, sizeof(float), ringWords, &mRingData[0]);
+	mCaptureBlock.resize(maxBlockWords);
+	mWriteBlock.resize(maxBlockWords);
+
+	mBlockFrames = blockFrames;
+	mFrame = 0;
+	mDropped = 0;
+	mWriter.start([this]() { write(); });
+	return true;
+}
+
+void MLSignalRecorder::stop()
+{
+	if(!mWriter.isRunning()) return;
+
+	// stop capturing, wait for a capture in progress and write what is left.
+	mWriter.stop();
+	fclose(mpFile);
+	mpFile = 0;
+
+	const int dropped = mDropped;
+	if(dropped)
+	{
+		debug() << "MLSignalRecorder: " << dropped << " blocks dropped.\n";
+	}
+}
+
+// copy all complete blocks from the ring to the file. capture() only writes
+// whole blocks, so once a header is readable the rest of its block is too.
+void MLSignalRecorder::write()
+{
+	bool wrote = false;
+	while(PaUtil_GetRingBufferReadAvailable(&mRing) >= kBlockHeaderWords)
+	{
+		float* pBlock = &mWriteBlock[0];
+		PaUtil_ReadRingBuffer(&mRing, pBlock, kBlockHeaderWords);
+		MLSignalRecordingBlock header;
+		memcpy(&header, pBlock, sizeof(header));
+		const int dataWords = (int)mTracks[header.mTrack].mVoices.size()*mBlockFrames;
+		PaUtil_ReadRingBuffer(&mRing, pBlock + kBlockHeaderWords, dataWords);
+		fwrite(pBlock, sizeof(float), kBlockHeaderWords + dataWords, mpFile);
+		wrote = true;
+	}
+	if(wrote)
+	{
+		fflush(mpFile);
+	}
+}
+
+void MLSignalRecorder::capture(int frames)
+{
+	MLBackgroundWriter::Producer producer(mWriter);
+	if(!producer.isOpen() || (frames != mBlockFrames)) return;
+
+	// drop the chunk for all tracks if it doesn't fit, so tracks stay in step.
+	const int tracks = (int)mTracks.size();
+	int chunkWords = 0;
+	for(int i=0; i<tracks; ++i)
+	{
+		chunkWords += kBlockHeaderWords + (int)mTracks[i].mVoices.size()*frames;
+	}
+	if(PaUtil_GetRingBufferWriteAvailable(&mRing) < chunkWords)
+	{
+		mDropped.fetch_add(tracks, std::memory_order_relaxed);
+	}
+	else
+	{
+		float* pBlock = &mCaptureBlock[0];
+		for(int i=0; i<tracks; ++i)
+		{
+			const Track& t = mTracks[i];
+			const int voices = (int)t.mVoices.size();
+			MLSignalRecordingBlock header;
+			header.mTrack = i;
+			header.mFrames = frames;
+			header.mFrame = mFrame;
+			header.mEnabledVoices = 0;
+
+			float* pData = pBlock + kBlockHeaderWords;
+			for(int v=0; v<voices; ++v)
+			{
+				MLProc& proc = *t.mVoices[v];
+				if(proc.isEnabled())
+				{
+					header.mEnabledVoices |= (uint64_t)1 << v;
+				}
+				const MLSignal& x = proc.getInput(1);
+				if(x.isConstant())
+				{
+					std::fill(pData, pData + frames, x[0]);
+				}
+				else
+				{
+					memcpy(pData, x.getConstBuffer(), frames*sizeof(float));
+				}
+				pData += frames;
+			}
+			memcpy(pBlock, &header, sizeof(header));
+			PaUtil_WriteRingBuffer(&mRing, pBlock, kBlockHeaderWords + voices*frames);
+		}
+	}
+	mFrame += frames;
+}
+
+// ----------------------------------------------------------------
+#pragma mark MLSignalRecording
+
+bool MLSignalRecording::open(const void* pData, size_t size)
+{
+	mpData = 0;
+	mSize = 0;
+	if(!pData || (size < sizeof(MLSignalRecordingHeader))) return false;
+
+	const MLSignalRecordingHeader* pHeader = static_cast<const MLSignalRecordingHeader*>(pData);
+	if(pHeader->mMagic != kMLSignalRecordingMagic) return false;
+	if(pHeader->mVersion != kMLSignalRecordingVersion) return false;
+	if(pHeader->mHeaderBytes != sizeof(MLSignalRecordingHeader) + pHeader->mTracks*sizeof(MLSignalRecordingTrack)) return false;
+	if(pHeader->mHeaderBytes > size) return false;
+
+	const MLSignalRecordingTrack* pTracks = reinterpret_cast<const MLSignalRecordingTrack*>(pHeader + 1);
+	for(uint32_t i=0; i<pHeader->mTracks; ++i)
+	{
+		const MLSignalRecordingTrack& t = pTracks[i];
+		if((t.mVoices == 0) || (t.mVoices > 64)) return false;
+		if(t.mBlockBytes != sizeof(MLSignalRecordingBlock) + t.mVoices*pHeader->mBlockFrames*sizeof(float)) return false;
+	}
+
+	mpData = static_cast<const unsigned char*>(pData);
+	mSize = size;
+	return true;
+}
+
+const MLSignalRecordingTrack& MLSignalRecording::getTrack(int i) const
+{
+	return reinterpret_cast<const MLSignalRecordingTrack*>(mpData + sizeof(MLSignalRecordingHeader))[i];
+}
+
+const MLSignalRecordingBlock* MLSignalRecording::checkBlock(size_t offset) const
+{
+	if(!mpData || (offset + sizeof(MLSignalRecordingBlock) > mSize)) return 0;
+	const MLSignalRecordingBlock* pBlock = reinterpret_cast<const MLSignalRecordingBlock*>(mpData + offset);
+	if(pBlock->mTrack >= getHeader().mTracks) return 0;
+	if(offset + getTrack(pBlock->mTrack).mBlockBytes > mSize) return 0;
+	return pBlock;
+}
+
+const MLSignalRecordingBlock* MLSignalRecording::getFirstBlock() const
+{
+	return mpData ? checkBlock(getHeader().mHeaderBytes) : 0;
+}
+
+const MLSignalRecordingBlock* MLSignalRecording::getNextBlock(const MLSignalRecordingBlock* pBlock) const
+{
+	if(!pBlock) return 0;
+	const size_t offset = reinterpret_cast<const unsigned char*>(pBlock) - mpData;
+	return checkBlock(offset + getTrack(pBlock->mTrack).mBlockBytes);
+}
+
+const float* MLSignalRecording::getSamples(const MLSignalRecordingBlock* pBlock, int voice) const
+{
+	const float* pData = reinterpret_cast<const float*>(pBlock + 1);
+	return pData + voice*pBlock->mFrames;
+}
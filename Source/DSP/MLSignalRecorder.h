@@ -0,0 +1,150 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef ML_SIGNAL_RECORDER_H
+#define ML_SIGNAL_RECORDER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "MLProc.h"
+#include "MLBackgroundWriter.h"
+#include "pa_ringbuffer.h"
+
+// MLSignalRecorder: records published signals to a file for offline analysis.
+//
+// After each processing chunk the engine calls capture() on the audio thread,
+// which copies the input of every voice of every recorded signal into one
+// block and writes the block into a lock-free ring. capture() does a fixed
+// amount of copying, never blocks, and drops the whole block if the ring is
+// full. A writer thread drains the ring to the file.
+//
+// The file is a header followed by blocks, appended as they arrive, so it can
+// be read while it is being written or mapped into memory afterwards with
+// MLSignalRecording. All values are in native byte order.
+//
+//	MLSignalRecordingHeader
+//	MLSignalRecordingTrack[header.mTracks]
+//	blocks: MLSignalRecordingBlock, then [voices][blockFrames] floats.
+//
+// Each block holds one chunk of one signal. Blocks for every track are
+// written for each chunk in track order. mFrame is the position of the chunk
+// in frames since the recording started, so dropped chunks show as gaps.
+
+const uint32_t kMLSignalRecordingMagic = 0x52534c4d; // "MLSR"
+const uint32_t kMLSignalRecordingVersion = 1;
+const int kMLSignalRecordingNameLength = 40;
+
+struct MLSignalRecordingHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+	uint32_t mHeaderBytes;		// offset of the first block
+	uint32_t mTracks;
+	double mSampleRate;
+	uint32_t mBlockFrames;
+	uint32_t mReserved;
+};
+
+struct MLSignalRecordingTrack
+{
+	char mName[kMLSignalRecordingNameLength];
+	uint32_t mVoices;
+	uint32_t mBlockBytes;		// size of a block for this track, including its header
+};
+
+struct MLSignalRecordingBlock
+{
+	uint32_t mTrack;
+	uint32_t mFrames;
+	uint64_t mFrame;
+	uint64_t mEnabledVoices;	// bit v is set if voice v was enabled
+};
+
+class MLSignalRecorder
+{
+public:
+	MLSignalRecorder();
+	~MLSignalRecorder();
+
+	// add a signal to record, one proc per voice. The procs are the ring buffers
+	// made by MLDSPEngine::publishSignal(). Tracks can't be changed while recording.
+	void addTrack(const MLSymbol name, const MLProcList& voices);
+	void clearTracks();
+	int getNumTracks() const { return (int)mTracks.size(); }
+
+	// open the file, write its header and start the writer thread. blockFrames should
+	// be the engine's vector size. bufferSeconds is how much audio the ring can hold
+	// while the writer is behind.
+	bool start(const std::string& path, double sampleRate, int blockFrames, float bufferSeconds = 1.f);
+
+	// stop capturing, write any remaining blocks and close the file.
+	void stop();
+
+	bool isRecording() const { return mWriter.isOpen(); }
+	int getDroppedBlocks() const { return mDropped; }
+
+	// audio thread: record one chunk of each track.
+	void capture(int frames);
+
+private:
+	struct Track
+	{
+		MLSymbol mName;
+		std::vector<MLProcPtr> mVoices;
+	};
+
+	void write();
+
+	std::vector<Track> mTracks;
+	int mBlockFrames;
+	uint64_t mFrame;
+
+	// the block being assembled by capture(), and the one being written by write().
+	std::vector<float> mCaptureBlock;
+	std::vector<float> mWriteBlock;
+
+	std::vector<float> mRingData;
+	PaUtilRingBuffer mRing;
+
+	FILE* mpFile;
+	MLBackgroundWriter mWriter;
+	std::atomic<int> mDropped;
+};
+
+// MLSignalRecording: reads a recording held in memory, for example a mapped file.
+// The data must stay valid while the recording is used. A block cut off at the
+// end, as when reading a file still being written, is ignored.
+
+class MLSignalRecording
+{
+public:
+	MLSignalRecording() : mpData(0), mSize(0) {}
+	~MLSignalRecording() {}
+
+	// check the header and track table. returns false if they are not valid.
+	bool open(const void* pData, size_t size);
+
+	const MLSignalRecordingHeader& getHeader() const { return *reinterpret_cast<const MLSignalRecordingHeader*>(mpData); }
+	int getNumTracks() const { return mpData ? (int)getHeader().mTracks : 0; }
+	const MLSignalRecordingTrack& getTrack(int i) const;
+
+	// step through the blocks in file order. returns null at the end.
+	const MLSignalRecordingBlock* getFirstBlock() const;
+	const MLSignalRecordingBlock* getNextBlock(const MLSignalRecordingBlock* pBlock) const;
+
+	// the samples of one voice in a block.
+	const float* getSamples(const MLSignalRecordingBlock* pBlock, int voice) const;
+
+private:
+	const MLSignalRecordingBlock* checkBlock(size_t offset) const;
+
+	const unsigned char* mpData;
+	size_t mSize;
+};
+
+#endif // ML_SIGNAL_RECORDER_H
@@ -13,6 +13,37 @@
 #include "MLDial.h"
 #include "MLLookAndFeel.h"
 
+#include <map>
+
+// static layers shared by all dials that look the same, keyed by everything the
+// layer is drawn from. Images are reference counted, so a dial's layer stays valid
+// while the dial holds it, and layers no dial holds can be purged.
+//
+typedef std::map<std::vector<float>, Image> MLDialStaticLayerCache;
+static const int kMaxCachedStaticLayers = 64;
+
+static MLDialStaticLayerCache& getStaticLayerCache()
+{
+	static MLDialStaticLayerCache cache;
+	return cache;
+}
+
+static void purgeStaticLayerCache()
+{
+	MLDialStaticLayerCache& cache = getStaticLayerCache();
+	for(MLDialStaticLayerCache::iterator it = cache.begin(); it != cache.end(); )
+	{
+		if(it->second.getReferenceCount() <= 1)
+		{
+			it = cache.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
 const int kDragStepSize = 16;
 const int kMinGestureDuration = 250;
 const int kMouseWheelStepSize = 16;
@@ -85,8 +116,8 @@ MLDial::MLDial () :
 	//
 	mParameterLayerNeedsRedraw(true),
 	mStaticLayerNeedsRedraw(true),		
-	mThumbLayerNeedsRedraw(true)
-
+	mThumbLayerNeedsRedraw(true),
+	mDisplayScale(1)
 {
 	mpTimer = std::unique_ptr<GestureTimer>(new GestureTimer(this));
 
@@ -106,6 +137,8 @@ MLDial::MLDial () :
 
 MLDial::~MLDial()
 {
+	mStaticImage = Image();
+	purgeStaticLayerCache();
 }
 
 // MLWidget methods
@@ -616,6 +649,11 @@ void MLDial::paint (Graphics& g)
 		g.fillPath(P);
 	}
 	
+	if (mStaticLayerNeedsRedraw)
+	{
+		updateStaticLayer();
+	}
+	
 	if (style == MLDial::Rotary)
 	{
 		const float dialPos = (float) valueToProportionOfLength (currentValue);
@@ -642,6 +680,87 @@ void MLDial::paint (Graphics& g)
     }
 }
 
+// append everything the static layer is drawn from to the key.
+void MLDial::getStaticLayerKey(std::vector<float>& key)
+{
+	const MLRect uBounds = getGridBounds();
+	const MLPoint center = getDialCenter();
+	const bool enabled = isEnabled();
+	const int colorIDs[3] = {MLLookAndFeel::shadowColor, MLLookAndFeel::outlineColor, MLLookAndFeel::labelColor};
+	
+	key.clear();
+	key.push_back(style);
+	key.push_back(getWidth());
+	key.push_back(getHeight());
+	key.push_back(mDisplayScale);
+	key.push_back(enabled);
+	key.push_back(uBounds.height() > 0.5f);
+	key.push_back(center.x());
+	key.push_back(center.y());
+	key.push_back(trackRect.left());
+	key.push_back(trackRect.top());
+	key.push_back(trackRect.width());
+	key.push_back(trackRect.height());
+	key.push_back(mDiameter);
+	key.push_back(mShadowSize);
+	key.push_back(mLineThickness);
+	key.push_back(mTickSize);
+	key.push_back(mMargin);
+	key.push_back(mTicks);
+	key.push_back(mTicksOffsetAngle);
+	key.push_back(rotaryStart);
+	key.push_back(rotaryEnd);
+	for(int i=0; i<3; ++i)
+	{
+		// split the color so that each half is exact as a float.
+		const uint32 argb = findColour(colorIDs[i]).getARGB();
+		key.push_back(argb >> 16);
+		key.push_back(argb & 0xFFFF);
+	}
+	for(unsigned i=0; i<mDetents.size(); ++i)
+	{
+		key.push_back(valueToProportionOfLength(mDetents[i].mValue));
+		key.push_back(mDetents[i].mWidth);
+	}
+}
+
+// find the static layer for our current look in the cache, drawing it if needed.
+void MLDial::updateStaticLayer()
+{
+	const int compWidth = getWidth();
+	const int compHeight = getHeight();
+	mStaticLayerNeedsRedraw = false;
+	if ((compWidth <= 0) || (compHeight <= 0)) return;
+	
+	std::vector<float> key;
+	getStaticLayerKey(key);
+	MLDialStaticLayerCache& cache = getStaticLayerCache();
+	MLDialStaticLayerCache::iterator look = cache.find(key);
+	if (look != cache.end())
+	{
+		mStaticImage = look->second;
+		return;
+	}
+	
+	mStaticImage = Image(Image::ARGB, compWidth*mDisplayScale + 1, compHeight*mDisplayScale + 1, true, SoftwareImageType());
+	{
+		Graphics sg(mStaticImage);
+		if (style == MLDial::Rotary)
+		{
+			drawRotaryStaticLayer(sg);
+		}
+		else
+		{
+			drawLinearStaticLayer(sg);
+		}
+	}
+	if ((int)cache.size() >= kMaxCachedStaticLayers)
+	{
+		purgeStaticLayerCache();
+	}
+	cache[key] = mStaticImage;
+}
+
 void MLDial::repaintAll()
 {
 	mParameterLayerNeedsRedraw = mThumbLayerNeedsRedraw = mStaticLayerNeedsRedraw = true;
@@ -666,8 +785,6 @@ void MLDial::drawLinearDial (Graphics& g, int , int , int , int ,
 	getDialRect (fr, MLDial::FillRect, dialPos, minDialPos, maxDialPos);
 	getDialRect (tr, MLDial::TrackRect, dialPos, minDialPos, maxDialPos);
 	
-	full.addRectangle(MLToJuceRect(fr));
-	
 	// parameter layer
 	if (mParameterLayerNeedsRedraw)
 	{	
@@ -681,75 +798,12 @@ void MLDial::drawLinearDial (Graphics& g, int , int , int , int ,
         
 		// draw fill
 		{
+			full.addRectangle(MLToJuceRect(fr));
 			pg.setColour (fill_normal);
 			pg.fillPath (full);	
 		}
 	}
 	
-	// static layer
-	if (mStaticLayerNeedsRedraw)
-	{
-		Graphics sg(mStaticImage);	
-		mStaticImage.clear(Rectangle<int>(0, 0, compWidth, compHeight), Colours::transparentBlack);
-		const Colour label_color = (findColour(MLLookAndFeel::labelColor).withAlpha (isEnabled() ? 1.f : 0.5f));	
-        
-		// detents 
-        if (isHorizontal())
-        {
-			float tX = tr.x();
-			float tY = tr.y();
-			float tW = tr.getWidth();
-			float x1, y1, x2, y2;
-
-			for (unsigned i=0; i<mDetents.size(); ++i)
-			{
-				float td = valueToProportionOfLength(mDetents[i].mValue); 
-				float xx = (tX + (td * tW));	
-				Path J;
-
-				// draw tick
-				x1 = xx;
-				y1 = tY - mMargin;
-				x2 = xx;
-				y2 = tY - mMargin*(1.0f - mDetents[i].mWidth);
-									
-				J.startNewSubPath(x1, y1);
-				J.lineTo(x2, y2);
-
-				sg.setColour (label_color.withAlpha(1.f));
-				sg.strokePath (J, PathStrokeType(mLineThickness*2));
-			}
-		}
-        else
-        {
- 			float tX = tr.x();
-			float tY = tr.y();
-			//float tW = tr.getWidth();
-			float tH = tr.getHeight();
-			float x1, y1, x2, y2;
-            
-			for (unsigned i=0; i<mDetents.size(); ++i)
-			{
-				float td = valueToProportionOfLength(mDetents[i].mValue);
-				float yy = (tY + (td * tH));
-				Path J;
-                
-				// draw tick
-				x1 = tX - mMargin;
-				y1 = yy;
-				x2 = tX - mMargin*(1.0f - mDetents[i].mWidth);
-				y2 = yy;
-                
-				J.startNewSubPath(x1, y1);
-				J.lineTo(x2, y2);
-                
-				sg.setColour (label_color.withAlpha(1.f));
-				sg.strokePath (J, PathStrokeType(mLineThickness*2));
-                
-			}
-        }
-	}
-	
 	// composite images
 	//
 	if(mParameterImage.isValid())
@@ -760,7 +814,70 @@ void MLDial::drawLinearDial (Graphics& g, int , int , int , int ,
 	{
 		g.drawImage (mStaticImage, 0, 0, compWidth, compHeight, 0, 0, compWidth, compHeight, false);
 	}
-	mParameterLayerNeedsRedraw = mStaticLayerNeedsRedraw = false;
+	mParameterLayerNeedsRedraw = false;
+}
+
+// draw the parts of a linear dial that do not depend on its value.
+void MLDial::drawLinearStaticLayer (Graphics& sg)
+{
+	const MLRect& tr = trackRect;
+	const Colour label_color = (findColour(MLLookAndFeel::labelColor).withAlpha (isEnabled() ? 1.f : 0.5f));	
+	
+	// detents 
+	if (isHorizontal())
+	{
+		float tX = tr.x();
+		float tY = tr.y();
+		float tW = tr.getWidth();
+		float x1, y1, x2, y2;
+
+		for (unsigned i=0; i<mDetents.size(); ++i)
+		{
+			float td = valueToProportionOfLength(mDetents[i].mValue); 
+			float xx = (tX + (td * tW));	
+			Path J;
+
+			// draw tick
+			x1 = xx;
+			y1 = tY - mMargin;
+			x2 = xx;
+			y2 = tY - mMargin*(1.0f - mDetents[i].mWidth);
+								
+			J.startNewSubPath(x1, y1);
+			J.lineTo(x2, y2);
+
+			sg.setColour (label_color.withAlpha(1.f));
+			sg.strokePath (J, PathStrokeType(mLineThickness*2));
+		}
+	}
+	else
+	{
+		float tX = tr.x();
+		float tY = tr.y();
+		//float tW = tr.getWidth();
+		float tH = tr.getHeight();
+		float x1, y1, x2, y2;
+	    
+		for (unsigned i=0; i<mDetents.size(); ++i)
+		{
+			float td = valueToProportionOfLength(mDetents[i].mValue);
+			float yy = (tY + (td * tH));
+			Path J;
+	        
+			// draw tick
+			x1 = tX - mMargin;
+			y1 = yy;
+			x2 = tX - mMargin*(1.0f - mDetents[i].mWidth);
+			y2 = yy;
+	        
+			J.startNewSubPath(x1, y1);
+			J.lineTo(x2, y2);
+	        
+			sg.setColour (label_color.withAlpha(1.f));
+			sg.strokePath (J, PathStrokeType(mLineThickness*2));
+	        
+		}
+	}
 }
 
 void MLDial::drawLinearDialOverlay (Graphics& g, int , int , int , int ,
@@ -887,8 +1004,6 @@ void MLDial::drawRotaryDial (Graphics& g, int rx, int ry, int rw, int rh, float
 
 	// Colors 
 	const Colour trackDark = (mTrackDarkColor.withMultipliedAlpha (isEnabled() ? 1.f : 0.5f));					
-	const Colour shadow (findColour(MLLookAndFeel::shadowColor).withAlpha (isEnabled() ? 1.f : 0.5f));
-	const Colour outline_color (findColour(MLLookAndFeel::outlineColor).withAlpha (isEnabled() ? 1.f : 0.5f));
 	const Colour fill_color (mTrackFillColor.withAlpha (isEnabled() ? 1.0f : 0.5f));
 	const Colour indicator_color (mIndicatorColor.withAlpha (isEnabled() ? 1.f : 0.5f));
 
@@ -906,11 +1021,6 @@ void MLDial::drawRotaryDial (Graphics& g, int rx, int ry, int rw, int rh, float
 	float indicator_thick = mLineThickness*2.f;
 	
 	bool do_indicator = true;
-	bool do_ticks = true;
-	if (uBounds.height() <= 0.5f) 
-	{
-		do_ticks = 0;
-	}
 	
 	float posA, posB;
 	float angleA, angleB, angleI, angleM;
@@ -990,87 +1100,6 @@ void MLDial::drawRotaryDial (Graphics& g, int rx, int ry, int rw, int rh, float
 		}
 	}
     
-	// static layer
-	if (mStaticLayerNeedsRedraw)
-    {
-		const Colour label_color = (findColour(MLLookAndFeel::labelColor).withAlpha (isEnabled() ? 1.f : 0.5f));	
-		mStaticImage.clear(MLToJuceRectInt(boundsRect), Colours::transparentBlack);
-
-		Graphics sg(mStaticImage);	
-		{	
-			// outer shadow
-			Path outline;
-			float d, opacity;
-			for (int i=0; i<mShadowSize; i++)
-			{
-				outline.clear();			
-				outline.addCentredArc(cx, cy, r1 + i + 0.5, r1 + i + 0.5, 0., rotaryStart, rotaryEnd, true);
-				d = (float)(mShadowSize - i) / (float)mShadowSize; // 0. - 1.
-				opacity = d * d * d * kMLShadowOpacity;
-				sg.setColour (shadow.withAlpha(opacity));
-				sg.strokePath (outline, PathStrokeType (1.f));	
-			}			
-		}		
-		
-		{	
-			// track outline
-			Path outline;
-			outline.addCentredArc(cx, cy, r1, r1, 0., rotaryStart, rotaryEnd, true);			
-			sg.setColour (outline_color.withAlpha(0.25f));
-			sg.strokePath (outline, PathStrokeType (mLineThickness));
-			sg.setColour (outline_color);
-			sg.strokePath (outline, PathStrokeType (mLineThickness*2));
-		}
-
-		if (do_ticks)
-		{
-			float angle;
-			Path tick;
-			tick.startNewSubPath(0, -r1);
-			tick.lineTo(0, -r1-mTickSize);
-			sg.setColour (outline_color);
-			for (int t=0; t<mTicks; t++)
-			{
-				angle = rotaryStart + (t * (rotaryEnd - rotaryStart) / (mTicks - 1)) ;
-				angle += mTicksOffsetAngle;
-				sg.strokePath (tick, PathStrokeType(mLineThickness*2), AffineTransform::rotation (angle).translated (cx, cy - 0.5f));
-			}
-		}
-
-		// draw detents
-		if(mDetents.size() > 0)
-		{
-			float x1, y1, x2, y2;		
-			for (unsigned i=0; i<mDetents.size(); ++i)
-			{
-				float td = valueToProportionOfLength(mDetents[i].mValue); 
-				
-				// if the detent has a label, it's a line under the text, otherwise a small dot.
-				float theta = rotaryStart + (td * (rotaryEnd - rotaryStart));
-	
-				bool coveringEnd = approxEqual(theta, rotaryStart) || approxEqual(theta, rotaryEnd);
-				if (!coveringEnd)
-				{
-					Path J;
-
-					// draw detent - outer edge lines up with tick
-					AffineTransform t1 = AffineTransform::rotation(theta).translated(cx, cy);
-					x1 = 0;
-					x2 = 0;
-					float tW = 0.875f; //  tweak
-					y1 = -r1 - (mTickSize*tW);
-					y2 = -r1 - (mTickSize*tW)*(1.f - mDetents[i].mWidth);
-					t1.transformPoint(x1, y1);
-					t1.transformPoint(x2, y2);					
-					J.startNewSubPath(x1, y1);
-					J.lineTo(x2, y2);
-					sg.setColour (label_color);
-					sg.strokePath (J, PathStrokeType(mLineThickness*2));
-				}
-			}
-		}		
-	}	
-	
 	// composite images
 	if(mParameterImage.isValid())
 	{
@@ -1094,7 +1123,95 @@ void MLDial::drawRotaryDial (Graphics& g, int rx, int ry, int rw, int rh, float
 		}
 	}
     
-	mParameterLayerNeedsRedraw = mStaticLayerNeedsRedraw = false;
+	mParameterLayerNeedsRedraw = false;
+}
+
+// draw the parts of a rotary dial that do not depend on its value.
+void MLDial::drawRotaryStaticLayer (Graphics& sg)
+{
+	const MLRect uBounds = getGridBounds();
+	const Colour shadow (findColour(MLLookAndFeel::shadowColor).withAlpha (isEnabled() ? 1.f : 0.5f));
+	const Colour outline_color (findColour(MLLookAndFeel::outlineColor).withAlpha (isEnabled() ? 1.f : 0.5f));
+	const float r1 = mDiameter*0.5f;
+	const MLPoint center = getDialCenter();
+	float cx, cy;
+	cx = (int)center.x() + 0.5;
+	cy = (int)center.y();
+	const Colour label_color = (findColour(MLLookAndFeel::labelColor).withAlpha (isEnabled() ? 1.f : 0.5f));	
+	bool do_ticks = (uBounds.height() > 0.5f);
+	
+	{	
+		// outer shadow
+		Path outline;
+		float d, opacity;
+		for (int i=0; i<mShadowSize; i++)
+		{
+			outline.clear();			
+			outline.addCentredArc(cx, cy, r1 + i + 0.5, r1 + i + 0.5, 0., rotaryStart, rotaryEnd, true);
+			d = (float)(mShadowSize - i) / (float)mShadowSize; // 0. - 1.
+			opacity = d * d * d * kMLShadowOpacity;
+			sg.setColour (shadow.withAlpha(opacity));
+			sg.strokePath (outline, PathStrokeType (1.f));	
+		}			
+	}		
+	
+	{	
+		// track outline
+		Path outline;
+		outline.addCentredArc(cx, cy, r1, r1, 0., rotaryStart, rotaryEnd, true);			
+		sg.setColour (outline_color.withAlpha(0.25f));
+		sg.strokePath (outline, PathStrokeType (mLineThickness));
+		sg.setColour (outline_color);
+		sg.strokePath (outline, PathStrokeType (mLineThickness*2));
+	}
+
+	if (do_ticks)
+	{
+		float angle;
+		Path tick;
+		tick.startNewSubPath(0, -r1);
+		tick.lineTo(0, -r1-mTickSize);
+		sg.setColour (outline_color);
+		for (int t=0; t<mTicks; t++)
+		{
+			angle = rotaryStart + (t * (rotaryEnd - rotaryStart) / (mTicks - 1)) ;
+			angle += mTicksOffsetAngle;
+			sg.strokePath (tick, PathStrokeType(mLineThickness*2), AffineTransform::rotation (angle).translated (cx, cy - 0.5f));
+		}
+	}
+
+	// draw detents
+	if(mDetents.size() > 0)
+	{
+		float x1, y1, x2, y2;		
+		for (unsigned i=0; i<mDetents.size(); ++i)
+		{
+			float td = valueToProportionOfLength(mDetents[i].mValue); 
+			
+			// if the detent has a label, it's a line under the text, otherwise a small dot.
+			float theta = rotaryStart + (td * (rotaryEnd - rotaryStart));
+
+			bool coveringEnd = approxEqual(theta, rotaryStart) || approxEqual(theta, rotaryEnd);
+			if (!coveringEnd)
+			{
+				Path J;
+
+				// draw detent - outer edge lines up with tick
+				AffineTransform t1 = AffineTransform::rotation(theta).translated(cx, cy);
+				x1 = 0;
+				x2 = 0;
+				float tW = 0.875f; //  tweak
+				y1 = -r1 - (mTickSize*tW);
+				y2 = -r1 - (mTickSize*tW)*(1.f - mDetents[i].mWidth);
+				t1.transformPoint(x1, y1);
+				t1.transformPoint(x2, y2);					
+				J.startNewSubPath(x1, y1);
+				J.lineTo(x2, y2);
+				sg.setColour (label_color);
+				sg.strokePath (J, PathStrokeType(mLineThickness*2));
+			}
+		}
+	}
 }
 
 void MLDial::drawRotaryDialOverlay (Graphics& g, int rx, int ry, int rw, int rh, float dialPos)
@@ -1110,7 +1227,7 @@ void MLDial::drawRotaryDialOverlay (Graphics& g, int rx, int ry, int rw, int rh,
 
 void MLDial::moved()
 {
-	mParameterLayerNeedsRedraw = mStaticLayerNeedsRedraw = true;
+	// all layers are drawn in local coordinates, so nothing needs redrawing.
 }
 
 void MLDial::resized()
@@ -2150,9 +2267,9 @@ void MLDial::resizeWidget(const MLRect& b, const int u)
 		pC->setBounds(cBounds);
 		
         // get display scale
-        int displayScale = 1;
+        mDisplayScale = 1;
         
- 		// make compositing images
+ 		// make compositing images. The static image comes from the cache when painted.
 		if ((width > 0) && (height > 0))
 		{
 			int compWidth = getWidth();
@@ -2161,9 +2278,8 @@ void MLDial::resizeWidget(const MLRect& b, const int u)
 			mParameterImage.clear(Rectangle<int>(0, 0, compWidth, compHeight), Colours::transparentBlack);	
 			mThumbImage = Image(Image::ARGB, compWidth + 1, compHeight + 1, true, SoftwareImageType());
 			mThumbImage.clear(Rectangle<int>(0, 0, compWidth, compHeight), Colours::transparentBlack);            
-			mStaticImage = Image(Image::ARGB, compWidth*displayScale + 1, compHeight*displayScale + 1, true, SoftwareImageType());
-			mStaticImage.clear(Rectangle<int>(0, 0, compWidth, compHeight), Colours::transparentBlack);
 		}
+		mStaticImage = Image();
 		
 		mParameterLayerNeedsRedraw = mThumbLayerNeedsRedraw = mStaticLayerNeedsRedraw = true;
 		resized();
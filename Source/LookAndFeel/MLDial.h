@@ -223,6 +223,10 @@ protected:
         float dialPos, float minDialPos, float maxDialPos);
 	void drawRotaryDial (Graphics& g, int rx, int ry, int rw, int rh, float dialPos);
 	void drawRotaryDialOverlay (Graphics& g, int rx, int ry, int rw, int rh, float dialPos);
+	void drawLinearStaticLayer (Graphics& g);
+	void drawRotaryStaticLayer (Graphics& g);
+	void getStaticLayerKey(std::vector<float>& key);
+	void updateStaticLayer();
     
     void moved();
     virtual void resized();
@@ -329,10 +333,11 @@ protected:
 	bool mStaticLayerNeedsRedraw;
 	bool mThumbLayerNeedsRedraw;
 
-	// image layers
+	// image layers. The static layer is shared with other dials that look the same.
 	Image mParameterImage;
 	Image mStaticImage;
 	Image mThumbImage;
+	int mDisplayScale;
 	
 	// TODO write a Timer class. juce::Timer is the only reason Juce is needed here. temporary.
 	class GestureTimer : private juce::Timer
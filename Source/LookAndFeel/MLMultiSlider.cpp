@@ -38,6 +38,28 @@ MLMultiSlider::~MLMultiSlider()
 void MLMultiSlider::doPropertyChangeAction(MLSymbol property, const MLProperty& val)
 {
 	if (property.withoutFinalNumber() == "value")
+	{
+		// repaint only the column of the slider that changed.
+		if (property != "value")
+		{
+			repaintSlider(property.getFinalNumber());
+		}
+		else
+		{
+			repaint();
+		}
+	}
+}
+
+void MLMultiSlider::repaintSlider(int i)
+{
+	if (within(i, 0, mNumSliders))
+	{
+		// include the outline, which is centered on the slider's edge.
+		MLRect sr = mPos.getElementBounds(i);
+		repaint(MLToJuceRectInt(sr).expanded(2, 2));
+	}
+	else
 	{
 		repaint();
 	}
@@ -123,23 +145,34 @@ void MLMultiSlider::paint (Graphics& g)
 	MLRange drawRange(mRange);
 	drawRange.convertTo(MLRange(r.height(), 0.));
 	
+	const Colour fullDarkColor = findColour(trackFullDarkColor);
+	const Colour emptyDarkColor = findColour(trackEmptyDarkColor);
+	const Colour fullLightColor = fullDarkColor.brighter(0.20f);
+	const Colour emptyLightColor = emptyDarkColor.brighter(0.10f);
+	
+	// draw only the sliders that intersect the area being repainted.
+	const Rectangle<int> clip = g.getClipBounds();
+	
 	for (int i=0; i<mNumSliders; ++i)
 	{
 		MLRect sr = (mPos.getElementBounds(i));
+		if (!clip.intersects(MLToJuceRectInt(sr).expanded(2, 2))) continue;
 
 		dialY = drawRange(getFloatProperty(MLSymbol("value").withFinalNumber(i)));
 		fullRect = sr;
 		emptyRect = sr;		
 		fullRect.setTop(dialY);
-	
-		fullColor = findColour(trackFullDarkColor);
-		emptyColor = findColour(trackEmptyDarkColor);
 		
 		// groups of 4 
 		if (!(i&4))
 		{
-			emptyColor = emptyColor.brighter(0.10f);
-			fullColor = fullColor.brighter(0.20f);
+			emptyColor = emptyLightColor;
+			fullColor = fullLightColor;
+		}
+		else
+		{
+			emptyColor = emptyDarkColor;
+			fullColor = fullDarkColor;
 		}
 		
 		empty.clear();
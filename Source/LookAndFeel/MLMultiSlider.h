@@ -71,6 +71,9 @@ protected:
 private:
 	int getSliderUnderPoint(const Vec2& p);
 	int getSliderUnderMouse();
+	
+	// repaint the column of slider i, or everything if i is out of range.
+	void repaintSlider(int i);
 
 	int mNumSliders;
 	MLRange mRange; 
@@ -0,0 +1,84 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLBackgroundWriter.h"
+
+#include <chrono>
+
+const int MLBackgroundWriter::kWriteIntervalMs;
+
+// the producer count is raised before mOpen is checked, and stop() clears mOpen
+// before it checks the count, so either stop() sees the producer or the producer
+// sees that the writer is closed.
+MLBackgroundWriter::Producer::Producer(MLBackgroundWriter& w) :
+	mWriter(w)
+{
+	mWriter.mProducers++;
+	mOpen = mWriter.mOpen;
+	if(!mOpen)
+	{
+		mWriter.mProducers--;
+	}
+}
+
+MLBackgroundWriter::Producer::~Producer()
+{
+	if(mOpen)
+	{
+		mWriter.mProducers--;
+	}
+}
+
+MLBackgroundWriter::MLBackgroundWriter() :
+	mRunning(false),
+	mOpen(false),
+	mProducers(0)
+{
+}
+
+MLBackgroundWriter::~MLBackgroundWriter()
+{
+	stop(false);
+}
+
+bool MLBackgroundWriter::start(std::function<void()> drain)
+{
+	if(mRunning) return false;
+	mDrain = drain;
+	mRunning = true;
+	mThread = std::thread(&MLBackgroundWriter::run, this);
+	mOpen = true;
+	return true;
+}
+
+void MLBackgroundWriter::stop(bool drainRemaining)
+{
+	if(!mRunning) return;
+
+	mOpen = false;
+	while(mProducers > 0)
+	{
+		std::this_thread::yield();
+	}
+
+	mRunning = false;
+	if(mThread.joinable())
+	{
+		mThread.join();
+	}
+	if(drainRemaining)
+	{
+		mDrain();
+	}
+	mDrain = nullptr;
+}
+
+void MLBackgroundWriter::run()
+{
+	while(mRunning)
+	{
+		mDrain();
+		std::this_thread::sleep_for(std::chrono::milliseconds(kWriteIntervalMs));
+	}
+}
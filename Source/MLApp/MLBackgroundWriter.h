@@ -0,0 +1,69 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef _ML_BACKGROUND_WRITER_H
+#define _ML_BACKGROUND_WRITER_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+// MLBackgroundWriter: a thread that regularly drains data written by realtime
+// producers, for MLRealtimeLog, MLSignalRecorder and MLEngineCapture. The owner
+// gives start() a function that moves whatever is waiting in its lock-free
+// buffers to a file or stream. It is called every kWriteIntervalMs, and once
+// more after the thread stops.
+//
+// Producers that must not write after stop() wrap each write in a Producer.
+// stop() closes the writer, then waits for any Producer still writing.
+
+class MLBackgroundWriter
+{
+public:
+	static const int kWriteIntervalMs = 10;
+
+	// marks a write in progress. Write only if isOpen() is true. Realtime safe.
+	class Producer
+	{
+	public:
+		Producer(MLBackgroundWriter& w);
+		~Producer();
+		bool isOpen() const { return mOpen; }
+
+	private:
+		Producer(const Producer&);
+		Producer& operator=(const Producer&);
+
+		MLBackgroundWriter& mWriter;
+		bool mOpen;
+	};
+
+	MLBackgroundWriter();
+	~MLBackgroundWriter();
+
+	// start the thread and open to producers. Returns false if already running.
+	bool start(std::function<void()> drain);
+
+	// close, wait for producers, stop the thread and drain what is left if
+	// drainRemaining is true.
+	void stop(bool drainRemaining = true);
+
+	// refuse any more writes but keep draining, as when the data can't be
+	// written without a gap.
+	void close() { mOpen = false; }
+
+	bool isRunning() const { return mRunning; }
+	bool isOpen() const { return mOpen; }
+
+private:
+	void run();
+
+	std::function<void()> mDrain;
+	std::thread mThread;
+	std::atomic<bool> mRunning;
+	std::atomic<bool> mOpen;
+	std::atomic<int> mProducers;
+};
+
+#endif // _ML_BACKGROUND_WRITER_H
@@ -5,6 +5,24 @@
 
 #include "MLDebug.h"
 
+#include <atomic>
+
+namespace
+{
+	std::atomic<MLTextStreamThreadCheck> gThreadCheck(nullptr);
+}
+
+void setTextStreamThreadCheck(MLTextStreamThreadCheck check)
+{
+	gThreadCheck = check;
+}
+
+bool textStreamThreadAllowed()
+{
+	MLTextStreamThreadCheck check = gThreadCheck;
+	return check ? check() : true;
+}
+
 MLTextStream::MLTextStream(const char* name) : 
 	mName(name), 
 	mActive(true),
@@ -49,7 +67,7 @@ const int kWideBufSize = 16384;
 static wchar_t wideBuf[kWideBufSize];
 void MLTextStream::display()
 {
-	if (!(juce::MessageManager::getInstance()->isThisTheMessageThread())) 
+	if (!textStreamThreadAllowed()) 
 	{
 		return;
 	}
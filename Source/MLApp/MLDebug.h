@@ -15,14 +15,18 @@
 #include "MLPlatform.h"
 #include "MLTextStreamListener.h"
 
-#ifdef ML_WINDOWS
-	#include "JuceHeader.h" // requires JUCE only for message thread checking
-#endif
-
-// TODO debug printing should have its own thread and MPSC queue.
+// debug() is not realtime safe. To print from the audio thread, use the ML_LOG
+// macros in MLRealtimeLog.h.
 
 #include <iostream>
 
+// returns true if the calling thread may write to text streams. On Windows, the
+// application sets a check for its message thread, so that this code does not
+// depend on any particular UI framework. With no check set, any thread may write.
+typedef bool (*MLTextStreamThreadCheck)();
+extern void setTextStreamThreadCheck(MLTextStreamThreadCheck check);
+extern bool textStreamThreadAllowed();
+
 class MLTextStream
 {
 public:
@@ -40,7 +44,7 @@ public:
 #ifdef ML_WINDOWS
 		
 		// TODO enable multi-threaded debugging again with some kind of queue on Windows.
-		if (!(juce::MessageManager::getInstance()->isThisTheMessageThread())) 
+		if (!textStreamThreadAllowed()) 
 		{
 			printf("Windows: no debugging outside of message thread!\n");
 			return *this;
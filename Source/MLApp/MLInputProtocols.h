@@ -13,4 +13,9 @@ enum eInputProtocol
 	kInputProtocolOSC = 2
 };
 
+// dimensions of the touch frames sent from OSC input to the DSP engine:
+// x, y, z and note for each touch.
+const int kMLTouchFrameWidth = 4;
+const int kMLTouchFrameHeight = 16;
+
 #endif // ML_INPUT_PROTOCOLS_H
\ No newline at end of file
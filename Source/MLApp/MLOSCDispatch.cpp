@@ -0,0 +1,81 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLOSCDispatch.h"
+
+const int MLOSCDispatch::kNoMatch;
+
+MLOSCDispatch::MLOSCDispatch()
+{
+	clear();
+}
+
+MLOSCDispatch::~MLOSCDispatch()
+{
+}
+
+void MLOSCDispatch::clear()
+{
+	mNodes.clear();
+	mNodes.push_back(Node(0));
+}
+
+int MLOSCDispatch::findChild(int node, char c) const
+{
+	for(int i = mNodes[node].mFirstChild; i; i = mNodes[i].mNextSibling)
+	{
+		if(mNodes[i].mChar == c) return i;
+	}
+	return 0;
+}
+
+void MLOSCDispatch::addAddress(const char* addr, int id, bool numbered)
+{
+	int node = 0;
+	for(const char* p = addr; *p; ++p)
+	{
+		int child = findChild(node, *p);
+		if(!child)
+		{
+			child = mNodes.size();
+			mNodes.push_back(Node(*p));
+			mNodes[child].mNextSibling = mNodes[node].mFirstChild;
+			mNodes[node].mFirstChild = child;
+		}
+		node = child;
+	}
+	mNodes[node].mID = id;
+	mNodes[node].mNumbered = numbered;
+}
+
+int MLOSCDispatch::match(const char* addr, int* pNumber) const
+{
+	int node = 0;
+	const char* p = addr;
+	for(; *p; ++p)
+	{
+		int child = findChild(node, *p);
+		if(!child) break;
+		node = child;
+	}
+
+	const Node& n = mNodes[node];
+	if(n.mID == kNoMatch) return kNoMatch;
+	if(!*p)
+	{
+		if(pNumber) *pNumber = 0;
+		return n.mID;
+	}
+	if(!n.mNumbered) return kNoMatch;
+
+	// the rest of the address must be a number.
+	int number = 0;
+	for(; *p; ++p)
+	{
+		if((*p < '0') || (*p > '9')) return kNoMatch;
+		number = number*10 + (*p - '0');
+	}
+	if(pNumber) *pNumber = number;
+	return n.mID;
+}
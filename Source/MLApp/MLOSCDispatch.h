@@ -0,0 +1,53 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef __ML_OSC_DISPATCH_H__
+#define __ML_OSC_DISPATCH_H__
+
+#include <vector>
+
+// MLOSCDispatch: a table mapping OSC address patterns to integer IDs.
+//
+// Addresses are added once, before listening starts. match() then walks a trie
+// one character at a time, so the cost of matching does not grow with the number
+// of addresses, and no strings are compared or allocated.
+//
+// An address added as numbered can be followed by a decimal number, like the
+// touch number in /t3d/tch12. The number is returned by match().
+
+class MLOSCDispatch
+{
+public:
+	static const int kNoMatch = -1;
+
+	MLOSCDispatch();
+	~MLOSCDispatch();
+
+	// add an address with the given ID, which must be >= 0.
+	void addAddress(const char* addr, int id, bool numbered = false);
+
+	// return the ID of the address, or kNoMatch. If the address was added as
+	// numbered, the number following it is written to pNumber, or 0 if there is none.
+	int match(const char* addr, int* pNumber = 0) const;
+
+	void clear();
+
+private:
+	struct Node
+	{
+		Node(char c) : mChar(c), mFirstChild(0), mNextSibling(0), mID(kNoMatch), mNumbered(false) {}
+
+		char mChar;
+		int mFirstChild; // node indices, or 0 for none. Node 0 is the root.
+		int mNextSibling;
+		int mID;
+		bool mNumbered;
+	};
+
+	int findChild(int node, char c) const;
+
+	std::vector<Node> mNodes;
+};
+
+#endif // __ML_OSC_DISPATCH_H__
@@ -11,11 +11,33 @@
 	
 #include "MLOSCListener.h"
 
+#if ML_LINUX
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#endif
+
+const int MLOSCListener::kBatchSize;
+const int MLOSCListener::kMaxPacketSize;
+
 MLOSCListener::MLOSCListener() :
 	mListening(false),
+#if ML_LINUX
+	mSocket(-1),
+	mRunning(false),
+#else
 	mpSocket(0),
+#endif
 	mPort(0)
 {
+#if ML_LINUX
+	// allocate the packet arena and message headers once.
+	mPacketArena.resize(kBatchSize*kMaxPacketSize);
+	mMessages.resize(kBatchSize);
+	mIOVecs.resize(kBatchSize);
+	mSenders.resize(kBatchSize);
+#endif
 }
 
 MLOSCListener::~MLOSCListener()
@@ -26,11 +48,14 @@ MLOSCListener::~MLOSCListener()
 void * MLOSCListenerStartThread(void *arg)
 {
 	MLOSCListener* pL = static_cast<MLOSCListener*>(arg);
-	UdpListeningReceiveSocket* pSocket = pL->mpSocket;
 
 	try
 	{
-		pSocket->Run();
+#if ML_LINUX
+		pL->runBatched();
+#else
+		pL->mpSocket->Run();
+#endif
 	}
 	catch( osc::Exception& e )
 	{
@@ -45,11 +70,108 @@ void * MLOSCListenerStartThread(void *arg)
 	return 0;
 }
 
+#if ML_LINUX
+
+bool MLOSCListener::openSocket(int port)
+{
+	mSocket = socket(AF_INET, SOCK_DGRAM, 0);
+	if(mSocket < 0)
+	{
+		std::cout << "MLOSCListener::listenToOSC: couldn't create socket.\n";
+		return false;
+	}
+	
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if(bind(mSocket, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+	{
+		std::cout << "MLOSCListener::listenToOSC: couldn't bind to port " << port << ".\n";
+		std::cout << "error: " << strerror(errno) << "\n";
+		close(mSocket);
+		mSocket = -1;
+		return false;
+	}
+	return true;
+}
+
+void MLOSCListener::closeSocket()
+{
+	if(mSocket >= 0)
+	{
+		// the listener thread wakes from poll() at least this often to check mRunning.
+		mRunning = false;
+		pthread_join(mListenerThread, 0);
+		close(mSocket);
+		mSocket = -1;
+	}
+}
+
+void MLOSCListener::runBatched()
+{
+	const int kPollTimeoutMs = 100;
+	struct pollfd pfd;
+	pfd.fd = mSocket;
+	pfd.events = POLLIN;
+	
+	while(mRunning)
+	{
+		int r = poll(&pfd, 1, kPollTimeoutMs);
+		if(r <= 0) continue;
+		
+		// set up headers pointing into the arena. recvmmsg() overwrites the
+		// lengths, so this is redone for each batch.
+		for(int i=0; i<kBatchSize; ++i)
+		{
+			mIOVecs[i].iov_base = &mPacketArena[i*kMaxPacketSize];
+			mIOVecs[i].iov_len = kMaxPacketSize;
+			struct msghdr& h = mMessages[i].msg_hdr;
+			memset(&h, 0, sizeof(h));
+			h.msg_iov = &mIOVecs[i];
+			h.msg_iovlen = 1;
+			h.msg_name = &mSenders[i];
+			h.msg_namelen = sizeof(struct sockaddr_in);
+		}
+		
+		int n = recvmmsg(mSocket, &mMessages[0], kBatchSize, MSG_DONTWAIT, 0);
+		for(int i=0; i<n; ++i)
+		{
+			const struct sockaddr_in& from = mSenders[i];
+			IpEndpointName sender(ntohl(from.sin_addr.s_addr), ntohs(from.sin_port));
+			const int size = mMessages[i].msg_len;
+			if(size > 0)
+			{
+				try
+				{
+					ProcessPacket(&mPacketArena[i*kMaxPacketSize], size, sender);
+				}
+				catch( osc::Exception& e )
+				{
+					// skip a malformed packet and keep going with the batch.
+					std::cout << "MLOSCListener caught osc exception: " << e.what() << "\n";
+				}
+			}
+		}
+	}
+}
+
+#endif // ML_LINUX
+
 int MLOSCListener::listenToOSC(int port)
 {
 	int ret = false;
 	if(port)
 	{
+#if ML_LINUX
+		if(mSocket >= 0)
+		{
+			listenToOSC(0);
+		}
+		std::cout << "MLOSCListener: trying listen on port " << port << "...\n";
+		bool socketOK = openSocket(port);
+#else
 		if(mpSocket)
 		{
 			listenToOSC(0);
@@ -73,8 +195,10 @@ int MLOSCListener::listenToOSC(int port)
 			std::cout << "MLOSCListener::listenToOSC: couldn't bind to port " << port << ".\n";
 			std::cout << "Unknown error.\n";
 		}
+		bool socketOK = (mpSocket != 0);
+#endif
 		
-		if(mpSocket)
+		if(socketOK)
 		{
 			std::cout << "MLOSCListener::listenToOSC: created receive socket on port " << port << ".\n";
 			mPort = port;
@@ -87,6 +211,9 @@ int MLOSCListener::listenToOSC(int port)
 
 			if(!err)
 			{
+#if ML_LINUX
+				mRunning = true;
+#endif
 				// std::cout << "creating listener thread...\n";
 				err = pthread_create(&mListenerThread, &attr, &MLOSCListenerStartThread, (void*)this);
 				
@@ -95,11 +222,26 @@ int MLOSCListener::listenToOSC(int port)
 					ret = true;
 					mListening = true;
 				}
+#if ML_LINUX
+				else
+				{
+					mRunning = false;
+					close(mSocket);
+					mSocket = -1;
+				}
+#endif
 			}
 		}
 	}
 	else
 	{
+#if ML_LINUX
+		if(mSocket >= 0)
+		{
+			std::cout << "MLOSCListener: disconnecting.\n";
+			closeSocket();
+		}
+#else
 		if(mpSocket)
 		{
 			std::cout << "MLOSCListener: disconnecting.\n";
@@ -107,10 +249,11 @@ int MLOSCListener::listenToOSC(int port)
 			delete mpSocket;
 			mpSocket = 0;
 		}
+#endif
 		mListening = false;
 		ret = true;
 	}
 	return ret;
 }
 
-#endif // ML_WINDOWS
\ No newline at end of file
+#endif // ML_WINDOWS
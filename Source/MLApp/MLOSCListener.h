@@ -18,7 +18,14 @@
 
 #include <stdexcept>
 #include <iostream>
+#include <vector>
+#include <atomic>
 #include "pthread.h"
+
+#if ML_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
 	
 // start and run a listener thread, not returning until the thread is done.
 // used as argument to pthread_create().
@@ -34,6 +41,10 @@ public:
 	
 	// listen to the given port or, if port = 0, shut down listening gear. Return success.
 	int listenToOSC(int port);
+	
+	// packets received by one batched read, and the largest packet size.
+	static const int kBatchSize = 64;
+	static const int kMaxPacketSize = 4096;
 		
 protected:
     virtual void ProcessMessage(const osc::ReceivedMessage&, const IpEndpointName& ) = 0;
@@ -42,7 +53,23 @@ protected:
 	bool mListening;
 
 private:
+#if ML_LINUX
+	// on Linux we own the socket, and read up to kBatchSize packets per system
+	// call with recvmmsg() into a preallocated arena. The packets are parsed
+	// in place.
+	bool openSocket(int port);
+	void closeSocket();
+	void runBatched();
+
+	int mSocket;
+	std::atomic<bool> mRunning;
+	std::vector<char> mPacketArena;
+	std::vector<struct mmsghdr> mMessages;
+	std::vector<struct iovec> mIOVecs;
+	std::vector<struct sockaddr_in> mSenders;
+#else
 	UdpListeningReceiveSocket* mpSocket;
+#endif
 	int mPort;
 	pthread_t mListenerThread;
 };
@@ -0,0 +1,179 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLRealtimeLog.h"
+#include "MLDebug.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+
+const int MLLogRecord::kMaxArgs;
+const int MLLogRecord::kTextSize;
+const int MLRealtimeLog::kRecords;
+
+void MLLogRecord::setString(int i, const char* s)
+{
+	// every string gets at least its terminator, so the text never runs over.
+	const int avail = kTextSize - mTextUsed;
+	mArg[i].mType = MLLogArg::kString;
+	if(avail <= 0)
+	{
+		mArg[i].mText = kTextSize - 1;
+		return;
+	}
+	int n = 0;
+	if(s)
+	{
+		while((n < avail - 1) && s[n])
+		{
+			mText[mTextUsed + n] = s[n];
+			n++;
+		}
+	}
+	mText[mTextUsed + n] = 0;
+	mArg[i].mText = mTextUsed;
+	mTextUsed += n + 1;
+}
+
+MLRealtimeLog::MLRealtimeLog() :
+	mUsers(0)
+{
+}
+
+MLRealtimeLog::~MLRealtimeLog()
+{
+	// no one called shutdown(). Stop the thread but don't write anything more.
+	std::lock_guard<std::mutex> lock(mThreadLock);
+	mWriter.stop(false);
+}
+
+void MLRealtimeLog::start()
+{
+	std::lock_guard<std::mutex> lock(mThreadLock);
+	if(mUsers++ > 0) return;
+	mWriter.start([this]() { write(debug()); });
+}
+
+void MLRealtimeLog::stop()
+{
+	std::lock_guard<std::mutex> lock(mThreadLock);
+	if(mUsers == 0) return;
+	if(--mUsers > 0) return;
+	mWriter.stop();
+}
+
+void MLRealtimeLog::shutdown()
+{
+	std::lock_guard<std::mutex> lock(mThreadLock);
+	mUsers = 0;
+	mWriter.stop();
+}
+
+void MLRealtimeLog::write(std::ostream& out)
+{
+	MLLogRecord r;
+	while(mQueue.pop(r))
+	{
+		out << format(r);
+	}
+	int dropped = mQueue.getDropped();
+	if(dropped)
+	{
+		out << "MLRealtimeLog: " << dropped << " records dropped!\n";
+	}
+	out.flush();
+}
+
+// format one printf-style conversion for the argument a. The conversion is chosen
+// by the stored type of the argument, so a mismatched format can't read garbage.
+static void formatArg(std::string& out, const std::string& spec, char conv, const MLLogRecord& r, int i)
+{
+	const MLLogArg& a = (i < r.mArgs) ? r.mArg[i] : MLLogArg();
+	char buf[256];
+	buf[0] = 0;
+	const bool floatConv = (strchr("fFeEgGaA", conv) != nullptr);
+	switch(a.mType)
+	{
+		case MLLogArg::kInt:
+			if(floatConv)
+			{
+				snprintf(buf, sizeof(buf), (spec + conv).c_str(), (double)a.mInt);
+			}
+			else if(conv == 'c')
+			{
+				snprintf(buf, sizeof(buf), (spec + conv).c_str(), (int)a.mInt);
+			}
+			else if(strchr("diouxX", conv))
+			{
+				snprintf(buf, sizeof(buf), (spec + "ll" + conv).c_str(), a.mInt);
+			}
+			else
+			{
+				snprintf(buf, sizeof(buf), "%lld", a.mInt);
+			}
+			break;
+		case MLLogArg::kDouble:
+			if(floatConv)
+			{
+				snprintf(buf, sizeof(buf), (spec + conv).c_str(), a.mDouble);
+			}
+			else
+			{
+				snprintf(buf, sizeof(buf), "%g", a.mDouble);
+			}
+			break;
+		case MLLogArg::kString:
+			snprintf(buf, sizeof(buf), (spec + 's').c_str(), r.getString(i));
+			break;
+		case MLLogArg::kNone:
+		default:
+			snprintf(buf, sizeof(buf), "(missing)");
+			break;
+	}
+	out += buf;
+}
+
+std::string MLRealtimeLog::format(const MLLogRecord& r)
+{
+	std::string out;
+	if(!r.mFormat) return out;
+	int argIdx = 0;
+	for(const char* p = r.mFormat; *p; ++p)
+	{
+		if(*p != '%')
+		{
+			out += *p;
+			continue;
+		}
+		if(p[1] == '%')
+		{
+			out += '%';
+			++p;
+			continue;
+		}
+
+		// collect flags, width and precision, skipping any length modifiers.
+		std::string spec("%");
+		++p;
+		while(*p && strchr("-+ #0123456789.", *p))
+		{
+			spec += *p++;
+		}
+		while(*p && strchr("hlLqjzt", *p))
+		{
+			++p;
+		}
+		if(!*p) break;
+
+		formatArg(out, spec, *p, r, argIdx++);
+	}
+	return out;
+}
+
+MLRealtimeLog& theRealtimeLog()
+{
+	static MLRealtimeLog theRealtimeLogObject;
+	return theRealtimeLogObject;
+}
@@ -0,0 +1,185 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef _ML_REALTIME_LOG_H
+#define _ML_REALTIME_LOG_H
+
+#include <atomic>
+#include <iosfwd>
+#include <mutex>
+#include <memory>
+#include <string>
+
+#include "MLMPSCQueue.h"
+#include "MLBackgroundWriter.h"
+
+// A log that can be written from any thread, including the audio thread.
+// post() copies a fixed-size record with a printf-style format string and its
+// arguments into a lock-free ring without allocating or formatting. A background
+// thread started by start() formats the records and writes them to debug().
+//
+// Only a pointer to the format string is kept, so the format must be a literal.
+// String arguments are copied into the record when it is posted, up to
+// MLLogRecord::kTextSize bytes in all, and are cut short past that. So it is
+// fine to pass the c_str() of a string that will change or go away.
+
+// log levels. messages below ML_LOG_LEVEL are compiled out.
+//
+enum MLLogLevel
+{
+	kMLLogDebug = 0,
+	kMLLogInfo,
+	kMLLogWarning,
+	kMLLogError
+};
+
+#ifndef ML_LOG_LEVEL
+	#if defined(DEBUG) && DEBUG
+		#define ML_LOG_LEVEL 0
+	#else
+		#define ML_LOG_LEVEL 1
+	#endif
+#endif
+
+// one argument to a log message, stored by value.
+//
+struct MLLogArg
+{
+	enum Type
+	{
+		kNone = 0,
+		kInt,
+		kDouble,
+		kString
+	};
+
+	MLLogArg() : mType(kNone), mInt(0) {}
+	MLLogArg(int i) : mType(kInt), mInt(i) {}
+	MLLogArg(unsigned i) : mType(kInt), mInt(i) {}
+	MLLogArg(long i) : mType(kInt), mInt(i) {}
+	MLLogArg(unsigned long i) : mType(kInt), mInt((long long)i) {}
+	MLLogArg(long long i) : mType(kInt), mInt(i) {}
+	MLLogArg(unsigned long long i) : mType(kInt), mInt((long long)i) {}
+	MLLogArg(bool b) : mType(kInt), mInt(b) {}
+	MLLogArg(float f) : mType(kDouble), mDouble(f) {}
+	MLLogArg(double d) : mType(kDouble), mDouble(d) {}
+
+	int mType;
+	union
+	{
+		long long mInt;
+		double mDouble;
+		int mText;	// offset of a string argument in its record's text
+	};
+};
+
+struct MLLogRecord
+{
+	static const int kMaxArgs = 6;
+	static const int kTextSize = 64;
+
+	MLLogRecord() : mFormat(nullptr), mLevel(0), mArgs(0), mTextUsed(0) {}
+
+	// copy a string argument into the text, truncating it if needed.
+	void setString(int i, const char* s);
+	const char* getString(int i) const { return &mText[mArg[i].mText]; }
+
+	const char* mFormat;
+	int mLevel;
+	int mArgs;
+	MLLogArg mArg[kMaxArgs];
+	int mTextUsed;
+	char mText[kTextSize];
+};
+
+class MLRealtimeLog
+{
+public:
+	static const int kRecords = 1024;	// must be a power of two
+
+	MLRealtimeLog();
+	~MLRealtimeLog();
+
+	// start and stop the writer thread. not for the audio thread. These can be
+	// called from several threads at once, as when engines are built in parallel.
+	// Each start() needs a matching stop(). The thread stops at the last stop(),
+	// after writing any waiting records.
+	void start();
+	void stop();
+
+	// stop the writer thread no matter how many users have started it, and write
+	// any waiting records. Call this before exiting: if the log is still running
+	// at static destruction, its remaining records are discarded instead, because
+	// the debug() stream may already be gone.
+	void shutdown();
+
+	// add a record to the log. realtime safe: if the ring is full, the record
+	// is dropped and counted.
+	template<typename... Args>
+	void post(int level, const char* format, Args... args)
+	{
+		static_assert(sizeof...(Args) <= MLLogRecord::kMaxArgs, "MLRealtimeLog: too many arguments");
+		MLLogRecord r;
+		r.mFormat = format;
+		r.mLevel = level;
+		r.mArgs = sizeof...(Args);
+		setArgs(r, 0, args...);
+		push(r);
+	}
+
+	// format and write all waiting records to out. called by the writer thread.
+	void write(std::ostream& out);
+
+	// format one record to a string.
+	static std::string format(const MLLogRecord& r);
+
+private:
+	template<typename T>
+	static void setArg(MLLogRecord& r, int i, T v) { r.mArg[i] = MLLogArg(v); }
+	static void setArg(MLLogRecord& r, int i, const char* s) { r.setString(i, s); }
+	static void setArg(MLLogRecord& r, int i, char* s) { r.setString(i, s); }
+	
+	static void setArgs(MLLogRecord&, int) {}
+	template<typename T, typename... Rest>
+	static void setArgs(MLLogRecord& r, int i, T first, Rest... rest)
+	{
+		setArg(r, i, first);
+		setArgs(r, i + 1, rest...);
+	}
+
+	void push(const MLLogRecord& r) { mQueue.push(r); }
+
+	MLMPSCQueue<MLLogRecord, kRecords> mQueue;
+	std::mutex mThreadLock;	// guards starting and stopping the writer
+	int mUsers;
+	MLBackgroundWriter mWriter;
+};
+
+// the log shared by the whole application or plugin.
+//
+extern MLRealtimeLog& theRealtimeLog();
+
+#define ML_LOG(level, ...) do { theRealtimeLog().post((level), __VA_ARGS__); } while(0)
+
+#if ML_LOG_LEVEL <= 0
+	#define ML_LOG_DEBUG(...) ML_LOG(kMLLogDebug, __VA_ARGS__)
+#else
+	#define ML_LOG_DEBUG(...) do {} while(0)
+#endif
+
+#if ML_LOG_LEVEL <= 1
+	#define ML_LOG_INFO(...) ML_LOG(kMLLogInfo, __VA_ARGS__)
+#else
+	#define ML_LOG_INFO(...) do {} while(0)
+#endif
+
+#if ML_LOG_LEVEL <= 2
+	#define ML_LOG_WARNING(...) ML_LOG(kMLLogWarning, __VA_ARGS__)
+#else
+	#define ML_LOG_WARNING(...) do {} while(0)
+#endif
+
+#define ML_LOG_ERROR(...) ML_LOG(kMLLogError, __VA_ARGS__)
+
+#endif // _ML_REALTIME_LOG_H
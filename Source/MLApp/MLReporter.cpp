@@ -5,6 +5,8 @@
 
 #include "MLReporter.h"
 
+#include <chrono>
+
 // property viewing
 
 MLPropertyView::MLPropertyView(MLWidget* w, MLSymbol a) :
@@ -29,7 +31,8 @@ void MLPropertyView::view(const MLProperty& p) const
 void MLReporter::PropertyListener::doPropertyChangeAction(MLSymbol property, const MLProperty& newVal)
 {
 	// note that property names will collide across different PropertyListeners!
-	mpOwnerReporter->enqueuePropertyChange(property, newVal);
+	// The value is read from our property set when it is viewed.
+	mpOwnerReporter->enqueuePropertyChange(property, mpPropertyOwner);
 }
 
 // MLReporter::ReporterTimer
@@ -52,11 +55,41 @@ void MLReporter::ReporterTimer::timerCallback()
 
 // MLReporter
 	
-MLReporter::MLReporter()
+const int MLReporter::kNumPriorities;
+const int MLReporter::kMaxSlots;
+const int MLReporter::kSlotTableSize;
+
+namespace
+{
+	// first slot table entry to try for a symbol ID.
+	inline int slotTableHash(int key)
+	{
+		return (int)(((unsigned)key*2654435761u) >> 8) & (MLReporter::kMaxSlots*2 - 1);
+	}
+}
+
+MLReporter::MLReporter() :
+	mNumSlots(0),
+	mSlotTableKeys(new std::atomic<int>[kSlotTableSize]),
+	mSlotTableSlots(new int[kSlotTableSize]),
+	mSlotSources(new std::atomic<MLPropertySet*>[kMaxSlots]),
+	mSlotQueued(new std::atomic<bool>[kMaxSlots]),
+	mChangeQueue(new std::atomic<int>[kMaxSlots]),
+	mChangeWritePos(0),
+	mChangeReadPos(0),
+	mFrameBudget(4.)
 {
-	int size = 1 << 10;
-	mChangeData.resize(size);
-	PaUtil_InitializeRingBuffer( &mChangeQueue, sizeof(MLSymbol), size, &(mChangeData[0]) );
+	for(int i=0; i<kSlotTableSize; ++i)
+	{
+		mSlotTableKeys[i] = 0;
+		mSlotTableSlots[i] = -1;
+	}
+	for(int i=0; i<kMaxSlots; ++i)
+	{
+		mSlotSources[i] = 0;
+		mSlotQueued[i] = false;
+		mChangeQueue[i] = 0;
+	}
 	mpTimer = std::unique_ptr<ReporterTimer>(new ReporterTimer(this));
 }
 
@@ -64,20 +97,70 @@ MLReporter::~MLReporter()
 {
 }
 
-void MLReporter::enqueuePropertyChange(MLSymbol prop, const MLProperty& newVal)
+int MLReporter::findSlot(MLSymbol prop) const
+{
+	const int key = prop.getID() + 1;
+	int h = slotTableHash(key);
+	for(int n=0; n<kSlotTableSize; ++n)
+	{
+		const int k = mSlotTableKeys[h].load(std::memory_order_acquire);
+		if(k == key) return mSlotTableSlots[h];
+		if(k == 0) return -1;
+		h = (h + 1) & (kSlotTableSize - 1);
+	}
+	return -1;
+}
+
+int MLReporter::addSlot(MLSymbol prop)
 {
-	// enqueue change
-#if DEBUG
-	int written = PaUtil_WriteRingBuffer( &mChangeQueue, &prop, 1 );
-	if(written < 1)
+	int i = findSlot(prop);
+	if(i >= 0) return i;
+	if(mNumSlots >= kMaxSlots)
+	{
+		debug() << "MLReporter: no slot for property " << prop << "!\n";
+		return -1;
+	}
+	
+	i = mNumSlots++;
+	mSlotNames.push_back(prop);
+	mSlotPriority.push_back(kNormalPriority);
+	
+	// publish the slot. The table is twice the maximum number of slots, so it has room.
+	const int key = prop.getID() + 1;
+	int h = slotTableHash(key);
+	while(mSlotTableKeys[h].load(std::memory_order_relaxed) != 0)
 	{
-		debug() << "MLReporter::doPropertyChangeAction: ring buffer full! \n";
+		h = (h + 1) & (kSlotTableSize - 1);
 	}
-#else
-	PaUtil_WriteRingBuffer( &mChangeQueue, &prop, 1 );
-#endif
-	// store changed value
-	mCurrentProperties.setProperty(prop, newVal);
+	mSlotTableSlots[h] = i;
+	mSlotTableKeys[h].store(key, std::memory_order_release);
+	return i;
+}
+
+void MLReporter::enqueuePropertyChange(MLSymbol prop, MLPropertySet* pSet)
+{
+	// ignore properties that nothing views.
+	const int i = findSlot(prop);
+	if(i < 0) return;
+	
+	// note where to read the value. The slot is queued after this is stored.
+	mSlotSources[i].store(pSet, std::memory_order_release);
+	
+	// enqueue change only if the property is not already waiting.
+	if(!mSlotQueued[i].exchange(true))
+	{
+		const unsigned pos = mChangeWritePos.fetch_add(1);
+		mChangeQueue[pos & (kMaxSlots - 1)].store(i + 1);
+	}
+}
+
+void MLReporter::setPropertyPriority(MLSymbol prop, int priority)
+{
+	const int i = addSlot(prop);
+	if(i < 0) return;
+	
+	// a queued change stays in the queue of its old priority until viewed.
+	mSlotPriority[i] = clamp(priority, (int)kLowPriority, (int)kHighPriority);
 }
 
 void MLReporter::listenTo(MLPropertySet* p)
@@ -106,33 +189,65 @@ void MLReporter::fetchAllProperties()
 //
 void MLReporter::addPropertyViewToMap(MLSymbol modelProp, MLWidget* w, MLSymbol widgetProp)
 {
+	addSlot(modelProp);
 	mPropertyViewsMap[modelProp].push_back(MLPropertyViewPtr(new MLPropertyView(w, widgetProp))); 
 }
 
-void MLReporter::viewProperties()
+void MLReporter::viewSlot(int i)
 {
-	while(PaUtil_GetRingBufferReadAvailable(&mChangeQueue) > 0)
+	// do we have viewers for this property?
+	MLPropertyViewListMap::const_iterator look = mPropertyViewsMap.find(mSlotNames[i]);
+	if (look != mPropertyViewsMap.end())
 	{
-		// dequeue name of changed property
-		MLSymbol propName;
-		PaUtil_ReadRingBuffer( &mChangeQueue, &propName, 1 );
+		// get the latest value from the set that changed it.
+		MLPropertySet* pSet = mSlotSources[i].load(std::memory_order_acquire);
+		if(!pSet) return;
 		
-		// do we have viewers for this property?
-		MLPropertyViewListMap::iterator look = mPropertyViewsMap.find(propName);
-		if (look != mPropertyViewsMap.end())
+		// run viewers
+		// copy the value, so that viewers can change properties of the set while viewing.
+		mViewValue = pSet->getProperty(mSlotNames[i]);
+		const MLPropertyViewList& viewers = look->second;
+		for(MLPropertyViewList::const_iterator vit = viewers.begin(); vit != viewers.end(); vit++)
 		{
-			// run viewers
-			MLPropertyViewList viewers = look->second;
-			for(MLPropertyViewList::iterator vit = viewers.begin(); vit != viewers.end(); vit++)
+			(*vit)->view(mViewValue);
+		}
+	}
+}
+
+void MLReporter::viewProperties()
+{
+	// move changed slots to the view queues for their priorities.
+	for(;;)
+	{
+		std::atomic<int>& entry = mChangeQueue[mChangeReadPos & (kMaxSlots - 1)];
+		const int e = entry.load();
+		if(!e) break;
+		entry.store(0);
+		mChangeReadPos++;
+		mViewQueues[mSlotPriority[e - 1]].push_back(e - 1);
+	}
+	
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	bool viewedAny = false;
+	for(int p = kNumPriorities - 1; p >= 0; --p)
+	{
+		std::deque<int>& queue = mViewQueues[p];
+		while(!queue.empty())
+		{
+			// leave the rest for the next frame if we are over budget.
+			if(viewedAny)
 			{
-				MLPropertyViewPtr pv = (*vit);
-				const MLPropertyView& v = (*pv);
-				v.view(mCurrentProperties.getProperty(propName));
+				std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+				if(elapsed.count() > mFrameBudget) return;
 			}
+			
+			// dequeue index of changed property. Clear its flag first so that
+			// any change made by a viewer is queued again.
+			int i = queue.front();
+			queue.pop_front();
+			mSlotQueued[i] = false;
+			viewSlot(i);
+			viewedAny = true;
 		}
 	}
 }
-
-
-
-
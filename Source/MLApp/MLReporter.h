@@ -8,8 +8,9 @@
 
 #include "MLModel.h"
 #include "MLWidget.h"
+#include <atomic>
 #include <map>
-#include "pa_ringbuffer.h"
+#include <deque>
 
 #pragma mark property viewing
 
@@ -35,9 +36,30 @@ typedef std::map<MLSymbol, MLPropertyViewList> MLPropertyViewListMap;
 // Reporter listens to one or more property sets and reports their changing properties by setting
 // properties of Widgets. Properties may contain float, string or signal values.
 //
+// Changes are coalesced: a property is queued at most once until it is viewed, and the
+// latest value wins. Each frame, viewProperties() runs views in priority order until its
+// time budget is used up, and leaves the rest queued for the next frame.
+//
+// Property changes can arrive on any thread, for example from a host automating a
+// parameter. Only properties with views or priorities are kept, each in a slot made on 
+// the message thread. The changing thread only marks the slot and notes which property
+// set changed it, without locks or copies. The message thread sorts changed slots by
+// priority and reads each value from its property set when it is viewed. As with any
+// MLPropertyListener, a value may be changing while it is read; the change queues its 
+// slot again, so the last value set is always the last one viewed.
+//
 class MLReporter
 {
 public:
+	static const int kNumPriorities = 3;
+	static const int kMaxSlots = 1 << 12;
+	enum
+	{
+		kLowPriority = 0,
+		kNormalPriority = 1,
+		kHighPriority = 2
+	};
+	
 	MLReporter();
     ~MLReporter();
 	
@@ -46,6 +68,13 @@ public:
 	void fetchAllProperties();
 	void addPropertyViewToMap(MLSymbol p, MLWidget* w, MLSymbol attr);
 	void viewProperties();
+	
+	// changes to properties with higher priority are viewed first. The default is kNormalPriority.
+	void setPropertyPriority(MLSymbol p, int priority);
+	
+	// set the time in milliseconds viewProperties() may spend each frame. At least one
+	// queued property is always viewed, so the queue makes progress under any budget.
+	void setFrameBudget(double ms) { mFrameBudget = ms; }
 
 protected:
 	MLPropertyViewListMap mPropertyViewsMap;
@@ -78,12 +107,44 @@ private:
 		MLReporter* mpOwnerReporter;
 	};
 	
-	void enqueuePropertyChange(MLSymbol property, const MLProperty& newVal);
+	static const int kSlotTableSize = kMaxSlots*2;
+
+	void enqueuePropertyChange(MLSymbol property, MLPropertySet* pSet);
+	
+	// message thread: return the slot for the property, making it if needed, or -1 if full.
+	int addSlot(MLSymbol property);
+	
+	// any thread: return the slot for the property, or -1 if it has none.
+	int findSlot(MLSymbol property) const;
+	
+	void viewSlot(int i);
 
 	std::vector<MLPropertyListenerPtr> pListeners;
-	MLPropertySet mCurrentProperties;
-	std::vector<MLSymbol> mChangeData;
-	PaUtilRingBuffer mChangeQueue;
+	
+	// slots, made by addSlot().
+	std::vector<MLSymbol> mSlotNames;
+	std::vector<int> mSlotPriority;
+	int mNumSlots;
+	
+	// the fixed-size parts of slots, used from any thread. A key is a symbol ID + 1, or 0
+	// if the entry is empty. It is stored after the entry's slot. A slot's source is the
+	// property set that last changed it.
+	std::unique_ptr<std::atomic<int>[]> mSlotTableKeys;
+	std::unique_ptr<int[]> mSlotTableSlots;
+	std::unique_ptr<std::atomic<MLPropertySet*>[]> mSlotSources;
+	std::unique_ptr<std::atomic<bool>[]> mSlotQueued;
+	
+	// changed slots, from any thread to the message thread. An entry is a slot + 1, or 0
+	// if not yet written. A slot is in this queue or mViewQueues at most once, so the 
+	// queue can't fill up.
+	std::unique_ptr<std::atomic<int>[]> mChangeQueue;
+	std::atomic<unsigned> mChangeWritePos;
+	unsigned mChangeReadPos;
+	
+	// message thread: slots waiting to be viewed, one queue per priority.
+	std::deque<int> mViewQueues[kNumPriorities];
+	MLProperty mViewValue;
+	double mFrameBudget;
 	std::unique_ptr<ReporterTimer> mpTimer;
 };
 
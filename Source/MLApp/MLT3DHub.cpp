@@ -23,6 +23,14 @@ MLT3DHub::MLT3DHub() :
 	// initialize touch frame for output
 	mOutputFrame.setDims(MLT3DHub::kFrameWidth, MLT3DHub::kFrameHeight);
 
+	// build address table
+	mDispatch.addAddress("/t3d/frm", kFrameAddr);
+	mDispatch.addAddress("/t3d/tch", kTouchAddr, true);
+	mDispatch.addAddress("/t3d/dr", kDataRateAddr);
+	mDispatch.addAddress("/pgm", kProgramAddr);
+	mDispatch.addAddress("/vol", kVolumeAddr);
+	mDispatch.addAddress("/seq", kSequenceAddr);
+
 	setShortName("<unnamed hub>");
 	
 	// build touch frame buffer
@@ -144,81 +152,79 @@ void MLT3DHub::ProcessMessage(const osc::ReceivedMessage& msg, const IpEndpointN
         
 		//debug() << "t3d: " << addy << "\n";
         
-		// frame message.
-		// /t3d/frm (int)frameID int)deviceID
-		if (strcmp(addy, "/t3d/frm") == 0)
-		{
-			args >> frameID >> deviceID;
-
- // debug() << "FRM " << frameID << "\n";
-		}
-        // match tch[n] message
-        else if (strncmp(addy, "/t3d/tch", 8) == 0)
-		{
-            // get trailing number
-			touchID = 1;
-            int len = strlen(addy);
-            if(len == 9)
-            {
-                touchID = addy[8] - 48;
-            }
-            else if(len == 10)
-            {
-                touchID = 10*(addy[8] - 48) + (addy[9] - 48);
-            }
-            touchID = clamp(touchID - 1, (osc::int32)0, (osc::int32)16);
-            
-			// t3d/tch[ID], (float)x, (float)y, (float)z, (float)note
-			args >> x >> y >> z >> note;
-			
-			// debug() << "TCH " << touchID << " " << x << " " << y << " " << z << " " << note << "\n";
-            
-			mOutputFrame(0, touchID) = x;
-			mOutputFrame(1, touchID) = y;
-			mOutputFrame(2, touchID) = z;
-			mOutputFrame(3, touchID) = note;
-		}
-        
-		// data rate message comes every second if t3d is being sent
-		else if (strcmp(addy, "/t3d/dr")==0)
-		{
-			osc::int32 r;
-			args >> r;
-			mDataRate = r;
-			notifyListeners("data_rate", r);
-						
-			mT3DWaitTime = 0;
-			mReceivingT3d = true;
-		}
-		else if (strcmp(addy, "/pgm")==0)
-		{
-			osc::int32 pgm;
-			args >> pgm;
-			notifyListeners("program", pgm);
-		}
-		else if (strcmp(addy, "/vol")==0)
+		switch(mDispatch.match(addy, &touchID))
 		{
-			float v;
-			args >> v;
-			notifyListeners("volume", v);
-		}
-		
-		// seq message for supporting sequencer pattern changes -- MLTEST
-		else if (strcmp(addy, "/seq")==0)
-		{
-			MLSignal sequence;
-			sequence.setDims(16);
-			osc::int32 seqWord;
-			args >> seqWord;
-			
-			// build signal from sequence bits
-			for(int i=0; i<16; ++i)
+			// frame message.
+			// /t3d/frm (int)frameID int)deviceID
+			case kFrameAddr:
+				args >> frameID >> deviceID;
+				
+	 // debug() << "FRM " << frameID << "\n";
+				break;
+				
+			// tch[n] message. touches with no trailing number are touch 1.
+			case kTouchAddr:
+				if(touchID == 0) touchID = 1;
+				touchID = clamp(touchID - 1, (osc::int32)0, (osc::int32)(kFrameHeight - 1));
+				
+				// t3d/tch[ID], (float)x, (float)y, (float)z, (float)note
+				args >> x >> y >> z >> note;
+				
+				// debug() << "TCH " << touchID << " " << x << " " << y << " " << z << " " << note << "\n";
+				
+				mOutputFrame(0, touchID) = x;
+				mOutputFrame(1, touchID) = y;
+				mOutputFrame(2, touchID) = z;
+				mOutputFrame(3, touchID) = note;
+				break;
+				
+			// data rate message comes every second if t3d is being sent
+			case kDataRateAddr:
+			{
+				osc::int32 r;
+				args >> r;
+				mDataRate = r;
+				notifyListeners("data_rate", r);
+				
+				mT3DWaitTime = 0;
+				mReceivingT3d = true;
+				break;
+			}
+			case kProgramAddr:
+			{
+				osc::int32 pgm;
+				args >> pgm;
+				notifyListeners("program", pgm);
+				break;
+			}
+			case kVolumeAddr:
+			{
+				float v;
+				args >> v;
+				notifyListeners("volume", v);
+				break;
+			}
+				
+			// seq message for supporting sequencer pattern changes -- MLTEST
+			case kSequenceAddr:
 			{
-				float f = (seqWord & (1<<i)) ? 1. : 0.;
-				sequence[i] = f;
+				MLSignal sequence;
+				sequence.setDims(16);
+				osc::int32 seqWord;
+				args >> seqWord;
+				
+				// build signal from sequence bits
+				for(int i=0; i<16; ++i)
+				{
+					float f = (seqWord & (1<<i)) ? 1. : 0.;
+					sequence[i] = f;
+				}
+				
+				notifyListeners("sequence", sequence);
+				break;
 			}
-			
-			notifyListeners("sequence", sequence);
+			default:
+				break;
 		}
 	}
 	catch( osc::Exception& e )
@@ -16,6 +16,8 @@
 #include "MLDSP.h"
 #include "MLPlatform.h"
 #include "MLOSCListener.h"
+#include "MLOSCDispatch.h"
+#include "MLInputProtocols.h"
 #include "MLNetServiceHub.h"
 #include "MLDebug.h"
 #include "MLSignal.h"
@@ -34,8 +36,8 @@ class MLT3DHub :
 	private juce::Timer
 {
 public:
-	static const int kFrameWidth = 4;
-	static const int kFrameHeight = 16;
+	static const int kFrameWidth = kMLTouchFrameWidth;
+	static const int kFrameHeight = kMLTouchFrameHeight;
 	static const int kFrameBufferSize = 128;
 	static const int kDefaultUDPPort = 3123;
 
@@ -77,9 +79,22 @@ protected:
 	void ProcessMessage(const osc::ReceivedMessage& m, const IpEndpointName& remoteEndpoint);
 	
 private:
+	// IDs for the OSC addresses we handle.
+	enum
+	{
+		kFrameAddr = 0,
+		kTouchAddr,
+		kDataRateAddr,
+		kProgramAddr,
+		kVolumeAddr,
+		kSequenceAddr
+	};
+
 	void connect();
 	void disconnect();
 
+	MLOSCDispatch mDispatch;
+
 	std::vector<MLT3DHub::Listener*> mpListeners;
 	std::string mShortName; // will append a port # to this to create full name of MLNetServiceHub
 
@@ -140,14 +140,16 @@ cJSON* MLAppState::getStateAsJSON()
 	cJSON* root = cJSON_CreateObject();
 
 	// get Model parameters
-	std::map<MLSymbol, PropertyState>::iterator it;
+	std::lock_guard<std::mutex> lock(mStatesLock);
+	std::vector<PropertyState>::iterator it;
 	for(it = mPropertyStates.begin(); it != mPropertyStates.end(); it++)
 	{
-		MLSymbol key = it->first;
+		PropertyState& state = *it;
+		if(!state.mKnown) continue;
+		MLSymbol key = state.mName;
 		if(mIgnoredProperties.find(key) == mIgnoredProperties.end())
 		{			
 			const char* keyStr = key.getString().c_str();
-			PropertyState& state = it->second;
 			switch(state.mValue.getType())
 			{
 				case MLProperty::kFloatProperty:
@@ -21,6 +21,10 @@ MLAppWindow::MLAppWindow() :
     setResizable(true, false);
 	setResizeLimits (400, 300, 8192, 8192);
 
+#ifdef ML_WINDOWS
+	setTextStreamThreadCheck([]() { return juce::MessageManager::getInstance()->isThisTheMessageThread(); });
+#endif
+
     commandManager.registerAllCommandsForTarget (JUCEApplication::getInstance());
     
     // this lets the command manager use keypresses that arrive in our window to send
@@ -15,7 +15,10 @@ const char* kUDPAddressName = "localhost";
 #endif
 
 MLPluginProcessor::MLPluginProcessor() : 
+	mpEngine(new MLDSPEngine),
 	mInputProtocol(-1),
+	mRequestedVoices(0),
+	mRebuildVoices(0),
 	mMLListener(0),
 	mEditorNumbersOn(true),
 	mEditorAnimationsOn(true),
@@ -24,6 +27,11 @@ MLPluginProcessor::MLPluginProcessor() :
 	mHasParametersSet = false;
 	mNumParameters = 0;
 	lastPosInfo.resetToDefault();
+	
+#ifdef ML_WINDOWS
+	// debug output on Windows is only safe from the message thread.
+	setTextStreamThreadCheck([]() { return juce::MessageManager::getInstance()->isThisTheMessageThread(); });
+#endif
     
     createFileCollections();
 	
@@ -64,6 +72,13 @@ MLPluginProcessor::~MLPluginProcessor()
 #if defined (__APPLE__)
 	mT3DHub.removeListener(this);
 #endif
+	if(mpEngineSwapTimer)
+	{
+		mpEngineSwapTimer->stopTimer();
+	}
+	MLDSPEngine* pEngine = getEngine();
+	mEngineSwap.reset(pEngine);
+	delete pEngine;
 }
 
 #pragma mark MLModel
@@ -85,12 +100,19 @@ void MLPluginProcessor::doPropertyChangeAction(MLSymbol propName, const MLProper
 		case MLProperty::kFloatProperty:
 		{
 			// Here is where changes in Model properties turn into changes in DSP Engine parameters.
-			MLPublishedParamPtr p = mEngine.getParamPtr(paramIdx);
+			MLPublishedParamPtr p = getEngine()->getParamPtr(paramIdx);
 			if(p)
 			{
 				// set published float parameter in DSP engine.
 				setParameterWithoutProperty (propName, f);
 				
+				// more voices than the engine has need a new engine.
+				if(propName == "voices")
+				{
+					mRequestedVoices = (int)f;
+					updateVoices();
+				}
+				
 				// convert to host units for VST
 				f = newVal.getFloatValue();
 				if (wrapperType == AudioProcessor::wrapperType_VST)
@@ -101,7 +123,7 @@ void MLPluginProcessor::doPropertyChangeAction(MLSymbol propName, const MLProper
 				// either enqueue change, or send change immediately to host wrapper
 				if(p->getNeedsQueue())
 				{
-					p->pushValue(f);
+					getEngine()->getAutomationQueue().push(paramIdx, f);
 				}
 				else
 				{
@@ -170,33 +192,25 @@ void MLPluginProcessor::MLEnvironmentModel::doPropertyChangeAction(MLSymbol prop
 
 void MLPluginProcessor::loadPluginDescription(const char* desc)
 {
-	mpPluginDoc = new XmlDocument(String(desc));
-	
-	if (mpPluginDoc.get())
+	// parse the description, or get it from another instance that already has.
+	mpPluginDesc = theGraphCache().getDescription(desc);
+	if (mpPluginDesc->getRoot())
 	{
-		ScopedPointer<XmlElement> doc (mpPluginDoc->getDocumentElement(true));
-		if (doc)	// true = quick scan header
-		{
-			mEngine.scanDoc(&*mpPluginDoc, &mNumParameters);
-			debug() << "loaded " << JucePlugin_Name << " plugin description, " << mNumParameters << " parameters.\n";
-		}
-		else
-		{
-			debug() << "MLPluginProcessor: error loading plugin description!\n";
-		}   
+		getEngine()->scanDoc(*mpPluginDesc, &mNumParameters);
+		debug() << "loaded " << JucePlugin_Name << " plugin description, " << mNumParameters << " parameters.\n";
 	}
 	else
 	{
-		debug() << "MLPluginProcessor: couldn't load plugin description!\n";
+		debug() << "MLPluginProcessor: error loading plugin description: " << mpPluginDesc->getError() << "\n";
 		return;
 	}
 
 	// build: turn XML description into graph of processors
-	if (mEngine.getGraphStatus() != MLProc::OK)
+	if (getEngine()->getGraphStatus() != MLProc::OK)
 	{
 		int inChans = getNumInputChannels();
 		bool makeSignalInputs = inChans > 0;
-		mEngine.buildGraphAndInputs(&*mpPluginDoc, makeSignalInputs, wantsMIDI());
+		getEngine()->buildGraphAndInputs(*mpPluginDesc, makeSignalInputs, wantsMIDI());
 	}
 
 	loadDefaultPreset();
@@ -327,17 +341,25 @@ void MLPluginProcessor::prepareToPlay (double sr, int maxFramesPerBlock)
 	MLProc::err prepareErr;
 	MLProc::err r = preflight();
 	
-	if (!mpPluginDoc.get()) return;
+	if (!mpPluginDesc || mpPluginDesc->isEmpty()) return;
 	
 	if (r == MLProc::OK)
 	{
 		// get the Juce process lock  // TODO ???
 		const juce::ScopedLock sl (getCallbackLock());
+		
+		// audio is stopped, so drop any engine swap in progress.
+		if(mpEngineSwapTimer)
+		{
+			mpEngineSwapTimer->stopTimer();
+		}
+		mEngineSwap.reset(getEngine());
+		mRebuildVoices = 0;
 
 		int inChans = getNumInputChannels();
 		int outChans = getNumOutputChannels();
-		mEngine.setInputChannels(inChans);
-		mEngine.setOutputChannels(outChans);
+		getEngine()->setInputChannels(inChans);
+		getEngine()->setOutputChannels(outChans);
 
 		int bufSize = 0;
 		int chunkSize = 0;
@@ -363,9 +385,9 @@ void MLPluginProcessor::prepareToPlay (double sr, int maxFramesPerBlock)
 #endif
 
 		// compile: schedule graph of processors , setup connections, allocate buffers
-		if (mEngine.getCompileStatus() != MLProc::OK)
+		if (getEngine()->getCompileStatus() != MLProc::OK)
 		{
-			mEngine.compileEngine();
+			getEngine()->compileEngine(sr, chunkSize);
 		}
 		else
 		{
@@ -373,13 +395,13 @@ void MLPluginProcessor::prepareToPlay (double sr, int maxFramesPerBlock)
 		}
 
 		// prepare to play: resize and clear processors
-		prepareErr = mEngine.prepareEngine(sr, bufSize, chunkSize);
+		prepareErr = getEngine()->prepareEngine(sr, bufSize, chunkSize);
 		if (prepareErr != MLProc::OK)
 		{
 			debug() << "MLPluginProcessor: prepareToPlay error: \n";
 		}
 		
-		// mEngine.dump();
+		// getEngine()->dump();
 			
 		// after prepare to play, set state from saved blob if one exists
 		const unsigned blobSize = mSavedBinaryState.getSize();
@@ -390,7 +412,7 @@ void MLPluginProcessor::prepareToPlay (double sr, int maxFramesPerBlock)
 		}
 		else 
 		{
-			mEngine.clear();
+			getEngine()->clear();
 			if (!mHasParametersSet)
 			{
 				loadDefaultPreset();
@@ -404,14 +426,17 @@ void MLPluginProcessor::prepareToPlay (double sr, int maxFramesPerBlock)
 			mInitialized = true;
 		}		
 		
-		mEngine.setEnabled(prepareErr == MLProc::OK);
+		getEngine()->setEnabled(prepareErr == MLProc::OK);
 	}
+	
+	// voices set before the engine was compiled.
+	updateVoices();
 }
 
 void MLPluginProcessor::reset()
 {
 	const juce::ScopedLock sl (getCallbackLock());
-	mEngine.clear();
+	getEngine()->clear();
 }
 
 void MLPluginProcessor::releaseResources()
@@ -420,6 +445,130 @@ void MLPluginProcessor::releaseResources()
     // spare memory, etc.
 }
 
+#pragma mark engine rebuild
+
+const int kEngineSwapInterval = 10;
+
+bool MLPluginProcessor::rebuildEngine(int maxVoices)
+{
+	MLDSPEngine* pEngine = getEngine();
+	if (!mpPluginDesc || (pEngine->getCompileStatus() != MLProc::OK)) return false;
+	if (mEngineSwap.isBusy()) return false;
+	mRebuildVoices = maxVoices;
+	
+	// capture everything the build needs, so the build thread doesn't touch the processor.
+	std::shared_ptr<const MLGraphDesc> pDesc = mpPluginDesc;
+	const double sr = pEngine->getSampleRate();
+	const int bufSize = pEngine->getBufferSize();
+	const int chunkSize = pEngine->getVectorSize();
+	const int inChans = getNumInputChannels();
+	const int outChans = getNumOutputChannels();
+	const bool makeMIDIInput = wantsMIDI();
+	
+	bool started = mEngineSwap.startBuild([=]() -> MLDSPEngine*
+	{
+		MLDSPEngine* pNewEngine = new MLDSPEngine;
+		pNewEngine->setMaxVoices(maxVoices);
+		pNewEngine->setInputChannels(inChans);
+		pNewEngine->setOutputChannels(outChans);
+		MLProc::err e = pNewEngine->buildGraphAndInputs(*pDesc, inChans > 0, makeMIDIInput);
+		if (e == MLProc::OK)
+		{
+			pNewEngine->compileEngine(sr, chunkSize);
+			e = pNewEngine->prepareEngine(sr, bufSize, chunkSize);
+		}
+		if (e != MLProc::OK)
+		{
+			debug() << "MLPluginProcessor: rebuild error " << e << "\n";
+			delete pNewEngine;
+			return 0;
+		}
+		return pNewEngine;
+	});
+	
+	if (started)
+	{
+		if (!mpEngineSwapTimer)
+		{
+			mpEngineSwapTimer = std::unique_ptr<EngineSwapTimer>(new EngineSwapTimer(this));
+		}
+		mpEngineSwapTimer->startTimer(kEngineSwapInterval);
+	}
+	return started;
+}
+
+void MLPluginProcessor::updateEngineSwap()
+{
+	// delete the old engine of a finished fade first, so a new one can be committed.
+	mEngineSwap.collect();
+	
+	MLDSPEngine* pNewEngine = mEngineSwap.takeReadyEngine();
+	if (pNewEngine)
+	{
+		MLDSPEngine* pOldEngine = getEngine();
+		const int params = pOldEngine->getPublishedParams();
+		if (pNewEngine->getPublishedParams() != params)
+		{
+			debug() << "MLPluginProcessor: rebuilt engine has " << pNewEngine->getPublishedParams() 
+				<< " parameters, expected " << params << "\n";
+			delete pNewEngine;
+		}
+		else
+		{
+			// bring the new engine up to date with the running one.
+			for (int i = 0; i < params; ++i)
+			{
+				MLPublishedParamPtr p = pOldEngine->getParamPtr(i);
+				if (p)
+				{
+					pNewEngine->setPublishedParam(i, p->getValueProperty());
+				}
+			}
+			if (mInputProtocol >= 0)
+			{
+				pNewEngine->setEngineInputProtocol(mInputProtocol);
+			}
+#if defined(__APPLE__)
+			pNewEngine->setInputFrameBuffer(mT3DHub.getFrameBuffer());
+			const int dataRate = (int)getFloatProperty("data_rate");
+			if (dataRate > 0)
+			{
+				pNewEngine->setInputDataRate(dataRate);
+			}
+#endif
+			pNewEngine->setEnabled(true);
+			
+			// from here on the message thread uses the new engine. If the audio thread 
+			// is still fading, the engine stays ready and is tried again next time.
+			if (mEngineSwap.commit(pNewEngine))
+			{
+				mpEngine = pNewEngine;
+			}
+		}
+	}
+	
+	if (!mEngineSwap.isBusy())
+	{
+		// the voices may have changed during the rebuild.
+		updateVoices();
+	}
+	
+	// keep polling while a committed engine waits for audio, so that its old engine
+	// is collected once the fade is done.
+	if (!mEngineSwap.isBusy() && !mEngineSwap.isSwapping() && mpEngineSwapTimer)
+	{
+		mpEngineSwapTimer->stopTimer();
+	}
+}
+
+void MLPluginProcessor::updateVoices()
+{
+	const int voices = min(mRequestedVoices, kMLEngineVoiceLimit);
+	if (voices <= getEngine()->getMaxVoices()) return;
+	if (voices == mRebuildVoices) return;
+	rebuildEngine(voices);
+}
+
 #pragma mark juce::AudioProcessor
 
 void MLPluginProcessor::getStateInformation (MemoryBlock& destData)
@@ -430,7 +579,7 @@ void MLPluginProcessor::getStateInformation (MemoryBlock& destData)
 void MLPluginProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
 	// if uninitialized, save blob for later.
-	if (mEngine.getCompileStatus() != MLProc::OK)
+	if (getEngine()->getCompileStatus() != MLProc::OK)
 	{
 		mSavedBinaryState.setSize(0);
 		mSavedBinaryState.append(data, sizeInBytes);
@@ -627,12 +776,14 @@ void MLPluginProcessor::processMIDI(MidiBuffer& midiMessages, MLControlEventVect
 
 void MLPluginProcessor::setCollectStats(bool k)
 {
-	mEngine.setCollectStats(k);
+	getEngine()->setCollectStats(k);
 }
 
 void MLPluginProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
 {
-	if (mEngine.isEnabled() && !isSuspended())
+	// a newly committed engine is picked up here.
+	MLDSPEngine* pEngine = mEngineSwap.getAudioEngine();
+	if (pEngine && pEngine->isEnabled() && !isSuspended())
 	{
 		unsigned samples = buffer.getNumSamples();
 		
@@ -665,19 +816,16 @@ void MLPluginProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& mid
 		{
 			ioMap.outputs[i] = buffer.getWritePointer(i);
 		}
-		mEngine.setIOBuffers(ioMap);
 
-		// for any parameters with queues, send out one queued value per block
-		for(int i = 0; i < mEngine.getPublishedParams(); ++i)
+		// send queued parameter changes to the host, at most one per param per block.
+		// JUCE has no sample offsets for parameter changes, so each one takes effect 
+		// at the start of the block.
+		MLParamQueue& automation = pEngine->getAutomationQueue();
+		MLParamChange change;
+		automation.beginBlock();
+		while(automation.popForBlock(change))
 		{
-			MLPublishedParamPtr p = mEngine.getParamPtr(i);
-			if(p) // TODO clean up null paramater ptrs!
-			{
-				if(p->getQueueValuesRemaining() > 0)
-				{
-					AudioProcessor::sendParamChangeMessageToListeners (i, p->popValue());
-				}
-			}
+			AudioProcessor::sendParamChangeMessageToListeners (change.mIndex, change.mValue);
 		}
         
         if(acceptsMidi())
@@ -687,7 +835,9 @@ void MLPluginProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& mid
             midiMessages.clear(); // otherwise messages will be passed back to the host
         }
 		
-        mEngine.processSignalsAndEvents(samples, mControlEvents, samplesPosition, secsPosition, ppqPosition, bpm, isPlaying);
+		// run the engine, crossfading from the old one if a swap is in progress.
+		mEngineSwap.process(samples, mControlEvents, samplesPosition, secsPosition, ppqPosition, bpm, isPlaying, 
+			ioMap, getNumOutputChannels());
 
 		
 #if OSC_PARAMS
@@ -719,13 +869,13 @@ int MLPluginProcessor::getNumParameters()
 
 int MLPluginProcessor::getParameterIndex (const MLSymbol name)
 {
- 	return mEngine.getParamIndex(name);
+ 	return getEngine()->getParamIndex(name);
 }
 
 float MLPluginProcessor::getParameter (int index)
 {
   	if (index < 0) return(0);
-	return mEngine.getParamByIndex(index);
+	return getEngine()->getParamByIndex(index);
 }
 
 // set scalar float plugin parameter by index. Typically called by the host wrapper.
@@ -734,7 +884,7 @@ float MLPluginProcessor::getParameter (int index)
 void MLPluginProcessor::setParameter (int index, float newValue)
 {
 	if (index < 0) return;
-	mEngine.setPublishedParam(index, MLProperty(newValue));
+	getEngine()->setPublishedParam(index, MLProperty(newValue));
 	mHasParametersSet = true;
 	
 	// exclude this listener to avoid feedback!
@@ -746,7 +896,7 @@ float MLPluginProcessor::getParameterAsLinearProportion (int index)
 {
 	float r = 0;
   	if (index < 0) return(0);
-	MLPublishedParamPtr p = mEngine.getParamPtr(index);
+	MLPublishedParamPtr p = getEngine()->getParamPtr(index);
 	if(p)
 	{	
 		r = p->getValueAsLinearProportion();
@@ -758,17 +908,17 @@ float MLPluginProcessor::getParameterAsLinearProportion (int index)
 void MLPluginProcessor::setParameterAsLinearProportion (int index, float newValue)
 {
 	if (index < 0) return;	
-	MLPublishedParamPtr p = mEngine.getParamPtr(index);
+	MLPublishedParamPtr p = getEngine()->getParamPtr(index);
 	if(p)
 	{
 		p->setValueAsLinearProportion(newValue);	
-		mEngine.setPublishedParam(index, MLProperty(p->getValue()));
+		getEngine()->setPublishedParam(index, MLProperty(p->getValue()));
 		mHasParametersSet = true;
 		
 		// set MLModel Parameter 
 		// exclude this listener to avoid feedback!
 		MLSymbol paramName = getParameterAlias(index);
-		float realVal = mEngine.getParamByIndex(index);
+		float realVal = getEngine()->getParamByIndex(index);
 		setPropertyImmediateExcludingListener(paramName, realVal, this);
 	}
 }
@@ -776,19 +926,19 @@ void MLPluginProcessor::setParameterAsLinearProportion (int index, float newValu
 float MLPluginProcessor::getParameterMin (int index)
 {
 	if (index < 0) return(0);
-	return mEngine.getParamPtr(index)->getRangeLo();
+	return getEngine()->getParamPtr(index)->getRangeLo();
 }
 
 float MLPluginProcessor::getParameterMax (int index)
 {
 	if (index < 0) return(0);
-	return mEngine.getParamPtr(index)->getRangeHi();
+	return getEngine()->getParamPtr(index)->getRangeHi();
 }
 
 const String MLPluginProcessor::getParameterName (int index)
 {
 	MLSymbol nameSym;
-	const int p = mEngine.getPublishedParams(); 
+	const int p = getEngine()->getPublishedParams(); 
 	if (index < mNumParameters)
 	{
 		if (p == 0) // doc has been scanned but not built
@@ -798,7 +948,7 @@ const String MLPluginProcessor::getParameterName (int index)
 		else
 		{
 			// graph has been built
-			nameSym = mEngine.getParamPtr(index)->getAlias();	
+			nameSym = getEngine()->getParamPtr(index)->getAlias();	
 	//debug() << "getParameterName: " << index << " is " << nameSym.getString().c_str() << ".\n";
 		}
 	}
@@ -847,39 +997,39 @@ const MLSymbol MLPluginProcessor::XMLAttrToSymbol(const String& str)
 
 const MLSymbol MLPluginProcessor::getParameterAlias (int index)
 {
- 	return mEngine.getParamPtr(index)->getAlias();
+ 	return getEngine()->getParamPtr(index)->getAlias();
 }
 
 float MLPluginProcessor::getParameterDefaultValue (int index)
 {
- 	return mEngine.getParamPtr(index)->getDefault();
+ 	return getEngine()->getParamPtr(index)->getDefault();
 }
 
 MLPublishedParamPtr MLPluginProcessor::getParameterPtr (int index)
 {
- 	return mEngine.getParamPtr(index);
+ 	return getEngine()->getParamPtr(index);
 }
 
 MLPublishedParamPtr MLPluginProcessor::getParameterPtr (MLSymbol sym)
 {
- 	return mEngine.getParamPtr(mEngine.getParamIndex(sym));
+ 	return getEngine()->getParamPtr(getEngine()->getParamIndex(sym));
 }
 
 const String MLPluginProcessor::getParameterText (int index)
 {
 	// get -inf and indexed values here?
-	float val = mEngine.getParamByIndex(index);
+	float val = getEngine()->getParamByIndex(index);
     return String (val, 2);
 }
 
 const std::string& MLPluginProcessor::getParameterGroupName (int index)
 {
-	return mEngine.getParamGroupName(index);
+	return getEngine()->getParamGroupName(index);
 }
 
 bool MLPluginProcessor::isParameterAutomatable (int idx) const
 {
-	return mEngine.getParamPtr(idx)->getAutomatable();
+	return getEngine()->getParamPtr(idx)->getAutomatable();
 }
 
 // set scalar float plugin parameter by name without setting property.
@@ -889,7 +1039,7 @@ void MLPluginProcessor::setParameterWithoutProperty (MLSymbol paramName, float n
 	int index = getParameterIndex(paramName);
 	if (index < 0) return;
 	
-	mEngine.setPublishedParam(index, MLProperty(newValue));
+	getEngine()->setPublishedParam(index, MLProperty(newValue));
 	mHasParametersSet = true;
 }
 
@@ -900,7 +1050,7 @@ void MLPluginProcessor::setStringParameterWithoutProperty (MLSymbol paramName, c
 	int index = getParameterIndex(paramName);
 	if (index < 0) return;
 	
-	mEngine.setPublishedParam(index, MLProperty(newValue));
+	getEngine()->setPublishedParam(index, MLProperty(newValue));
 	mHasParametersSet = true;
 }
 
@@ -911,14 +1061,14 @@ void MLPluginProcessor::setSignalParameterWithoutProperty (MLSymbol paramName, c
 	int index = getParameterIndex(paramName);
 	if (index < 0) return;
 	
-	mEngine.setPublishedParam(index, MLProperty(newValue));
+	getEngine()->setPublishedParam(index, MLProperty(newValue));
 	mHasParametersSet = true;
 }
 
 // count the number of published copies of the signal matching alias.
 int MLPluginProcessor::countSignals(const MLSymbol alias)
 {
-	int numSignals = mEngine.getPublishedSignalVoicesEnabled(alias);
+	int numSignals = getEngine()->getPublishedSignalVoicesEnabled(alias);
 	return numSignals;
 }
 
@@ -1314,7 +1464,7 @@ void MLPluginProcessor::setPatchStateFromText (const String& stateStr)
 void MLPluginProcessor::setStateFromXML(const XmlElement& xmlState, bool setViewAttributes)
 {
 	if (!(xmlState.hasTagName (JucePlugin_Name))) return;
-	if (!(mEngine.getCompileStatus() == MLProc::OK)) return; // TODO revisit need to compile first
+	if (!(getEngine()->getCompileStatus() == MLProc::OK)) return; // TODO revisit need to compile first
 	
 	// only the differences between default parameters and the program state are saved in an XML program,
 	// so the first step is to set the default parameters.
@@ -1477,7 +1627,9 @@ void MLPluginProcessor::setStateFromXML(const XmlElement& xmlState, bool setView
 
 void MLPluginProcessor::createFileCollections()
 {
-	mScaleFiles = (MLFileCollectionPtr)(new MLFileCollection("scales", getDefaultFileLocation(kScaleFiles), "scl"));
+	File scaleRoot = getDefaultFileLocation(kScaleFiles);
+	MLScaleLoader::setScaleRoot(scaleRoot.getFullPathName().toStdString());
+	mScaleFiles = (MLFileCollectionPtr)(new MLFileCollection("scales", scaleRoot, "scl"));
     mPresetFiles = (MLFileCollectionPtr)(new MLFileCollection("presets", getDefaultFileLocation(kPresetFiles), "mlpreset"));
     mMIDIProgramFiles = (MLFileCollectionPtr)(new MLFileCollection("midi_programs", getDefaultFileLocation(kPresetFiles).getChildFile("MIDI Programs"), "mlpreset"));
 }
@@ -1531,7 +1683,7 @@ void MLPluginProcessor::advancePreset(int amount)
 
 void MLPluginProcessor::setDefaultParameters()
 {
-	if (mEngine.getCompileStatus() == MLProc::OK)
+	if (getEngine()->getCompileStatus() == MLProc::OK)
 	{
 		// set default for each parameter.
 		const unsigned numParams = getNumParameters();
@@ -1668,7 +1820,7 @@ void MLPluginProcessor::sendSeqInfo()
 	MLDSPEngine* eng = getEngine();
 	
 	// if we made one or more Patchers with the right names in the document, save a list of them for direct access. 
-	eng->getProcList(mSequencerList, MLPath(kMLStepSeqProcName), kMLEngineMaxVoices);
+	eng->getProcList(mSequencerList, MLPath(kMLStepSeqProcName), eng->getMaxVoices());
 	// debug() << "got " << mSequencerList.size() << "seqs\n";
 	//int nSeqs = mSequencerList.size();
 	
@@ -7,6 +7,7 @@
 #define __PLUGINPROCESSOR__
 
 #include "MLDSPEngine.h"
+#include "MLEngineSwap.h"
 #include "MLAudioProcessorListener.h"
 #include "MLDefaultFileLocations.h"
 #include "MLModel.h"
@@ -181,8 +182,19 @@ public:
     MLProc::err sendMessageToMLListener (unsigned msg, const File& f);
 	
 	// engine stuff
-	MLDSPEngine* getEngine() { return &mEngine; }
-	inline void showEngine() { mEngine.dump(); }
+	MLDSPEngine* getEngine() { return mpEngine.load(); }
+	inline void showEngine() { getEngine()->dump(); }
+	
+	// build a new engine with the given number of voices in the background and 
+	// crossfade to it when ready, without stopping audio. Parameter values are copied
+	// to the new engine but notes in progress are dropped. Returns false if the 
+	// engine is not compiled yet or a rebuild is already in progress. Message thread.
+	//
+	// This is called when the "voices" parameter asks for more voices than the engine
+	// has. Only the voice count changes: the new engine is built from the same plugin
+	// description at the same sample rate and buffer size. A new description or sample
+	// rate still needs prepareToPlay(), which stops audio.
+	bool rebuildEngine(int maxVoices);
 	
 	// environment: through which anything outside the patch, such as window size, can be stored in the host
 	MLEnvironmentModel* getEnvironment() { return mpEnvironmentModel.get(); }
@@ -201,13 +213,15 @@ protected:
 	void setStringParameterWithoutProperty (MLSymbol paramName, const std::string& newValue);
 	void setSignalParameterWithoutProperty (MLSymbol paramName, const MLSignal& newValue);
 		
-	// Engine creates graphs of Processors, does the work
-	MLDSPEngine	mEngine;	
+	// Engine creates graphs of Processors, does the work. This is the engine for the 
+	// message thread, the audio thread gets its engine from mEngineSwap.
+	std::atomic<MLDSPEngine*> mpEngine;
+	MLEngineSwap mEngineSwap;
 
 	int mInputProtocol;
 		
 	typedef std::shared_ptr<XmlElement> XmlElementPtr;
-	ScopedPointer<XmlDocument> mpPluginDoc;
+	std::shared_ptr<const MLGraphDesc> mpPluginDesc;
 	String mDocLocationString;
     
 	AudioPlayHead::CurrentPositionInfo lastPosInfo;
@@ -215,6 +229,29 @@ protected:
 private:
 	
 	void setCurrentPresetDir(const char* name);
+	
+	// while a rebuild is in progress, commit the new engine when it is ready
+	// and delete the old one when the audio thread is done with it.
+	void updateEngineSwap();
+	
+	// rebuild the engine if the "voices" parameter wants more voices than it has.
+	void updateVoices();
+	
+	class EngineSwapTimer : public juce::Timer
+	{
+	public:
+		EngineSwapTimer(MLPluginProcessor* pProc) : mpOwnerProcessor(pProc) {}
+		~EngineSwapTimer() { stopTimer(); }
+		void timerCallback() { mpOwnerProcessor->updateEngineSwap(); }
+	private:
+		MLPluginProcessor* mpOwnerProcessor;
+	};
+	std::unique_ptr<EngineSwapTimer> mpEngineSwapTimer;
+	
+	// the value of the "voices" parameter, and the voices of the last rebuild, so
+	// that a rebuild that fails is not tried again.
+	int mRequestedVoices;
+	int mRebuildVoices;
     
 	MLAudioProcessorListener* mMLListener;
     
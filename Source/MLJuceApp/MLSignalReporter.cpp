@@ -7,6 +7,7 @@
 
 MLSignalReporter::MLSignalReporter(MLPluginProcessor* p) :
 	mpProcessor(p),
+	mpEngine(nullptr),
     mViewIndex(0),
 	mNeedsRedraw(true)
 {
@@ -21,7 +22,8 @@ MLSignalReporter::~MLSignalReporter()
 //
 MLSignalView* MLSignalReporter::addSignalViewToMap(MLSymbol alias, MLWidget* w, MLSymbol attr, int viewSize, int priority)
 {
- 	MLDSPEngine* const pEngine = mpProcessor->getEngine();
+ 	updateEngine();
+ 	MLDSPEngine* const pEngine = mpEngine;
 	if(!pEngine) return nullptr;	
 	MLSignalView* pNewView = nullptr;
 	
@@ -35,12 +37,12 @@ MLSignalView* MLSignalReporter::addSignalViewToMap(MLSymbol alias, MLWidget* w,
 		MLSymbolToSignalMap::const_iterator it = mSignalBuffers.find(alias);
 		if (it == mSignalBuffers.end()) 
 		{
-			// add buffers so we can see if the signal has been changed since the last view
 			mSignalBuffers[alias] = MLSignalPtr(new MLSignal(bufSize, voices));
-			mSignalBuffers2[alias] = MLSignalPtr(new MLSignal(bufSize, voices));
-			mSignalBuffers2[alias]->fill(-1.f); // force initial view of zero signal
 		}
 		
+		// force a view including the new widget.
+		mSignalStates[alias].mViewed = false;
+		
 		viewSize = min(viewSize, bufSize);
 
         // add the list of widgets and attributes for viewing
@@ -64,30 +66,6 @@ MLSignalView* MLSignalReporter::addSignalViewToMap(MLSymbol alias, MLWidget* w,
 	return pNewView;
 }
 
-bool signalsAreDifferent(const MLSignal& a, const MLSignal& b, int samplesToCompare, int voices)
-{
-    bool result = false;
-    float totalDiff = 0.0f;
-    for(int j = 0; j < voices; ++j)
-    {
-        for(int i = 0; i<samplesToCompare; ++i)
-        {
-            float fa = a(i, j);
-            float fb = b(i, j);
-            float df = fa - fb;
-            totalDiff += df*df;
-            if(totalDiff > 0.01f)
-            {
-                result = true;
-				goto bail;
-            }
-        }
-    }
-    
-bail:
-    return result;
-}
-
 // for one signal in the map, run all views in the view list matching priority.
 //
 int MLSignalReporter::viewOneSignal(MLSymbol signalName, bool forceView, int priority)
@@ -95,50 +73,80 @@ int MLSignalReporter::viewOneSignal(MLSymbol signalName, bool forceView, int pri
  	MLDSPEngine* const pEngine = mpProcessor->getEngine();
 	if(!pEngine) return 0;
  
-    // get temp buffers
     MLSignal& buffer1 = *(mSignalBuffers[signalName].get());
-    MLSignal& buffer2 = *(mSignalBuffers2[signalName].get());
+	PublishedSignalState& state = mSignalStates[signalName];
     
-    // TODO revisit this-- we should not need to count the signals each time.
-    // only needed when we recompile or turn voices on / off.
-    int voices = mpProcessor->countSignals(signalName);
+    // count the voices only when the engine says they may have changed.
+	const uint32_t epoch = pEngine->getVoiceEpoch();
+	const bool voicesChanged = !state.mViewed || (epoch != state.mVoiceEpoch);
+	if(voicesChanged)
+	{
+		state.mVoices = mpProcessor->countSignals(signalName);
+		state.mVoiceEpoch = epoch;
+	}
+	const int voices = state.mVoices;
+    
+	// skip the read if nothing has been written that changes what we would see.
+	// the sequence is read first, so that a write during the read is seen next time.
+	const uint32_t sequence = pEngine->getPublishedSignalSequence(signalName);
+	if(!forceView && !voicesChanged && (sequence == state.mChangeSequence))
+	{
+		return 0;
+	}
     
-    // read signal into buffer and check for change.
-    // TODO post ring buffer, we have to look at all the samples in the buffer
-    // to detect changes. Instead, the DSP engine can keep track of what
-    // published signals have changed since the last read, and we can ask it.
     int drawn = 0;
     int samplesRead = pEngine->readPublishedSignal(signalName, buffer1);
     int samplesRequested = buffer1.getWidth(); // samples asked for by readPublishedSignal()
     
-    // if the buffer was full, compare to see if a redraw is needed. 
+    // if the buffer was full, send it to the views. 
     if(samplesRead == samplesRequested) 
     {
-		bool changed = signalsAreDifferent(buffer1, buffer2, samplesRead, voices);
-        if(changed || forceView)
-        {
-			// send signal to each signal view in its viewer list.
-            MLSignalViewList viewList = mSignalViewsMap[signalName];
-            for(MLSignalViewList::iterator it2 = viewList.begin(); it2 != viewList.end(); it2++)
-            {
-                // send engine and signal information to viewer proc.  
-                MLSignalViewPtr pV = *it2;
-                if(pV->mPriority >= priority)
-                {
-                    // again TODO should not be needed every time, only when # of voices changes
-                    pV->setupSignalView(pEngine, signalName, voices);                    
-                    pV->sendSignalToWidget(buffer1, samplesRead, voices);
-                    drawn++;
-                }
-            }
-			buffer2 = buffer1;
-        }
+		// send signal to each signal view in its viewer list.
+		MLSignalViewList& viewList = mSignalViewsMap[signalName];
+		for(MLSignalViewList::iterator it2 = viewList.begin(); it2 != viewList.end(); it2++)
+		{
+			// send engine and signal information to viewer proc.  
+			MLSignalViewPtr pV = *it2;
+			if(pV->mPriority >= priority)
+			{
+				pV->setupSignalView(pEngine, signalName, voices);                    
+				pV->sendSignalToWidget(buffer1, samplesRead, voices);
+				drawn++;
+			}
+		}
+		state.mChangeSequence = sequence;
+		state.mViewed = true;
     }
     return drawn;
 }
 
+void MLSignalReporter::updateEngine()
+{
+ 	MLDSPEngine* const pEngine = mpProcessor->getEngine();
+	if(pEngine == mpEngine) return;
+	mpEngine = pEngine;
+	
+	// a rebuilt engine starts its sequences and epochs again, and may have more voices.
+	mSignalStates.clear();
+	if(pEngine)
+	{
+		for(MLSymbolToSignalMap::iterator it = mSignalBuffers.begin(); it != mSignalBuffers.end(); ++it)
+		{
+			const MLSymbol alias = it->first;
+			const int bufSize = pEngine->getPublishedSignalBufferSize(alias);
+			const int voices = pEngine->getPublishedSignalVoices(alias);
+			if(bufSize > 0)
+			{
+				it->second = MLSignalPtr(new MLSignal(bufSize, voices));
+			}
+		}
+	}
+	mNeedsRedraw = true;
+}
+
 void MLSignalReporter::viewSignals()
 {
+	updateEngine();
 	if(mNeedsRedraw)
 	{
 		mNeedsRedraw = false;
@@ -32,15 +32,40 @@ protected:
 	int viewOneSignal(MLSymbol signalName, bool forceView, int priority = 0);
 	void redrawSignals();
 	
+	// if the processor has a new engine, make the read buffers for its signals and
+	// forget what we knew about the old one.
+	void updateEngine();
+	
 	typedef std::shared_ptr<MLSignalView> MLSignalViewPtr;
 	typedef std::list<MLSignalViewPtr> MLSignalViewList;
 	typedef std::map<MLSymbol, MLSignalViewList> MLSignalViewListMap;
 	typedef std::map<MLSymbol, MLSignalPtr> MLSymbolToSignalMap;
 	typedef std::map<MLSymbol, int> ViewPriorityMap;
+	
+	// what we know about each published signal since we last viewed it.
+	class PublishedSignalState
+	{
+	public:
+		PublishedSignalState() : mViewed(false), mChangeSequence(0), mVoiceEpoch(0), mVoices(0) {}
+		
+		// false until the signal has been read and viewed once, or after views are added.
+		bool mViewed;
+		
+		// change sequence of the published signal when we last read it.
+		uint32_t mChangeSequence;
+		
+		// voice count, cached until the engine's voice epoch changes.
+		uint32_t mVoiceEpoch;
+		int mVoices;
+	};
+	typedef std::map<MLSymbol, PublishedSignalState> PublishedSignalStateMap;
 
 	MLPluginProcessor* mpProcessor;
+	
+	// the engine that mSignalBuffers and mSignalStates were made for.
+	MLDSPEngine* mpEngine;
 	MLSymbolToSignalMap mSignalBuffers;
-	MLSymbolToSignalMap mSignalBuffers2;
+	PublishedSignalStateMap mSignalStates;
     ViewPriorityMap mViewPriorityMap;
     
     // map of view lists
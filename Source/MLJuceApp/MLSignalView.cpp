@@ -14,7 +14,8 @@ MLSignalView::MLSignalView(MLWidget* w, MLSymbol attr, int size, int priority) :
 	mpWidget(w),
 	mAttr(attr),
 	mSize(size),
-	mPriority(priority)
+	mPriority(priority),
+	mFront(0)
 {
 }
 
@@ -37,5 +38,19 @@ void MLSignalView::setupSignalView (MLDSPEngine* pEng, const MLSymbol sigName, i
 void MLSignalView::sendSignalToWidget(const MLSignal& signal, int samples, int voices)
 {		
 	const int viewSamples = min(mSize, samples);
-	mpWidget->viewSignal(mAttr, signal, viewSamples, voices);
+	const int points = mpWidget->getSignalViewPoints(mAttr);
+	if(points > 0)
+	{
+		// send a fixed number of min / max points per voice, so the widget's cost
+		// does not depend on the length of the buffer.
+		const int back = mFront ^ 1;
+		MLSignal& decimated = mDecimated[back];
+		decimated.decimateMinMax(signal, viewSamples, points);
+		mFront = back;
+		mpWidget->viewSignal(mAttr, decimated, decimated.getWidth(), voices);
+	}
+	else
+	{
+		mpWidget->viewSignal(mAttr, signal, viewSamples, voices);
+	}
 }
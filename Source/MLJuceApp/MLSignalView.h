@@ -35,6 +35,11 @@ private:
 	MLSymbol mAttr;
 	int mSize;
     int mPriority;
+	
+	// decimated signals for widgets that want them, double buffered so that the 
+	// signal last sent to the widget stays valid while the next one is made.
+	MLSignal mDecimated[2];
+	int mFront;
 };
 
 
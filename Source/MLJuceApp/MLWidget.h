@@ -57,6 +57,12 @@ public:
 	
 	// A signal viewer, not required. This is called repeatedly to view a Signal.
 	virtual void viewSignal(MLSymbol, const MLSignal&, int frames, int voices) {}
+	
+	// A signal viewer can return a number of points, typically its width in pixels, to 
+	// receive signals decimated to that many points per voice instead of every sample. 
+	// Plane 0 of the signal passed to viewSignal() is then the minimum of each point's
+	// span of samples and plane 1 the maximum.
+	virtual int getSignalViewPoints(MLSymbol) { return 0; }
 
     void setupGL(Component* pC);
     OpenGLContext* getGLContext() { return pGLContext; }
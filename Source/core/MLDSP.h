@@ -71,7 +71,10 @@ const uintptr_t kMLProcessChunkSize = 1 << kMLProcessChunkBits;
 const uintptr_t kMLSamplesPerSSEVectorBits = 2;
 const uintptr_t kSSEVecSize = 1 << kMLSamplesPerSSEVectorBits;
 
+// default number of voices made by the engine. the number can be changed at runtime
+// with MLDSPEngine::setMaxVoices(), up to kMLEngineVoiceLimit.
 const int kMLEngineMaxVoices = 8;
+const int kMLEngineVoiceLimit = 64;
 
 const uintptr_t kMLAlignBits = 6; // cache line is 64 bytes
 const uintptr_t kMLAlignSize = 1 << kMLAlignBits;
@@ -155,6 +158,8 @@ inline MLSample werp(const MLSample* t, float phase)
 float scaleForRangeTransform(float a, float b, float c, float d); // TODO replace with MLRange object
 float offsetForRangeTransform(float a, float b, float c, float d);
 
+// a single global generator, not safe to share between threads.
+// DSP code should use its own MLRandom instead.
 MLSample MLRand(void);
 void MLRandReset(void);
 
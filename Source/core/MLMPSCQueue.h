@@ -0,0 +1,114 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef __MLMPSCQueue__
+#define __MLMPSCQueue__
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+// MLMPSCQueue: a bounded queue of fixed-size values of type T, after Dmitry Vyukov.
+// Any number of threads can push, and one thread pops. All the storage is made in
+// the constructor, so neither push() nor pop() locks or allocates. Each cell has a
+// sequence number that tells producers and the consumer whether it is free to
+// write or read.
+//
+// The size must be a power of two. T should be cheap to copy.
+
+template<typename T, int N>
+class MLMPSCQueue
+{
+public:
+	static const int kSize = N;
+	static_assert((N > 0) && ((N & (N - 1)) == 0), "MLMPSCQueue: size must be a power of two");
+
+	MLMPSCQueue() :
+		mCells(new Cell[N]),
+		mWritePos(0),
+		mReadPos(0),
+		mDropped(0)
+	{
+		for(int i=0; i<N; ++i)
+		{
+			mCells[i].mSequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	~MLMPSCQueue() {}
+
+	// add a value. If the queue is full, the value is dropped and counted.
+	bool push(const T& v)
+	{
+		const size_t mask = N - 1;
+		Cell* pCell;
+		size_t pos = mWritePos.load(std::memory_order_relaxed);
+		for(;;)
+		{
+			pCell = &mCells[pos & mask];
+			size_t seq = pCell->mSequence.load(std::memory_order_acquire);
+			intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+			if(dif == 0)
+			{
+				if(mWritePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if(dif < 0)
+			{
+				// full
+				mDropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				pos = mWritePos.load(std::memory_order_relaxed);
+			}
+		}
+		pCell->mValue = v;
+		pCell->mSequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// remove the oldest value. Single consumer only.
+	bool pop(T& v)
+	{
+		const size_t mask = N - 1;
+		size_t pos = mReadPos.load(std::memory_order_relaxed);
+		Cell& cell = mCells[pos & mask];
+		size_t seq = cell.mSequence.load(std::memory_order_acquire);
+		if((intptr_t)seq - (intptr_t)(pos + 1) < 0)
+		{
+			// empty
+			return false;
+		}
+		v = cell.mValue;
+		cell.mSequence.store(pos + mask + 1, std::memory_order_release);
+		mReadPos.store(pos + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// return and reset the number of values dropped since the last call.
+	int getDropped() { return mDropped.exchange(0, std::memory_order_relaxed); }
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> mSequence;
+		T mValue;
+	};
+
+	MLMPSCQueue(const MLMPSCQueue&);
+	MLMPSCQueue& operator=(const MLMPSCQueue&);
+
+	std::unique_ptr<Cell[]> mCells;
+	std::atomic<size_t> mWritePos;
+	std::atomic<size_t> mReadPos;
+	std::atomic<int> mDropped;
+};
+
+template<typename T, int N>
+const int MLMPSCQueue<T, N>::kSize;
+
+#endif // __MLMPSCQueue__
@@ -0,0 +1,188 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLRandom.h"
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// mix a seed into well distributed bits.
+	inline uint32_t hashWord(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7FEB352D;
+		x ^= x >> 15;
+		x *= 0x846CA68B;
+		x ^= x >> 16;
+		return x;
+	}
+
+	// random bits to a float on [1, 2).
+	inline float wordToFloat(uint32_t w)
+	{
+		uint32_t temp = (w >> 9) | 0x3F800000;
+		float f;
+		memcpy(&f, &temp, sizeof(f));
+		return f;
+	}
+
+	// random bits to a float on (0, 1].
+	inline float wordToUnitOpen(uint32_t w)
+	{
+		return (float)((w >> 8) + 1)*(1.f/16777216.f);
+	}
+}
+
+const int MLRandom::kLanes;
+
+void MLRandom::setSeed(uint32_t seed)
+{
+	// hashWord() is a bijection, so the 16 words of state are all different
+	// and no lane can be all zero.
+	uint32_t k = seed;
+	for(int i=0; i<kLanes; ++i)
+	{
+		mX[i] = hashWord(k += 0x9E3779B9);
+		mY[i] = hashWord(k += 0x9E3779B9);
+		mZ[i] = hashWord(k += 0x9E3779B9);
+		mW[i] = hashWord(k += 0x9E3779B9);
+	}
+	mSampleIndex = kLanes;
+}
+
+void MLRandom::nextWords(uint32_t* pDest)
+{
+	for(int i=0; i<kLanes; ++i)
+	{
+		uint32_t t = mX[i] ^ (mX[i] << 11);
+		mX[i] = mY[i];
+		mY[i] = mZ[i];
+		mZ[i] = mW[i];
+		mW[i] = mW[i] ^ (mW[i] >> 19) ^ t ^ (t >> 8);
+		pDest[i] = mW[i];
+	}
+}
+
+MLSample MLRandom::getSample()
+{
+	if(mSampleIndex >= kLanes)
+	{
+		uint32_t words[kLanes];
+		nextWords(words);
+		for(int i=0; i<kLanes; ++i)
+		{
+			mSamples[i] = wordToFloat(words[i])*2.f - 3.f;
+		}
+		mSampleIndex = 0;
+	}
+	return mSamples[mSampleIndex++];
+}
+
+void MLRandom::fillUniform(MLSample* pDest, int n, float gain)
+{
+	const float scale = 2.f*gain;
+	const float offset = -3.f*gain;
+	int i = 0;
+
+#ifdef __SSE2__
+	__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mX));
+	__m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mY));
+	__m128i z = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mZ));
+	__m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mW));
+	const __m128i one = _mm_set1_epi32(0x3F800000);
+	const __m128 vScale = _mm_set1_ps(scale);
+	const __m128 vOffset = _mm_set1_ps(offset);
+
+	for(; i <= n - kLanes; i += kLanes)
+	{
+		__m128i t = _mm_xor_si128(x, _mm_slli_epi32(x, 11));
+		x = y;
+		y = z;
+		z = w;
+		w = _mm_xor_si128(_mm_xor_si128(w, _mm_srli_epi32(w, 19)), _mm_xor_si128(t, _mm_srli_epi32(t, 8)));
+		__m128 f = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(w, 9), one));
+		_mm_storeu_ps(pDest + i, _mm_add_ps(_mm_mul_ps(f, vScale), vOffset));
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(mX), x);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(mY), y);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(mZ), z);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(mW), w);
+#endif
+
+	uint32_t words[kLanes];
+	for(; i < n; i += kLanes)
+	{
+		nextWords(words);
+		const int m = min(kLanes, n - i);
+		for(int j=0; j<m; ++j)
+		{
+			pDest[i + j] = wordToFloat(words[j])*scale + offset;
+		}
+	}
+}
+
+// signal fills write only the logical region, leaving any row padding alone.
+void MLRandom::fillUniform(const MLSignalRef& y, float gain)
+{
+	for(int k=0; k<y.getDepth(); ++k)
+	{
+		for(int j=0; j<y.getHeight(); ++j)
+		{
+			fillUniform(y.getRow(j, k), y.getWidth(), gain);
+		}
+	}
+}
+
+void MLRandom::fillUniform(MLSignal& y, float gain)
+{
+	y.setConstant(false);
+	fillUniform(y.getView(), gain);
+}
+
+// Box-Muller transform: each pair of lanes makes two normal samples.
+void MLRandom::fillGaussian(MLSample* pDest, int n, float stdDev)
+{
+	const float twoPi = kMLTwoPi;
+	uint32_t words[kLanes];
+	for(int i=0; i<n; i += kLanes)
+	{
+		nextWords(words);
+		MLSample g[kLanes];
+		for(int j=0; j<kLanes; j += 2)
+		{
+			const float r = sqrtf(-2.f*logf(wordToUnitOpen(words[j])))*stdDev;
+			const float theta = twoPi*(wordToFloat(words[j + 1]) - 1.f);
+			g[j] = r*cosf(theta);
+			g[j + 1] = r*sinf(theta);
+		}
+		const int m = min(kLanes, n - i);
+		for(int j=0; j<m; ++j)
+		{
+			pDest[i + j] = g[j];
+		}
+	}
+}
+
+void MLRandom::fillGaussian(const MLSignalRef& y, float stdDev)
+{
+	for(int k=0; k<y.getDepth(); ++k)
+	{
+		for(int j=0; j<y.getHeight(); ++j)
+		{
+			fillGaussian(y.getRow(j, k), y.getWidth(), stdDev);
+		}
+	}
+}
+
+void MLRandom::fillGaussian(MLSignal& y, float stdDev)
+{
+	y.setConstant(false);
+	fillGaussian(y.getView(), stdDev);
+}
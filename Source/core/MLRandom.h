@@ -0,0 +1,60 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef _ML_RANDOM_H
+#define _ML_RANDOM_H
+
+#include <stdint.h>
+
+#include "MLDSP.h"
+#include "MLSignal.h"
+
+// MLRandom: a random number generator with its own state, for procs that
+// need noise without sharing the global MLRand() generator.
+//
+// four xorshift128 generators run side by side, one in each lane of an SSE
+// vector, so block fills make four numbers per step. the scalar code makes
+// exactly the same sequence where SSE2 is not available.
+//
+// the same seed always produces the same output.
+
+class MLRandom
+{
+public:
+	static const int kLanes = 4;
+
+	MLRandom(uint32_t seed = 0) { setSeed(seed); }
+	~MLRandom() {}
+
+	void setSeed(uint32_t seed);
+
+	// one sample on [-1, 1), like MLRand().
+	MLSample getSample();
+
+	// fill with samples on [-gain, gain). A view, which must not be constant,
+	// can be a row or frame of a larger signal.
+	void fillUniform(MLSample* pDest, int n, float gain = 1.f);
+	void fillUniform(const MLSignalRef& y, float gain = 1.f);
+	void fillUniform(MLSignal& y, float gain = 1.f);
+
+	// fill with normally distributed samples with mean 0.
+	void fillGaussian(MLSample* pDest, int n, float stdDev = 1.f);
+	void fillGaussian(const MLSignalRef& y, float stdDev = 1.f);
+	void fillGaussian(MLSignal& y, float stdDev = 1.f);
+
+private:
+	// step all lanes once, writing kLanes new words.
+	void nextWords(uint32_t* pDest);
+
+	uint32_t mX[kLanes];
+	uint32_t mY[kLanes];
+	uint32_t mZ[kLanes];
+	uint32_t mW[kLanes];
+
+	// samples left over from the last step made by getSample().
+	MLSample mSamples[kLanes];
+	int mSampleIndex;
+};
+
+#endif // _ML_RANDOM_H
@@ -30,15 +30,14 @@ MLSignal::MLSignal() :
 	setDims(kMLProcessChunkSize); // TODO rewrite everything to allocate explictly
 }
 
-MLSignal::MLSignal (int width, int height, int depth) : 
+MLSignal::MLSignal (int width, int height, int depth, Layout layout) : 
 	mData(0),
 	mDataAligned(0),
 	mCopy(0),
 	mCopyAligned(0)
 {
 	mRate = kMLToBeCalculated;
-	setConstant(false);	
-	setDims(width, height, depth);
+	setDims(width, height, depth, layout);
 }
 
 MLSignal::MLSignal(const MLSignal& other) :
@@ -50,17 +49,35 @@ MLSignal::MLSignal(const MLSignal& other) :
 	mSize = other.mSize;
 	mData = allocateData(mSize);
 	mDataAligned = initializeData(mData, mSize);
-	mConstantMask = other.mConstantMask;
-	mWidth = other.mWidth;
-	mHeight = other.mHeight;
-	mDepth = other.mDepth;
-	mHeightBits = other.mHeightBits;
-	mWidthBits = other.mWidthBits;
-	mDepthBits = other.mDepthBits;
-	mRate = other.mRate;
+	copyInfo(other);
 	std::copy(other.mDataAligned, other.mDataAligned + mSize, mDataAligned);
 }
 
+// move constructor: take the other signal's heap data if it has any. Small signals
+// in local storage and references to other signals are copied. The other signal 
+// is left as a valid signal of size 1.
+MLSignal::MLSignal(MLSignal&& other) :
+	mData(0),
+	mDataAligned(0),
+	mCopy(0),
+	mCopyAligned(0)
+{
+	if(other.ownsHeapData())
+	{
+		mSize = other.mSize;
+		copyInfo(other);
+		takeData(other);
+	}
+	else
+	{
+		mSize = other.mSize;
+		mData = allocateData(mSize);
+		mDataAligned = initializeData(mData, mSize);
+		copyInfo(other);
+		std::copy(other.mDataAligned, other.mDataAligned + mSize, mDataAligned);
+	}
+}
+
 MLSignal::MLSignal (std::initializer_list<float> values) : 
 mData(0),
 mDataAligned(0),
@@ -78,7 +95,7 @@ mCopyAligned(0)
 }
 
 // constructor for making loops. only one type for now. we could loop in different directions and dimensions.
-MLSignal::MLSignal(MLSignal other, eLoopType loopType, int loopSize) :
+MLSignal::MLSignal(const MLSignal& other, eLoopType loopType, int loopSize) :
 mData(0),
 mDataAligned(0),
 mCopy(0),
@@ -100,110 +117,88 @@ mCopyAligned(0)
 	}
 }
 
+// make a new signal with a copy of the data in the view.
+MLSignal::MLSignal(const MLSignalRef& v) :
+	mData(0),
+	mDataAligned(0),
+	mCopy(0),
+	mCopyAligned(0)
+{
+	mRate = kMLToBeCalculated;
+	setConstant(false);
+	setDims(v.getWidth(), v.getHeight(), v.getDepth());
+	if(v.isConstant())
+	{
+		setToConstant(v[0]);
+		return;
+	}
+	for(int k=0; k<mDepth; ++k)
+	{
+		for(int j=0; j<mHeight; ++j)
+		{
+			const MLSample* pSrc = v.getRow(j, k);
+			std::copy(pSrc, pSrc + mWidth, mDataAligned + plane(k) + row(j));
+		}
+	}
+}
+
 MLSignal& MLSignal::operator= (const MLSignal& other)
 {
 	if (this != &other) // protect against self-assignment
 	{
 		if (mSize != other.mSize)
 		{
-			// 1: allocate new memory and copy the elements
-			mSize = other.mSize;
-			MLSample * newData = allocateData(mSize);
-			MLSample * newDataAligned = initializeData(newData, mSize);
-			std::copy(other.mDataAligned, other.mDataAligned + mSize, newDataAligned);
-
-			// 2: deallocate old memory
-			delete[] mData;
+			// 1: deallocate old memory
+			freeData();
 			
-			// 3: assign the new memory to the object
-			mData = newData;
-			mDataAligned = newDataAligned;
-			mConstantMask = other.mConstantMask;
-			mWidth = other.mWidth;
-			mHeight = other.mHeight;
-			mDepth = other.mDepth;
-			mHeightBits = other.mHeightBits;
-			mWidthBits = other.mWidthBits;
-			mDepthBits = other.mDepthBits;
-			mRate = other.mRate;
+			// 2: allocate new memory and copy the elements
+			mSize = other.mSize;
+			mData = allocateData(mSize);
+			mDataAligned = initializeData(mData, mSize);
+			std::copy(other.mDataAligned, other.mDataAligned + mSize, mDataAligned);
+			copyInfo(other);
 		}
 		else 
 		{
 			// keep existing data buffer.
 			// copy other elements
 			std::copy(other.mDataAligned, other.mDataAligned + this->mSize, mDataAligned);
-			
-			// copy other info
-			mConstantMask = other.mConstantMask;
-			mWidth = other.mWidth;
-			mHeight = other.mHeight;
-			mDepth = other.mDepth;
-			mHeightBits = other.mHeightBits;
-			mWidthBits = other.mWidthBits;
-			mDepthBits = other.mDepthBits;
-			mRate = other.mRate;
+			copyInfo(other);
 		}
 	}
 	return *this;
 }
 
-
-// private signal constructor: make a reference to a slice of the external signal.
-// of course this object will be meaningless when the other Signal is gone, so
-// use wih care -- only as a temporary, ideally.  Is there a way to force 
-// the object to be a temporary?  In other words not allow a named 
-// MLSignal notTemporary(pOther, 4);
-//
-// NOTE this signal will not pass checkIntegrity()!
-//
-MLSignal::MLSignal(const MLSignal* other, int slice) : 
-	mData(0),
-	mDataAligned(0),
-	mCopy(0),
-	mCopyAligned(0)
+// move assignment: take the other signal's heap data if it has any, otherwise 
+// copy as operator=(const MLSignal&) does.
+MLSignal& MLSignal::operator= (MLSignal&& other)
 {
-	mRate = kMLToBeCalculated;
-	setConstant(false);
-	if(other->getDepth() > 1) // make 2d slice
-	{
-		mDataAligned = other->mDataAligned + other->plane(slice);
-		mWidth = other->mWidth;
-		mHeight = other->mHeight;
-		mDepth = 1;
-	}
-	else if(other->getHeight() > 1) // make 1d slice
-	{
-		mDataAligned = other->mDataAligned + other->row(slice);
-		mWidth = other->mWidth;
-		mHeight = 1;
-		mDepth = 1;
-	}
-	else
+	if (this != &other)
 	{
-		// signal to take slice of must be 2d or 3d!
-		assert(false);
+		if(other.ownsHeapData() && (mData || !mDataAligned))
+		{
+			freeData();
+			mSize = other.mSize;
+			copyInfo(other);
+			takeData(other);
+		}
+		else
+		{
+			operator=(static_cast<const MLSignal&>(other));
+		}
 	}
-	mWidthBits = bitsToContain(mWidth);
-	mHeightBits = bitsToContain(mHeight);
-	mDepthBits = bitsToContain(mDepth);
-	mSize = 1 << mWidthBits << mHeightBits << mDepthBits;
-	mConstantMask = mSize - 1;
+	return *this;
 }
 
 MLSignal::~MLSignal() 
 {
-	delete[] mData;
-	delete[] mCopy;
+	freeData();
 }
 
-MLSample* MLSignal::setDims (int width, int height, int depth)
+MLSample* MLSignal::setDims (int width, int height, int depth, Layout layout)
 {
-	mDataAligned = 0;	
 	// delete old
-	if (mData)
-	{
-		delete[] mData;
-	}
+	freeData();
 
 	mWidth = width;
 	mHeight = height;
@@ -211,10 +206,22 @@ MLSample* MLSignal::setDims (int width, int height, int depth)
 	mWidthBits = bitsToContain(width);
 	mHeightBits = bitsToContain(height);
 	mDepthBits = bitsToContain(depth);
-	mSize = 1 << mWidthBits << mHeightBits << mDepthBits;
+	if(layout == kPackedLayout)
+	{
+		mRowStride = (width + kSSEVecSize - 1) & ~(kSSEVecSize - 1);
+		mPlaneStride = mRowStride*height;
+		mSize = mPlaneStride*depth;
+	}
+	else
+	{
+		mRowStride = 1 << mWidthBits;
+		mPlaneStride = mRowStride << mHeightBits;
+		mSize = mPlaneStride << mDepthBits;
+	}
+	mIndexMask = (1 << ilog2(mSize)) - 1;
 	mData = allocateData(mSize);	
 	mDataAligned = initializeData(mData, mSize);	
-	mConstantMask = mSize - 1;
+	mConstantMask = mIndexMask;
 	return mDataAligned;
 }
 
@@ -225,27 +232,28 @@ MLSample* MLSignal::getCopy()
 {
 	if (!mCopy)
 	{
-		mCopy = allocateData(mSize);
-		if (mCopy)
-		{
-			mCopyAligned = initializeData(mCopy, mSize);
-		}
-		else
-		{
-			std::cerr << "MLSignal::getCopy: out of memory!\n";
-		}
+		mCopy = new MLSample[padSize(mSize)];
+		mCopyAligned = initializeData(mCopy, mSize);
 	}
 	std::copy(mDataAligned, mDataAligned + mSize, mCopyAligned);
 	return mCopyAligned;
 }
 
-// allocate unaligned data
+// allocate unaligned data. Signals small enough to fit use the local storage 
+// inside the object, so they don't allocate.
 // TODO test cache-friendly distributions
 //
 MLSample* MLSignal::allocateData(int size)
 {
 	MLSample* newData = 0;
-	newData = new MLSample[padSize(size)];
+	if(size <= kLocalSize)
+	{
+		newData = mLocalData;
+	}
+	else
+	{
+		newData = new MLSample[padSize(size)];
+	}
 	return newData;
 }
 
@@ -263,6 +271,51 @@ MLSample* MLSignal::initializeData(MLSample* pData, int size)
 	return newDataAligned;
 }
 
+// free any data we own, and the copy buffer, which is the size of the data.
+void MLSignal::freeData()
+{
+	if(mData != mLocalData)
+	{
+		delete[] mData;
+	}
+	delete[] mCopy;
+	mData = 0;
+	mDataAligned = 0;
+	mCopy = 0;
+	mCopyAligned = 0;
+}
+
+// copy everything but the data from another signal.
+void MLSignal::copyInfo(const MLSignal& other)
+{
+	mConstantMask = other.mConstantMask;
+	mIndexMask = other.mIndexMask;
+	mRowStride = other.mRowStride;
+	mPlaneStride = other.mPlaneStride;
+	mWidth = other.mWidth;
+	mHeight = other.mHeight;
+	mDepth = other.mDepth;
+	mHeightBits = other.mHeightBits;
+	mWidthBits = other.mWidthBits;
+	mDepthBits = other.mDepthBits;
+	mRate = other.mRate;
+}
+
+// take the heap data and copy buffer from the other signal, which must own heap data.
+// the other signal is left with size 1 in its local storage. 
+void MLSignal::takeData(MLSignal& other)
+{
+	mData = other.mData;
+	mDataAligned = other.mDataAligned;
+	mCopy = other.mCopy;
+	mCopyAligned = other.mCopyAligned;
+	other.mData = 0;
+	other.mDataAligned = 0;
+	other.mCopy = 0;
+	other.mCopyAligned = 0;
+	other.setDims(1);
+}
+
 int MLSignal::getFrames() const
 { 		
 	if (mRate != kMLTimeless)
@@ -333,24 +386,14 @@ const MLSample MLSignal::operator() (const Vec3 ) const
 }
 */
 
-// return const 2D signal made from a slice of the 3D data in place. 
-const MLSignal MLSignal::getFrame(int i) const
-{
-	// only valid for 3D signals
-	assert(mDepthBits > 1);
-	
-	// use slice constructor as return value.
-	return MLSignal(this, i);
-}
-
 // setFrame() - set the 2D frame i to the incoming signal.
-void MLSignal::setFrame(int i, const MLSignal& src)
+void MLSignal::setFrame(int i, const MLSignalRef& src)
 {
 	// only valid for 3D signals
 	assert(is3D());
 	
 	// source must be 2D
-	assert(src.is2D());
+	assert(src.getDepth() == 1);
 	
 	// src signal should match our dimensions
 	if((src.getWidth() != mWidth) || (src.getHeight() != mHeight))
@@ -358,9 +401,19 @@ void MLSignal::setFrame(int i, const MLSignal& src)
 		return;
 	}
 	
-	MLSample* pDestFrame = mDataAligned + plane(i);
-	const MLSample* pSrc = src.getConstBuffer();
-	std::copy(pSrc, pSrc + src.getSize(), pDestFrame);
+	for(int j=0; j<mHeight; ++j)
+	{
+		MLSample* pDest = mDataAligned + plane(i) + row(j);
+		if(src.isConstant())
+		{
+			std::fill(pDest, pDest + mWidth, src[0]);
+		}
+		else
+		{
+			const MLSample* pSrc = src.getRow(j);
+			std::copy(pSrc, pSrc + mWidth, pDest);
+		}
+	}
 }
 
 //
@@ -382,61 +435,243 @@ void MLSignal::write(MLSample *output, const int offset, const int n)
 	std::copy(mDataAligned, mDataAligned + n, output + offset);
 }
 
+// ----------------------------------------------------------------
+#pragma mark row kernels
+
+// Operators on signals visit only the width x height x depth region of each signal, 
+// one row at a time, so padding in either layout is never touched. 
+
+namespace
+{
+	// true if the rows of the w x h x d region of s are contiguous in memory.
+	inline bool isContiguous(const MLSignal& s, const int w, const int h, const int d)
+	{
+		return ((h == 1) || (s.getRowStride() == w)) && ((d == 1) || (s.getPlaneStride() == w*h));
+	}
+	
+	// call f(offsetA, offsetB, offsetC, n) for each row of the region common to 
+	// signals a, b and c, where the offsets are the start of the row in each signal.
+	// If every signal stores the region contiguously it is visited as one row, so 
+	// 1D and dense signals take a single pass.
+	template<typename F>
+	inline void forEachRow(const MLSignal& a, const MLSignal& b, const MLSignal& c, F f)
+	{
+		const int w = min(a.getWidth(), min(b.getWidth(), c.getWidth()));
+		const int h = min(a.getHeight(), min(b.getHeight(), c.getHeight()));
+		const int d = min(a.getDepth(), min(b.getDepth(), c.getDepth()));
+		if(isContiguous(a, w, h, d) && isContiguous(b, w, h, d) && isContiguous(c, w, h, d))
+		{
+			f(0, 0, 0, w*h*d);
+			return;
+		}
+		for(int k=0; k<d; ++k)
+		{
+			for(int j=0; j<h; ++j)
+			{
+				f(a.plane(k) + a.row(j), b.plane(k) + b.row(j), c.plane(k) + c.row(j), w);
+			}
+		}
+	}
+	
+	template<typename F>
+	inline void forEachRow(const MLSignal& a, const MLSignal& b, F f)
+	{
+		forEachRow(a, b, b, [&](int oa, int ob, int, int n) { f(oa, ob, n); });
+	}
+	
+	template<typename F>
+	inline void forEachRow(const MLSignal& a, F f)
+	{
+		forEachRow(a, a, a, [&](int oa, int, int, int n) { f(oa, n); });
+	}
+	
+	// rows whose length is at least one vector start on a vector boundary, in
+	// either layout. Ops take and return both __m128 and MLSample.
+	
+	// p[i] = op(p[i]) for n samples.
+	template<typename Op>
+	inline void mapRow(MLSample* p, const int n, const Op& op)
+	{
+		int i = 0;
+		for(; i <= n - (int)kSSEVecSize; i += kSSEVecSize)
+		{
+			_mm_store_ps(p + i, op(_mm_load_ps(p + i)));
+		}
+		for(; i < n; ++i)
+		{
+			p[i] = op(p[i]);
+		}
+	}
+	
+	// pa[i] = op(pa[i], pb[i]) for n samples.
+	template<typename Op>
+	inline void zipRow(MLSample* pa, const MLSample* pb, const int n, const Op& op)
+	{
+		int i = 0;
+		for(; i <= n - (int)kSSEVecSize; i += kSSEVecSize)
+		{
+			_mm_store_ps(pa + i, op(_mm_load_ps(pa + i), _mm_load_ps(pb + i)));
+		}
+		for(; i < n; ++i)
+		{
+			pa[i] = op(pa[i], pb[i]);
+		}
+	}
+	
+	struct AddOp
+	{
+		__m128 operator()(__m128 a, __m128 b) const { return _mm_add_ps(a, b); }
+		MLSample operator()(MLSample a, MLSample b) const { return a + b; }
+	};
+	struct SubtractOp
+	{
+		__m128 operator()(__m128 a, __m128 b) const { return _mm_sub_ps(a, b); }
+		MLSample operator()(MLSample a, MLSample b) const { return a - b; }
+	};
+	struct MultiplyOp
+	{
+		__m128 operator()(__m128 a, __m128 b) const { return _mm_mul_ps(a, b); }
+		MLSample operator()(MLSample a, MLSample b) const { return a * b; }
+	};
+	struct DivideOp
+	{
+		__m128 operator()(__m128 a, __m128 b) const { return _mm_div_ps(a, b); }
+		MLSample operator()(MLSample a, MLSample b) const { return a / b; }
+	};
+	struct MinOp
+	{
+		__m128 operator()(__m128 a, __m128 b) const { return _mm_min_ps(a, b); }
+		MLSample operator()(MLSample a, MLSample b) const { return min(a, b); }
+	};
+	struct MaxOp
+	{
+		__m128 operator()(__m128 a, __m128 b) const { return _mm_max_ps(a, b); }
+		MLSample operator()(MLSample a, MLSample b) const { return max(a, b); }
+	};
+	
+	// a binary op with its second argument fixed: x -> op(x, k).
+	template<typename Op>
+	struct WithSecond
+	{
+		WithSecond(MLSample k) : mV(_mm_set1_ps(k)), mK(k) {}
+		__m128 operator()(__m128 a) const { return Op()(a, mV); }
+		MLSample operator()(MLSample a) const { return Op()(a, mK); }
+		__m128 mV;
+		MLSample mK;
+	};
+	
+	// a binary op with its first argument fixed: (x, y) -> op(k, y).
+	template<typename Op>
+	struct WithFirst
+	{
+		WithFirst(MLSample k) : mV(_mm_set1_ps(k)), mK(k) {}
+		__m128 operator()(__m128, __m128 b) const { return Op()(mV, b); }
+		MLSample operator()(MLSample, MLSample b) const { return Op()(mK, b); }
+		__m128 mV;
+		MLSample mK;
+	};
+
+	// a = op(a, b) over the common region of the signals, using the first sample 
+	// of any constant signal. 
+	template<typename Op>
+	void combine(MLSignal& a, const MLSignal& b, const Op& op)
+	{
+		const bool ka = a.isConstant();
+		const bool kb = b.isConstant();
+		MLSample* pa = a.getBuffer();
+		const MLSample* pb = b.getConstBuffer();
+		if (ka && kb)
+		{
+			a.setToConstant(op(pa[0], pb[0]));
+		}
+		else 
+		{
+			if (ka && !kb)
+			{
+				const WithFirst<Op> opA(pa[0]);
+				forEachRow(a, b, [&](int oa, int ob, int n) { zipRow(pa + oa, pb + ob, n, opA); });
+			}
+			else if (!ka && kb)
+			{
+				const WithSecond<Op> opB(pb[0]);
+				forEachRow(a, [&](int oa, int n) { mapRow(pa + oa, n, opB); });
+			}
+			else
+			{
+				forEachRow(a, b, [&](int oa, int ob, int n) { zipRow(pa + oa, pb + ob, n, op); });
+			}
+			a.setConstant(false);
+		}
+	}
+	
+	// a = op(a, k) over the region of a.
+	template<typename Op>
+	inline void combine(MLSignal& a, const MLSample k, const Op&)
+	{
+		MLSample* pa = a.getBuffer();
+		const WithSecond<Op> opK(k);
+		forEachRow(a, [&](int oa, int n) { mapRow(pa + oa, n, opK); });
+	}
+}
+
 // TODO SSE
 void MLSignal::sigClamp(const MLSignal& a, const MLSignal& b)
 {
-	int n = min(mSize, a.getSize());
-	n = min(n, b.getSize());
-	for(int i = 0; i < n; ++i)
+	const MLSample* pa = a.getConstBuffer();
+	const MLSample* pb = b.getConstBuffer();
+	forEachRow(*this, a, b, [&](int o, int oa, int ob, int n)
 	{
-		MLSample f = mDataAligned[i];
-		mDataAligned[i] = clamp(f, a.mDataAligned[i], b.mDataAligned[i]);
-	}
+		MLSample* py = mDataAligned + o;
+		for(int i = 0; i < n; ++i)
+		{
+			py[i] = clamp(py[i], pa[oa + i], pb[ob + i]);
+		}
+	});
 	setConstant(false);
 }
 
 void MLSignal::sigMin(const MLSignal& b)
 {
-	int n = min(mSize, b.getSize());
-	for(int i = 0; i < n; ++i)
-	{
-		MLSample f = mDataAligned[i];
-		mDataAligned[i] = min(f, b.mDataAligned[i]);
-	}
+	const MLSample* pb = b.getConstBuffer();
+	forEachRow(*this, b, [&](int oa, int ob, int n) { zipRow(mDataAligned + oa, pb + ob, n, MinOp()); });
 	setConstant(false);
 }
 
 void MLSignal::sigMax(const MLSignal& b)
 {
-	int n = min(mSize, b.getSize());
-	for(int i = 0; i < n; ++i)
-	{
-		MLSample f = mDataAligned[i];
-		mDataAligned[i] = max(f, b.mDataAligned[i]);
-	}
+	const MLSample* pb = b.getConstBuffer();
+	forEachRow(*this, b, [&](int oa, int ob, int n) { zipRow(mDataAligned + oa, pb + ob, n, MaxOp()); });
 	setConstant(false);
 }
 
 // TODO SSE
 void MLSignal::sigLerp(const MLSignal& b, const MLSample mix)
 {
-	int n = min(mSize, b.getSize());
-	for(int i = 0; i < n; ++i)
+	const MLSample* pb = b.getConstBuffer();
+	forEachRow(*this, b, [&](int oa, int ob, int n)
 	{
-		mDataAligned[i] = lerp(mDataAligned[i], b.mDataAligned[i], mix);
-	}
+		MLSample* py = mDataAligned + oa;
+		for(int i = 0; i < n; ++i)
+		{
+			py[i] = lerp(py[i], pb[ob + i], mix);
+		}
+	});
 	setConstant(false);
 }
 
 // TODO SSE
 void MLSignal::sigLerp(const MLSignal& b, const MLSignal& mix)
 {
-	int n = min(mSize, b.getSize());
-	n = min(n, mix.getSize());
-	for(int i = 0; i < n; ++i)
+	const MLSample* pb = b.getConstBuffer();
+	const MLSample* pm = mix.getConstBuffer();
+	forEachRow(*this, b, mix, [&](int oa, int ob, int om, int n)
 	{
-		mDataAligned[i] = lerp(mDataAligned[i], b.mDataAligned[i], mix.mDataAligned[i]);
-	}
+		MLSample* py = mDataAligned + oa;
+		for(int i = 0; i < n; ++i)
+		{
+			py[i] = lerp(py[i], pb[ob + i], pm[om + i]);
+		}
+	});
 	setConstant(false);
 }
 
@@ -444,18 +679,18 @@ void MLSignal::sigLerp(const MLSignal& b, const MLSignal& mix)
 #pragma mark binary ops
 // 
 
-// TODO SSE
 bool MLSignal::operator==(const MLSignal& b) const
 {
 	if(mWidth != b.mWidth) return false;
 	if(mHeight != b.mHeight) return false;
 	if(mDepth != b.mDepth) return false;
 	
-	for(int i=0; i<mSize; ++i)
+	bool r = true;
+	forEachRow(*this, b, [&](int oa, int ob, int n)
 	{
-		if(mDataAligned[i] != b.mDataAligned[i]) return false;
-	}
-	return true;
+		r = r && std::equal(mDataAligned + oa, mDataAligned + oa + n, b.mDataAligned + ob);
+	});
+	return r;
 }
 
 void MLSignal::copy(const MLSignal& b)
@@ -467,8 +702,10 @@ void MLSignal::copy(const MLSignal& b)
 	}
 	else 
 	{
-		const int n = min(mSize, b.getSize());
-		std::copy(b.mDataAligned, b.mDataAligned + n, mDataAligned);
+		forEachRow(*this, b, [&](int oa, int ob, int n)
+		{
+			std::copy(b.mDataAligned + ob, b.mDataAligned + ob + n, mDataAligned + oa);
+		});
 		setConstant(false);
 	}
 }
@@ -529,161 +766,85 @@ const MLSample MLSignal::operator() (const float i, const float j) const
 }*/
 
 
-// TODO SSE
 void MLSignal::add(const MLSignal& b)
 {
-	const bool ka = isConstant();
-	const bool kb = b.isConstant();
-	if (ka && kb)
-	{
-		setToConstant(mDataAligned[0] + b.mDataAligned[0]);
-	}
-	else 
+	combine(*this, b, AddOp());
+}
+
+// sum n input signals into this one, reading each input vector once and writing 
+// each output vector once. constant inputs are folded into a single offset. 
+// all inputs are read before each output vector is stored, so this signal 
+// can safely appear in the input list.
+void MLSignal::setToSum(const MLSignal* const* ps, const int n)
+{
+	MLSample k = 0.f;
+	int size = mSize;
+	int variableInputs = 0;
+	for(int j = 0; j < n; ++j)
 	{
-		const int n = min(mSize, b.getSize());
-		if (ka && !kb)
-		{
-			MLSample fa = mDataAligned[0];
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] = fa + b[i];
-			}
-		}
-		else if (!ka && kb)
+		const MLSignal& b = *ps[j];
+		if(b.isConstant())
 		{
-			MLSample fb = b[0];
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] += fb;
-			}
+			k += b.mDataAligned[0];
 		}
 		else
 		{
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] += b.mDataAligned[i];
-			}
+			size = min(size, b.getSize());
+			variableInputs++;
 		}
-		setConstant(false);
 	}
-}
-
-// TODO SSE
-void MLSignal::subtract(const MLSignal& b)
-{
-	const bool ka = isConstant();
-	const bool kb = b.isConstant();
-	if (ka && kb)
+	
+	if(!variableInputs)
 	{
-		setToConstant(mDataAligned[0] + b.mDataAligned[0]);
+		setToConstant(k);
+		return;
 	}
-	else 
+	
+	const int vectors = size >> kMLSamplesPerSSEVectorBits;
+	const __m128 vk = _mm_set1_ps(k);
+	for(int v = 0; v < vectors; ++v)
 	{
-		const int n = min(mSize, b.getSize());
-		if (ka && !kb)
-		{
-			MLSample fa = mDataAligned[0];
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] = fa - b[i];
-			}
-		}
-		else if (!ka && kb)
+		const int i = v << kMLSamplesPerSSEVectorBits;
+		__m128 vy = vk;
+		for(int j = 0; j < n; ++j)
 		{
-			MLSample fb = b[0];
-			for(int i = 0; i < n; ++i)
+			const MLSignal& b = *ps[j];
+			if(!b.isConstant())
 			{
-				mDataAligned[i] -= fb;
+				vy = _mm_add_ps(vy, _mm_load_ps(b.mDataAligned + i));
 			}
 		}
-		else
+		_mm_store_ps(mDataAligned + i, vy);
+	}
+	for(int i = vectors << kMLSamplesPerSSEVectorBits; i < size; ++i)
+	{
+		MLSample y = k;
+		for(int j = 0; j < n; ++j)
 		{
-			for(int i = 0; i < n; ++i)
+			const MLSignal& b = *ps[j];
+			if(!b.isConstant())
 			{
-				mDataAligned[i] -= b.mDataAligned[i];
+				y += b.mDataAligned[i];
 			}
 		}
-		setConstant(false);
+		mDataAligned[i] = y;
 	}
+	setConstant(false);
 }
 
+void MLSignal::subtract(const MLSignal& b)
+{
+	combine(*this, b, SubtractOp());
+}
 
-// TODO SSE
 void MLSignal::multiply(const MLSignal& b)
 {
-	const bool ka = isConstant();
-	const bool kb = b.isConstant();
-	if (ka && kb)
-	{
-		setToConstant(mDataAligned[0] + b.mDataAligned[0]);
-	}
-	else 
-	{
-		const int n = min(mSize, b.getSize());
-		if (ka && !kb)
-		{
-			MLSample fa = mDataAligned[0];
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] = fa * b[i];
-			}
-		}
-		else if (!ka && kb)
-		{
-			MLSample fb = b[0];
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] *= fb;
-			}
-		}
-		else
-		{
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] *= b.mDataAligned[i];
-			}
-		}
-		setConstant(false);
-	}
+	combine(*this, b, MultiplyOp());
 }
 
-// TODO SSE
 void MLSignal::divide(const MLSignal& b)
 {
-	const bool ka = isConstant();
-	const bool kb = b.isConstant();
-	if (ka && kb)
-	{
-		setToConstant(mDataAligned[0] + b.mDataAligned[0]);
-	}
-	else 
-	{
-		const int n = min(mSize, b.getSize());
-		if (ka && !kb)
-		{
-			MLSample fa = mDataAligned[0];
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] = fa / b[i];
-			}
-		}
-		else if (!ka && kb)
-		{
-			MLSample fb = b[0];
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] /= fb;
-			}
-		}
-		else
-		{
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] /= b.mDataAligned[i];
-			}
-		}
-		setConstant(false);
-	}
+	combine(*this, b, DivideOp());
 }
 
 
@@ -691,9 +852,10 @@ void MLSignal::divide(const MLSignal& b)
 #pragma mark unary ops
 // 
 
+// unlike the other operators, clear() zeroes the whole storage including the
+// padding, which kernels that read past the row ends rely on being zero.
 void MLSignal::clear()
 {
-//	std::fill(mDataAligned, mDataAligned+mSize, 0);
 //	setToConstant(0); // TODO 
 	memset((void *)(mDataAligned), 0, (size_t)(mSize*sizeof(MLSample)));
 }
@@ -701,69 +863,54 @@ void MLSignal::clear()
 
 void MLSignal::fill(const MLSample f)
 {
-	std::fill(mDataAligned, mDataAligned+mSize, f);
+	forEachRow(*this, [&](int o, int n)
+	{
+		std::fill(mDataAligned + o, mDataAligned + o + n, f);
+	});
 }
 
 void MLSignal::scale(const MLSample k)
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		mDataAligned[i] *= k;
-	}
+	combine(*this, k, MultiplyOp());
 }
 
 void MLSignal::add(const MLSample k)
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		mDataAligned[i] += k;
-	}
+	combine(*this, k, AddOp());
 }
 
 void MLSignal::subtract(const MLSample k)
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		mDataAligned[i] -= k;
-	}
+	combine(*this, k, SubtractOp());
 }
 
 void MLSignal::subtractFrom(const MLSample k)
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		mDataAligned[i] = k - mDataAligned[i];
-	}
+	const WithFirst<SubtractOp> op(k);
+	forEachRow(*this, [&](int o, int n) { zipRow(mDataAligned + o, mDataAligned + o, n, op); });
 }
 
 // name collision with clamp template made this sigClamp
 void MLSignal::sigClamp(const MLSample min, const MLSample max)	
 {
-	for(int i=0; i<mSize; ++i)
+	forEachRow(*this, [&](int o, int n)
 	{
-		float f = mDataAligned[i];
-		mDataAligned[i] = clamp(f, (float)min, (float)max);
-	}
+		MLSample* py = mDataAligned + o;
+		for(int i = 0; i < n; ++i)
+		{
+			py[i] = clamp(py[i], (float)min, (float)max);
+		}
+	});
 }
 
-// TODO SSE
 void MLSignal::sigMin(const MLSample m)
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		float f = mDataAligned[i];
-		mDataAligned[i] = min(f, (float)m);
-	}
+	combine(*this, m, MinOp());
 }
 
-// TODO SSE
 void MLSignal::sigMax(const MLSample m)	
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		float f = mDataAligned[i];
-		mDataAligned[i] = max(f, (float)m);
-	}
+	combine(*this, m, MaxOp());
 }
 
 // convolve a 1D signal with a 3-point impulse response.
@@ -808,422 +955,255 @@ void MLSignal::convolve5x1(const MLSample kmm, const MLSample km, const MLSample
 }
 
 
-// an operator for 2D signals only
-void MLSignal::convolve3x3r(const MLSample kc, const MLSample ke, const MLSample kk)
+// ----------------------------------------------------------------
+#pragma mark 2D pipeline
+
+namespace
 {
-	int i, j;
-    float f;
-    float * pr1, * pr2, * pr3; // input row ptrs
-    float * prOut; 	
-	
-	MLSample* pIn = getCopy();
-	MLSample* pOut = mDataAligned;
-	int width = mWidth;
-	int height = mHeight;
-	
-	j = 0;	// top row
-	{
-		// row ptrs
-		pr2 = (pIn + row(j));
-		pr3 = (pIn + row(j + 1));
-		prOut = (pOut + row(j));
-		
-		i = 0; // top left corner
-		{
-			f = ke * (pr2[i+1] + pr3[i]);
-			f += kk * (pr3[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-			
-		for(i = 1; i < width - 1; i++) // top side
-		{
-			f = ke * (pr2[i-1] + pr2[i+1] + pr3[i]);
-			f += kk * (pr3[i-1] + pr3[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;
-		}
-		
-		i = width - 1; // top right corner
-		{
-			f = ke * (pr2[i-1] + pr3[i]);
-			f += kk * (pr3[i-1]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-	}
-	for(j = 1; j < height - 1; j++) // center rows
+	// rows in the 2D pipeline have this many samples of padding on each side, so the
+	// neighbors of every sample in the row can be read without checking for edges.
+	const int kRowPad = kSSEVecSize;
+
+	inline int paddedRowSize(const int width)
 	{
-		// row ptrs
-		pr1 = (pIn + row(j - 1));
-		pr2 = (pIn + row(j));
-		pr3 = (pIn + row(j + 1));
-		prOut = (pOut + row(j));
-		
-		i = 0; // left side
-		{
-			f = ke * (pr1[i] + pr2[i+1] + pr3[i]);
-			f += kk * (pr1[i+1] + pr3[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-			
-		for(i = 1; i < width - 1; i++) // center
-		{
-			f = ke * (pr2[i-1] + pr1[i] + pr2[i+1] + pr3[i]);
-			f += kk * (pr1[i-1] + pr1[i+1] + pr3[i-1] + pr3[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;
-		}
-		
-		i = width - 1; // right side
-		{
-			f = ke * (pr2[i-1] + pr1[i] + pr3[i]);
-			f += kk * (pr1[i-1] + pr3[i-1]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
+		const int v = (int)kSSEVecSize;
+		return kRowPad + ((width + v - 1) & ~(v - 1)) + kRowPad;
 	}
-	j = height - 1;	// bottom row
+
+	// scratch rows for process2D(), kept for each thread and grown as needed,
+	// so that processing a frame does not allocate once things are running.
+	MLSample* get2DScratch(const int size)
 	{
-		// row ptrs
-		pr1 = (pIn + row(j - 1));
-		pr2 = (pIn + row(j));
-		prOut = (pOut + row(j));
-		
-		i = 0; // bottom left corner
-		{
-			f = ke * (pr1[i] + pr2[i+1]);
-			f += kk * (pr1[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-			
-		for(i = 1; i < width - 1; i++) // bottom side
-		{
-			f = ke * (pr2[i-1] + pr1[i] + pr2[i+1]);
-			f += kk * (pr1[i-1] + pr1[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;
-		}
-		
-		i = width - 1; // bottom right corner
+		static thread_local std::vector<MLSample> scratch;
+		const int alignedSize = size + kMLAlignSize/sizeof(MLSample);
+		if((int)scratch.size() < alignedSize)
 		{
-			f = ke * (pr2[i-1] + pr1[i]);
-			f += kk * (pr1[i-1]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
+			scratch.resize(alignedSize);
 		}
+		return alignToCacheLine(scratch.data());
 	}
-}
-
 
-// an operator for 2D signals only
-// convolve signal with coefficients, duplicating samples at border. 
-void MLSignal::convolve3x3rb(const MLSample kc, const MLSample ke, const MLSample kk)
-{
-	int i, j;
-	float f;
-	float * pr1, * pr2, * pr3; // input row ptrs
-	float * prOut; 	
-	
-	MLSample* pIn = getCopy();
-	MLSample* pOut = mDataAligned;
-	int width = mWidth;
-	int height = mHeight;
-	
-	j = 0;	// top row
+	// write one row of output by calling f(i) for each vector of samples starting at i.
+	// any partial vector at the end is computed whole, and only the samples
+	// inside the row are written.
+	template<typename F>
+	inline void writeRow2D(MLSample* pOut, const int width, F f)
 	{
-		// row ptrs
-		pr2 = (pIn + row(j));
-		pr3 = (pIn + row(j + 1));
-		prOut = (pOut + row(j));
-		
-		i = 0; // top left corner
-		{
-			f = ke * (pr2[i+1] + pr3[i] + pr2[i] + pr2[i]);
-			f += kk * (pr3[i+1] + pr2[i+1] + pr3[i] + pr2[i]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-			
-		for(i = 1; i < width - 1; i++) // top side
+		const int vectors = width >> kMLSamplesPerSSEVectorBits;
+		int i = 0;
+		for(int v = 0; v < vectors; ++v, i += kSSEVecSize)
 		{
-			f = ke * (pr2[i-1] + pr2[i+1] + pr3[i] + pr2[i]);
-			f += kk * (pr3[i-1] + pr3[i+1] + pr2[i-1] + pr2[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;
+			_mm_store_ps(pOut + i, f(i));
 		}
-		
-		i = width - 1; // top right corner
+		if(i < width)
 		{
-			f = ke * (pr2[i-1] + pr3[i] + pr2[i] + pr2[i]);
-			f += kk * (pr3[i-1] + pr2[i-1] + pr3[i] + pr2[i]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
+			MLSample temp[kSSEVecSize];
+			_mm_storeu_ps(temp, f(i));
+			for(int k = 0; i + k < width; ++k)
+			{
+				pOut[i + k] = temp[k];
+			}
 		}
 	}
-	for(j = 1; j < height - 1; j++) // center rows
+	
+	inline __m128 square4(const __m128 x) { return _mm_mul_ps(x, x); }
+
+	// process one row of a 2D operator. r1, r2 and r3 are the rows above, at and 
+	// below the output row. Their padding has been set up for the operator.
+	void processRow2D(const MLSignal::Op2D& op, const MLSample* r1, const MLSample* r2, const MLSample* r3, 
+		MLSample* pOut, const int width, const MLSample* pMaskL, const MLSample* pMaskR, const MLSample* pColN, 
+		const float upValid, const float downValid)
 	{
-		// row ptrs
-		pr1 = (pIn + row(j - 1));
-		pr2 = (pIn + row(j));
-		pr3 = (pIn + row(j + 1));
-		prOut = (pOut + row(j));
-		
-		i = 0; // left side
+		switch(op.mType)
 		{
-			f = ke * (pr1[i] + pr2[i+1] + pr3[i] + pr2[i]);
-			f += kk * (pr1[i+1] + pr3[i+1] + pr1[i] + pr3[i]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-			
-		for(i = 1; i < width - 1; i++) // center
-		{
-			f = ke * (pr2[i-1] + pr1[i] + pr2[i+1] + pr3[i]);
-			f += kk * (pr1[i-1] + pr1[i+1] + pr3[i-1] + pr3[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;
-		}
-		
-		i = width - 1; // right side
-		{
-			f = ke * (pr2[i-1] + pr1[i] + pr3[i] + pr2[i]);
-			f += kk * (pr1[i-1] + pr3[i-1] + pr1[i] + pr3[i]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
+			case MLSignal::Op2D::kConvolve3x3r:
+			case MLSignal::Op2D::kConvolve3x3rb:
+			{
+				const __m128 kc = _mm_set1_ps(op.mKc);
+				const __m128 ke = _mm_set1_ps(op.mKe);
+				const __m128 kk = _mm_set1_ps(op.mKk);
+				writeRow2D(pOut, width, [&](int i)
+				{
+					__m128 e = _mm_add_ps(_mm_loadu_ps(r2 + i - 1), _mm_loadu_ps(r2 + i + 1));
+					e = _mm_add_ps(e, _mm_add_ps(_mm_load_ps(r1 + i), _mm_load_ps(r3 + i)));
+					__m128 k = _mm_add_ps(_mm_loadu_ps(r1 + i - 1), _mm_loadu_ps(r1 + i + 1));
+					k = _mm_add_ps(k, _mm_add_ps(_mm_loadu_ps(r3 + i - 1), _mm_loadu_ps(r3 + i + 1)));
+					__m128 y = _mm_mul_ps(kc, _mm_load_ps(r2 + i));
+					y = _mm_add_ps(y, _mm_mul_ps(ke, e));
+					return _mm_add_ps(y, _mm_mul_ps(kk, k));
+				});
+				break;
+			}
+			case MLSignal::Op2D::kPartialDiffX:
+			{
+				const __m128 half = _mm_set1_ps(0.5f);
+				writeRow2D(pOut, width, [&](int i)
+				{
+					return _mm_mul_ps(half, _mm_sub_ps(_mm_loadu_ps(r2 + i + 1), _mm_loadu_ps(r2 + i - 1)));
+				});
+				break;
+			}
+			case MLSignal::Op2D::kPartialDiffY:
+			{
+				const __m128 half = _mm_set1_ps(0.5f);
+				writeRow2D(pOut, width, [&](int i)
+				{
+					return _mm_mul_ps(half, _mm_sub_ps(_mm_load_ps(r3 + i), _mm_load_ps(r1 + i)));
+				});
+				break;
+			}
+			case MLSignal::Op2D::kVariance3x3:
+			{
+				// neighbors outside the signal are masked out of the sum and the count.
+				const __m128 up = _mm_set1_ps(upValid);
+				const __m128 down = _mm_set1_ps(downValid);
+				const __m128 rowN = _mm_set1_ps(1.f + upValid + downValid);
+				const __m128 one = _mm_set1_ps(1.f);
+				writeRow2D(pOut, width, [&](int i)
+				{
+					const __m128 c = _mm_load_ps(r2 + i);
+					const __m128 mL = _mm_load_ps(pMaskL + i);
+					const __m128 mR = _mm_load_ps(pMaskR + i);
+					__m128 sUp = _mm_mul_ps(mL, square4(_mm_sub_ps(_mm_loadu_ps(r1 + i - 1), c)));
+					sUp = _mm_add_ps(sUp, square4(_mm_sub_ps(_mm_load_ps(r1 + i), c)));
+					sUp = _mm_add_ps(sUp, _mm_mul_ps(mR, square4(_mm_sub_ps(_mm_loadu_ps(r1 + i + 1), c))));
+					__m128 sMid = _mm_mul_ps(mL, square4(_mm_sub_ps(_mm_loadu_ps(r2 + i - 1), c)));
+					sMid = _mm_add_ps(sMid, _mm_mul_ps(mR, square4(_mm_sub_ps(_mm_loadu_ps(r2 + i + 1), c))));
+					__m128 sDown = _mm_mul_ps(mL, square4(_mm_sub_ps(_mm_loadu_ps(r3 + i - 1), c)));
+					sDown = _mm_add_ps(sDown, square4(_mm_sub_ps(_mm_load_ps(r3 + i), c)));
+					sDown = _mm_add_ps(sDown, _mm_mul_ps(mR, square4(_mm_sub_ps(_mm_loadu_ps(r3 + i + 1), c))));
+					__m128 sum = _mm_add_ps(sMid, _mm_add_ps(_mm_mul_ps(up, sUp), _mm_mul_ps(down, sDown)));
+					__m128 n = _mm_sub_ps(_mm_mul_ps(_mm_load_ps(pColN + i), rowN), one);
+					n = _mm_max_ps(n, one);
+					return _mm_sqrt_ps(_mm_div_ps(sum, n));
+				});
+				break;
+			}
 		}
 	}
-	j = height - 1;	// bottom row
+	
+	// set the padding at each end of a row for the operator that will read it.
+	inline void setRowPadding2D(const MLSignal::Op2D& op, MLSample* r, const int width)
 	{
-		// row ptrs
-		pr1 = (pIn + row(j - 1));
-		pr2 = (pIn + row(j));
-		prOut = (pOut + row(j));
-		
-		i = 0; // bottom left corner
-		{
-			f = ke * (pr1[i] + pr2[i+1] + pr2[i] + pr2[i]);
-			f += kk * (pr1[i+1] + pr1[i] + pr2[i+1] + pr2[i]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-			
-		for(i = 1; i < width - 1; i++) // bottom side
+		if(op.mType == MLSignal::Op2D::kConvolve3x3rb)
 		{
-			f = ke * (pr2[i-1] + pr1[i] + pr2[i+1] + pr2[i]);
-			f += kk * (pr1[i-1] + pr1[i+1] + pr2[i-1] + pr2[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;
+			r[-1] = r[0];
+			r[width] = r[width - 1];
 		}
-		
-		i = width - 1; // bottom right corner
+		else
 		{
-			f = ke * (pr2[i-1] + pr1[i] + pr2[i] + pr2[i]);
-			f += kk * (pr1[i-1] + pr1[i] + pr2[i-1] + pr2[i]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
+			r[-1] = 0.f;
+			r[width] = 0.f;
 		}
 	}
 }
 
-// an operator for 2D signals only
-void MLSignal::variance3x3()
+void MLSignal::process2D(const Op2D* ops, const int nOps)
 {
-	MLSample* pIn = getCopy();
-	MLSample* pOut = mDataAligned;
-	int i, j;
-	float f;
-	float * pr1, * pr2, * pr3; // input row ptrs
-	float * prOut; 		
-	int width = mWidth;
-	int height = mHeight;
-	float c, x1, x2, x3, x4, x5, x6, x7, x8;
-	
-	i = 0;	// top row
-	{
-		// row ptrs
-		pr2 = (pIn + row(i));
-		pr3 = (pIn + row(i + 1));
-		prOut = (pOut + row(i));
-		
-		j = 0; // top left corner
-		{
-			c = pr2[j]; x5 = pr2[j+1];
-			x7 = pr3[j]; x8 = pr3[j+1];
-			
-			x5 -= c;
-			x7 -= c; x8 -= c;
-			
-			x5 *= x5;
-			x7 *= x7; x8 *= x8;
-			
-			f = x5 + x7 + x8;
-			f /= 3.f;
-			prOut[j] = sqrtf(f);
-		}
-		for(j = 1; j < width - 1; j++) // top side
-		{
-			x4 = pr2[j-1]; c = pr2[j]; x5 = pr2[j+1];
-			x6 = pr3[j-1]; x7 = pr3[j]; x8 = pr3[j+1];
-			
-			x4 -= c; x5 -= c;
-			x6 -= c; x7 -= c; x8 -= c;
-			
-			x4 *= x4; x5 *= x5;
-			x6 *= x6; x7 *= x7; x8 *= x8;
-			
-			f = x4 + x5 + x6 + x7 + x8;
-			f /= 5.f;
-			prOut[j] = sqrtf(f);
-		}		
-		j = width - 1; // top right corner
-		{
-			x4 = pr2[j-1]; c = pr2[j];
-			x6 = pr3[j-1]; x7 = pr3[j];
-			
-			x4 -= c;
-			x6 -= c; x7 -= c; 
-			
-			x4 *= x4; 
-			x6 *= x6; x7 *= x7; 
-			
-			f = x4 + x6 + x7;
-			f /= 3.f;
-			prOut[j] = sqrtf(f);
-		}
-	}
-	for(i = 1; i < height - 1; i++) // center rows
+	if(nOps <= 0) return;
+	if(nOps > kMaxOps2D)
 	{
-		// row ptrs
-		pr1 = (pIn + row(i - 1));
-		pr2 = (pIn + row(i));
-		pr3 = (pIn + row(i + 1));
-		prOut = (pOut + row(i));
-		
-		j = 0; // left side
-		{
-			x2 = pr1[j]; x3 = pr1[j+1];
-			c = pr2[j]; x5 = pr2[j+1];
-			x7 = pr3[j]; x8 = pr3[j+1];
-			
-			x2 -= c; x3 -= c;
-			x5 -= c;
-			x7 -= c; x8 -= c;
-			
-			x2 *= x2; x3 *= x3;
-			x5 *= x5;
-			x7 *= x7; x8 *= x8;
-			
-			f = x2 + x3 + x5 + x7 + x8;
-			f /= 5.f;
-			prOut[j] = sqrtf(f);
-		}
-		for(j = 1; j < width - 1; j++) // center
-		{
-			x1 = pr1[j-1]; x2 = pr1[j]; x3 = pr1[j+1];
-			x4 = pr2[j-1]; c = pr2[j]; x5 = pr2[j+1];
-			x6 = pr3[j-1]; x7 = pr3[j]; x8 = pr3[j+1];
-			
-			x1 -= c; x2 -= c; x3 -= c;
-			x4 -= c; x5 -= c;
-			x6 -= c; x7 -= c; x8 -= c;
-			
-			x1 *= x1; x2 *= x2; x3 *= x3;
-			x4 *= x4; x5 *= x5;
-			x6 *= x6; x7 *= x7; x8 *= x8;
-			
-			f = x1 + x2 + x3 + x4 + x5 + x6 + x7 + x8;
-			f /= 8.f;
-			prOut[j] = sqrtf(f);
-		}
-		
-		j = width - 1; // right side
-		{
-			x1 = pr1[j-1]; x2 = pr1[j]; 
-			x4 = pr2[j-1]; c = pr2[j]; 
-			x6 = pr3[j-1]; x7 = pr3[j]; 
-			
-			x1 -= c; x2 -= c;
-			x4 -= c; 
-			x6 -= c; x7 -= c; 
-			
-			x1 *= x1; x2 *= x2; 
-			x4 *= x4; 
-			x6 *= x6; x7 *= x7;
-			
-			f = x1 + x2 + x4 + x6 + x7;
-			f /= 5.f;
-			prOut[j] = sqrtf(f);
-		}
+		process2D(ops, kMaxOps2D);
+		process2D(ops + kMaxOps2D, nOps - kMaxOps2D);
+		return;
 	}
-	i = height - 1;	// bottom row
+	
+	const int width = mWidth;
+	const int height = mHeight;
+	const int rowSize = paddedRowSize(width);
+	
+	// scratch: a row of zeros, the left, right and count masks for variance, 
+	// then three rows for the input and three for each stage before the last.
+	const int kFixedRows = 4;
+	MLSample* pScratch = get2DScratch(rowSize*(kFixedRows + 3*nOps));
+	MLSample* pZero = pScratch + kRowPad;
+	MLSample* pMaskL = pZero + rowSize;
+	MLSample* pMaskR = pMaskL + rowSize;
+	MLSample* pColN = pMaskR + rowSize;
+	std::fill(pScratch, pScratch + rowSize*kFixedRows, 0.f);
+	for(int i = 0; i < width; ++i)
+	{
+		pMaskL[i] = (i > 0);
+		pMaskR[i] = (i < width - 1);
+		pColN[i] = 1.f + pMaskL[i] + pMaskR[i];
+	}
+	auto ringRow = [&](const int level, const int j)
+	{
+		return pScratch + rowSize*(kFixedRows + 3*level + (j % 3)) + kRowPad;
+	};
+	
+	// rows done at each level. level 0 is the input, level s the output of stage s.
+	// each sweep reads at most one new input row, and each stage makes at most one
+	// row as soon as the rows it needs are ready. This keeps each stage no more
+	// than one row behind the one before, so three rows per level are enough.
+	int done[kMaxOps2D + 1] = {0};
+	while(done[nOps] < height)
 	{
-		// row ptrs
-		pr1 = (pIn + row(i - 1));
-		pr2 = (pIn + row(i));
-		prOut = (pOut + row(i));
-		
-		j = 0; // bottom left corner
+		if(done[0] < height)
 		{
-			x2 = pr1[j]; x3 = pr1[j+1];
-			c = pr2[j]; x5 = pr2[j+1];
-			
-			x2 -= c; x3 -= c;
-			x5 -= c;
-			
-			x2 *= x2; x3 *= x3;
-			x5 *= x5;
-			
-			f = x2 + x3 + x5 ;
-			f /= 3.f;
-			prOut[j] = sqrtf(f);
+			const int j = done[0];
+			const MLSample* pIn = mDataAligned + row(j);
+			std::copy(pIn, pIn + width, ringRow(0, j));
+			done[0]++;
 		}
-			
-		for(j = 1; j < width - 1; j++) // bottom side
-		{
-			x1 = pr1[j-1]; x2 = pr1[j]; x3 = pr1[j+1];
-			x4 = pr2[j-1]; c = pr2[j]; x5 = pr2[j+1];
-			
-			x1 -= c; x2 -= c; x3 -= c;
-			x4 -= c; x5 -= c;
-			
-			x1 *= x1; x2 *= x2; x3 *= x3;
-			x4 *= x4; x5 *= x5;
-			
-			f = x1 + x2 + x3 + x4 + x5 ;
-			f /= 5.f;
-			prOut[j] = sqrtf(f);
-		}
-		
-		j = width - 1; // bottom right corner
+		for(int s = 1; s <= nOps; ++s)
 		{
-			x1 = pr1[j-1]; x2 = pr1[j]; 
-			x4 = pr2[j-1]; c = pr2[j]; 
+			const int j = done[s];
+			if(j >= height) continue;
+			if(done[s - 1] < min(j + 2, height)) continue;
 			
-			x1 -= c; x2 -= c;
-			x4 -= c;
+			const Op2D& op = ops[s - 1];
+			const bool dup = (op.mType == Op2D::kConvolve3x3rb);
+			MLSample* r2 = ringRow(s - 1, j);
+			MLSample* r1 = (j > 0) ? ringRow(s - 1, j - 1) : (dup ? r2 : pZero);
+			MLSample* r3 = (j < height - 1) ? ringRow(s - 1, j + 1) : (dup ? r2 : pZero);
+			if(r1 != pZero) setRowPadding2D(op, r1, width);
+			setRowPadding2D(op, r2, width);
+			if(r3 != pZero) setRowPadding2D(op, r3, width);
 			
-			x1 *= x1; x2 *= x2; 
-			x4 *= x4; 
-						
-			f = x1 + x2 + x4 ;
-			f /= 3.f;
-			prOut[j] = sqrtf(f);
+			MLSample* pOut = (s == nOps) ? mDataAligned + row(j) : ringRow(s, j);
+			processRow2D(op, r1, r2, r3, pOut, width, pMaskL, pMaskR, pColN, (float)(j > 0), (float)(j < height - 1));
+			done[s]++;
 		}
 	}
+	setConstant(false);
+}
+
+// an operator for 2D signals only
+void MLSignal::convolve3x3r(const MLSample kc, const MLSample ke, const MLSample kk)
+{
+	Op2D op(Op2D::kConvolve3x3r, kc, ke, kk);
+	process2D(&op, 1);
+}
+
+// an operator for 2D signals only
+// convolve signal with coefficients, duplicating samples at border. 
+void MLSignal::convolve3x3rb(const MLSample kc, const MLSample ke, const MLSample kk)
+{
+	Op2D op(Op2D::kConvolve3x3rb, kc, ke, kk);
+	process2D(&op, 1);
+}
+
+// an operator for 2D signals only
+// the RMS difference of each sample from its neighbors.
+void MLSignal::variance3x3()
+{
+	Op2D op(Op2D::kVariance3x3);
+	process2D(&op, 1);
 }
 
 float MLSignal::getRMS()
 {
     float d = 0.f;
-    for(int i=0; i<mSize; ++i)
-    {
-        const float v = (mDataAligned[i]);
-        d += v*v;
-    }
-    return sqrtf(d/mSize);
+	forEachRow(*this, [&](int o, int n)
+	{
+		for(int i=0; i<n; ++i)
+		{
+			const float v = (mDataAligned[o + i]);
+			d += v*v;
+		}
+	});
+    return sqrtf(d/(mWidth*mHeight*mDepth));
 }
 
 float MLSignal::rmsDiff(const MLSignal& b)
@@ -1233,87 +1213,105 @@ float MLSignal::rmsDiff(const MLSignal& b)
     if(mHeight != b.mHeight) return -1.f;
     if(mDepth != b.mDepth) return -1.f;
     
-    for(int i=0; i<mSize; ++i)
-    {
-        float v = (mDataAligned[i] - b.mDataAligned[i]);
-        d += v*v;
-    }
-    return sqrtf(d/mSize);
+	forEachRow(*this, b, [&](int oa, int ob, int n)
+	{
+		for(int i=0; i<n; ++i)
+		{
+			float v = (mDataAligned[oa + i] - b.mDataAligned[ob + i]);
+			d += v*v;
+		}
+	});
+    return sqrtf(d/(mWidth*mHeight*mDepth));
 }
 
 void MLSignal::flipVertical()
 {
 	MLSample* p0 = mDataAligned;
-	for(int j=0; j<(mHeight>>1) - 1; ++j)
+	const int vectors = mWidth >> kMLSamplesPerSSEVectorBits;
+	for(int j=0; j<(mHeight>>1); ++j)
 	{
-		MLSample temp;
 		MLSample* p1 = p0 + row(j);
 		MLSample* p2 = p0 + row(mHeight - 1 - j);
-		for(int i=0; i<mWidth; ++i)
+		int i = 0;
+		for(int v=0; v<vectors; ++v, i += kSSEVecSize)
+		{
+			__m128 a = _mm_load_ps(p1 + i);
+			_mm_store_ps(p1 + i, _mm_load_ps(p2 + i));
+			_mm_store_ps(p2 + i, a);
+		}
+		for(; i<mWidth; ++i)
 		{
-			temp = p1[i];
-			p1[i] = p2[i];
-			p2[i] = temp;
+			std::swap(p1[i], p2[i]);
 		}
 	}
 }
 
-void MLSignal::square()
+namespace
 {
-	for(int i=0; i<mSize; ++i)
+	struct SquareOp
 	{
-		mDataAligned[i] *= mDataAligned[i];
-	}
+		__m128 operator()(__m128 x) const { return _mm_mul_ps(x, x); }
+		MLSample operator()(MLSample x) const { return x*x; }
+	};
+	struct SqrtOp
+	{
+		__m128 operator()(__m128 x) const { return _mm_sqrt_ps(x); }
+		MLSample operator()(MLSample x) const { return sqrtf(x); }
+	};
+	struct AbsOp
+	{
+		__m128 operator()(__m128 x) const { return _mm_andnot_ps(_mm_set1_ps(-0.f), x); }
+		MLSample operator()(MLSample x) const { return fabsf(x); }
+	};
+	struct InvOp
+	{
+		__m128 operator()(__m128 x) const { return _mm_div_ps(_mm_set1_ps(1.f), x); }
+		MLSample operator()(MLSample x) const { return 1.0f / x; }
+	};
+	struct SignOp
+	{
+		__m128 operator()(__m128 x) const 
+		{
+			const __m128 neg = _mm_cmplt_ps(x, _mm_setzero_ps());
+			return _mm_or_ps(_mm_and_ps(neg, _mm_set1_ps(-1.f)), _mm_andnot_ps(neg, _mm_set1_ps(1.f)));
+		}
+		MLSample operator()(MLSample x) const { return x < 0.f ? -1.f : 1.f; }
+	};
+	struct Log2ApproxOp
+	{
+		__m128 operator()(__m128 x) const { return log2Approx4(x); }
+		MLSample operator()(MLSample x) const { return _mm_cvtss_f32(log2Approx4(_mm_set1_ps(x))); }
+	};
+}
+
+void MLSignal::square()
+{
+	forEachRow(*this, [&](int o, int n) { mapRow(mDataAligned + o, n, SquareOp()); });
 }
 
 void MLSignal::sqrt()
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		mDataAligned[i] = sqrtf(mDataAligned[i]);
-	}
+	forEachRow(*this, [&](int o, int n) { mapRow(mDataAligned + o, n, SqrtOp()); });
 }
 
 void MLSignal::abs()
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		mDataAligned[i] = fabs(mDataAligned[i]);
-	}
+	forEachRow(*this, [&](int o, int n) { mapRow(mDataAligned + o, n, AbsOp()); });
 }
 
 void MLSignal::inv()
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		mDataAligned[i] = 1.0f / mDataAligned[i];
-	}
+	forEachRow(*this, [&](int o, int n) { mapRow(mDataAligned + o, n, InvOp()); });
 }
 
 void MLSignal::ssign()
 {
-	// TODO SSE
-	for(int i=0; i<mSize; ++i)
-	{
-		MLSample f = mDataAligned[i];
-		mDataAligned[i] = f < 0.f ? -1.f : 1.f;
-	}
+	forEachRow(*this, [&](int o, int n) { mapRow(mDataAligned + o, n, SignOp()); });
 }
 
 void MLSignal::log2Approx()
 {
-	MLSample* px1 = getBuffer();
-    
-	int c = getSize() >> kMLSamplesPerSSEVectorBits;
-	__m128 vx1, vy1;
-	
-	for (int n = 0; n < c; ++n)
-	{
-		vx1 = _mm_load_ps(px1);
-		vy1 = log2Approx4(vx1); 		
-		_mm_store_ps(px1, vy1);
-		px1 += kSSEVecSize;
-	}
+	forEachRow(*this, [&](int o, int n) { mapRow(mDataAligned + o, n, Log2ApproxOp()); });
 }
 
 void MLSignal::setIdentity()
@@ -1331,20 +1329,18 @@ void MLSignal::setIdentity()
 // edge values with duplicates of the neighboring values.
 void MLSignal::makeDuplicateBoundary2D()
 {
-	MLSignal& a = *this;
+	MLSample* p0 = mDataAligned;
 	
 	// top and bottom
-	for(int i=1; i<mWidth - 1; ++i)
-	{
-		a(i, 0) = a(i, 1);
-		a(i, mHeight - 1) = a(i, mHeight - 2);
-	}
+	std::copy(p0 + row(1) + 1, p0 + row(1) + mWidth - 1, p0 + row(0) + 1);
+	std::copy(p0 + row(mHeight - 2) + 1, p0 + row(mHeight - 2) + mWidth - 1, p0 + row(mHeight - 1) + 1);
 	
 	// left and right
 	for(int j=0; j<mHeight; ++j)
 	{
-		a(0, j) = a(1, j);
-		a(mWidth - 1, j) = a(mWidth - 2, j);
+		MLSample* pr = p0 + row(j);
+		pr[0] = pr[1];
+		pr[mWidth - 1] = pr[mWidth - 2];
 	}
 }
 
@@ -1354,14 +1350,14 @@ Vec3 MLSignal::findPeak() const
 {
 	int maxX = -1;
 	int maxY = -1;
-	float z = -1.f;
 	float maxZ = -MAXFLOAT;
 	
 	for (int j=0; j < mHeight; ++j)
 	{
+		const MLSample* pr = mDataAligned + row(j);
 		for (int i=0; i < mWidth; i++)
 		{
-			z = operator()(i, j);
+			const float z = pr[i];
 			if(z > maxZ)
 			{
 				maxZ = z;
@@ -1373,6 +1369,78 @@ Vec3 MLSignal::findPeak() const
 	return Vec3(maxX, maxY, maxZ);
 }
 
+int MLSignal::findPeaks(Vec3* pPeaks, const int maxPeaks, const float threshold) const
+{
+	if((maxPeaks <= 0) || (mWidth <= 0) || (mHeight <= 0)) return 0;
+	const int width = mWidth;
+	const int height = mHeight;
+	const int rowSize = paddedRowSize(width);
+
+	// scratch: a row that is all padding, then three input rows. Padding is
+	// -MAXFLOAT so that samples at the edges can be peaks.
+	MLSample* pScratch = get2DScratch(rowSize*4);
+	std::fill(pScratch, pScratch + rowSize*4, -MAXFLOAT);
+	MLSample* pNone = pScratch + kRowPad;
+	auto ringRow = [&](const int j)
+	{
+		return pScratch + rowSize*(1 + (j % 3)) + kRowPad;
+	};
+	std::copy(mDataAligned, mDataAligned + width, ringRow(0));
+	
+	const __m128 vThresh = _mm_set1_ps(threshold);
+	int nPeaks = 0;
+	for(int j = 0; j < height; ++j)
+	{
+		if(j + 1 < height)
+		{
+			const MLSample* pIn = mDataAligned + row(j + 1);
+			std::copy(pIn, pIn + width, ringRow(j + 1));
+		}
+		const MLSample* r1 = (j > 0) ? ringRow(j - 1) : pNone;
+		const MLSample* r2 = ringRow(j);
+		const MLSample* r3 = (j < height - 1) ? ringRow(j + 1) : pNone;
+		
+		for(int i = 0; i < width; i += kSSEVecSize)
+		{
+			const __m128 c = _mm_load_ps(r2 + i);
+			__m128 m = _mm_cmpgt_ps(c, vThresh);
+			
+			// neighbors before in scan order
+			m = _mm_and_ps(m, _mm_cmpgt_ps(c, _mm_loadu_ps(r1 + i - 1)));
+			m = _mm_and_ps(m, _mm_cmpgt_ps(c, _mm_load_ps(r1 + i)));
+			m = _mm_and_ps(m, _mm_cmpgt_ps(c, _mm_loadu_ps(r1 + i + 1)));
+			m = _mm_and_ps(m, _mm_cmpgt_ps(c, _mm_loadu_ps(r2 + i - 1)));
+			
+			// neighbors after
+			m = _mm_and_ps(m, _mm_cmpge_ps(c, _mm_loadu_ps(r2 + i + 1)));
+			m = _mm_and_ps(m, _mm_cmpge_ps(c, _mm_loadu_ps(r3 + i - 1)));
+			m = _mm_and_ps(m, _mm_cmpge_ps(c, _mm_load_ps(r3 + i)));
+			m = _mm_and_ps(m, _mm_cmpge_ps(c, _mm_loadu_ps(r3 + i + 1)));
+			
+			int bits = _mm_movemask_ps(m);
+			for(int k = 0; bits; ++k, bits >>= 1)
+			{
+				if(!(bits & 1) || (i + k >= width)) continue;
+				
+				// insert into the list of highest peaks, sorted by z.
+				const float z = r2[i + k];
+				if((nPeaks < maxPeaks) || (z > pPeaks[nPeaks - 1].z()))
+				{
+					int n = min(nPeaks, maxPeaks - 1);
+					while((n > 0) && (pPeaks[n - 1].z() < z))
+					{
+						pPeaks[n] = pPeaks[n - 1];
+						n--;
+					}
+					pPeaks[n] = Vec3(i + k, j, z);
+					nPeaks = min(nPeaks + 1, maxPeaks);
+				}
+			}
+		}
+	}
+	return nPeaks;
+}
+
 int MLSignal::checkIntegrity() const
 {
 	int ret = true;
@@ -1394,62 +1462,171 @@ int MLSignal::checkIntegrity() const
 int MLSignal::checkForNaN() const
 {
 	int ret = false;
-	const MLSample* p = mDataAligned;
-	for(int i=0; i<mSize; ++i)
+	forEachRow(*this, [&](int o, int n)
 	{
-        const float k = p[i];
-		if (k != k)
+		const MLSample* p = mDataAligned + o;
+		for(int i=0; (i<n) && !ret; ++i)
 		{
-			ret = true;
-			break;
+			const float k = p[i];
+			if (k != k)
+			{
+				ret = true;
+			}
 		}
-	}
+	});
 	return ret;
 }
 
 float MLSignal::getSum() const
 {
 	MLSample sum = 0.f;
-	for(int i=0; i<mSize; ++i)
+	forEachRow(*this, [&](int o, int n)
 	{
-		sum += mDataAligned[i];
-	}
+		for(int i=0; i<n; ++i)
+		{
+			sum += mDataAligned[o + i];
+		}
+	});
 	return sum;
 }
 
 float MLSignal::getMean() const
 {
-	return getSum() / (float)mSize;
+	return getSum() / (float)(mWidth*mHeight*mDepth);
 }
 
 float MLSignal::getMin() const
 {
 	MLSample fMin = kMLMaxSample;
-	for(int i=0; i<mSize; ++i)
+	forEachRow(*this, [&](int o, int n)
 	{
-		MLSample x = mDataAligned[i];
-		if(x < fMin)
+		for(int i=0; i<n; ++i)
 		{
-			fMin = x;
+			fMin = min(fMin, mDataAligned[o + i]);
 		}
-	}
+	});
 	return fMin;
 }
 
 float MLSignal::getMax() const
 {
 	MLSample fMax = kMLMinSample;
-	for(int i=0; i<mSize; ++i)
+	forEachRow(*this, [&](int o, int n)
 	{
-		MLSample x = mDataAligned[i];
-		if(x > fMax)
+		for(int i=0; i<n; ++i)
 		{
-			fMax = x;
+			fMax = max(fMax, mDataAligned[o + i]);
 		}
-	}
+	});
 	return fMax;
 }
 
+float MLSignal::getAbsMax() const
+{
+	if(isConstant())
+	{
+		return fabsf(mDataAligned[0]);
+	}
+	
+	// clear the sign bits and take the max, four samples at a time.
+	const __m128 vSignMask = _mm_set1_ps(-0.f);
+	__m128 vMax = _mm_setzero_ps();
+	MLSample fMax = 0.f;
+	forEachRow(*this, [&](int o, int n)
+	{
+		const MLSample* p = mDataAligned + o;
+		const int vectors = n >> kMLSamplesPerSSEVectorBits;
+		for(int v = 0; v < vectors; ++v)
+		{
+			__m128 vx = _mm_load_ps(p + (v << kMLSamplesPerSSEVectorBits));
+			vMax = _mm_max_ps(vMax, _mm_andnot_ps(vSignMask, vx));
+		}
+		for(int i = vectors << kMLSamplesPerSSEVectorBits; i < n; ++i)
+		{
+			fMax = max(fMax, fabsf(p[i]));
+		}
+	});
+	vMax = _mm_max_ps(vMax, _mm_movehl_ps(vMax, vMax));
+	vMax = _mm_max_ss(vMax, _mm_shuffle_ps(vMax, vMax, 1));
+	return max(fMax, _mm_cvtss_f32(vMax));
+}
+
+// write the minimum and maximum of n samples starting at p to the outputs.
+static inline void spanMinMax(const MLSample* p, const int n, MLSample& outMin, MLSample& outMax)
+{
+	const int kVec = kSSEVecSize;
+	MLSample fMin = p[0];
+	MLSample fMax = p[0];
+	int i = 1;
+	if(n >= kVec)
+	{
+		__m128 vMin = _mm_loadu_ps(p);
+		__m128 vMax = vMin;
+		for(i = kVec; i + kVec <= n; i += kVec)
+		{
+			const __m128 v = _mm_loadu_ps(p + i);
+			vMin = _mm_min_ps(vMin, v);
+			vMax = _mm_max_ps(vMax, v);
+		}
+		
+		// reduce the four lanes.
+		vMin = _mm_min_ps(vMin, _mm_movehl_ps(vMin, vMin));
+		vMin = _mm_min_ss(vMin, _mm_shuffle_ps(vMin, vMin, 1));
+		vMax = _mm_max_ps(vMax, _mm_movehl_ps(vMax, vMax));
+		vMax = _mm_max_ss(vMax, _mm_shuffle_ps(vMax, vMax, 1));
+		fMin = _mm_cvtss_f32(vMin);
+		fMax = _mm_cvtss_f32(vMax);
+	}
+	for(; i < n; ++i)
+	{
+		fMin = min(fMin, p[i]);
+		fMax = max(fMax, p[i]);
+	}
+	outMin = fMin;
+	outMax = fMax;
+}
+
+void MLSignal::decimateMinMax(const MLSignal& src, int samples, int points)
+{
+	samples = clamp(samples, 0, src.getWidth());
+	points = clamp(points, 1, max(samples, 1));
+	const int rows = src.getHeight();
+	if((mWidth != points) || (mHeight != rows) || (mDepth != 2))
+	{
+		setDims(points, rows, 2);
+	}
+	setConstant(false);
+	if(!samples)
+	{
+		clear();
+		return;
+	}
+	
+	for(int j=0; j<rows; ++j)
+	{
+		MLSample* pMin = mDataAligned + row(j);
+		MLSample* pMax = mDataAligned + plane(1) + row(j);
+		if(src.isConstant())
+		{
+			const MLSample k = src.getConstBuffer()[0];
+			std::fill(pMin, pMin + points, k);
+			std::fill(pMax, pMax + points, k);
+			continue;
+		}
+		
+		// span k covers [k*samples/points, (k+1)*samples/points), so spans differ 
+		// in length by at most one sample and none is empty.
+		const MLSample* pSrc = src.getConstBuffer() + src.row(j);
+		int start = 0;
+		for(int k=0; k<points; ++k)
+		{
+			const int end = (int)((int64_t)(k + 1)*samples/points);
+			spanMinMax(pSrc + start, end - start, pMin[k], pMax[k]);
+			start = end;
+		}
+	}
+}
+
 void MLSignal::dump(std::ostream& s, int verbosity) const
 {
 	s << "signal @ " << std::hex << this << std::dec << " [" << mSize << " frames] : sum " << getSum() << "\n";
@@ -1564,9 +1741,76 @@ Vec2 MLSignal::correctPeak(const int ix, const int iy, const float maxCorrect) c
 }
 
 
+void MLSignal::correctPeaks(Vec3* pPeaks, const int n, const float maxCorrect) const
+{
+	const int width = mWidth;
+	const int height = mHeight;
+	if((width < 3) || (height < 3)) return;
+	
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 quarter = _mm_set1_ps(0.25f);
+	const __m128 two = _mm_set1_ps(2.f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 maxC = _mm_set1_ps(maxCorrect);
+	const __m128 minC = _mm_set1_ps(-maxCorrect);
+	
+	for(int p = 0; p < n; p += kSSEVecSize)
+	{
+		// gather the 3x3 neighborhood around each peak, one peak per vector lane.
+		// any unused lanes repeat the last peak.
+		MLSample nb[9][kSSEVecSize];
+		MLSample px[kSSEVecSize], py[kSSEVecSize];
+		for(int k = 0; k < (int)kSSEVecSize; ++k)
+		{
+			const Vec3& peak = pPeaks[min(p + k, n - 1)];
+			const int x = clamp((int)peak.x(), 1, width - 2);
+			const int y = clamp((int)peak.y(), 1, height - 2);
+			px[k] = x;
+			py[k] = y;
+			for(int dj = 0; dj < 3; ++dj)
+			{
+				const MLSample* pr = mDataAligned + row(y + dj - 1) + x;
+				nb[dj*3][k] = pr[-1];
+				nb[dj*3 + 1][k] = pr[0];
+				nb[dj*3 + 2][k] = pr[1];
+			}
+		}
+		__m128 v[9];
+		for(int m = 0; m < 9; ++m)
+		{
+			v[m] = _mm_loadu_ps(nb[m]);
+		}
+		
+		// centered differences, as in correctPeak().
+		const __m128 dx = _mm_mul_ps(half, _mm_sub_ps(v[5], v[3]));
+		const __m128 dy = _mm_mul_ps(half, _mm_sub_ps(v[7], v[1]));
+		const __m128 c2 = _mm_mul_ps(two, v[4]);
+		const __m128 dxx = _mm_sub_ps(_mm_add_ps(v[5], v[3]), c2);
+		const __m128 dyy = _mm_sub_ps(_mm_add_ps(v[7], v[1]), c2);
+		const __m128 dxy = _mm_mul_ps(quarter, _mm_sub_ps(_mm_add_ps(v[8], v[0]), _mm_add_ps(v[2], v[6])));
+		const __m128 det = _mm_sub_ps(_mm_mul_ps(dxx, dyy), _mm_mul_ps(dxy, dxy));
+		const __m128 valid = _mm_and_ps(_mm_cmpneq_ps(dxx, zero), _mm_cmpneq_ps(det, zero));
+		const __m128 safeDet = _mm_or_ps(_mm_and_ps(valid, det), _mm_andnot_ps(valid, _mm_set1_ps(1.f)));
+		const __m128 oneOverDet = _mm_div_ps(_mm_set1_ps(1.f), safeDet);
+		__m128 fx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dyy, dx), _mm_mul_ps(dxy, dy)), oneOverDet);
+		__m128 fy = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dxx, dy), _mm_mul_ps(dxy, dx)), oneOverDet);
+		fx = _mm_and_ps(valid, _mm_min_ps(maxC, _mm_max_ps(minC, fx)));
+		fy = _mm_and_ps(valid, _mm_min_ps(maxC, _mm_max_ps(minC, fy)));
+		
+		MLSample rx[kSSEVecSize], ry[kSSEVecSize];
+		_mm_storeu_ps(rx, _mm_sub_ps(_mm_loadu_ps(px), fx));
+		_mm_storeu_ps(ry, _mm_sub_ps(_mm_loadu_ps(py), fy));
+		for(int k = 0; (k < (int)kSSEVecSize) && (p + k < n); ++k)
+		{
+			pPeaks[p + k].setX(rx[k]);
+			pPeaks[p + k].setY(ry[k]);
+		}
+	}
+}
+
 // a simple pixel-by-pixel measure of the distance between two signals.
 //
-float rmsDifference2D(const MLSignal& a, const MLSignal& b)
+float rmsDifference2D(const MLSignalRef& a, const MLSignalRef& b)
 {
 	int w = min(a.getWidth(), b.getWidth());
 	int h = min(a.getHeight(), b.getHeight());
@@ -1585,92 +1829,66 @@ float rmsDifference2D(const MLSignal& a, const MLSignal& b)
 	return sum;
 }
 
-
-// centered partial derivative of 2D signal in x
-//
-void MLSignal::partialDiffX()
+// greedy matching: repeatedly take the closest pair of unmatched peaks.
+// peak counts are small, so this doesn't allocate or sort.
+void associatePeaks(const Vec3* pPrev, const int nPrev, const Vec3* pNew, const int nNew, 
+	int* pMatches, const float maxDistance)
 {
-	int i, j;
-	float * pr; // input row ptr
-	float * prOut; 	
-	
-	MLSample* pIn = getCopy();
-	MLSample* pOut = mDataAligned;
-	int width = mWidth;
-	int height = mHeight;
-	
-	for(j = 0; j < height; ++j) 
+	for(int i=0; i<nNew; ++i)
 	{
-		// row ptrs
-		pr = (pIn + row(j));
-		prOut = (pOut + row(j));
-		
-		i = 0; // left side
-		{
-			prOut[i] = (pr[i+1]) / 2.f;		
-		}
-			
-		for(i = 1; i < width - 1; ++i) 
+		pMatches[i] = -1;
+	}
+	auto prevIsMatched = [&](const int j)
+	{
+		for(int i=0; i<nNew; ++i)
 		{
-			prOut[i] = (pr[i+1] - pr[i-1]) / 2.f;
+			if(pMatches[i] == j) return true;
 		}
-		
-		i = width - 1; // right side
+		return false;
+	};
+	
+	const float maxDistSquared = maxDistance*maxDistance;
+	const int maxPairs = min(nPrev, nNew);
+	for(int pairs=0; pairs<maxPairs; ++pairs)
+	{
+		float minDistSquared = maxDistSquared;
+		int bestNew = -1;
+		int bestPrev = -1;
+		for(int i=0; i<nNew; ++i)
 		{
-			prOut[i] = (-pr[i-1]) / 2.f;		
+			if(pMatches[i] >= 0) continue;
+			for(int j=0; j<nPrev; ++j)
+			{
+				const float dx = pNew[i].x() - pPrev[j].x();
+				const float dy = pNew[i].y() - pPrev[j].y();
+				const float d = dx*dx + dy*dy;
+				if((d <= minDistSquared) && !prevIsMatched(j))
+				{
+					minDistSquared = d;
+					bestNew = i;
+					bestPrev = j;
+				}
+			}
 		}
+		if(bestNew < 0) break;
+		pMatches[bestNew] = bestPrev;
 	}
 }
 
+// centered partial derivative of 2D signal in x
+//
+void MLSignal::partialDiffX()
+{
+	Op2D op(Op2D::kPartialDiffX);
+	process2D(&op, 1);
+}
+
 // centered partial derivative of 2D signal in y
 //
 void MLSignal::partialDiffY()
 {
-	int i, j;
-	float * pr1, * pr2, * pr3; // input row ptrs
-	float * prOut; 	
-	
-	MLSample* pIn = getCopy();
-	MLSample* pOut = mDataAligned;
-	int width = mWidth;
-	int height = mHeight;
-	
-	j = 0; // top row
-	{
-		pr2 = (pIn + row(j));
-		pr3 = (pIn + row(j + 1));
-		prOut = (pOut + row(j));
-
-		for(i = 0; i < width; ++i) 
-		{
-			prOut[i] = (pr3[i]) / 2.f;
-		}
-	}
-
-	for(j = 1; j < height - 1; ++j) // center rows
-	{
-		pr1 = (pIn + row(j - 1));
-		pr2 = (pIn + row(j));
-		pr3 = (pIn + row(j + 1));
-		prOut = (pOut + row(j));
-		
-		for(i = 0; i < width; ++i) 
-		{
-			prOut[i] = (pr3[i] - pr1[i]) / 2.f;
-		}
-	}
-	
-	j = height - 1;	// bottom row
-	{
-		pr1 = (pIn + row(j - 1));
-		pr2 = (pIn + row(j));
-		prOut = (pOut + row(j));
-		
-		for(i = 0; i < width; ++i) 
-		{
-			prOut[i] = (-pr1[i]) / 2.f;
-		}
-	}
+	Op2D op(Op2D::kPartialDiffY);
+	process2D(&op, 1);
 }
 
 std::ostream& operator<< (std::ostream& out, const MLSignal & s)
@@ -49,8 +49,13 @@ typedef enum
 // no time, signal is 2D on dims[2, 1] (image)
 // 
 //
-// A signal always allocates storage in power of 2 sizes.  For signals of dimension > 1,
-// bitmasks are used to force accesses to be within bounds.  
+// By default a signal allocates storage in power of 2 sizes.  For signals of dimension > 1,
+// bitmasks are used to force accesses to be within bounds.  Signals that don't need 
+// this can use the packed layout, in which only rows are padded, to a multiple of 
+// the SIMD vector size. Masked lookups into a packed signal stay inside its storage
+// but wrap at a power of two smaller than it, so they don't loop over the signal.
+// Either way, operators on signals touch only the width x height x depth region, 
+// except clear(), which also zeroes the padding.
 
 // Signals greater than three dimensions are used so little, it seems to make
 // sense for objects that would need those signals to implement them
@@ -61,19 +66,42 @@ typedef enum
 // This allows optimizations to take place downstream, and does not require 
 // conditionals in loops to read the signal.
 
+// Signals of up to kLocalSize samples keep their data inside the object and 
+// don't allocate. Larger signals own heap data, which is taken without copying
+// when a signal is moved.
+
+class MLSignalRef;
+
 class MLSignal 
 {	
 public:
+	// largest signal in samples that is stored inside the object.
+	static const int kLocalSize = 16;
+
+	// storage layouts. 
+	// kPowerOfTwoLayout: each dimension is padded to a power of two. 
+	// kPackedLayout: each row is padded to a multiple of kSSEVecSize samples.
+	enum Layout
+	{
+		kPowerOfTwoLayout = 0,
+		kPackedLayout
+	};
+
 	MLSignal();	
 	MLSignal(const MLSignal& b);
-	MLSignal(int width, int height = 1, int depth = 1); 
+	MLSignal(MLSignal&& b);
+	MLSignal(int width, int height = 1, int depth = 1, Layout layout = kPowerOfTwoLayout); 
 	MLSignal (std::initializer_list<float> values);
 
 	// create a looped version of the signal argument, according to the loop type
-	MLSignal(MLSignal src, eLoopType loopType, int loopLength); 
+	MLSignal(const MLSignal& src, eLoopType loopType, int loopLength); 
+
+	// create a signal with a copy of the data in a view.
+	explicit MLSignal(const MLSignalRef& v);
 
 	~MLSignal();
 	MLSignal & operator= (const MLSignal & other); 
+	MLSignal & operator= (MLSignal && other); 
 
 	MLSample* getBuffer (void) const
 	{	
@@ -120,8 +148,8 @@ public:
 		}
 		else
 		{
-			// if this not is a constant signal, mConstantMask gets the mask for the power-of-two size.
-			mConstantMask = mSize - 1;
+			// if this not is a constant signal, mConstantMask gets the index mask.
+			mConstantMask = mIndexMask;
 		}
 	}
 	
@@ -159,15 +187,15 @@ public:
 	// (TODO) does not work with reference?! (MLSignal& t = mySignal; t(2, 3) = k;)
 	inline MLSample& operator()(const int i, const int j)
 	{
-		assert((j<<mWidthBits) + i < mSize);
-		return mDataAligned[(j<<mWidthBits) + i];
+		assert(j*mRowStride + i < mSize);
+		return mDataAligned[j*mRowStride + i];
 	}
 	
 	// inspector, return by value
 	inline const MLSample operator()(const int i, const int j) const
 	{
-		assert((j<<mWidthBits) + i < mSize);
-		return mDataAligned[(j<<mWidthBits) + i];
+		assert(j*mRowStride + i < mSize);
+		return mDataAligned[j*mRowStride + i];
 	}
 
 	// interpolators could be lambdas?
@@ -254,39 +282,42 @@ public:
 	// mutator, return sample reference
 	inline MLSample& operator()(const int i, const int j, const int k)
 	{
-		assert((k<<mWidthBits<<mHeightBits) + (j<<mWidthBits) + i < mSize);
-		return mDataAligned[(k<<mWidthBits<<mHeightBits) + (j<<mWidthBits) + i];
+		assert(k*mPlaneStride + j*mRowStride + i < mSize);
+		return mDataAligned[k*mPlaneStride + j*mRowStride + i];
 	}
 	
 	// inspector, return sample by value
 	inline const MLSample operator()(const int i, const int j, const int k) const
 	{
-		assert((k<<mWidthBits<<mHeightBits) + (j<<mWidthBits) + i < mSize);
-		return mDataAligned[(k<<mWidthBits<<mHeightBits) + (j<<mWidthBits) + i];
+		assert(k*mPlaneStride + j*mRowStride + i < mSize);
+		return mDataAligned[k*mPlaneStride + j*mRowStride + i];
 	}
 
-	// getFrame() - return const 2D signal made from data in place. 
-	const MLSignal getFrame(int i) const;
+	// return a view of all the data, or of the 2D frame i, without copying.
+	inline MLSignalRef getView() const;
+	inline MLSignalRef getFrame(int i) const;
 
-	// setFrame() - set the 2D frame i to the incoming signal.
-	void setFrame(int i, const MLSignal& src);
+	// setFrame() - set the 2D frame i to the incoming signal or view.
+	void setFrame(int i, const MLSignalRef& src);
 
 	// set dims.  return data ptr, or 0 if out of memory.
-	MLSample* setDims (int width, int height = 1, int depth = 1);
+	MLSample* setDims (int width, int height = 1, int depth = 1, Layout layout = kPowerOfTwoLayout);
 	
 	MLRect getBoundsRect() const { return MLRect(0, 0, mWidth, mHeight); }
 	
 	int getWidth() const { return mWidth; }
 	int getHeight() const { return mHeight; }
 	int getDepth() const { return mDepth; }
+	// log2 of the power-of-two size of each dimension. Only the power-of-two
+	// layout stores data with these sizes.
 	int getWidthBits() const { return mWidthBits; }
 	int getHeightBits() const { return mHeightBits; }
 	int getDepthBits() const { return mDepthBits; }
 	int getSize() const { return mSize; }
 
 	int getXStride() const { return (int)sizeof(MLSample); }
-	int getYStride() const { return (int)sizeof(MLSample) << mWidthBits; }
-	int getZStride() const { return (int)sizeof(MLSample) << mWidthBits << mHeightBits; }
+	int getYStride() const { return (int)sizeof(MLSample)*mRowStride; }
+	int getZStride() const { return (int)sizeof(MLSample)*mPlaneStride; }
 	int getFrames() const;
 	
 	// rate
@@ -310,6 +341,10 @@ public:
 	bool operator!=(const MLSignal& b) const { return !(operator==(b)); }
 	void copy(const MLSignal& b);
 	void add(const MLSignal& b);
+	
+	// set this signal to the sum of the n signals in ps, in one pass. 
+	// this signal may also be one of the inputs.
+	void setToSum(const MLSignal* const* ps, const int n);
 	void subtract(const MLSignal& b);
 	void multiply(const MLSignal& s);	
 	void divide(const MLSignal& s);	
@@ -336,6 +371,32 @@ public:
 	void convolve3x3rb(const MLSample kc, const MLSample ke, const MLSample kk);
 	void variance3x3();
 
+	// one stage of a 2D pipeline run by process2D(). Each operator has the same 
+	// result as the MLSignal method of the same name.
+	struct Op2D
+	{
+		enum Type
+		{
+			kConvolve3x3r = 0,
+			kConvolve3x3rb,
+			kPartialDiffX,
+			kPartialDiffY,
+			kVariance3x3
+		};
+		
+		Op2D(Type t, MLSample kc = 0.f, MLSample ke = 0.f, MLSample kk = 0.f) : 
+			mType(t), mKc(kc), mKe(ke), mKk(kk) {}
+		
+		Type mType;
+		MLSample mKc, mKe, mKk;
+	};
+	static const int kMaxOps2D = 8;
+	
+	// run a sequence of 3x3 operators on a 2D signal in place, in one pass down the 
+	// signal. Each stage keeps only three padded rows of its output, so intermediate 
+	// results stay in cache and no intermediate signals are written. 
+	void process2D(const Op2D* ops, const int nOps);
+
     // metrics
     float getRMS();
     float rmsDiff(const MLSignal& b);
@@ -349,6 +410,10 @@ public:
 	//
 	Vec2 correctPeak(const int ix, const int iy, const float maxCorrect) const;
 
+	// refine the positions of n peaks in place as correctPeak() does, four peaks 
+	// at a time. The z value of each peak is unchanged.
+	void correctPeaks(Vec3* pPeaks, const int n, const float maxCorrect) const;
+
 	// unary operators on Signals
 	void square();	
 	void sqrt();	
@@ -364,6 +429,11 @@ public:
 	void partialDiffY();
 	// return highest value in signal
 	Vec3 findPeak() const;
+	// find up to maxPeaks local maxima greater than threshold in one pass over a 2D signal.
+	// A local maximum is greater than the neighbors before it in scan order, and 
+	// not less than the ones after, so each plateau makes one peak. Peaks are written 
+	// to pPeaks as (x, y, z), highest first. Returns the number of peaks found.
+	int findPeaks(Vec3* pPeaks, const int maxPeaks, const float threshold) const;
     // add (blit) another 2D signal
 	void add2D(const MLSignal& b, int destX, int destY);
 	void add2D(const MLSignal& b, const Vec2& destOffset);
@@ -378,6 +448,15 @@ public:
 	float getMean() const;
 	float getMin() const;
 	float getMax() const;
+	
+	// return the largest absolute value in the signal. 
+	float getAbsMax() const;
+	
+	// divide the first samples of each row of src into points equal spans, and write 
+	// the minimum and maximum of each span into planes 0 and 1 of this signal, 
+	// resizing it to (points, rows of src, 2) if needed. points is limited to samples.
+	// Used to draw long signals at the resolution of a display.
+	void decimateMinMax(const MLSignal& src, int samples, int points);
 	void dump(std::ostream& s, int verbosity = 0) const;
 	void dump(std::ostream& s, const MLRect& b) const;
 	void dumpASCII(std::ostream& s) const;
@@ -388,10 +467,10 @@ public:
 
 	// handy shorthand for row and plane access
     // TODO looking at actual use, would look better to return dataAligned + row, plane.
- 	inline int row(int i) const { return i<<mWidthBits; }
-	inline int plane(int i) const { return i<<mWidthBits<<mHeightBits; }
-	inline int getRowStride() const { return 1<<mWidthBits; }
-	inline int getPlaneStride() const { return 1<<mWidthBits<<mHeightBits; }
+ 	inline int row(int i) const { return i*mRowStride; }
+	inline int plane(int i) const { return i*mPlaneStride; }
+	inline int getRowStride() const { return mRowStride; }
+	inline int getPlaneStride() const { return mPlaneStride; }
 	
 	// utilities for getting pointers to the aligned data as other types.
 	uint32_t* asUInt32Ptr(void) const
@@ -431,14 +510,15 @@ public:
 	static MLSignal copyWithLoopAtEnd(const MLSignal& src, int loopLength);
 
 private:
-	// private signal constructor: make a reference to a frame of the external signal.
-	MLSignal(const MLSignal* other, int frame);
-
 	MLSample* getCopy();
 
 	inline int padSize(int size) { return size + kMLAlignSize - 1 + kMLSignalEndSize; }
 	MLSample* allocateData(int size);
 	MLSample* initializeData(MLSample* pData, int size);
+	void freeData();
+	void copyInfo(const MLSignal& other);
+	void takeData(MLSignal& other);
+	inline bool ownsHeapData() const { return mData && (mData != mLocalData); }
 
 	// start of data in memory. 
 	// If this is 0, we do not own any data.  However, in the case of a
@@ -455,9 +535,17 @@ private:
 	// mask for array lookups. By setting to zero, the signal becomes a constant.
 	int mConstantMask;
 	
-	// total power-of-two size in samples, stored for fast access by clear() etc.
+	// total size of storage in samples.
 	int mSize; 
 	
+	// mask for array lookups when not constant: the largest power of two at or below mSize, minus one.
+	// For the power-of-two layout this covers all of the storage. For the packed layout it only
+	// keeps masked lookups inside the storage, so packed signals should not rely on wrapping.
+	int mIndexMask;
+	
+	// distance in samples between rows and planes.
+	int mRowStride, mPlaneStride;
+	
 	// store requested size of each dimension. For 1D signals, height is 1, etc.
 	int mWidth, mHeight, mDepth; 
 	
@@ -467,11 +555,109 @@ private:
 	// Reciprocal of sample rate in Hz.  if negative, signal is not a time series.
 	// if zero, rate is a positive one that hasn't been calculated by the DSP engine yet.
 	MLSampleRate mRate;
+	
+	// local storage for small signals, with room for alignment and the end samples.
+	static const int kLocalStorageSize = kLocalSize + kMLAlignSize/sizeof(MLSample) - 1 + 4;
+	MLSample mLocalData[kLocalStorageSize];
 };
 
 typedef std::shared_ptr<MLSignal> MLSignalPtr;
 
-float rmsDifference2D(const MLSignal& a, const MLSignal& b);
+// ----------------------------------------------------------------
+// A view of signal data that it does not own: a pointer, dimensions, 
+// strides in samples and a constant flag. Procs and utilities that only 
+// read or write samples can take a view, so that frames of a larger signal 
+// and external buffers can be used without copying. A view is valid only 
+// while its data is: resizing or destroying a signal invalidates its views.
+//
+// As with MLSignal, when a view is marked constant every index reads the 
+// first sample.
+//
+// This is not called MLSignalView because MLJuceApp/MLSignalView already 
+// names the class that draws published signals.
+
+class MLSignalRef
+{
+public:
+	MLSignalRef() : 
+		mpData(0), mWidth(0), mHeight(0), mDepth(0), mRowStride(0), mPlaneStride(0), mConstantMask(0) {}
+	
+	// make a view of external data. By default, rows and planes are packed.
+	MLSignalRef(MLSample* pData, int width, int height = 1, int depth = 1, 
+		int rowStride = 0, int planeStride = 0, bool constant = false) :
+		mpData(pData), mWidth(width), mHeight(height), mDepth(depth),
+		mRowStride(rowStride ? rowStride : width),
+		mPlaneStride(planeStride ? planeStride : (rowStride ? rowStride : width)*height),
+		mConstantMask(constant ? 0 : ~0) {}
+	
+	// a view of a whole signal.
+	MLSignalRef(const MLSignal& s) : 
+		mpData(s.getBuffer()), mWidth(s.getWidth()), mHeight(s.getHeight()), mDepth(s.getDepth()),
+		mRowStride(s.getRowStride()), mPlaneStride(s.getPlaneStride()),
+		mConstantMask(s.isConstant() ? 0 : ~0) {}
+	
+	MLSample* getBuffer() const { return mpData; }
+	int getWidth() const { return mWidth; }
+	int getHeight() const { return mHeight; }
+	int getDepth() const { return mDepth; }
+	int getRowStride() const { return mRowStride; }
+	int getPlaneStride() const { return mPlaneStride; }
+	int getSize() const { return mWidth*mHeight*mDepth; }
+	bool isConstant() const { return mConstantMask == 0; }
+	
+	inline MLSample& operator[](int i) const
+	{
+		assert(i < mRowStride*mHeight*mDepth);
+		return mpData[i & mConstantMask];
+	}
+	inline MLSample& operator()(int i, int j) const
+	{
+		assert((i < mWidth) && (j < mHeight));
+		return mpData[(j*mRowStride + i) & mConstantMask];
+	}
+	inline MLSample& operator()(int i, int j, int k) const
+	{
+		assert((i < mWidth) && (j < mHeight) && (k < mDepth));
+		return mpData[(k*mPlaneStride + j*mRowStride + i) & mConstantMask];
+	}
+	
+	// start of row j in plane k. Not meaningful for constant views.
+	inline MLSample* getRow(int j, int k = 0) const { return mpData + k*mPlaneStride + j*mRowStride; }
+	
+	// views of one row or one 2D frame of this view.
+	MLSignalRef getRowView(int j, int k = 0) const
+	{
+		return MLSignalRef(getRow(j, k), mWidth, 1, 1, mRowStride, mRowStride, isConstant());
+	}
+	MLSignalRef getFrameView(int k) const
+	{
+		return MLSignalRef(getRow(0, k), mWidth, mHeight, 1, mRowStride, mPlaneStride, isConstant());
+	}
+
+private:
+	MLSample* mpData;
+	int mWidth, mHeight, mDepth;
+	int mRowStride, mPlaneStride;
+	int mConstantMask;
+};
+
+inline MLSignalRef MLSignal::getView() const
+{
+	return MLSignalRef(*this);
+}
+
+inline MLSignalRef MLSignal::getFrame(int i) const
+{
+	return MLSignalRef(*this).getFrameView(i);
+}
+
+float rmsDifference2D(const MLSignalRef& a, const MLSignalRef& b);
+
+// match peaks in a new frame to peaks in the previous frame, closest pairs first. 
+// For each new peak, pMatches gets the index of the previous peak it continues,
+// or -1 if no unmatched previous peak is within maxDistance. 
+void associatePeaks(const Vec3* pPrev, const int nPrev, const Vec3* pNew, const int nNew, 
+	int* pMatches, const float maxDistance);
 std::ostream& operator<< (std::ostream& out, const MLSignal & r);
 
 
@@ -0,0 +1,586 @@
+//
+// dspTest
+// unit tests for DSP procs, made using the Catch framework in catch.hpp / tests.cpp.
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "../include/madronalib.h"
+
+#include "MLDSPEngine.h"
+#include "MLEngineCapture.h"
+#include "MLEngineSwap.h"
+#include "MLGraphCache.h"
+#include "MLMultProxy.h"
+#include "MLProcInputToSignals.h"
+#include "MLScale.h"
+#include "MLScaleLoader.h"
+
+namespace
+{
+	// a context for running one proc outside of an engine.
+	class TestContext : public MLDSPContext
+	{
+	public:
+		TestContext(int vectorSize, MLSampleRate rate)
+		{
+			setVectorSize(vectorSize);
+			setSampleRate(rate);
+		}
+		void setEnabled(bool t) { mEnabled = t; }
+		bool isEnabled() const { return true; }
+		bool isProcEnabled(const MLProc*) const { return true; }
+	};
+}
+
+TEST_CASE("madronalib/dsp/inputs/OSC voices", "[dsp][inputs]")
+{
+	// more voices than there are touches in a frame.
+	const int kVoices = kMLTouchFrameHeight*2;
+	const int kVectorSize = 64;
+	const int kGate = 2;
+
+	TestContext context(kVectorSize, 44100);
+	MLProcPtr pProc = MLProcFactory::theFactory().create("midi_to_signals", &context);
+	REQUIRE(pProc);
+	MLProcInputToSignals& proc = static_cast<MLProcInputToSignals&>(*pProc);
+	proc.setParam("max_voices", kVoices);
+	proc.setParam("voices", kVoices);
+	proc.setParam("protocol", kInputProtocolOSC);
+	proc.setup();
+
+	std::vector<MLSignal> outputs(kVoices*kNumVoiceSignals);
+	for(int i=0; i<(int)outputs.size(); ++i)
+	{
+		outputs[i].setDims(kVectorSize);
+		proc.setOutput(i + 1, outputs[i]);
+	}
+	REQUIRE(proc.resize() == MLProc::OK);
+	REQUIRE(proc.prepareToProcess() == MLProc::OK);
+
+	// one frame touching every row.
+	const int kFrameSize = kMLTouchFrameWidth*kMLTouchFrameHeight;
+	std::vector<float> frameData(kFrameSize*MLProcInputToSignals::kFrameBufferSize);
+	PaUtilRingBuffer frameBuf;
+	PaUtil_InitializeRingBuffer(&frameBuf, kFrameSize*sizeof(float), MLProcInputToSignals::kFrameBufferSize, &frameData[0]);
+	std::vector<float> frame(kFrameSize);
+	for(int t=0; t<kMLTouchFrameHeight; ++t)
+	{
+		frame[t*kMLTouchFrameWidth + 0] = 0.5f;
+		frame[t*kMLTouchFrameWidth + 1] = 0.5f;
+		frame[t*kMLTouchFrameWidth + 2] = 0.5f;
+		frame[t*kMLTouchFrameWidth + 3] = 60.f;
+	}
+	PaUtil_WriteRingBuffer(&frameBuf, &frame[0], 1);
+	proc.setInputFrameBuffer(&frameBuf);
+	proc.process(kVectorSize);
+
+	// voices with a touch row play, the others stay off.
+	for(int v=0; v<kVoices; ++v)
+	{
+		const MLSignal& gate = outputs[v*kNumVoiceSignals + kGate - 1];
+		REQUIRE(gate[kVectorSize - 1] == (v < kMLTouchFrameHeight ? 1.f : 0.f));
+	}
+}
+
+namespace
+{
+	// the largest difference between the table lookup and taking the log of the pitch.
+	float maxLogPitchError(const MLScale& scale)
+	{
+		float maxErr = 0.f;
+		for(float note = 0.f; note < kMLNumScaleNotes - 1; note += 0.01f)
+		{
+			const float err = fabsf(scale.noteToLogPitch(note) - log2f(scale.noteToPitch(note)));
+			maxErr = max(maxErr, err);
+		}
+		return maxErr;
+	}
+}
+
+TEST_CASE("madronalib/dsp/scale/log pitch", "[dsp][scale]")
+{
+	// 12-equal.
+	MLScale equal;
+	REQUIRE(maxLogPitchError(equal) < 1e-5f);
+	
+	// one octave per note, the widest step the table is meant for.
+	MLScale wide;
+	wide.loadFromString("one octave per note\n1\n1200.0\n");
+	REQUIRE(wide.noteToPitch(61) == Approx(wide.noteToPitch(60)*2.f));
+	REQUIRE(maxLogPitchError(wide) < 1.f/1200.f);
+}
+
+TEST_CASE("madronalib/dsp/scale/loader", "[dsp][scale]")
+{
+	// a scale file in the working directory.
+	const char* kScaleName = "scaleLoaderTest";
+	const std::string scalePath = std::string(kScaleName) + ".scl";
+	FILE* f = fopen(scalePath.c_str(), "w");
+	REQUIRE(f);
+	fputs("! scaleLoaderTest.scl\nquarter tones\n24\n", f);
+	for(int i=1; i<=24; ++i)
+	{
+		fprintf(f, "%d.0\n", i*50);
+	}
+	fclose(f);
+	MLScaleLoader::setScaleRoot(".");
+	
+	// the same path gives the same cached scale.
+	const MLScale* pDefault = MLScaleLoader::getCachedScale("");
+	const MLScale* pScale = MLScaleLoader::getCachedScale(kScaleName);
+	REQUIRE(pScale != pDefault);
+	REQUIRE(MLScaleLoader::getCachedScale(kScaleName) == pScale);
+	REQUIRE(pScale->noteToPitch(61) == Approx(pScale->noteToPitch(60)*powf(2.f, 1.f/24.f)));
+	
+	// a requested scale is published to getScale().
+	MLScaleLoader loader;
+	REQUIRE(&loader.getScale() == pDefault);
+	loader.requestScale(kScaleName);
+	const MLScale* pLoaded = &loader.getScale();
+	for(int i=0; (i < 1000) && (pLoaded == pDefault); ++i)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		pLoaded = &loader.getScale();
+	}
+	REQUIRE(pLoaded == pScale);
+	
+	MLScaleLoader::setScaleRoot("");
+	remove(scalePath.c_str());
+}
+
+namespace
+{
+	// one input through a published gain to one output.
+	const char* kGainGraph =
+		"<rootproc>"
+		"<proc class=\"param_to_sig\" name=\"gain_param\"/>"
+		"<proc class=\"multiply\" name=\"m\"/>"
+		"<connect from=\"gain_param\" output=\"out\" to=\"m\" input=\"in2\"/>"
+		"<input proc=\"m\" input=\"in1\" alias=\"in\"/>"
+		"<output proc=\"m\" output=\"out\" alias=\"out\"/>"
+		"<param proc=\"gain_param\" param=\"in\" alias=\"gain\">"
+		"<range low=\"0\" high=\"1\" interval=\"0.01\"/><default value=\"0.5\"/>"
+		"</param>"
+		"</rootproc>";
+}
+
+TEST_CASE("madronalib/dsp/engine/capture", "[dsp][capture]")
+{
+	const double kRate = 44100.;
+	const int kBufferSize = 256;
+	const int kVectorSize = 64;
+	const int kBlocks = 40;
+	const char* kCapturePath = "engineCaptureTest.mlic";
+	
+	MLGraphDesc desc;
+	REQUIRE(desc.parseXML(kGainGraph));
+	
+	MLDSPEngine engine;
+	engine.setInputChannels(1);
+	engine.setOutputChannels(1);
+	REQUIRE(engine.buildGraphAndInputs(desc, true, true) == MLProc::OK);
+	engine.compileEngine(kRate, kVectorSize);
+	REQUIRE(engine.prepareEngine(kRate, kBufferSize, kVectorSize) == MLProc::OK);
+	engine.setEnabled(true);
+	const int gainIdx = engine.getParamIndex("gain");
+	REQUIRE(gainIdx >= 0);
+	
+	MLEngineCapture capture;
+	REQUIRE(capture.start(kCapturePath, engine));
+	engine.setInputCapture(&capture);
+	
+	// the input and output share one buffer, as they do in JUCE.
+	std::vector<float> buf(kBufferSize);
+	MLDSPEngine::ClientIOMap ioMap;
+	memset(&ioMap, 0, sizeof(ioMap));
+	ioMap.inputs[0] = &buf[0];
+	ioMap.outputs[0] = &buf[0];
+	engine.setIOBuffers(ioMap);
+	
+	MLControlEventVector events;
+	MLProcContainer* pContainer = &engine;
+	int64_t pos = 0;
+	for(int b=0; b<kBlocks; ++b)
+	{
+		for(int i=0; i<kBufferSize; ++i)
+		{
+			buf[i] = sinf((float)(pos + i)*0.05f);
+		}
+		
+		// change the gain between blocks, sometimes through the base class.
+		if(b == 10)
+		{
+			engine.setPublishedParam(gainIdx, MLProperty(0.25f));
+		}
+		if(b == 20)
+		{
+			pContainer->setPublishedParam(gainIdx, MLProperty(0.75f));
+		}
+		engine.processSignalsAndEvents(kBufferSize, events, pos, pos/kRate, 0., 120., false);
+		pos += kBufferSize;
+	}
+	
+	engine.setInputCapture(0);
+	capture.stop();
+	REQUIRE(!capture.didOverflow());
+	REQUIRE(capture.getBlocks() == kBlocks);
+	
+	// the replay gets the same inputs and params, and makes the same outputs.
+	MLEngineReplay replay;
+	REQUIRE(replay.load(kCapturePath));
+	MLDSPEngine replayEngine;
+	REQUIRE(replay.setupEngine(replayEngine, desc) == MLProc::OK);
+	MLEngineReplay::Result r = replay.run(replayEngine);
+	REQUIRE(r.mBlocks == kBlocks);
+	REQUIRE(r.mMismatches == 0);
+	REQUIRE(r.mLateParams == 0);
+	
+	remove(kCapturePath);
+}
+
+namespace
+{
+	MLDSPEngine* makeGainEngine(const MLGraphDesc& desc, double rate, int bufSize, int vecSize)
+	{
+		MLDSPEngine* pEngine = new MLDSPEngine;
+		pEngine->setInputChannels(1);
+		pEngine->setOutputChannels(1);
+		pEngine->buildGraphAndInputs(desc, true, true);
+		pEngine->compileEngine(rate, vecSize);
+		pEngine->prepareEngine(rate, bufSize, vecSize);
+		pEngine->setEnabled(true);
+		return pEngine;
+	}
+}
+
+TEST_CASE("madronalib/dsp/engine/swap", "[dsp][swap]")
+{
+	const double kRate = 44100.;
+	const int kBufferSize = 256;
+	const int kVectorSize = 64;
+	
+	MLGraphDesc desc;
+	REQUIRE(desc.parseXML(kGainGraph));
+	
+	MLEngineSwap swap;
+	MLDSPEngine* pEngine = makeGainEngine(desc, kRate, kBufferSize, kVectorSize);
+	swap.reset(pEngine);
+	REQUIRE(!swap.isBusy());
+	
+	// with no audio running, a committed engine waits without blocking another build,
+	// and committing again replaces it.
+	REQUIRE(swap.startBuild([&]() { return makeGainEngine(desc, kRate, kBufferSize, kVectorSize); }));
+	MLDSPEngine* pNext = 0;
+	for(int i=0; (i < 1000) && !pNext; ++i)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		pNext = swap.takeReadyEngine();
+	}
+	REQUIRE(pNext);
+	REQUIRE(swap.commit(pNext));
+	REQUIRE(swap.isSwapping());
+	REQUIRE(!swap.isBusy());
+	MLDSPEngine* pLast = makeGainEngine(desc, kRate, kBufferSize, kVectorSize);
+	REQUIRE(swap.commit(pLast));
+	
+	// the audio thread picks up the last engine and fades to it.
+	std::vector<float> buf(kBufferSize);
+	MLDSPEngine::ClientIOMap ioMap;
+	memset(&ioMap, 0, sizeof(ioMap));
+	ioMap.inputs[0] = &buf[0];
+	ioMap.outputs[0] = &buf[0];
+	MLControlEventVector events;
+	REQUIRE(swap.getAudioEngine() == pLast);
+	REQUIRE(swap.isBusy());
+	const int fadeBlocks = (int)(kRate*MLEngineSwap::kFadeTime)/kBufferSize + 1;
+	for(int b=0; b<=fadeBlocks; ++b)
+	{
+		swap.getAudioEngine();
+		std::fill(buf.begin(), buf.end(), 1.f);
+		swap.process(kBufferSize, events, 0, 0., 0., 120., false, ioMap, 1);
+	}
+	
+	// no new engine can be committed until the old one is collected.
+	MLDSPEngine* pExtra = makeGainEngine(desc, kRate, kBufferSize, kVectorSize);
+	REQUIRE(!swap.commit(pExtra));
+	REQUIRE(swap.takeReadyEngine() == pExtra);
+	delete pExtra;
+	swap.collect();
+	REQUIRE(!swap.isSwapping());
+	REQUIRE(!swap.isBusy());
+	
+	swap.reset(pLast);
+	delete pLast;
+}
+
+namespace
+{
+	// an envelope proc outside of an engine, with its own input signals.
+	class TestEnvelope
+	{
+	public:
+		static const int kInputs = 8;
+		
+		TestEnvelope(MLDSPContext& context, int vectorSize, bool constantParams)
+		{
+			mpProc = MLProcFactory::theFactory().create("envelope", &context);
+			mpProc->resizeInputs(kInputs);
+			for(int i=0; i<kInputs; ++i)
+			{
+				mInputs[i].setDims(vectorSize);
+				mpProc->setInput(i + 1, mInputs[i]);
+			}
+			mOutput.setDims(vectorSize);
+			mpProc->setOutput(1, mOutput);
+			mpProc->clear();
+			mConstantParams = constantParams;
+		}
+		
+		// set input 2 through 8: delay, attack, decay, sustain, release, repeat, vel.
+		void setParams(const float* params)
+		{
+			for(int i=1; i<kInputs; ++i)
+			{
+				if(mConstantParams)
+				{
+					mInputs[i].setToConstant(params[i - 1]);
+				}
+				else
+				{
+					mInputs[i].fill(params[i - 1]);
+					mInputs[i].setConstant(false);
+				}
+			}
+		}
+		
+		const MLSignal& process(float gate)
+		{
+			mInputs[0].fill(gate);
+			mInputs[0].setConstant(false);
+			mpProc->process(mOutput.getWidth());
+			return mOutput;
+		}
+		
+	private:
+		MLProcPtr mpProc;
+		MLSignal mInputs[kInputs];
+		MLSignal mOutput;
+		bool mConstantParams;
+	};
+}
+
+TEST_CASE("madronalib/dsp/envelope/segments", "[dsp][envelope]")
+{
+	// with constant params the envelope renders in segments, otherwise sample by sample.
+	// Both must make the same output, including the timing of repeats.
+	const int kVectorSize = 64;
+	const float kRate = 44100.f;
+	const float kRepeat = 0.1f;
+	const float params[7] = {0.f, 0.01f, 0.02f, 0.f, 0.05f, kRepeat, 1.f};
+	
+	TestContext context(kVectorSize, kRate);
+	TestEnvelope segments(context, kVectorSize, true);
+	TestEnvelope samples(context, kVectorSize, false);
+	segments.setParams(params);
+	samples.setParams(params);
+	
+	// gate on for a number of repeats, then off for the release.
+	const int kOnBlocks = 1000;
+	const int kBlocks = kOnBlocks + 200;
+	float maxDiff = 0.f;
+	std::vector<int> peaks;
+	float y1 = 0.f;
+	for(int b=0; b<kBlocks; ++b)
+	{
+		const float gate = (b < kOnBlocks) ? 1.f : 0.f;
+		const MLSignal& ya = segments.process(gate);
+		const MLSignal& yb = samples.process(gate);
+		for(int n=0; n<kVectorSize; ++n)
+		{
+			maxDiff = max(maxDiff, fabsf(ya[n] - yb[n]));
+			
+			// the start of each attack, when the output rises past half of its peak.
+			if((y1 < 1.f) && (ya[n] >= 1.f))
+			{
+				peaks.push_back(b*kVectorSize + n);
+			}
+			y1 = ya[n];
+		}
+	}
+	REQUIRE(maxDiff < 1e-3f);
+	
+	// a repeat starts every (kRate*kRepeat) + 1 samples: the counter starts the sample 
+	// after it reaches its threshold.
+	REQUIRE(peaks.size() > 4);
+	for(int i=1; i<(int)peaks.size(); ++i)
+	{
+		REQUIRE(peaks[i] - peaks[i - 1] == (int)(kRate*kRepeat) + 1);
+	}
+}
+
+namespace
+{
+	// two voices, each an envelope on its gate.
+	const char* kVoicesGraph =
+		"<rootproc>"
+		"<proc class=\"multiple\" name=\"voices\" copies=\"2\" enable=\"2\">"
+		"<proc class=\"container\" name=\"voice\">"
+		"<proc class=\"param_to_sig\" name=\"attack\" in=\"0.01\"/>"
+		"<proc class=\"param_to_sig\" name=\"sustain\" in=\"1\"/>"
+		"<proc class=\"param_to_sig\" name=\"release\" in=\"0.01\"/>"
+		"<proc class=\"param_to_sig\" name=\"vel\" in=\"1\"/>"
+		"<proc class=\"envelope\" name=\"env\"/>"
+		"<connect from=\"attack\" output=\"out\" to=\"env\" input=\"attack\"/>"
+		"<connect from=\"sustain\" output=\"out\" to=\"env\" input=\"sustain\"/>"
+		"<connect from=\"release\" output=\"out\" to=\"env\" input=\"release\"/>"
+		"<connect from=\"vel\" output=\"out\" to=\"env\" input=\"vel\"/>"
+		"<input proc=\"env\" input=\"in\" alias=\"gate\"/>"
+		"<output proc=\"env\" output=\"out\" alias=\"out\"/>"
+		"</proc>"
+		"<input proc=\"voice\" copy=\"1\" input=\"gate\" alias=\"gate1\"/>"
+		"<input proc=\"voice\" copy=\"2\" input=\"gate\" alias=\"gate2\"/>"
+		"<output proc=\"voice\" output=\"out\" alias=\"out\"/>"
+		"</proc>"
+		"<connect from=\"the_midi_inputs\" output=\"gate1\" to=\"voices\" input=\"gate1\"/>"
+		"<connect from=\"the_midi_inputs\" output=\"gate2\" to=\"voices\" input=\"gate2\"/>"
+		"<output proc=\"voices\" output=\"out\" alias=\"out\"/>"
+		"</rootproc>";
+	
+	MLDSPEngine* makeVoicesEngine(const MLGraphDesc& desc, double rate, int bufSize, int vecSize, float sleepTime)
+	{
+		MLDSPEngine* pEngine = new MLDSPEngine;
+		pEngine->setInputChannels(0);
+		pEngine->setOutputChannels(1);
+		pEngine->setMaxVoices(2);
+		pEngine->setVoiceSleepTime(sleepTime);
+		pEngine->buildGraphAndInputs(desc, false, true);
+		pEngine->compileEngine(rate, vecSize);
+		pEngine->prepareEngine(rate, bufSize, vecSize);
+		pEngine->setEnabled(true);
+		return pEngine;
+	}
+}
+
+TEST_CASE("madronalib/dsp/engine/voice sleep", "[dsp][sleep]")
+{
+	// a voice that has been silent for the sleep time sleeps, and wakes on the next
+	// note to make the same output as a voice that never slept.
+	const double kRate = 44100.;
+	const int kBufferSize = 256;
+	const int kVectorSize = 64;
+	const int kBlocks = 300;
+	const int kSecondNote = 200;
+	
+	MLGraphDesc desc;
+	REQUIRE(desc.parseXML(kVoicesGraph));
+	std::unique_ptr<MLDSPEngine> pSleeper(makeVoicesEngine(desc, kRate, kBufferSize, kVectorSize, 0.05f));
+	std::unique_ptr<MLDSPEngine> pWaker(makeVoicesEngine(desc, kRate, kBufferSize, kVectorSize, 0.f));
+	MLMultiContainer* pVoices = dynamic_cast<MLMultiContainer*>(pSleeper->getProc(MLPath("voices/voice")).get());
+	REQUIRE(pVoices);
+	
+	std::vector<float> sleeperOut(kBufferSize), wakerOut(kBufferSize);
+	MLDSPEngine::ClientIOMap ioMap;
+	memset(&ioMap, 0, sizeof(ioMap));
+	ioMap.outputs[0] = &sleeperOut[0];
+	pSleeper->setIOBuffers(ioMap);
+	ioMap.outputs[0] = &wakerOut[0];
+	pWaker->setIOBuffers(ioMap);
+	
+	MLSignal out(kBufferSize);
+	float maxDiff = 0.f;
+	float maxOut = 0.f;
+	bool slept = false;
+	int64_t pos = 0;
+	for(int b=0; b<kBlocks; ++b)
+	{
+		// play a note for 20 blocks at the start and again after the voices sleep.
+		MLControlEventVector events;
+		if((b == 0) || (b == kSecondNote))
+		{
+			events.push_back(MLControlEvent(MLControlEvent::kNoteOn, 1, b + 1, 10, 60.f, 1.f));
+		}
+		if((b == 20) || (b == kSecondNote + 20))
+		{
+			events.push_back(MLControlEvent(MLControlEvent::kNoteOff, 1, b - 19, 10, 60.f, 0.f));
+		}
+		pSleeper->processSignalsAndEvents(kBufferSize, events, pos, pos/kRate, 0., 120., false);
+		pWaker->processSignalsAndEvents(kBufferSize, events, pos, pos/kRate, 0., 120., false);
+		pos += kBufferSize;
+		
+		for(int n=0; n<kBufferSize; ++n)
+		{
+			maxDiff = max(maxDiff, fabsf(sleeperOut[n] - wakerOut[n]));
+			out[n] = sleeperOut[n];
+		}
+		out.setConstant(false);
+		maxOut = max(maxOut, out.getAbsMax());
+		
+		if(b == kSecondNote - 1)
+		{
+			// a sleeping voice makes no output at all.
+			slept = !pVoices->isCopyAwake(0) && !pVoices->isCopyAwake(1);
+			REQUIRE(out.getAbsMax() == 0.f);
+		}
+		if(b == kSecondNote + 1)
+		{
+			REQUIRE((pVoices->isCopyAwake(0) || pVoices->isCopyAwake(1)));
+		}
+	}
+	REQUIRE(slept);
+	REQUIRE(maxOut > 0.5f);
+	REQUIRE(maxDiff <= MLMultiContainer::kSleepThreshold);
+}
+
+TEST_CASE("madronalib/dsp/graph cache", "[dsp][cache]")
+{
+	MLGraphCache cache;
+	
+	// descriptions in use are kept, and unused ones are dropped past the limit.
+	std::shared_ptr<const MLGraphDesc> pKept = cache.getDescription(kGainGraph);
+	REQUIRE(pKept->getRoot());
+	std::weak_ptr<const MLGraphDesc> dropped;
+	for(int i=0; i<=MLGraphCache::kMaxDescriptions; ++i)
+	{
+		char text[128];
+		snprintf(text, sizeof(text), "<rootproc><proc class=\"multiply\" name=\"m%d\"/></rootproc>", i);
+		std::shared_ptr<const MLGraphDesc> pDesc = cache.getDescription(text);
+		REQUIRE(pDesc->getRoot());
+		if(i == 0)
+		{
+			dropped = pDesc;
+		}
+	}
+	REQUIRE(dropped.expired());
+	REQUIRE(cache.getDescription(kGainGraph) == pKept);
+	
+	// compiled graphs are saved whole and read back by a new cache.
+	const uint64_t key = MLGraphCache::makeKey(pKept->getHash(), 44100., 64, 8);
+	std::shared_ptr<MLCompiledGraph> pGraph(new MLCompiledGraph(key));
+	MLCompiledGraph::Container c;
+	c.mProcs = 2;
+	c.mPipes = 1;
+	c.mSignals.push_back("gain_param_out");
+	c.mBuffers.push_back(3);
+	pGraph->addContainer(c);
+	cache.setDirectory(".");
+	cache.addGraph(pGraph);
+	
+	MLGraphCache cache2;
+	cache2.setDirectory(".");
+	MLCompiledGraphPtr pRead = cache2.findGraph(key);
+	REQUIRE(pRead);
+	REQUIRE(pRead->getNumContainers() == 1);
+	REQUIRE(pRead->getContainer(0).mSignals[0] == "gain_param_out");
+	REQUIRE(pRead->getContainer(0).mBuffers[0] == 3);
+	
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.mlgraph", (unsigned long long)key);
+	REQUIRE(remove(name) == 0);
+}
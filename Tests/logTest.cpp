@@ -0,0 +1,86 @@
+//
+//  logTest.cpp
+//  madronalib
+//
+//  unit tests for the realtime log.
+//
+
+#include <sstream>
+#include <string>
+
+#include "catch.hpp"
+#include "../include/madronalib.h"
+
+#include "MLRealtimeLog.h"
+
+TEST_CASE("madronalib/core/log/format", "[log]")
+{
+	MLRealtimeLog log;
+	std::ostringstream out;
+	
+	// records come out in order, formatted by the stored type of each argument.
+	log.post(kMLLogInfo, "%d + %d = %d\n", 2, 2, 4);
+	log.post(kMLLogInfo, "%.2f %5.1f%%\n", 0.25, 2.f);
+	log.post(kMLLogInfo, "int as float: %f, float as int: %d\n", 3, 1.5f);
+	log.post(kMLLogInfo, "missing: %d\n");
+	log.write(out);
+	REQUIRE(out.str() == "2 + 2 = 4\n0.25   2.0%\nint as float: 3.000000, float as int: 1.5\nmissing: (missing)\n");
+	
+	// nothing left to write.
+	out.str("");
+	log.write(out);
+	REQUIRE(out.str() == "");
+}
+
+TEST_CASE("madronalib/core/log/strings", "[log]")
+{
+	MLRealtimeLog log;
+	std::ostringstream out;
+	
+	// strings are copied when posted, so changing them afterwards is fine.
+	std::string name("first");
+	log.post(kMLLogInfo, "%s, %s", name.c_str(), "second");
+	name = "changed";
+	log.write(out);
+	REQUIRE(out.str() == "first, second");
+	
+	// strings past the record's text are cut short.
+	out.str("");
+	std::string longName(MLLogRecord::kTextSize*2, 'x');
+	log.post(kMLLogInfo, "%s|%s|", longName.c_str(), "after");
+	log.write(out);
+	REQUIRE(out.str() == std::string(MLLogRecord::kTextSize - 1, 'x') + "||");
+}
+
+TEST_CASE("madronalib/core/log/full", "[log]")
+{
+	MLRealtimeLog log;
+	std::ostringstream out;
+	
+	// records past the size of the ring are dropped and counted.
+	for(int i=0; i<MLRealtimeLog::kRecords + 3; ++i)
+	{
+		log.post(kMLLogInfo, "");
+	}
+	log.write(out);
+	REQUIRE(out.str() == "MLRealtimeLog: 3 records dropped!\n");
+}
+
+TEST_CASE("madronalib/core/log/thread", "[log]")
+{
+	// the writer thread runs from the first start() to the last stop(), and
+	// shutdown() stops it no matter how many starts there were, writing any
+	// waiting records on the way.
+	MLRealtimeLog log;
+	std::ostringstream out;
+	log.start();
+	log.start();
+	log.stop();
+	log.post(kMLLogInfo, "");
+	log.shutdown();
+	log.write(out);
+	REQUIRE(out.str() == "");
+	log.stop();
+	log.start();
+	log.shutdown();
+}
@@ -0,0 +1,105 @@
+//
+//  oscTest.cpp
+//  madronalib
+//
+//  unit tests for OSC address matching.
+//
+
+#include "catch.hpp"
+#include "../include/madronalib.h"
+
+#include "MLOSCDispatch.h"
+
+namespace
+{
+	enum
+	{
+		kFrameAddr = 0,
+		kTouchAddr,
+		kDataRateAddr,
+		kProgramAddr
+	};
+	
+	// the addresses MLT3DHub listens to.
+	void addT3DAddresses(MLOSCDispatch& d)
+	{
+		d.addAddress("/t3d/frm", kFrameAddr);
+		d.addAddress("/t3d/tch", kTouchAddr, true);
+		d.addAddress("/t3d/dr", kDataRateAddr);
+		d.addAddress("/pgm", kProgramAddr);
+	}
+}
+
+TEST_CASE("madronalib/osc/dispatch/exact", "[osc]")
+{
+	MLOSCDispatch d;
+	addT3DAddresses(d);
+	
+	int number = -1;
+	REQUIRE(d.match("/t3d/frm", &number) == kFrameAddr);
+	REQUIRE(number == 0);
+	REQUIRE(d.match("/t3d/dr") == kDataRateAddr);
+	REQUIRE(d.match("/pgm") == kProgramAddr);
+	
+	// after clear() nothing matches.
+	d.clear();
+	REQUIRE(d.match("/t3d/frm") == MLOSCDispatch::kNoMatch);
+	REQUIRE(d.match("") == MLOSCDispatch::kNoMatch);
+}
+
+TEST_CASE("madronalib/osc/dispatch/numbers", "[osc]")
+{
+	MLOSCDispatch d;
+	addT3DAddresses(d);
+	
+	// with no number the touch number is 0, which MLT3DHub reads as touch 1.
+	int number = -1;
+	REQUIRE(d.match("/t3d/tch", &number) == kTouchAddr);
+	REQUIRE(number == 0);
+	
+	// one or more digits.
+	REQUIRE(d.match("/t3d/tch3", &number) == kTouchAddr);
+	REQUIRE(number == 3);
+	REQUIRE(d.match("/t3d/tch12", &number) == kTouchAddr);
+	REQUIRE(number == 12);
+	REQUIRE(d.match("/t3d/tch0107", &number) == kTouchAddr);
+	REQUIRE(number == 107);
+	
+	// the number is optional to ask for.
+	REQUIRE(d.match("/t3d/tch4") == kTouchAddr);
+	
+	// anything else after a numbered address does not match.
+	REQUIRE(d.match("/t3d/tchx") == MLOSCDispatch::kNoMatch);
+	REQUIRE(d.match("/t3d/tch3a") == MLOSCDispatch::kNoMatch);
+	REQUIRE(d.match("/t3d/tch-1") == MLOSCDispatch::kNoMatch);
+	REQUIRE(d.match("/t3d/tch/1") == MLOSCDispatch::kNoMatch);
+	
+	// addresses not added as numbered take no number.
+	REQUIRE(d.match("/t3d/frm2") == MLOSCDispatch::kNoMatch);
+	REQUIRE(d.match("/pgm1") == MLOSCDispatch::kNoMatch);
+}
+
+TEST_CASE("madronalib/osc/dispatch/prefixes", "[osc]")
+{
+	MLOSCDispatch d;
+	addT3DAddresses(d);
+	
+	// a prefix of an address is not a match.
+	REQUIRE(d.match("") == MLOSCDispatch::kNoMatch);
+	REQUIRE(d.match("/") == MLOSCDispatch::kNoMatch);
+	REQUIRE(d.match("/t3d") == MLOSCDispatch::kNoMatch);
+	REQUIRE(d.match("/t3d/") == MLOSCDispatch::kNoMatch);
+	REQUIRE(d.match("/t3d/tc") == MLOSCDispatch::kNoMatch);
+	REQUIRE(d.match("/t3d/d") == MLOSCDispatch::kNoMatch);
+	
+	// nor is an address that goes on past one.
+	REQUIRE(d.match("/t3d/frmx") == MLOSCDispatch::kNoMatch);
+	REQUIRE(d.match("/t3d/drx") == MLOSCDispatch::kNoMatch);
+	REQUIRE(d.match("/pgm/") == MLOSCDispatch::kNoMatch);
+	
+	// an address that is a prefix of another still matches on its own.
+	d.addAddress("/t3d", kProgramAddr + 1);
+	REQUIRE(d.match("/t3d") == kProgramAddr + 1);
+	REQUIRE(d.match("/t3d/frm") == kFrameAddr);
+	REQUIRE(d.match("/t3d/") == MLOSCDispatch::kNoMatch);
+}
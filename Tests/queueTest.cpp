@@ -0,0 +1,132 @@
+//
+//  queueTest.cpp
+//  madronalib
+//
+//  unit tests for the lock-free queues.
+//
+
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "../include/madronalib.h"
+
+#include "MLMPSCQueue.h"
+#include "MLParamQueue.h"
+
+TEST_CASE("madronalib/core/queue/single", "[queue]")
+{
+	MLMPSCQueue<int, 8> q;
+	int v;
+	REQUIRE(!q.pop(v));
+	
+	// fills to its size, then drops and counts.
+	for(int i=0; i<8; ++i)
+	{
+		REQUIRE(q.push(i));
+	}
+	REQUIRE(!q.push(8));
+	REQUIRE(!q.push(9));
+	REQUIRE(q.getDropped() == 2);
+	REQUIRE(q.getDropped() == 0);
+	
+	// values come out in order, and the queue can be reused after wrapping.
+	for(int i=0; i<8; ++i)
+	{
+		REQUIRE(q.pop(v));
+		REQUIRE(v == i);
+	}
+	REQUIRE(!q.pop(v));
+	REQUIRE(q.push(10));
+	REQUIRE(q.pop(v));
+	REQUIRE(v == 10);
+}
+
+TEST_CASE("madronalib/core/queue/multiple producers", "[queue]")
+{
+	const int kProducers = 4;
+	const int kValuesEach = 50000;
+	MLMPSCQueue<int, 1024> q;
+	
+	// each producer pushes its index and a count, retrying while the queue is full.
+	std::vector<std::thread> producers;
+	for(int p=0; p<kProducers; ++p)
+	{
+		producers.push_back(std::thread([&q, p, kValuesEach]()
+		{
+			for(int i=0; i<kValuesEach; ++i)
+			{
+				while(!q.push(p*kValuesEach + i))
+				{
+					std::this_thread::yield();
+				}
+			}
+		}));
+	}
+	
+	// every value arrives once, and each producer's values arrive in order.
+	std::vector<int> nextFrom(kProducers, 0);
+	int received = 0;
+	bool inOrder = true;
+	while(received < kProducers*kValuesEach)
+	{
+		int v;
+		if(q.pop(v))
+		{
+			const int p = v/kValuesEach;
+			if((p < 0) || (p >= kProducers) || (v%kValuesEach != nextFrom[p]))
+			{
+				inOrder = false;
+				break;
+			}
+			nextFrom[p]++;
+			received++;
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+	for(auto& t : producers)
+	{
+		t.join();
+	}
+	REQUIRE(inOrder);
+	REQUIRE(received == kProducers*kValuesEach);
+	int v;
+	REQUIRE(!q.pop(v));
+}
+
+TEST_CASE("madronalib/core/queue/param pacing", "[queue]")
+{
+	MLParamQueue q;
+	q.push(1, 0.1f);
+	q.push(1, 0.2f);
+	q.push(2, 0.5f);
+	q.push(1, 0.3f);
+	
+	// one value per param per block, in the order they were pushed.
+	std::vector<MLParamChange> sent;
+	std::vector<int> blockSizes;
+	for(int b=0; b<4; ++b)
+	{
+		MLParamChange c;
+		int n = 0;
+		q.beginBlock();
+		while(q.popForBlock(c))
+		{
+			sent.push_back(c);
+			n++;
+		}
+		blockSizes.push_back(n);
+	}
+	REQUIRE(blockSizes[0] == 1);
+	REQUIRE(blockSizes[1] == 2);
+	REQUIRE(blockSizes[2] == 1);
+	REQUIRE(blockSizes[3] == 0);
+	REQUIRE(sent.size() == 4);
+	REQUIRE(sent[0].mValue == 0.1f);
+	REQUIRE(sent[1].mValue == 0.2f);
+	REQUIRE(sent[2].mIndex == 2);
+	REQUIRE(sent[3].mValue == 0.3f);
+}
@@ -6,9 +6,16 @@
 //
 //
 
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
 #include "catch.hpp"
 #include "../include/madronalib.h"
 
+#include "MLSignalRecorder.h"
+
 TEST_CASE("madronalib/core/signal/creation", "[signal][creation]")
 {
 	// signal comparisons are by value
@@ -41,3 +48,742 @@ TEST_CASE("madronalib/core/signal/creation", "[signal][creation]")
 	std::cout << "MLSignal sum: " << sum  << "\n";
 }
 
+
+TEST_CASE("madronalib/core/signal/sum", "[signal][sum]")
+{
+	const int testSize(67);
+	MLSignal a(testSize), b(testSize), c(testSize), y(testSize);
+	for(int i=0; i<testSize; ++i)
+	{
+		a[i] = i;
+		b[i] = 2*i;
+	}
+	c.setToConstant(0.5f);
+	
+	// sum of variable and constant inputs
+	const MLSignal* inputs[3] = {&a, &b, &c};
+	y.setToSum(inputs, 3);
+	REQUIRE(!y.isConstant());
+	for(int i=0; i<testSize; ++i)
+	{
+		REQUIRE(y[i] == 3*i + 0.5f);
+	}
+
+	// output may also be an input
+	const MLSignal* inputsWithY[2] = {&y, &a};
+	y.setToSum(inputsWithY, 2);
+	REQUIRE(y[testSize - 1] == 4*(testSize - 1) + 0.5f);
+
+	// all constant inputs give a constant output
+	const MLSignal* constInputs[2] = {&c, &c};
+	y.setToSum(constInputs, 2);
+	REQUIRE(y.isConstant());
+	REQUIRE(y[0] == 1.f);
+}
+
+// reference 3x3 operators on 2D signals, reading neighbors with explicit edge checks.
+namespace
+{
+	float neighbor(const MLSignal& s, int i, int j, bool duplicate)
+	{
+		if(duplicate)
+		{
+			i = clamp(i, 0, s.getWidth() - 1);
+			j = clamp(j, 0, s.getHeight() - 1);
+		}
+		else if((i < 0) || (i >= s.getWidth()) || (j < 0) || (j >= s.getHeight()))
+		{
+			return 0.f;
+		}
+		return s(i, j);
+	}
+
+	MLSignal refConvolve3x3(const MLSignal& s, float kc, float ke, float kk, bool duplicate)
+	{
+		MLSignal y(s);
+		for(int j=0; j<s.getHeight(); ++j)
+		{
+			for(int i=0; i<s.getWidth(); ++i)
+			{
+				float e = neighbor(s, i - 1, j, duplicate) + neighbor(s, i + 1, j, duplicate) 
+					+ neighbor(s, i, j - 1, duplicate) + neighbor(s, i, j + 1, duplicate);
+				float k = neighbor(s, i - 1, j - 1, duplicate) + neighbor(s, i + 1, j - 1, duplicate) 
+					+ neighbor(s, i - 1, j + 1, duplicate) + neighbor(s, i + 1, j + 1, duplicate);
+				y(i, j) = kc*s(i, j) + ke*e + kk*k;
+			}
+		}
+		return y;
+	}
+
+	MLSignal refVariance3x3(const MLSignal& s)
+	{
+		MLSignal y(s);
+		for(int j=0; j<s.getHeight(); ++j)
+		{
+			for(int i=0; i<s.getWidth(); ++i)
+			{
+				float sum = 0.f;
+				int n = 0;
+				for(int dj=-1; dj<=1; ++dj)
+				{
+					for(int di=-1; di<=1; ++di)
+					{
+						int ii = i + di;
+						int jj = j + dj;
+						if((di || dj) && within(ii, 0, s.getWidth()) && within(jj, 0, s.getHeight()))
+						{
+							float d = s(ii, jj) - s(i, j);
+							sum += d*d;
+							n++;
+						}
+					}
+				}
+				y(i, j) = sqrtf(sum/n);
+			}
+		}
+		return y;
+	}
+
+	MLSignal refPartialDiff(const MLSignal& s, bool inX)
+	{
+		MLSignal y(s);
+		for(int j=0; j<s.getHeight(); ++j)
+		{
+			for(int i=0; i<s.getWidth(); ++i)
+			{
+				y(i, j) = inX ? (neighbor(s, i + 1, j, false) - neighbor(s, i - 1, j, false))*0.5f
+					: (neighbor(s, i, j + 1, false) - neighbor(s, i, j - 1, false))*0.5f;
+			}
+		}
+		return y;
+	}
+
+	void makeTestFrame(MLSignal& s)
+	{
+		for(int j=0; j<s.getHeight(); ++j)
+		{
+			for(int i=0; i<s.getWidth(); ++i)
+			{
+				s(i, j) = sinf(i*0.7f + j*1.3f) + 0.1f*((i*7 + j*13) % 5);
+			}
+		}
+	}
+
+	float maxDiff(const MLSignal& a, const MLSignal& b)
+	{
+		float d = 0.f;
+		for(int j=0; j<a.getHeight(); ++j)
+		{
+			for(int i=0; i<a.getWidth(); ++i)
+			{
+				d = max(d, fabsf(a(i, j) - b(i, j)));
+			}
+		}
+		return d;
+	}
+}
+
+TEST_CASE("madronalib/core/signal/2D", "[signal][2D]")
+{
+	const float kc = 4.f/16.f, ke = 2.f/16.f, kk = 1.f/16.f;
+	const float epsilon = 0.0001f;
+	
+	// sizes that are not multiples of the SIMD vector size test the row ends.
+	const int sizes[3][2] = {{13, 7}, {8, 2}, {64, 8}};
+	for(auto& size : sizes)
+	{
+		MLSignal frame(size[0], size[1]);
+		makeTestFrame(frame);
+		
+		MLSignal a(frame);
+		a.convolve3x3r(kc, ke, kk);
+		REQUIRE(maxDiff(a, refConvolve3x3(frame, kc, ke, kk, false)) < epsilon);
+		
+		MLSignal b(frame);
+		b.convolve3x3rb(kc, ke, kk);
+		REQUIRE(maxDiff(b, refConvolve3x3(frame, kc, ke, kk, true)) < epsilon);
+
+		MLSignal c(frame);
+		c.variance3x3();
+		REQUIRE(maxDiff(c, refVariance3x3(frame)) < epsilon);
+		
+		MLSignal dx(frame), dy(frame);
+		dx.partialDiffX();
+		dy.partialDiffY();
+		REQUIRE(maxDiff(dx, refPartialDiff(frame, true)) < epsilon);
+		REQUIRE(maxDiff(dy, refPartialDiff(frame, false)) < epsilon);
+		
+		// a fused pipeline gives the same result as the operators in sequence.
+		MLSignal seq(frame), fused(frame);
+		seq.convolve3x3rb(kc, ke, kk);
+		seq.partialDiffX();
+		seq.variance3x3();
+		MLSignal::Op2D ops[3] = 
+		{
+			MLSignal::Op2D(MLSignal::Op2D::kConvolve3x3rb, kc, ke, kk),
+			MLSignal::Op2D(MLSignal::Op2D::kPartialDiffX),
+			MLSignal::Op2D(MLSignal::Op2D::kVariance3x3)
+		};
+		fused.process2D(ops, 3);
+		REQUIRE(maxDiff(seq, fused) == 0.f);
+	}
+	
+	// flip
+	MLSignal f(5, 5);
+	makeTestFrame(f);
+	MLSignal g(f);
+	g.flipVertical();
+	REQUIRE(g(3, 0) == f(3, 4));
+	REQUIRE(g(3, 1) == f(3, 3));
+	REQUIRE(g(3, 2) == f(3, 2));
+	
+	SECTION("2D benchmark")
+	{
+		// touch frames at sensor size and at an interpolated size.
+		const int benchSizes[2][2] = {{64, 8}, {256, 64}};
+		for(auto& size : benchSizes)
+		{
+			const int kFrames = (64*8*20000) / (size[0]*size[1]);
+			MLSignal frame(size[0], size[1]);
+			makeTestFrame(frame);
+			MLSignal work(frame);
+			std::chrono::time_point<std::chrono::system_clock> start, end;
+			std::chrono::duration<double> elapsed;
+			
+			start = std::chrono::system_clock::now();
+			for(int n=0; n<kFrames; ++n)
+			{
+				work.copy(frame);
+				work.convolve3x3rb(kc, ke, kk);
+				work.partialDiffX();
+				work.variance3x3();
+			}
+			end = std::chrono::system_clock::now();
+			elapsed = end-start;
+			std::cout << size[0] << "x" << size[1] << " blur, diff, variance separately: " << elapsed.count()*1000000./kFrames << " us / frame\n";
+			
+			MLSignal::Op2D ops[3] = 
+			{
+				MLSignal::Op2D(MLSignal::Op2D::kConvolve3x3rb, kc, ke, kk),
+				MLSignal::Op2D(MLSignal::Op2D::kPartialDiffX),
+				MLSignal::Op2D(MLSignal::Op2D::kVariance3x3)
+			};
+			start = std::chrono::system_clock::now();
+			for(int n=0; n<kFrames; ++n)
+			{
+				work.copy(frame);
+				work.process2D(ops, 3);
+			}
+			end = std::chrono::system_clock::now();
+			elapsed = end-start;
+			std::cout << size[0] << "x" << size[1] << " blur, diff, variance fused: " << elapsed.count()*1000000./kFrames << " us / frame\n";
+		}
+	}
+}
+
+TEST_CASE("madronalib/core/signal/peaks", "[signal][peaks]")
+{
+	// three smooth bumps of different heights at fractional positions.
+	const float bumps[3][3] = {{3.3f, 2.6f, 0.5f}, {9.2f, 5.1f, 1.0f}, {5.7f, 6.4f, 0.75f}};
+	MLSignal frame(13, 9);
+	for(int j=0; j<frame.getHeight(); ++j)
+	{
+		for(int i=0; i<frame.getWidth(); ++i)
+		{
+			float z = 0.f;
+			for(auto& b : bumps)
+			{
+				float dx = i - b[0];
+				float dy = j - b[1];
+				z += b[2]*expf(-(dx*dx + dy*dy));
+			}
+			frame(i, j) = z;
+		}
+	}
+
+	// all peaks, highest first.
+	Vec3 peaks[8];
+	int n = frame.findPeaks(peaks, 8, 0.1f);
+	REQUIRE(n == 3);
+	REQUIRE(peaks[0].z() >= peaks[1].z());
+	REQUIRE(peaks[1].z() >= peaks[2].z());
+	REQUIRE((int)peaks[0].x() == 9);
+	REQUIRE((int)peaks[0].y() == 5);
+	REQUIRE(frame.findPeak() == peaks[0]);
+	
+	// the threshold and the maximum count.
+	REQUIRE(frame.findPeaks(peaks, 8, 0.45f) == 2);
+	REQUIRE(frame.findPeaks(peaks, 1, 0.1f) == 1);
+	REQUIRE((int)peaks[0].x() == 9);
+	
+	// a plateau gives one peak.
+	MLSignal flat(6, 5);
+	flat(2, 2) = flat(3, 2) = flat(2, 3) = flat(3, 3) = 1.f;
+	REQUIRE(flat.findPeaks(peaks, 8, 0.5f) == 1);
+	
+	// batched refinement matches correctPeak().
+	n = frame.findPeaks(peaks, 8, 0.1f);
+	Vec3 corrected[8];
+	std::copy(peaks, peaks + n, corrected);
+	frame.correctPeaks(corrected, n, 0.5f);
+	for(int i=0; i<n; ++i)
+	{
+		Vec2 c = frame.correctPeak(peaks[i].x(), peaks[i].y(), 0.5f);
+		REQUIRE(fabs(c.x() - corrected[i].x()) < 0.0001f);
+		REQUIRE(fabs(c.y() - corrected[i].y()) < 0.0001f);
+		REQUIRE(corrected[i].z() == peaks[i].z());
+	}
+	
+	// association: the previous peaks, moved a little and in a different order.
+	Vec3 prev[3] = {corrected[0], corrected[1], corrected[2]};
+	Vec3 next[4] = {prev[2] + Vec3(0.3f, 0.f, 0.f), prev[0] + Vec3(0.f, -0.2f, 0.f), 
+		Vec3(0.f, 0.f, 1.f), prev[1] + Vec3(0.2f, 0.2f, 0.f)};
+	int matches[4];
+	associatePeaks(prev, 3, next, 4, matches, 1.f);
+	REQUIRE(matches[0] == 2);
+	REQUIRE(matches[1] == 0);
+	REQUIRE(matches[2] == -1);
+	REQUIRE(matches[3] == 1);
+}
+
+TEST_CASE("madronalib/core/signal/move", "[signal][move]")
+{
+	// moving a large signal takes its data.
+	MLSignal a(64, 4);
+	makeTestFrame(a);
+	MLSignal ref(a);
+	const MLSample* pData = a.getConstBuffer();
+	MLSignal b(std::move(a));
+	REQUIRE(b.getConstBuffer() == pData);
+	REQUIRE(b == ref);
+	
+	// the moved-from signal is still usable.
+	REQUIRE(a.getSize() == 1);
+	a.setDims(8);
+	a.fill(1.f);
+	REQUIRE(a.getSum() == 8.f);
+	
+	MLSignal c;
+	c = std::move(b);
+	REQUIRE(c.getConstBuffer() == pData);
+	REQUIRE(c == ref);
+	
+	// small signals are stored in the object and copied when moved.
+	MLSignal s{1.f, 2.f, 3.f, 4.f};
+	uintptr_t pObj = reinterpret_cast<uintptr_t>(&s);
+	uintptr_t pBuf = reinterpret_cast<uintptr_t>(s.getConstBuffer());
+	REQUIRE(pBuf >= pObj);
+	REQUIRE(pBuf < pObj + sizeof(MLSignal));
+	MLSignal t(std::move(s));
+	REQUIRE(t.getWidth() == 4);
+	REQUIRE(t[3] == 4.f);
+	
+	// resizing between local and heap storage.
+	t.setDims(100);
+	t.fill(2.f);
+	t.setDims(4);
+	t.fill(3.f);
+	REQUIRE(t.getSum() == 12.f);
+	MLSignal u(200);
+	u = t;
+	REQUIRE(u.getSum() == 12.f);
+	
+	// copyWithLoopAtEnd returns by value.
+	MLSignal loop = MLSignal::copyWithLoopAtEnd(ref, 4);
+	REQUIRE(loop.getWidth() == 68);
+	REQUIRE(loop[64] == ref[0]);
+}
+
+TEST_CASE("madronalib/core/signal/view", "[signal][view]")
+{
+	MLSignal a(5, 3, 2);
+	for(int k=0; k<2; ++k)
+	{
+		for(int j=0; j<3; ++j)
+		{
+			for(int i=0; i<5; ++i)
+			{
+				a(i, j, k) = i + j*10 + k*100;
+			}
+		}
+	}
+	
+	// views of a signal and a frame read with the signal's strides.
+	MLSignalRef v = a.getView();
+	REQUIRE(v(4, 2, 1) == a(4, 2, 1));
+	MLSignalRef f = a.getFrame(1);
+	REQUIRE(f.getDepth() == 1);
+	REQUIRE(f(3, 2) == 123.f);
+	REQUIRE(f.getRowView(2)[3] == 123.f);
+	
+	// views write through to the signal.
+	f(0, 0) = -1.f;
+	REQUIRE(a(0, 0, 1) == -1.f);
+	
+	// frames can be set from views, including frames of other signals.
+	MLSignal c(5, 3, 2);
+	c.setFrame(0, a.getFrame(1));
+	REQUIRE(c(3, 2, 0) == 123.f);
+	REQUIRE(c(0, 0, 0) == -1.f);
+	REQUIRE(c(3, 2, 1) == 0.f);
+	
+	// a signal made from a view copies only the view's samples.
+	MLSignal g(f);
+	REQUIRE(g.getWidth() == 5);
+	REQUIRE(g.getHeight() == 3);
+	REQUIRE(g.getDepth() == 1);
+	REQUIRE(g(3, 2) == 123.f);
+	REQUIRE(rmsDifference2D(g, f) == 0.f);
+	
+	// a view of external data, and constant views.
+	float data[12] = {0, 1, 2, 0, 3, 4, 5, 0, 6, 7, 8, 0};
+	MLSignalRef e(data, 3, 3, 1, 4);
+	REQUIRE(e(2, 1) == 5.f);
+	MLSignalRef k(data + 1, 3, 3, 1, 4, 0, true);
+	REQUIRE(k.isConstant());
+	REQUIRE(k(2, 2) == 1.f);
+	MLSignal h(k);
+	REQUIRE(h.isConstant());
+	REQUIRE(h[0] == 1.f);
+}
+
+TEST_CASE("madronalib/core/signal/layout", "[signal][layout]")
+{
+	const int w = 33, h = 17;
+	MLSignal p2(w, h);
+	MLSignal packed(w, h, 1, MLSignal::kPackedLayout);
+	REQUIRE(p2.getRowStride() == 64);
+	REQUIRE(p2.getSize() == 64*32);
+	REQUIRE(packed.getRowStride() == 36);
+	REQUIRE(packed.getSize() == 36*17);
+	
+	// operators touch only the logical region.
+	const float kPad = 1234.f;
+	p2.getBuffer()[p2.row(3) + w] = kPad;
+	p2.getBuffer()[p2.row(h)] = kPad;
+	packed.getBuffer()[packed.row(3) + w] = kPad;
+	makeTestFrame(p2);
+	makeTestFrame(packed);
+	MLSignal b(w, h);
+	makeTestFrame(b);
+	b.scale(0.5f);
+	for(MLSignal* s : {&p2, &packed})
+	{
+		s->add(b);
+		s->multiply(b);
+		s->scale(3.f);
+		s->subtract(1.f);
+		s->sigMax(0.f);
+		s->sqrt();
+		s->sigLerp(b, 0.25f);
+		s->convolve3x3rb(0.25f, 0.125f, 0.0625f);
+		s->variance3x3();
+	}
+	REQUIRE(p2 == packed);
+	REQUIRE(p2.getBuffer()[p2.row(3) + w] == kPad);
+	REQUIRE(p2.getBuffer()[p2.row(h)] == kPad);
+	REQUIRE(packed.getBuffer()[packed.row(3) + w] == kPad);
+	REQUIRE(fabs(p2.getMean() - p2.getSum()/(w*h)) < 0.0001f);
+	REQUIRE(p2.getMin() == packed.getMin());
+	REQUIRE(p2.getAbsMax() == packed.getAbsMax());
+	
+	// copies between layouts.
+	MLSignal c(w, h, 1, MLSignal::kPackedLayout);
+	c.copy(p2);
+	REQUIRE(c == p2);
+	c.clear();
+	REQUIRE(c.getAbsMax() == 0.f);
+	REQUIRE(packed.getBuffer()[packed.row(3) + w] == kPad);
+	
+	// packed 3D frames.
+	MLSignal v(5, 3, 4, MLSignal::kPackedLayout);
+	REQUIRE(v.getPlaneStride() == 24);
+	v(4, 2, 3) = 1.f;
+	REQUIRE(v.getFrame(3)(4, 2) == 1.f);
+	REQUIRE(v.getSum() == 1.f);
+	
+	// clear() zeroes padding too, and masked lookups stay inside packed storage.
+	MLSignal q(5, 3, 1, MLSignal::kPackedLayout);
+	REQUIRE(q.getSize() == 24);
+	q.getBuffer()[q.row(1) + 6] = kPad;
+	q.clear();
+	REQUIRE(q.getBuffer()[q.row(1) + 6] == 0.f);
+	for(int i=0; i<q.getSize(); ++i)
+	{
+		q.getBuffer()[i] = i;
+	}
+	for(int i=0; i<64; ++i)
+	{
+		REQUIRE(q.getInterpolatedLinear(i) < q.getSize());
+	}
+	
+	// constant signals.
+	MLSignal k1(4), k2(4);
+	k1.setToConstant(3.f);
+	k2.setToConstant(2.f);
+	k1.subtract(k2);
+	REQUIRE(k1.isConstant());
+	REQUIRE(k1[0] == 1.f);
+	
+	SECTION("layout benchmark")
+	{
+		const int benchSizes[2][2] = {{33, 17}, {129, 65}};
+		for(auto& size : benchSizes)
+		{
+			const int kIters = 2000000 / (size[0]*size[1]);
+			MLSignal x(size[0], size[1]);
+			MLSignal y(size[0], size[1]);
+			makeTestFrame(x);
+			makeTestFrame(y);
+			std::chrono::time_point<std::chrono::system_clock> start, end;
+			std::chrono::duration<double> elapsed;
+			float sum = 0.f;
+			
+			// the work of the previous operators, over all storage.
+			start = std::chrono::system_clock::now();
+			for(int n=0; n<kIters; ++n)
+			{
+				MLSample* px = x.getBuffer();
+				const MLSample* py = y.getConstBuffer();
+				const int size = x.getSize();
+				for(int i=0; i<size; ++i) px[i] += py[i];
+				for(int i=0; i<size; ++i) px[i] *= 0.5f;
+				for(int i=0; i<size; ++i) px[i] = min(px[i], py[i]);
+				sum += px[n & 7];
+			}
+			end = std::chrono::system_clock::now();
+			elapsed = end-start;
+			std::cout << size[0] << "x" << size[1] << " add, scale, min over storage: " << elapsed.count()*1000000./kIters << " us\n";
+			
+			for(auto layout : {MLSignal::kPowerOfTwoLayout, MLSignal::kPackedLayout})
+			{
+				MLSignal a(size[0], size[1], 1, layout);
+				a.copy(x);
+				start = std::chrono::system_clock::now();
+				for(int n=0; n<kIters; ++n)
+				{
+					a.add(y);
+					a.scale(0.5f);
+					a.sigMin(y);
+					sum += a(n & 7, 0);
+				}
+				end = std::chrono::system_clock::now();
+				elapsed = end-start;
+				std::cout << size[0] << "x" << size[1] << " add, scale, min by row, " << 
+					((layout == MLSignal::kPackedLayout) ? "packed" : "power of two") << ": " << 
+					elapsed.count()*1000000./kIters << " us\n";
+			}
+			REQUIRE(sum == sum);
+		}
+	}
+}
+
+TEST_CASE("madronalib/core/signal/random", "[signal][random]")
+{
+	const int n = 4099;
+	MLSignal a(n), b(n);
+	MLRandom r1(17), r2(17);
+	r1.fillUniform(a);
+	r2.fillUniform(b);
+	REQUIRE(a == b);
+	REQUIRE(!a.isConstant());
+	REQUIRE(a.getMin() >= -1.f);
+	REQUIRE(a.getMax() < 1.f);
+	REQUIRE(fabs(a.getMean()) < 0.05f);
+	
+	// different seeds give different sequences.
+	MLRandom r3(18);
+	r3.fillUniform(b);
+	REQUIRE(a != b);
+	
+	// the vector fill makes the same sequence as single samples.
+	MLRandom r4(17);
+	bool same = true;
+	for(int i=0; i<1024; ++i)
+	{
+		same &= (r4.getSample() == a[i]);
+	}
+	REQUIRE(same);
+	
+	// gaussian fill has mean 0 and the given deviation.
+	const float sd = 0.5f;
+	MLRandom r5(5);
+	r5.fillGaussian(a, sd);
+	float mean = a.getMean();
+	float var = 0.f;
+	for(int i=0; i<n; ++i)
+	{
+		var += (a[i] - mean)*(a[i] - mean);
+	}
+	var /= n;
+	REQUIRE(fabs(mean) < 0.05f);
+	REQUIRE(fabs(sqrtf(var) - sd) < 0.05f);
+	
+	// row padding is left alone.
+	const float kPad = 1234.f;
+	MLSignal p(33, 3, 1, MLSignal::kPackedLayout);
+	p.getBuffer()[p.row(1) + 33] = kPad;
+	r5.fillUniform(p);
+	REQUIRE(p.getBuffer()[p.row(1) + 33] == kPad);
+	REQUIRE(p.getAbsMax() <= 1.f);
+	
+	// a view of one row fills only that row.
+	p.clear();
+	r5.fillUniform(p.getView().getRowView(2));
+	REQUIRE(p(5, 1) == 0.f);
+	REQUIRE(p(5, 2) != 0.f);
+}
+
+TEST_CASE("madronalib/core/signal/decimate", "[signal][decimate]")
+{
+	const int samples = 1001;
+	const int rows = 3;
+	MLSignal a(samples, rows);
+	MLRandom r(3);
+	r.fillUniform(a);
+	
+	// compare to a plain loop over each span, for spans shorter and longer than a vector.
+	const int pointsToTest[] = {1, 7, 64, 333, samples};
+	for(int points : pointsToTest)
+	{
+		MLSignal d;
+		d.decimateMinMax(a, samples, points);
+		REQUIRE(d.getWidth() == points);
+		REQUIRE(d.getHeight() == rows);
+		REQUIRE(d.getDepth() == 2);
+		bool same = true;
+		for(int j=0; j<rows; ++j)
+		{
+			for(int k=0; k<points; ++k)
+			{
+				const int start = k*samples/points;
+				const int end = (k + 1)*samples/points;
+				float fMin = a(start, j), fMax = a(start, j);
+				for(int i=start; i<end; ++i)
+				{
+					fMin = min(fMin, a(i, j));
+					fMax = max(fMax, a(i, j));
+				}
+				same &= (d(k, j, 0) == fMin) && (d(k, j, 1) == fMax);
+			}
+		}
+		REQUIRE(same);
+	}
+	
+	// points are limited to the number of samples.
+	MLSignal d;
+	d.decimateMinMax(a, 10, 100);
+	REQUIRE(d.getWidth() == 10);
+	REQUIRE(d(9, 2, 0) == a(9, 2));
+	
+	// a constant signal decimates to its value.
+	MLSignal k(256, 2);
+	k.setToConstant(0.25f);
+	d.decimateMinMax(k, 256, 16);
+	REQUIRE(d(15, 1, 0) == 0.25f);
+	REQUIRE(d(15, 1, 1) == 0.25f);
+}
+
+namespace
+{
+	// a context and a one-input proc, standing in for the ring buffer procs
+	// that an engine makes for each voice of a published signal.
+	class RecorderTestContext : public MLDSPContext
+	{
+	public:
+		void setEnabled(bool t) { mEnabled = t; }
+		bool isEnabled() const { return true; }
+		bool isProcEnabled(const MLProc*) const { return true; }
+	};
+
+	class RecorderTestProc : public MLProc
+	{
+	public:
+		RecorderTestProc(MLDSPContext* pContext, const MLSignal& input)
+		{
+			setContext(pContext);
+			resizeInputs(1);
+			setInput(1, input);
+		}
+		MLProcInfoBase& procInfo() { return mInfo; }
+		void process(const int) {}
+	private:
+		MLProcInfo<RecorderTestProc> mInfo;
+	};
+}
+
+TEST_CASE("madronalib/core/signal/recorder", "[signal][recorder]")
+{
+	const int kVoices = 2;
+	const int kFrames = 64;
+	const int kChunks = 5;
+	const char* kPath = "signalRecorderTest.mlsr";
+	
+	RecorderTestContext context;
+	std::vector<MLSignal> inputs(kVoices);
+	MLProcList procs;
+	for(int v=0; v<kVoices; ++v)
+	{
+		inputs[v].setDims(kFrames);
+		procs.push_back(MLProcPtr(new RecorderTestProc(&context, inputs[v])));
+	}
+	
+	// record a known signal, different for each voice and chunk.
+	MLSignalRecorder recorder;
+	recorder.addTrack("test_signal", procs);
+	REQUIRE(recorder.start(kPath, 44100., kFrames));
+	for(int c=0; c<kChunks; ++c)
+	{
+		for(int v=0; v<kVoices; ++v)
+		{
+			for(int i=0; i<kFrames; ++i)
+			{
+				inputs[v][i] = c*1000.f + v*100.f + i;
+			}
+		}
+		recorder.capture(kFrames);
+	}
+	recorder.stop();
+	REQUIRE(recorder.getDroppedBlocks() == 0);
+	
+	// read it back.
+	std::vector<unsigned char> data;
+	FILE* f = fopen(kPath, "rb");
+	REQUIRE(f);
+	unsigned char buf[4096];
+	size_t n;
+	while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+	{
+		data.insert(data.end(), buf, buf + n);
+	}
+	fclose(f);
+	remove(kPath);
+	
+	MLSignalRecording recording;
+	REQUIRE(recording.open(data.data(), data.size()));
+	REQUIRE(recording.getHeader().mBlockFrames == kFrames);
+	REQUIRE(recording.getNumTracks() == 1);
+	REQUIRE(recording.getTrack(0).mVoices == kVoices);
+	REQUIRE(std::string(recording.getTrack(0).mName) == "test_signal");
+	
+	int blocks = 0;
+	bool same = true;
+	for(const MLSignalRecordingBlock* pBlock = recording.getFirstBlock(); pBlock; pBlock = recording.getNextBlock(pBlock))
+	{
+		REQUIRE(pBlock->mTrack == 0);
+		REQUIRE(pBlock->mFrames == kFrames);
+		REQUIRE(pBlock->mFrame == (uint64_t)blocks*kFrames);
+		REQUIRE(pBlock->mEnabledVoices == 3);
+		for(int v=0; v<kVoices; ++v)
+		{
+			const float* pSamples = recording.getSamples(pBlock, v);
+			for(int i=0; i<kFrames; ++i)
+			{
+				same &= (pSamples[i] == blocks*1000.f + v*100.f + i);
+			}
+		}
+		blocks++;
+	}
+	REQUIRE(blocks == kChunks);
+	REQUIRE(same);
+}
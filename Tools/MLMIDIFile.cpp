@@ -0,0 +1,254 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLMIDIFile.h"
+#include "MLDebug.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+
+namespace
+{
+	struct TickEvent
+	{
+		long mTick;
+		int mOrder;
+		MLControlEvent mEvent;
+	};
+
+	bool tickEventLess(const TickEvent& a, const TickEvent& b)
+	{
+		return (a.mTick < b.mTick) || ((a.mTick == b.mTick) && (a.mOrder < b.mOrder));
+	}
+
+	class Reader
+	{
+	public:
+		Reader(const unsigned char* p, size_t size) : mp(p), mEnd(p + size) {}
+		bool atEnd() const { return mp >= mEnd; }
+		size_t remaining() const { return mEnd - mp; }
+		int byte() { return (mp < mEnd) ? *mp++ : 0; }
+		int peek() const { return (mp < mEnd) ? *mp : 0; }
+		unsigned long bigEndian(int bytes)
+		{
+			unsigned long v = 0;
+			for(int i=0; i<bytes; ++i)
+			{
+				v = (v << 8) | byte();
+			}
+			return v;
+		}
+		unsigned long varLen()
+		{
+			unsigned long v = 0;
+			for(int i=0; i<4; ++i)
+			{
+				int b = byte();
+				v = (v << 7) | (b & 0x7F);
+				if(!(b & 0x80)) break;
+			}
+			return v;
+		}
+		void skip(size_t n) { mp = (n < remaining()) ? mp + n : mEnd; }
+		const unsigned char* pos() const { return mp; }
+
+	private:
+		const unsigned char* mp;
+		const unsigned char* mEnd;
+	};
+
+	// make a control event from a channel message, or return false if it has none.
+	bool makeEvent(int status, int d1, int d2, MLControlEvent& e)
+	{
+		const int chan = (status & 0x0F) + 1;
+		e = MLControlEvent();
+		e.mChannel = chan;
+		switch(status & 0xF0)
+		{
+			case 0x90:
+				if(d2 > 0)
+				{
+					e.mType = MLControlEvent::kNoteOn;
+					e.mValue1 = d1;
+					e.mValue2 = d2/127.f;
+					e.mID = d1;
+					return true;
+				}
+				// note on with velocity 0 is a note off.
+				e.mType = MLControlEvent::kNoteOff;
+				e.mValue1 = d1;
+				e.mID = d1;
+				return true;
+			case 0x80:
+				e.mType = MLControlEvent::kNoteOff;
+				e.mValue1 = d1;
+				e.mValue2 = d2/127.f;
+				e.mID = d1;
+				return true;
+			case 0xA0:
+				e.mType = MLControlEvent::kNotePressure;
+				e.mValue1 = d1;
+				e.mValue2 = d2/127.f;
+				e.mID = d1;
+				return true;
+			case 0xB0:
+				if(d1 == 64)
+				{
+					e.mType = MLControlEvent::kSustainPedal;
+					e.mValue1 = (d2 >= 64) ? 1.f : 0.f;
+				}
+				else
+				{
+					e.mType = MLControlEvent::kController;
+					e.mValue1 = d1;
+					e.mValue2 = d2/127.f;
+				}
+				return true;
+			case 0xD0:
+				e.mType = MLControlEvent::kChannelPressure;
+				e.mValue1 = d1/127.f;
+				return true;
+			case 0xE0:
+				e.mType = MLControlEvent::kPitchWheel;
+				e.mValue1 = d1 | (d2 << 7);
+				return true;
+			default:
+				return false;
+		}
+	}
+}
+
+bool MLMIDIFile::read(const std::string& path)
+{
+	FILE* f = fopen(path.c_str(), "rb");
+	if(!f)
+	{
+		debug() << "MLMIDIFile: could not open " << path << "\n";
+		return false;
+	}
+	std::vector<unsigned char> data;
+	unsigned char buf[4096];
+	size_t n;
+	while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+	{
+		data.insert(data.end(), buf, buf + n);
+	}
+	fclose(f);
+	return !data.empty() && parse(&data[0], data.size());
+}
+
+bool MLMIDIFile::parse(const unsigned char* pData, size_t size)
+{
+	mEvents.clear();
+	Reader r(pData, size);
+	if((r.remaining() < 14) || (r.bigEndian(4) != 0x4D546864)) // "MThd"
+	{
+		debug() << "MLMIDIFile: not a MIDI file.\n";
+		return false;
+	}
+	const unsigned long headerLength = r.bigEndian(4);
+	const int format = (int)r.bigEndian(2);
+	const int tracks = (int)r.bigEndian(2);
+	const int division = (int)r.bigEndian(2);
+	r.skip(headerLength - 6);
+	if((format > 1) || (division & 0x8000))
+	{
+		debug() << "MLMIDIFile: only format 0 and 1 files with ticks per quarter note are supported.\n";
+		return false;
+	}
+	const int ticksPerQuarter = division ? division : 480;
+
+	std::vector<TickEvent> events;
+	std::map<long, double> tempos;	// tick -> microseconds per quarter note
+	int order = 0;
+
+	for(int t=0; (t < tracks) && !r.atEnd(); ++t)
+	{
+		if(r.bigEndian(4) != 0x4D54726B) // "MTrk"
+		{
+			debug() << "MLMIDIFile: bad track header.\n";
+			return false;
+		}
+		const unsigned long trackLength = r.bigEndian(4);
+		Reader tr(r.pos(), std::min((size_t)trackLength, r.remaining()));
+		r.skip(trackLength);
+
+		long tick = 0;
+		int status = 0;
+		while(!tr.atEnd())
+		{
+			tick += tr.varLen();
+			int b = tr.peek();
+			if(b & 0x80)
+			{
+				status = tr.byte();
+			}
+			if(status == 0xFF)
+			{
+				const int type = tr.byte();
+				const unsigned long len = tr.varLen();
+				if((type == 0x51) && (len == 3))
+				{
+					tempos[tick] = (double)tr.bigEndian(3);
+				}
+				else
+				{
+					tr.skip(len);
+				}
+				if(type == 0x2F) break; // end of track
+				status = 0;
+			}
+			else if((status == 0xF0) || (status == 0xF7))
+			{
+				tr.skip(tr.varLen());
+				status = 0;
+			}
+			else if(status & 0x80)
+			{
+				const int d1 = tr.byte();
+				const int kind = status & 0xF0;
+				const int d2 = ((kind == 0xC0) || (kind == 0xD0)) ? 0 : tr.byte();
+				TickEvent te;
+				if(makeEvent(status, d1, d2, te.mEvent))
+				{
+					te.mTick = tick;
+					te.mOrder = order++;
+					events.push_back(te);
+				}
+			}
+			else
+			{
+				// data byte with no running status.
+				tr.byte();
+			}
+		}
+	}
+
+	// convert ticks to seconds through the tempo map.
+	std::stable_sort(events.begin(), events.end(), tickEventLess);
+	std::map<long, double>::const_iterator tempoIt = tempos.begin();
+	long lastTick = 0;
+	double seconds = 0.;
+	double usPerQuarter = 500000.;
+	for(size_t i=0; i<events.size(); ++i)
+	{
+		const long tick = events[i].mTick;
+		while((tempoIt != tempos.end()) && (tempoIt->first <= tick))
+		{
+			seconds += (tempoIt->first - lastTick)*usPerQuarter/(ticksPerQuarter*1000000.);
+			lastTick = tempoIt->first;
+			usPerQuarter = tempoIt->second;
+			++tempoIt;
+		}
+		seconds += (tick - lastTick)*usPerQuarter/(ticksPerQuarter*1000000.);
+		lastTick = tick;
+
+		Event e;
+		e.mSeconds = seconds;
+		e.mEvent = events[i].mEvent;
+		mEvents.push_back(e);
+	}
+	return true;
+}
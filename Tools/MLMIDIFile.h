@@ -0,0 +1,40 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef ML_MIDI_FILE_H
+#define ML_MIDI_FILE_H
+
+#include <string>
+#include <vector>
+
+#include "MLControlEvent.h"
+
+// MLMIDIFile: reads the channel messages from a Standard MIDI File, format 0 or 1,
+// and turns them into MLControlEvents as MLPluginProcessor::processMIDI() does.
+// Events from all tracks are merged and timed in seconds with the file's tempo map.
+
+class MLMIDIFile
+{
+public:
+	struct Event
+	{
+		double mSeconds;
+		MLControlEvent mEvent;
+	};
+
+	MLMIDIFile() {}
+	~MLMIDIFile() {}
+
+	bool read(const std::string& path);
+	bool parse(const unsigned char* pData, size_t size);
+
+	// events sorted by time.
+	const std::vector<Event>& getEvents() const { return mEvents; }
+	double getLength() const { return mEvents.empty() ? 0. : mEvents.back().mSeconds; }
+
+private:
+	std::vector<Event> mEvents;
+};
+
+#endif // ML_MIDI_FILE_H
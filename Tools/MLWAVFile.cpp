@@ -0,0 +1,77 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLWAVFile.h"
+
+#include <stdint.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	// WAV files are little-endian.
+	void putLE(std::vector<unsigned char>& out, uint32_t v, int bytes)
+	{
+		for(int i=0; i<bytes; ++i)
+		{
+			out.push_back((v >> (8*i)) & 0xFF);
+		}
+	}
+
+	void putTag(std::vector<unsigned char>& out, const char* tag)
+	{
+		out.insert(out.end(), tag, tag + 4);
+	}
+}
+
+bool MLWriteWAVFile(const std::string& path, const std::vector<float>& interleaved, int channels,
+	int sampleRate, int bits)
+{
+	if((channels <= 0) || ((bits != 16) && (bits != 24) && (bits != 32))) return false;
+
+	const bool isFloat = (bits == 32);
+	const int bytesPerSample = bits/8;
+	const uint32_t dataBytes = (uint32_t)(interleaved.size()*bytesPerSample);
+
+	std::vector<unsigned char> out;
+	out.reserve(44 + dataBytes);
+	putTag(out, "RIFF");
+	putLE(out, 36 + dataBytes, 4);
+	putTag(out, "WAVE");
+	putTag(out, "fmt ");
+	putLE(out, 16, 4);
+	putLE(out, isFloat ? 3 : 1, 2);	// WAVE_FORMAT_IEEE_FLOAT or WAVE_FORMAT_PCM
+	putLE(out, channels, 2);
+	putLE(out, sampleRate, 4);
+	putLE(out, sampleRate*channels*bytesPerSample, 4);
+	putLE(out, channels*bytesPerSample, 2);
+	putLE(out, bits, 2);
+	putTag(out, "data");
+	putLE(out, dataBytes, 4);
+
+	for(size_t i=0; i<interleaved.size(); ++i)
+	{
+		const float x = interleaved[i];
+		if(isFloat)
+		{
+			uint32_t w;
+			memcpy(&w, &x, sizeof(w));
+			putLE(out, w, 4);
+		}
+		else
+		{
+			const float maxVal = (float)((1 << (bits - 1)) - 1);
+			const float clipped = (x > 1.f) ? 1.f : ((x < -1.f) ? -1.f : x);
+			const int32_t v = (int32_t)lrintf(clipped*maxVal);
+			putLE(out, (uint32_t)v, bytesPerSample);
+		}
+	}
+
+	FILE* f = fopen(path.c_str(), "wb");
+	if(!f) return false;
+	const bool ok = (fwrite(&out[0], 1, out.size(), f) == out.size());
+	fclose(f);
+	return ok;
+}
@@ -0,0 +1,16 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef ML_WAV_FILE_H
+#define ML_WAV_FILE_H
+
+#include <string>
+#include <vector>
+
+// write interleaved samples to a WAV file, as 16 or 24 bit integers or 32 bit floats.
+//
+bool MLWriteWAVFile(const std::string& path, const std::vector<float>& interleaved, int channels,
+	int sampleRate, int bits);
+
+#endif // ML_WAV_FILE_H
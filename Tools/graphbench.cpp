@@ -0,0 +1,162 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// graphbench: measure how long it takes to open a session of DSP engines made
+// from one graph, with the graph cache cold and warm.
+//
+// cold: the cache is cleared before each engine, so every engine parses the
+// description and packs its buffers.
+// warm: engines are made one after another as a host opening a session would,
+// so all but the first reuse the parsed description and the packing.
+// disk: if a directory is given, the in-memory cache is cleared and the packing
+// is read back from the file the warm pass saved, as in a later session.
+//
+// usage: graphbench -g graph.xml [-n instances] [-r rate] [-c chunkSize] [--voices n] [-d dir]
+
+#include "MLDSPEngine.h"
+#include "MLGraphCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Options
+	{
+		Options() : mInstances(50), mSampleRate(44100), mChunkSize(kMLProcessChunkSize), mVoices(4) {}
+
+		std::string mGraphPath;
+		std::string mCacheDir;
+		int mInstances;
+		int mSampleRate;
+		int mChunkSize;
+		int mVoices;
+	};
+
+	bool readFile(const std::string& path, std::string& text)
+	{
+		FILE* f = fopen(path.c_str(), "rb");
+		if(!f) return false;
+		char buf[4096];
+		size_t n;
+		text.clear();
+		while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		{
+			text.append(buf, n);
+		}
+		fclose(f);
+		return true;
+	}
+
+	double msSince(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	// make one engine from the graph text as a plugin instance does: get the
+	// description from the cache, then build, compile and prepare.
+	std::unique_ptr<MLDSPEngine> openEngine(const std::string& graphText, const Options& opts)
+	{
+		std::unique_ptr<MLDSPEngine> pEngine(new MLDSPEngine);
+		std::shared_ptr<const MLGraphDesc> desc = theGraphCache().getDescription(graphText.c_str());
+		pEngine->setMaxVoices(opts.mVoices);
+		pEngine->setInputChannels(0);
+		pEngine->setOutputChannels(2);
+		if(pEngine->buildGraphAndInputs(*desc, false, true) != MLProc::OK) return nullptr;
+		pEngine->compileEngine(opts.mSampleRate, opts.mChunkSize);
+		if(pEngine->prepareEngine(opts.mSampleRate, opts.mChunkSize, opts.mChunkSize) != MLProc::OK) return nullptr;
+		return pEngine;
+	}
+
+	// open the engines, clearing the cache before each one if cold is set.
+	// returns the mean time per engine in ms, or a negative number on failure.
+	double openSession(const std::string& graphText, const Options& opts, int instances, bool cold)
+	{
+		std::vector<std::unique_ptr<MLDSPEngine> > engines;
+		double total = 0.;
+		for(int i=0; i<instances; ++i)
+		{
+			if(cold)
+			{
+				theGraphCache().clear();
+			}
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			std::unique_ptr<MLDSPEngine> pEngine = openEngine(graphText, opts);
+			total += msSince(start);
+			if(!pEngine) return -1.;
+			engines.push_back(std::move(pEngine));
+		}
+		return total / instances;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opts;
+	for(int i=1; i<argc; ++i)
+	{
+		const std::string arg(argv[i]);
+		const bool hasValue = (i + 1 < argc);
+		if(hasValue && (arg == "-g")) opts.mGraphPath = argv[++i];
+		else if(hasValue && (arg == "-d")) opts.mCacheDir = argv[++i];
+		else if(hasValue && (arg == "-n")) opts.mInstances = atoi(argv[++i]);
+		else if(hasValue && (arg == "-r")) opts.mSampleRate = atoi(argv[++i]);
+		else if(hasValue && (arg == "-c")) opts.mChunkSize = atoi(argv[++i]);
+		else if(hasValue && (arg == "--voices")) opts.mVoices = atoi(argv[++i]);
+		else
+		{
+			opts.mGraphPath.clear();
+			break;
+		}
+	}
+	if(opts.mGraphPath.empty() || (opts.mInstances <= 0) || (opts.mSampleRate <= 0) ||
+		(opts.mChunkSize <= 0) || (opts.mVoices <= 0))
+	{
+		fprintf(stderr, "usage: graphbench -g graph.xml [-n instances] [-r rate] [-c chunkSize] [--voices n] [-d dir]\n");
+		return 1;
+	}
+
+	std::string graphText;
+	if(!readFile(opts.mGraphPath, graphText))
+	{
+		fprintf(stderr, "graphbench: could not read graph %s\n", opts.mGraphPath.c_str());
+		return 1;
+	}
+
+	// the cold pass runs without a directory, so that it doesn't read earlier files.
+	const double cold = openSession(graphText, opts, opts.mInstances, true);
+
+	theGraphCache().clear();
+	theGraphCache().setDirectory(opts.mCacheDir);
+	const double warm = openSession(graphText, opts, opts.mInstances, false);
+
+	double disk = 0.;
+	if(!opts.mCacheDir.empty())
+	{
+		theGraphCache().clear();
+		disk = openSession(graphText, opts, 1, false);
+	}
+
+	if((cold < 0.) || (warm < 0.) || (disk < 0.))
+	{
+		fprintf(stderr, "graphbench: could not build graph %s\n", opts.mGraphPath.c_str());
+		return 1;
+	}
+
+	printf("%d instances, %d voices, rate %d, chunk size %d\n", opts.mInstances, opts.mVoices,
+		opts.mSampleRate, opts.mChunkSize);
+	printf("cold: %.3f ms per instance, %.1f ms per session\n", cold, cold*opts.mInstances);
+	printf("warm: %.3f ms per instance, %.1f ms per session\n", warm, warm*opts.mInstances);
+	if(!opts.mCacheDir.empty())
+	{
+		printf("first instance of a later session, packing read from disk: %.3f ms\n", disk);
+	}
+	return 0;
+}
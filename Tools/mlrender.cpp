@@ -0,0 +1,444 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// mlrender: render patches through a DSP graph to WAV files, with no host or GUI.
+//
+// usage: mlrender -g graph.xml [options] [patch.mlpreset ...]
+//
+// each patch is played with the same MIDI input, either a file (-m) or a single note,
+// and written to <outdir>/<patch name>.wav. with no patches the graph's default
+// parameters are rendered to <outdir>/out.wav. patches are divided among -j worker
+// threads, each of which builds one engine and reuses it for all of its patches.
+
+#include "MLDSPEngine.h"
+#include "MLGraphCache.h"
+#include "MLMIDIFile.h"
+#include "MLWAVFile.h"
+#include "cJSON.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct Options
+	{
+		Options() :
+			mSampleRate(44100), mBufferSize(512), mVectorSize(kMLProcessChunkSize), mVoices(4), mBits(24),
+			mThreads(0), mNote(60), mVelocity(100), mLength(1.), mTail(2.), mOutDir(".") {}
+
+		std::string mGraphPath;
+		std::string mMIDIPath;
+		int mSampleRate;
+		int mBufferSize;
+		int mVectorSize;
+		int mVoices;
+		int mBits;
+		int mThreads;
+		int mNote;
+		int mVelocity;
+		double mLength;
+		double mTail;
+		std::string mOutDir;
+		std::vector<std::string> mPatches;
+	};
+
+	struct Job
+	{
+		Job() : mOK(false), mRenderSeconds(0.) {}
+
+		std::string mPatchPath;	// empty for default parameters
+		std::string mOutPath;
+		bool mOK;
+		double mRenderSeconds;
+	};
+
+	void usage()
+	{
+		fprintf(stderr,
+			"usage: mlrender -g graph.xml [options] [patch.mlpreset ...]\n"
+			"  -g path          DSP graph description (required)\n"
+			"  -m path          MIDI file to play\n"
+			"  --note n         note to play if no MIDI file is given (60)\n"
+			"  --velocity v     velocity of the note, 1-127 (100)\n"
+			"  --length secs    length of the note (1)\n"
+			"  --tail secs      time to render after the last event (2)\n"
+			"  -r rate          sample rate (44100)\n"
+			"  -b frames        processing buffer size (512)\n"
+			"  --voices n       maximum voices (4)\n"
+			"  --bits n         16, 24, or 32 for float output (24)\n"
+			"  -j n             worker threads (hardware concurrency)\n"
+			"  -o dir           output directory (.)\n");
+	}
+
+	bool parseOptions(int argc, char** argv, Options& opts)
+	{
+		for(int i=1; i<argc; ++i)
+		{
+			const std::string arg(argv[i]);
+			const bool hasValue = (i + 1 < argc);
+			if(arg[0] != '-')
+			{
+				opts.mPatches.push_back(arg);
+			}
+			else if(!hasValue)
+			{
+				fprintf(stderr, "mlrender: missing value for %s\n", arg.c_str());
+				return false;
+			}
+			else if(arg == "-g") opts.mGraphPath = argv[++i];
+			else if(arg == "-m") opts.mMIDIPath = argv[++i];
+			else if(arg == "-o") opts.mOutDir = argv[++i];
+			else if(arg == "-r") opts.mSampleRate = atoi(argv[++i]);
+			else if(arg == "-b") opts.mBufferSize = atoi(argv[++i]);
+			else if(arg == "-j") opts.mThreads = atoi(argv[++i]);
+			else if(arg == "--voices") opts.mVoices = atoi(argv[++i]);
+			else if(arg == "--bits") opts.mBits = atoi(argv[++i]);
+			else if(arg == "--note") opts.mNote = atoi(argv[++i]);
+			else if(arg == "--velocity") opts.mVelocity = atoi(argv[++i]);
+			else if(arg == "--length") opts.mLength = atof(argv[++i]);
+			else if(arg == "--tail") opts.mTail = atof(argv[++i]);
+			else
+			{
+				fprintf(stderr, "mlrender: unknown option %s\n", arg.c_str());
+				return false;
+			}
+		}
+
+		if(opts.mGraphPath.empty()) return false;
+		if((opts.mSampleRate <= 0) || (opts.mBufferSize <= 0) || (opts.mVoices <= 0)) return false;
+		if((opts.mBits != 16) && (opts.mBits != 24) && (opts.mBits != 32)) return false;
+		opts.mBufferSize = std::max(opts.mBufferSize, opts.mVectorSize);
+		opts.mVelocity = std::min(std::max(opts.mVelocity, 1), 127);
+		return true;
+	}
+
+	bool readFile(const std::string& path, std::string& text)
+	{
+		FILE* f = fopen(path.c_str(), "rb");
+		if(!f) return false;
+		char buf[4096];
+		size_t n;
+		text.clear();
+		while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		{
+			text.append(buf, n);
+		}
+		fclose(f);
+		return true;
+	}
+
+	std::string baseName(const std::string& path)
+	{
+		size_t start = path.find_last_of("/\\");
+		start = (start == std::string::npos) ? 0 : start + 1;
+		size_t end = path.find_last_of('.');
+		if((end == std::string::npos) || (end < start)) end = path.size();
+		return path.substr(start, end - start);
+	}
+
+	// set the published float params to their defaults, so that each patch starts
+	// from the same state no matter what the engine rendered before.
+	void setDefaultParams(MLDSPEngine& engine)
+	{
+		const int n = engine.getPublishedParams();
+		for(int i=0; i<n; ++i)
+		{
+			MLPublishedParamPtr p = engine.getParamPtr(i);
+			if(p)
+			{
+				MLSymbol type = p->getType();
+				if((type == "float") || (type == MLSymbol()))
+				{
+					engine.setPublishedParam(i, MLProperty(p->getDefault()));
+				}
+			}
+		}
+	}
+
+	// apply a JSON patch to the engine's published params, as MLAppState::setStateFromJSON()
+	// applies it to a processor. keys that are not params, like the scale name, are ignored.
+	void setParamsFromJSON(MLDSPEngine& engine, cJSON* pNode)
+	{
+		for(cJSON* child = pNode->child; child; child = child->next)
+		{
+			if(!child->string) continue;
+			if((child->type & 255) == cJSON_Object)
+			{
+				cJSON* pObjType = cJSON_GetObjectItem(child, "type");
+				if(!pObjType)
+				{
+					setParamsFromJSON(engine, child);
+					continue;
+				}
+			}
+
+			const int idx = engine.getParamIndex(MLSymbol(child->string));
+			if(idx < 0) continue;
+
+			switch(child->type & 255)
+			{
+				case cJSON_Number:
+					engine.setPublishedParam(idx, MLProperty((float)child->valuedouble));
+					break;
+				case cJSON_String:
+					engine.setPublishedParam(idx, MLProperty(std::string(child->valuestring)));
+					break;
+				case cJSON_Object:
+				{
+					cJSON* pObjType = cJSON_GetObjectItem(child, "type");
+					cJSON* pWidth = cJSON_GetObjectItem(child, "width");
+					cJSON* pHeight = cJSON_GetObjectItem(child, "height");
+					cJSON* pDepth = cJSON_GetObjectItem(child, "depth");
+					cJSON* pData = cJSON_GetObjectItem(child, "data");
+					if(!pObjType->valuestring || strcmp(pObjType->valuestring, "signal")) break;
+					if(!pWidth || !pHeight || !pDepth || !pData) break;
+
+					MLSignal signalValue(pWidth->valueint, pHeight->valueint, pDepth->valueint);
+					float* pSigData = signalValue.getBuffer();
+					const int size = 1 << bitsToContain(pWidth->valueint) << bitsToContain(pHeight->valueint)
+						<< bitsToContain(pDepth->valueint);
+					if(pSigData && (cJSON_GetArraySize(pData) == size))
+					{
+						int i = 0;
+						for(cJSON* c = pData->child; c; c = c->next)
+						{
+							pSigData[i++] = c->valuedouble;
+						}
+						engine.setPublishedParam(idx, MLProperty(signalValue));
+					}
+					break;
+				}
+				default:
+					break;
+			}
+		}
+	}
+
+	bool loadPatch(MLDSPEngine& engine, const std::string& path)
+	{
+		std::string text;
+		if(!readFile(path, text))
+		{
+			fprintf(stderr, "mlrender: could not read %s\n", path.c_str());
+			return false;
+		}
+		cJSON* root = cJSON_Parse(text.c_str());
+		if(!root)
+		{
+			fprintf(stderr, "mlrender: %s is not a JSON patch, skipping.\n", path.c_str());
+			return false;
+		}
+		setParamsFromJSON(engine, root);
+		cJSON_Delete(root);
+		return true;
+	}
+
+	MLProc::err buildEngine(MLDSPEngine& engine, const MLGraphDesc& desc, const Options& opts)
+	{
+		engine.setMaxVoices(opts.mVoices);
+		engine.setInputChannels(0);
+		engine.setOutputChannels(2);
+		MLProc::err e = engine.buildGraphAndInputs(desc, false, true);
+		if(e != MLProc::OK) return e;
+		engine.compileEngine(opts.mSampleRate, opts.mVectorSize);
+		e = engine.prepareEngine(opts.mSampleRate, opts.mBufferSize, opts.mVectorSize);
+		if(e != MLProc::OK) return e;
+		engine.setEnabled(true);
+		return MLProc::OK;
+	}
+
+	// render the events through the engine, returning interleaved stereo samples.
+	void render(MLDSPEngine& engine, const std::vector<MLMIDIFile::Event>& events, double seconds,
+		const Options& opts, std::vector<float>& interleaved)
+	{
+		const int bufSize = opts.mBufferSize;
+		const int64_t totalFrames = (int64_t)(seconds*opts.mSampleRate);
+		std::vector<float> outputs[2];
+		MLDSPEngine::ClientIOMap ioMap;
+		memset(&ioMap, 0, sizeof(ioMap));
+		for(int c=0; c<2; ++c)
+		{
+			outputs[c].resize(bufSize);
+			ioMap.outputs[c] = &outputs[c][0];
+		}
+		engine.setIOBuffers(ioMap);
+
+		MLControlEventVector blockEvents;
+		interleaved.assign(totalFrames*2, 0.f);
+		size_t nextEvent = 0;
+		for(int64_t pos = 0; pos < totalFrames; pos += bufSize)
+		{
+			const int frames = (int)std::min((int64_t)bufSize, totalFrames - pos);
+			blockEvents.clear();
+			while((nextEvent < events.size()) &&
+				((int64_t)(events[nextEvent].mSeconds*opts.mSampleRate) < pos + frames))
+			{
+				MLControlEvent e = events[nextEvent++].mEvent;
+				e.mTime = std::max(0, (int)((int64_t)(events[nextEvent - 1].mSeconds*opts.mSampleRate) - pos));
+				blockEvents.push_back(e);
+			}
+			blockEvents.push_back(kMLNullControlEvent);
+
+			engine.processSignalsAndEvents(frames, blockEvents, pos, (double)pos/opts.mSampleRate, 0., 120., true);
+
+			float* pOut = &interleaved[pos*2];
+			for(int i=0; i<frames; ++i)
+			{
+				*pOut++ = outputs[0][i];
+				*pOut++ = outputs[1][i];
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opts;
+	if(!parseOptions(argc, argv, opts))
+	{
+		usage();
+		return 1;
+	}
+
+	std::string graphText;
+	if(!readFile(opts.mGraphPath, graphText))
+	{
+		fprintf(stderr, "mlrender: could not read graph %s\n", opts.mGraphPath.c_str());
+		return 1;
+	}
+	std::shared_ptr<const MLGraphDesc> desc = theGraphCache().getDescription(graphText.c_str());
+	if(!desc)
+	{
+		fprintf(stderr, "mlrender: could not parse graph %s\n", opts.mGraphPath.c_str());
+		return 1;
+	}
+
+	// input events, shared read-only by all workers.
+	std::vector<MLMIDIFile::Event> events;
+	double inputLength = 0.;
+	if(!opts.mMIDIPath.empty())
+	{
+		MLMIDIFile midi;
+		if(!midi.read(opts.mMIDIPath))
+		{
+			fprintf(stderr, "mlrender: could not read MIDI file %s\n", opts.mMIDIPath.c_str());
+			return 1;
+		}
+		events = midi.getEvents();
+		inputLength = midi.getLength();
+	}
+	else
+	{
+		MLMIDIFile::Event on, off;
+		on.mSeconds = 0.;
+		on.mEvent = MLControlEvent(MLControlEvent::kNoteOn, 1, opts.mNote, 0, opts.mNote, opts.mVelocity/127.f);
+		off.mSeconds = opts.mLength;
+		off.mEvent = MLControlEvent(MLControlEvent::kNoteOff, 1, opts.mNote, 0, opts.mNote, 0.f);
+		events.push_back(on);
+		events.push_back(off);
+		inputLength = opts.mLength;
+	}
+	const double seconds = inputLength + opts.mTail;
+
+	std::vector<Job> jobs;
+	if(opts.mPatches.empty())
+	{
+		Job j;
+		j.mOutPath = opts.mOutDir + "/out.wav";
+		jobs.push_back(j);
+	}
+	for(size_t i=0; i<opts.mPatches.size(); ++i)
+	{
+		Job j;
+		j.mPatchPath = opts.mPatches[i];
+		j.mOutPath = opts.mOutDir + "/" + baseName(opts.mPatches[i]) + ".wav";
+		jobs.push_back(j);
+	}
+
+	int threads = opts.mThreads > 0 ? opts.mThreads : (int)std::thread::hardware_concurrency();
+	threads = std::max(1, std::min(threads, (int)jobs.size()));
+
+	std::atomic<int> nextJob(0);
+	std::mutex printMutex;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+	// each worker builds its own engine from the shared description, then takes
+	// jobs until there are none left.
+	auto worker = [&]()
+	{
+		MLDSPEngine engine;
+		if(buildEngine(engine, *desc, opts) != MLProc::OK)
+		{
+			std::lock_guard<std::mutex> lock(printMutex);
+			fprintf(stderr, "mlrender: could not build engine from %s\n", opts.mGraphPath.c_str());
+			return;
+		}
+
+		std::vector<float> samples;
+		for(int j = nextJob++; j < (int)jobs.size(); j = nextJob++)
+		{
+			Job& job = jobs[j];
+			std::chrono::steady_clock::time_point jobStart = std::chrono::steady_clock::now();
+
+			setDefaultParams(engine);
+			job.mOK = job.mPatchPath.empty() || loadPatch(engine, job.mPatchPath);
+			if(job.mOK)
+			{
+				// preparing again clears DSP history and reseeds the random generators,
+				// so each patch renders the same on any worker.
+				job.mOK = (engine.prepareEngine(opts.mSampleRate, opts.mBufferSize, opts.mVectorSize) == MLProc::OK);
+			}
+			if(job.mOK)
+			{
+				render(engine, events, seconds, opts, samples);
+				job.mOK = MLWriteWAVFile(job.mOutPath, samples, 2, opts.mSampleRate, opts.mBits);
+			}
+
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - jobStart;
+			job.mRenderSeconds = elapsed.count();
+
+			std::lock_guard<std::mutex> lock(printMutex);
+			if(job.mOK)
+			{
+				printf("%s: %.2fs\n", job.mOutPath.c_str(), job.mRenderSeconds);
+			}
+			else
+			{
+				fprintf(stderr, "mlrender: failed to render %s\n", job.mOutPath.c_str());
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for(int i=0; i<threads; ++i)
+	{
+		workers.push_back(std::thread(worker));
+	}
+	for(size_t i=0; i<workers.size(); ++i)
+	{
+		workers[i].join();
+	}
+
+	std::chrono::duration<double> wall = std::chrono::steady_clock::now() - t0;
+	int rendered = 0;
+	for(size_t i=0; i<jobs.size(); ++i)
+	{
+		if(jobs[i].mOK) rendered++;
+	}
+	const double audioSeconds = rendered*seconds;
+	printf("rendered %d of %d patches on %d threads in %.2fs: %.1f patches per minute, %.1fx realtime\n",
+		rendered, (int)jobs.size(), threads, wall.count(), rendered*60./wall.count(), audioSeconds/wall.count());
+
+	return (rendered == (int)jobs.size()) ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// oscbench: measure how many OSC messages per second MLOSCListener can receive
+// and dispatch, by sending t3d-style touch bundles to it over the loopback interface.
+//
+// usage: oscbench [-p port] [-n bundles] [-t touches]
+
+#include "MLOSCListener.h"
+#include "MLOSCDispatch.h"
+#include "OscOutboundPacketStream.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+	enum
+	{
+		kFrameAddr = 0,
+		kTouchAddr
+	};
+
+	// counts and dispatches messages the way MLT3DHub does, without the GUI.
+	class CountingListener : public MLOSCListener
+	{
+	public:
+		CountingListener() : mMessages(0), mBundles(0), mCheck(0.f)
+		{
+			mDispatch.addAddress("/t3d/frm", kFrameAddr);
+			mDispatch.addAddress("/t3d/tch", kTouchAddr, true);
+		}
+		~CountingListener() { listenToOSC(0); }
+
+		std::atomic<long> mMessages;
+		std::atomic<long> mBundles;
+		float mCheck;
+
+	protected:
+		void ProcessMessage(const osc::ReceivedMessage& msg, const IpEndpointName&)
+		{
+			osc::ReceivedMessageArgumentStream args = msg.ArgumentStream();
+			int touchID;
+			osc::int32 frameID, deviceID;
+			float x, y, z, note;
+			switch(mDispatch.match(msg.AddressPattern(), &touchID))
+			{
+				case kFrameAddr:
+					args >> frameID >> deviceID;
+					break;
+				case kTouchAddr:
+					args >> x >> y >> z >> note;
+					mCheck += x + y + z + note;
+					break;
+				default:
+					break;
+			}
+			mMessages++;
+		}
+
+		void ProcessBundle(const osc::ReceivedBundle& b, const IpEndpointName& remoteEndpoint)
+		{
+			for(osc::ReceivedBundle::const_iterator i = b.ElementsBegin(); i != b.ElementsEnd(); ++i)
+			{
+				if(i->IsBundle())
+					ProcessBundle(osc::ReceivedBundle(*i), remoteEndpoint);
+				else
+					ProcessMessage(osc::ReceivedMessage(*i), remoteEndpoint);
+			}
+			mBundles++;
+		}
+
+	private:
+		MLOSCDispatch mDispatch;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	int port = 3199;
+	long bundles = 200000;
+	int touches = 8;
+
+	for(int i=1; i<argc; ++i)
+	{
+		if(!strcmp(argv[i], "-p") && (i + 1 < argc)) port = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-n") && (i + 1 < argc)) bundles = atol(argv[++i]);
+		else if(!strcmp(argv[i], "-t") && (i + 1 < argc)) touches = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: oscbench [-p port] [-n bundles] [-t touches]\n");
+			return 1;
+		}
+	}
+
+	CountingListener listener;
+	if(!listener.listenToOSC(port))
+	{
+		fprintf(stderr, "oscbench: couldn't listen on port %d\n", port);
+		return 1;
+	}
+
+	UdpTransmitSocket sender(IpEndpointName("127.0.0.1", port));
+	char buffer[MLOSCListener::kMaxPacketSize];
+	char addr[16];
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(long b=0; b<bundles; ++b)
+	{
+		osc::OutboundPacketStream p(buffer, sizeof(buffer));
+		p << osc::BeginBundleImmediate;
+		p << osc::BeginMessage("/t3d/frm") << (osc::int32)b << (osc::int32)0 << osc::EndMessage;
+		for(int t=0; t<touches; ++t)
+		{
+			snprintf(addr, sizeof(addr), "/t3d/tch%d", t + 1);
+			p << osc::BeginMessage(addr) << 0.5f << 0.25f << 0.125f << 60.f << osc::EndMessage;
+		}
+		p << osc::EndBundle;
+		sender.Send(p.Data(), p.Size());
+
+		// don't get too far ahead of the receiver, or the socket will drop packets.
+		while(b - listener.mBundles > 256)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// wait for the last packets, giving up after a second of silence.
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	long lastCount = listener.mBundles;
+	while(lastCount < bundles)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		long count = listener.mBundles;
+		if(count != lastCount)
+		{
+			end = std::chrono::steady_clock::now();
+			lastCount = count;
+		}
+		else if(std::chrono::steady_clock::now() - end > std::chrono::seconds(1))
+		{
+			break;
+		}
+	}
+	std::chrono::duration<double> elapsed = end - start;
+	listener.listenToOSC(0);
+
+	const long messages = listener.mMessages;
+	printf("received %ld of %ld bundles, %ld messages in %.3f s\n",
+		(long)listener.mBundles, bundles, messages, elapsed.count());
+	printf("%.0f messages/sec\n", messages / elapsed.count());
+	return 0;
+}
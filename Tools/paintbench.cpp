@@ -0,0 +1,141 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// paintbench: measure the cost of repainting MLDials and an MLMultiSlider while
+// their values change every frame, as they do under automation. Everything is
+// painted in software into an offscreen Image, so no window is needed.
+//
+// usage: paintbench [-d dials] [-f frames] [-u gridUnit] [-s sliders]
+
+#include "MLDial.h"
+#include "MLMultiSlider.h"
+#include "MLLookAndFeel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	// paint a widget's component at its position into g, optionally clipped to a
+	// rectangle in the component's local coordinates.
+	void paintWidget(Graphics& g, MLWidget* w, const Rectangle<int>& clip = Rectangle<int>())
+	{
+		Component* c = w->getComponent();
+		g.saveState();
+		g.setOrigin(c->getX(), c->getY());
+		if(!clip.isEmpty())
+		{
+			g.reduceClipRegion(clip);
+		}
+		c->paintEntireComponent(g, false);
+		g.restoreState();
+	}
+
+	double msSince(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int numDials = 128;
+	int frames = 200;
+	int u = 48;
+	int numSliders = 32;
+
+	for(int i=1; i<argc; ++i)
+	{
+		if(!strcmp(argv[i], "-d") && (i + 1 < argc)) numDials = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-f") && (i + 1 < argc)) frames = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-u") && (i + 1 < argc)) u = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-s") && (i + 1 < argc)) numSliders = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: paintbench [-d dials] [-f frames] [-u gridUnit] [-s sliders]\n");
+			return 1;
+		}
+	}
+
+	ScopedJuceInitialiser_GUI juceInit;
+	MLLookAndFeel* myLookAndFeel = MLLookAndFeel::getInstance();
+	myLookAndFeel->setGridUnitSize(u);
+
+	// lay out the dials on a grid, with the multislider below them.
+	const int columns = 16;
+	const int rows = (numDials + columns - 1) / columns;
+	std::vector<std::unique_ptr<MLDial> > dials;
+	for(int i=0; i<numDials; ++i)
+	{
+		MLDial* d = new MLDial;
+		d->setDialStyle(MLDial::Rotary);
+		d->setRange(0.f, 1.f, 0.001f);
+		d->setFillColor(Colours::aquamarine);
+		d->setTicks(11);
+
+		MLWidget* w = d;
+		MLRect r(i % columns, i / columns, 1, 1);
+		w->setGridBounds(r);
+		w->resizeWidget(r*u, u);
+		dials.push_back(std::unique_ptr<MLDial>(d));
+	}
+
+	MLMultiSlider slider;
+	slider.setNumSliders(numSliders);
+	slider.setRange(0.f, 1.f, 0.001f);
+	slider.setFillColor(Colours::aquamarine);
+	MLRect sliderBounds(0, rows, columns, 2);
+	slider.setGridBounds(sliderBounds);
+	slider.resizeWidget(sliderBounds*u, u);
+
+	Image image(Image::ARGB, columns*u, (rows + 2)*u, true, SoftwareImageType());
+	Graphics g(image);
+
+	// first paint draws everything, including the static layers.
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(int i=0; i<numDials; ++i)
+	{
+		paintWidget(g, dials[i].get());
+	}
+	paintWidget(g, &slider);
+	double firstPaint = msSince(start);
+
+	// then every dial and one slider changes each frame.
+	double dialTime = 0., sliderFullTime = 0., sliderColumnTime = 0.;
+	const int sliderWidth = slider.getWidth() / numSliders;
+	for(int f=0; f<frames; ++f)
+	{
+		float v = (f % 100) / 100.f;
+
+		start = std::chrono::steady_clock::now();
+		for(int i=0; i<numDials; ++i)
+		{
+			dials[i]->setPropertyImmediate("value", v);
+			paintWidget(g, dials[i].get());
+		}
+		dialTime += msSince(start);
+
+		int s = f % numSliders;
+		slider.setPropertyImmediate(MLSymbol("value").withFinalNumber(s), v);
+
+		start = std::chrono::steady_clock::now();
+		paintWidget(g, &slider);
+		sliderFullTime += msSince(start);
+
+		start = std::chrono::steady_clock::now();
+		paintWidget(g, &slider, Rectangle<int>(s*sliderWidth, 0, sliderWidth + 4, slider.getHeight()));
+		sliderColumnTime += msSince(start);
+	}
+
+	printf("%d dials, %d sliders, grid unit %d, %d frames\n", numDials, numSliders, u, frames);
+	printf("first paint: %.3f ms\n", firstPaint);
+	printf("dials: %.3f ms per frame, %.2f us per dial\n", dialTime / frames, dialTime*1000. / (frames*numDials));
+	printf("multislider: %.3f ms per full repaint, %.3f ms per column repaint\n",
+		sliderFullTime / frames, sliderColumnTime / frames);
+	return 0;
+}
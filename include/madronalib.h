@@ -10,5 +10,6 @@
 
 #include "../source/core/MLSymbol.h"
 #include "../source/core/MLSignal.h"
+#include "../source/core/MLRandom.h"
 
 #endif // _madronalib_dot_h